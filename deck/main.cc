@@ -49,8 +49,9 @@ void checkpt(const char* fbase, int tag)
 {
     char fname[256];
     if( !fbase ) ERROR(( "NULL filename base" ));
-    sprintf( fname, "%s.%i.%i", fbase, tag, world_rank );
+    sprintf( fname, "%s.%i", fbase, tag );
     if( world_rank==0 ) log_printf( "*** Checkpointing to \"%s\"\n", fbase );
+    simulation->dump_particles_flush(); // Particle dumps complete at checkpoints
     checkpt_objects( fname );
 }
 
@@ -81,19 +82,30 @@ int main(int argc, char** argv)
     if( fbase )
     {
 
-        // We are restoring from a checkpoint.  Determine checkpt file
-        // for this process, restore all the objects in that file,
-        // wait for all other processes to finishing restoring (such
-        // that communication within reanimate functions is safe),
+        // We are restoring from a checkpoint.  Restore all the objects
+        // of this process (the checkpt service finds the file holding
+        // them), wait for all other processes to finishing restoring
+        // (such that communication within reanimate functions is safe),
         // reanimate all the objects and issue a final barrier to
         // so that all processes come of a restore together.
+        // A checkpt written by a different number of processes is
+        // restored by restoring the objects of one of the processes
+        // that wrote it and then remapping the domain.
+        int n_rank = checkpt_ranks( fbase );
         if( world_rank==0 ) log_printf( "*** Restoring from \"%s\"\n", fbase );
-        char fname[256];
-        sprintf( fname, "%s.%i", fbase, world_rank );
-        restore_objects( fname );
+        if( n_rank==world_size ) restore_objects( fbase );
+        else restore_remapped_objects( fbase, (int)( (int64_t)world_rank*
+                                                     n_rank/world_size ) );
         mp_barrier();
         reanimate_objects();
         mp_barrier();
+        if( n_rank!=world_size ) {
+            if( world_rank==0 )
+                log_printf( "*** Remapping from %i to %i processes\n",
+                            n_rank, world_size );
+            simulation->remap_domain( fbase );
+            mp_barrier();
+        }
 
     }
     else // We are initializing from scratch.
@@ -156,3 +168,8 @@ int main(int argc, char** argv)
     halt_services();
     return 0;
 }
+
+// Named for checkpt_sym (see REGISTER_SYMBOL)
+
+REGISTER_SYMBOL( checkpt_main )
+REGISTER_SYMBOL( restore_main )
@@ -22,7 +22,8 @@ interact_absorb_tally( absorb_tally_t      * RESTRICT at,
                        particle_mover_t    * RESTRICT pm,
                        particle_injector_t * RESTRICT pi,
                        int                            max_pi,
-                       int                            face ) {
+                       int                            face,
+                       int                            pipeline_rank ) {
   at->tally[ sp->id ]++;
   accumulate_rhob( at->fa->f, p, at->fa->g, sp->q );
   return 0;
@@ -82,3 +83,9 @@ get_absorb_tally( particle_bc_t * pbc ) {
   return ((absorb_tally_t *)pbc->params)->tally;
 }
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( interact_absorb_tally )
+REGISTER_SYMBOL( delete_absorb_tally )
+REGISTER_SYMBOL( checkpt_absorb_tally )
+REGISTER_SYMBOL( restore_absorb_tally )
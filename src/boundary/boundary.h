@@ -32,6 +32,18 @@ get_particle_bc_id( particle_bc_t * pbc );
 
 /* In boundary_p.cxx */
 
+void
+boundary_p_begin( particle_bc_t       * RESTRICT pbc_list,
+                  species_t           * RESTRICT sp_list,
+                  field_array_t       * RESTRICT fa,
+                  accumulator_array_t * RESTRICT aa );
+
+void
+boundary_p_end( particle_bc_t       * RESTRICT pbc_list,
+                species_t           * RESTRICT sp_list,
+                field_array_t       * RESTRICT fa,
+                accumulator_array_t * RESTRICT aa );
+
 void
 boundary_p( particle_bc_t       * RESTRICT pbc_list,
             species_t           * RESTRICT sp_list,
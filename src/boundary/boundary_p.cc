@@ -1,6 +1,8 @@
 #define IN_boundary
 #include "boundary_private.h"
 
+#include "../util/pipelines/pipelines_exec.h"
+
 // If this is defined particle and mover buffers will not resize dynamically
 // (This is the common case for the users)
 //#define DISABLE_DYNAMIC_RESIZING
@@ -30,30 +32,91 @@ using namespace v4;
 //#define MIN_NP 32768 // 32768 particles is 1 MiB of memory.
 #endif
 
+// Below this many movers or injectors per pipeline, boundary_p handles
+// them on the host rather than dispatching them to the pipelines.
+#ifndef MIN_PIPELINE_WORK
+#define MIN_PIPELINE_WORK 256
+#endif
 
 enum { MAX_PBC = 32, MAX_SP = 32 };
 
-void
-boundary_p( particle_bc_t       * RESTRICT pbc_list,
-            species_t           * RESTRICT sp_list,
-            field_array_t       * RESTRICT fa,
-            accumulator_array_t * RESTRICT aa ) {
+// Gives the local mp port associated with a local face
+static const int f2b[6]  = { BOUNDARY(-1, 0, 0),
+                             BOUNDARY( 0,-1, 0),
+                             BOUNDARY( 0, 0,-1),
+                             BOUNDARY( 1, 0, 0),
+                             BOUNDARY( 0, 1, 0),
+                             BOUNDARY( 0, 0, 1) };
+
+// Gives the remote mp port associated with a local face
+static const int f2rb[6] = { BOUNDARY( 1, 0, 0),
+                             BOUNDARY( 0, 1, 0),
+                             BOUNDARY( 0, 0, 1),
+                             BOUNDARY(-1, 0, 0),
+                             BOUNDARY( 0,-1, 0),
+                             BOUNDARY( 0, 0,-1) };
+
+// Temporary store for local particle injectors and what is left to do
+// for each mover after the mover pipelines (both max_ci long)
+// FIXME: Ugly static usage
+static particle_injector_t * RESTRICT ALIGNED(16) ci = NULL;
+static char * RESTRICT ALIGNED(16) act = NULL;
+static int max_ci = 0;
+
+// State carried from boundary_p_begin to boundary_p_end
+static int n_recv[6], n_ci;
+
+//----------------------------------------------------------------------------//
+// boundary_p_begin mover pipelines.  Pipeline r handles the movers of a
+// species DISTRIBUTE gives it, in the same reverse order the host processes
+// the movers in.  Movers going to a neighbor are loaded into the send
+// buffers and movers that hit a custom boundary condition that may be
+// called from the pipelines (see particle_bc_t) are handed to it with the
+// pipeline's rank.  A pipeline creates at most one injector per mover, so
+// the injectors of pipeline r are put in the buffers starting at the
+// position of its first mover and the host compacts them afterward.  What
+// is left for the host to do for a mover (absorb it, interact with it or
+// warn about it) is noted in act along with the face that was hit.  The
+// host then backfills the holes in the particle list in order.
+//----------------------------------------------------------------------------//
+
+enum { MOVER_DONE = 0, MOVER_ABSORB = 1, MOVER_INTERACT = 2, MOVER_UNKNOWN = 3 };
+
+typedef struct boundary_p_mover_seg {
+  int n_send[6]; // Injectors loaded into each send buffer
+  int n_ci;      // Injectors loaded into the local injection buffer
+
+  PAD_STRUCT( 7*sizeof(int) )
+
+} boundary_p_mover_seg_t;
+
+typedef struct boundary_p_mover_pipeline_args {
+  MEM_PTR( species_t,              1   ) sp;         // Species of the movers
+  MEM_PTR( particle_t,             128 ) p0;         // Particles (AoS)
+  MEM_PTR( particle_block_t,       128 ) pb0;        // Particles (AoSoA)
+  MEM_PTR( particle_mover_t,       16  ) pm;         // Movers
+  MEM_PTR( particle_injector_t,    16  ) pi_send[6]; // Next free send injectors
+  MEM_PTR( particle_injector_t,    16  ) ci;         // Next free local injector
+  MEM_PTR( char,                   16  ) act;        // What is left per mover
+  MEM_PTR( boundary_p_mover_seg_t, 128 ) seg;        // Dest for return values
+  MEM_PTR( const int64_t,          128 ) neighbor;   // Grid neighbors
+  MEM_PTR( const particle_bc_func_t, 1 ) pbc_interact;
+  MEM_PTR( void * const,           1   ) pbc_params;
+  MEM_PTR( const int,              1   ) pbc_pipelined;
+
+  int64_t rangel, rangeh, rangem;                    // See grid_t
+  int64_t range[6];                                  // Neighbor offsets
+  int nm;                                            // Number of movers
+  int nb;                                            // Number of custom bcs
+
+  PAD_STRUCT( 17*SIZEOF_MEM_PTR + 9*sizeof(int64_t) + 2*sizeof(int) )
+
+} boundary_p_mover_pipeline_args_t;
 
-  // Gives the local mp port associated with a local face
-  static const int f2b[6]  = { BOUNDARY(-1, 0, 0),
-                               BOUNDARY( 0,-1, 0),
-                               BOUNDARY( 0, 0,-1),
-                               BOUNDARY( 1, 0, 0),
-                               BOUNDARY( 0, 1, 0),
-                               BOUNDARY( 0, 0, 1) };
-
-  // Gives the remote mp port associated with a local face
-  static const int f2rb[6] = { BOUNDARY( 1, 0, 0),
-                               BOUNDARY( 0, 1, 0),
-                               BOUNDARY( 0, 0, 1),
-                               BOUNDARY(-1, 0, 0),
-                               BOUNDARY( 0,-1, 0),
-                               BOUNDARY( 0, 0,-1) };
+void
+boundary_p_mover_pipeline_scalar( boundary_p_mover_pipeline_args_t * args,
+                                  int pipeline_rank,
+                                  int n_pipeline ) {
 
   // Gives the axis associated with a local face
   static const int axis[6]  = { 0, 1, 2,  0,  1,  2 };
@@ -61,12 +124,256 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
   // Gives the location of sending face on the receiver
   static const float dir[6] = { 1, 1, 1, -1, -1, -1 };
 
-  // Temporary store for local particle injectors
-  // FIXME: Ugly static usage
-  static particle_injector_t * RESTRICT ALIGNED(16) ci = NULL;
-  static int max_ci = 0;
+  /**/  species_t        * RESTRICT              sp       = args->sp;
+  /**/  particle_t       * RESTRICT ALIGNED(128) p0       = args->p0;
+  /**/  particle_block_t * RESTRICT ALIGNED(128) pb0      = args->pb0;
+  const int64_t          * RESTRICT ALIGNED(128) neighbor = args->neighbor;
+  const int64_t rangel = args->rangel;
+  const int64_t rangeh = args->rangeh;
+  const int64_t rangem = args->rangem;
+  const int32_t sp_id  = sp->id;
+
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, local_p, 1 );
+  particle_t          * RESTRICT ALIGNED(32) p;
+  particle_mover_t    * RESTRICT ALIGNED(16) pm;
+  particle_injector_t * RESTRICT ALIGNED(16) pi;
+  particle_injector_t * RESTRICT ALIGNED(16) pi_send[6];
+  particle_injector_t * RESTRICT ALIGNED(16) ci;
+  char                * RESTRICT             act;
+  int n_send[6], n_ci = 0;
+  int k, n, i, voxel, face;
+  int64_t nn;
+
+  DISTRIBUTE( args->nm, 1, pipeline_rank, n_pipeline, k, n );
+
+  for( face=0; face<6; face++ ) {
+    pi_send[face] = args->pi_send[face] ? args->pi_send[face] + k : NULL;
+    n_send[face]  = 0;
+  }
+  ci  = args->ci + k;
+  act = args->act + k;
+  pm  = args->pm + args->nm - 1 - k;
+
+  for( ; n; pm--, act++, n-- ) {
+    i = pm->i;
+    if( pb0 ) load_particle_pb( p = local_p, pb0, i );
+    else      p = p0 + i;
+    voxel = p->i;
+    face = voxel & 7;
+    voxel >>= 3;
+    p->i = voxel;
+    nn = neighbor[ 6*voxel + face ];
+
+    // Absorb (the host accumulates rhob)
+
+    if( nn==absorb_particles ) {
+      *act = MOVER_ABSORB | (face<<2);
+      continue;
+    }
+
+    // Send to a neighboring node
+
+    if( ((nn>=0) & (nn< rangel)) | ((nn>rangeh) & (nn<=rangem)) ) {
+      pi = &pi_send[face][n_send[face]++];
+#     ifdef V4_ACCELERATION
+      if( !pb0 ) {
+        copy_4x1( &pi->dx,    &p->dx     );
+        copy_4x1( &pi->ux,    &p->ux     );
+        copy_4x1( &pi->dispx, &pm->dispx );
+      } else
+#     endif
+      {
+        pi->dx=p->dx; pi->dy=p->dy; pi->dz=p->dz;
+        pi->ux=p->ux; pi->uy=p->uy; pi->uz=p->uz; pi->w=p->w;
+        pi->dispx = pm->dispx; pi->dispy = pm->dispy; pi->dispz = pm->dispz;
+      }
+      (&pi->dx)[axis[face]] = dir[face];
+      pi->i                 = nn - args->range[face];
+      pi->sp_id             = sp_id;
+      *act = MOVER_DONE;
+      continue;
+    }
+
+    // User-defined handling (see boundary_p_begin).  Boundary conditions
+    // that can not be called from the pipelines are left to the host.
+
+    nn = -nn - 3; // Assumes reflective/absorbing are -1, -2
+    if( (nn>=0) & (nn<args->nb) ) {
+      if( args->pbc_pipelined[nn] ) {
+        n_ci += args->pbc_interact[nn]( args->pbc_params[nn], sp, p, pm,
+                                        ci+n_ci, 1, face, pipeline_rank );
+        *act = MOVER_DONE;
+      } else {
+        *act = MOVER_INTERACT | (face<<2);
+      }
+      continue;
+    }
+
+    // Uh-oh: We fell through
+
+    *act = MOVER_UNKNOWN | (face<<2);
+  }
+
+  for( face=0; face<6; face++ )
+    args->seg[pipeline_rank].n_send[face] = n_send[face];
+  args->seg[pipeline_rank].n_ci = n_ci;
+}
+
+//----------------------------------------------------------------------------//
+// boundary_p_end injection pipelines.  The injectors are injected in the
+// order the host would: the local injectors and then those received from
+// each face, each buffer in reverse order.  Pipeline r injects the
+// injectors DISTRIBUTE gives it.  The host assigns each pipeline the
+// particle and mover slots of each species its injectors go to such that
+// the particles land where they would had the host injected them all.
+// The injected particles are moved with the pipeline's accumulator.
+// Movers that did not complete their move are kept in order from the
+// first mover slot of the pipeline and the host compacts them afterward.
+//----------------------------------------------------------------------------//
+
+typedef struct boundary_p_inject_seg {
+  int np[MAX_SP];      // First particle slot of each species
+  int nm[MAX_SP];      // First mover slot of each species
+  int n_mover[MAX_SP]; // Movers left (return value)
+# ifdef DISABLE_DYNAMIC_RESIZING
+  int n_dropped_particles[MAX_SP], n_dropped_movers[MAX_SP];
+# endif
+} boundary_p_inject_seg_t;
+
+typedef struct boundary_p_inject_pipeline_args {
+  MEM_PTR( const particle_injector_t, 16 ) src[7];   // Injector buffers
+  int n_src[7];                                      // Injectors in each
+  int n_buf;                                         // Number of buffers
+  int n_inj;                                         // Number of injectors
+
+  MEM_PTR( boundary_p_inject_seg_t, 128 ) seg;       // Slots/return values
+  MEM_PTR( accumulator_t,           128 ) a0;        // Host accumulator
+  MEM_PTR( accumulator_t * const,   1   ) ap;        // Pipeline accumulators
+  MEM_PTR( const grid_t,            1   ) g;         // Local domain grid
+
+  particle_t       * ALIGNED(32) sp_p[ MAX_SP];
+  particle_block_t * ALIGNED(32) sp_pb[MAX_SP];
+  particle_mover_t * ALIGNED(32) sp_pm[MAX_SP];
+  float sp_q[MAX_SP];
+# ifdef DISABLE_DYNAMIC_RESIZING
+  int sp_max_np[MAX_SP], sp_max_nm[MAX_SP];
+# endif
+  int n_sp;
+
+} boundary_p_inject_pipeline_args_t;
+
+void
+boundary_p_inject_pipeline_scalar( boundary_p_inject_pipeline_args_t * args,
+                                   int pipeline_rank,
+                                   int n_pipeline ) {
+  /**/  boundary_p_inject_seg_t * RESTRICT seg = args->seg + pipeline_rank;
+  const grid_t                  * RESTRICT g   = args->g;
+  /**/  particle_t          * RESTRICT ALIGNED(32) p;
+  /**/  particle_block_t    * RESTRICT ALIGNED(32) pb;
+  /**/  particle_mover_t    * RESTRICT ALIGNED(16) pm;
+  const particle_injector_t * RESTRICT ALIGNED(16) pi;
+  accumulator_t * RESTRICT ALIGNED(128) a0;
+  int sp_np[MAX_SP], sp_nm[MAX_SP];
+  int np, nm, id, k, n, b, left;
+
+  if( pipeline_rank==n_pipeline ) return; // No host straggler cleanup
+
+  // The host gets the host accumulator, as do pipelines that do not have
+  // an accumulator of their own
+
+  a0 = args->ap ? args->ap[pipeline_rank] : args->a0;
+
+  for( id=0; id<args->n_sp; id++ ) {
+    sp_np[id] = seg->np[id];
+    sp_nm[id] = seg->nm[id];
+#   ifdef DISABLE_DYNAMIC_RESIZING
+    seg->n_dropped_particles[id] = 0;
+    seg->n_dropped_movers[id]    = 0;
+#   endif
+  }
+
+  DISTRIBUTE( args->n_inj, 1, pipeline_rank, n_pipeline, k, n );
+
+  // Find the first injector of this pipeline
 
-  int n_send[6], n_recv[6], n_ci;
+  for( b=0; n && k>=args->n_src[b]; b++ ) k -= args->n_src[b];
+  if( n ) pi = args->src[b] + args->n_src[b] - 1 - k, left = args->n_src[b] - k;
+
+  for( ; n; n-- ) {
+    id = pi->sp_id;
+    p  = args->sp_p[id];  np = sp_np[id];
+    pb = args->sp_pb[id];
+    pm = args->sp_pm[id]; nm = sp_nm[id];
+
+#   ifdef DISABLE_DYNAMIC_RESIZING
+    if( np>=args->sp_max_np[id] ) {
+      seg->n_dropped_particles[id]++;
+      goto next;
+    }
+#   endif
+    if( pb ) {
+      DECLARE_ALIGNED_ARRAY( particle_t, 32, local_p, 1 );
+      local_p->dx=pi->dx; local_p->dy=pi->dy; local_p->dz=pi->dz;
+      local_p->i =pi->i;
+      local_p->ux=pi->ux; local_p->uy=pi->uy; local_p->uz=pi->uz;
+      local_p->w =pi->w;
+      store_particle_pb( pb, np, local_p );
+    } else {
+#   ifdef V4_ACCELERATION
+    copy_4x1(  &p[np].dx,    &pi->dx    );
+    copy_4x1(  &p[np].ux,    &pi->ux    );
+#   else
+    p[np].dx=pi->dx; p[np].dy=pi->dy; p[np].dz=pi->dz; p[np].i=pi->i;
+    p[np].ux=pi->ux; p[np].uy=pi->uy; p[np].uz=pi->uz; p[np].w=pi->w;
+#   endif
+    }
+    sp_np[id] = np+1;
+
+#   ifdef DISABLE_DYNAMIC_RESIZING
+    if( nm>=args->sp_max_nm[id] ) {
+      seg->n_dropped_movers[id]++;
+      goto next;
+    }
+#   endif
+#   ifdef V4_ACCELERATION
+    copy_4x1( &pm[nm].dispx, &pi->dispx );
+    pm[nm].i = np;
+#   else
+    pm[nm].dispx=pi->dispx; pm[nm].dispy=pi->dispy; pm[nm].dispz=pi->dispz;
+    pm[nm].i=np;
+#   endif
+    sp_nm[id] = nm + ( pb ? move_pb( pb, pm+nm, a0, g, args->sp_q[id] ) :
+                            move_p(  p,  pm+nm, a0, g, args->sp_q[id] ) );
+
+# ifdef DISABLE_DYNAMIC_RESIZING
+  next:
+# endif
+    if( --left ) pi--;
+    else if( n>1 ) b++, pi = args->src[b] + args->n_src[b] - 1, left = args->n_src[b];
+  }
+
+  for( id=0; id<args->n_sp; id++ ) seg->n_mover[id] = sp_nm[id] - seg->nm[id];
+}
+
+// boundary_p is split in two phases so that the caller can do useful
+// work while the particles are in flight.  boundary_p_begin processes
+// the movers and posts the particle exchange with the neighbors.
+// boundary_p_end resizes the particle storage as needed, injects the
+// received and locally reinjected particles and completes the exchange.
+// Between the two, the caller may not touch the particles that had
+// movers or the particles boundary_p_begin backfilled their holes with
+// (the last sp->nm particles going into boundary_p_begin) and may only
+// create movers for particles that stay in the local domain.
+
+void
+boundary_p_begin( particle_bc_t       * RESTRICT pbc_list,
+                  species_t           * RESTRICT sp_list,
+                  field_array_t       * RESTRICT fa,
+                  accumulator_array_t * RESTRICT aa ) {
+  DECLARE_ALIGNED_ARRAY( boundary_p_mover_pipeline_args_t, 128, args, 1 );
+  DECLARE_ALIGNED_ARRAY( boundary_p_mover_seg_t, 128, seg, MAX_PIPELINE+1 );
+
+  int n_send[6];
 
   species_t * sp;
   int face;
@@ -81,11 +388,13 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
 
   particle_bc_func_t pbc_interact[MAX_PBC];
   void * pbc_params[MAX_PBC];
+  int pbc_pipelined[MAX_PBC];
   const int nb = num_particle_bc( pbc_list );
   if( nb>MAX_PBC ) ERROR(( "Update this to support more particle boundary conditions" ));
   for( particle_bc_t * pbc=pbc_list; pbc; pbc=pbc->next ) {
-    pbc_interact[-pbc->id-3] = pbc->interact;
-    pbc_params[  -pbc->id-3] = pbc->params;
+    pbc_interact[ -pbc->id-3] = pbc->interact;
+    pbc_params[   -pbc->id-3] = pbc->params;
+    pbc_pipelined[-pbc->id-3] = pbc->pipelined>N_PIPELINE;
    }
 
   // Unpack fields
@@ -93,10 +402,6 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
   field_t * RESTRICT ALIGNED(128) f = fa->f;
   grid_t  * RESTRICT              g = fa->g;
 
-  // Unpack accumulator
-
-  accumulator_t * RESTRICT ALIGNED(128) a0 = aa->a;
-
   // Unpack the grid
 
   const int64_t * RESTRICT ALIGNED(128) neighbor = g->neighbor;
@@ -131,7 +436,8 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
     //
     // Each buffer is large enough to hold one injector corresponding
     // to every mover in use (worst case, but plausible scenario in
-    // beam simulations, is one buffer gets all the movers).
+    // beam simulations, is one buffer gets all the movers).  The
+    // mover pipelines rely on this.
     //
     // FIXME: We could be several times more efficient in our particle
     // injector buffer sizing here.  Namely, we could create on local
@@ -152,38 +458,62 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
 
     int nm = 0; LIST_FOR_EACH( sp, sp_list ) nm += sp->nm;
 
-    for( face=0; face<6; face++ )
+    for( face=0; face<6; face++ ) {
+      pi_send[face] = NULL;
       if( shared[face] ) {
         mp_size_send_buffer( mp, f2b[face], 16+nm*sizeof(particle_injector_t) );
         pi_send[face] = (particle_injector_t *)(((char *)mp_send_buffer(mp,f2b[face]))+16);
         n_send[face] = 0;
       }
+    }
 
     if( max_ci<nm ) {
       particle_injector_t * new_ci = ci;
+      char * new_act = act;
       FREE_ALIGNED( new_ci );
-      MALLOC_ALIGNED( new_ci, nm, 16 );
+      FREE_ALIGNED( new_act );
+      MALLOC_ALIGNED( new_ci,  nm, 16 );
+      MALLOC_ALIGNED( new_act, nm, 16 );
       ci     = new_ci;
+      act    = new_act;
       max_ci = nm;
     }
     n_ci = 0;
 
+    args->seg           = seg;
+    args->neighbor      = neighbor;
+    args->pbc_interact  = pbc_interact;
+    args->pbc_params    = pbc_params;
+    args->pbc_pipelined = pbc_pipelined;
+    args->rangel        = rangel;
+    args->rangeh        = rangeh;
+    args->rangem        = rangem;
+    for( face=0; face<6; face++ ) args->range[face] = range[face];
+    args->nb            = nb;
+
     // For each species, load the movers
 
     LIST_FOR_EACH( sp, sp_list ) {
-      const float   sp_q  = sp->q;
-      const int32_t sp_id = sp->id;
+      const float sp_q = sp->q;
 
       particle_t * RESTRICT ALIGNED(128) p0 = sp->p;
       int np = sp->np;
 
-      particle_mover_t * RESTRICT ALIGNED(16)  pm = sp->pm + sp->nm - 1;
-      nm = sp->nm;
+      // In the AoSoA layout, each outbound particle is gathered into a
+      // local particle before it is handled.
+
+      particle_block_t * RESTRICT ALIGNED(128) pb0 =
+        sp->p_layout==particle_layout_aosoa ? (particle_block_t *)sp->p : NULL;
+      DECLARE_ALIGNED_ARRAY( particle_t, 32, local_p, 1 );
+      particle_t * RESTRICT ALIGNED(32) p;
 
-      particle_injector_t * RESTRICT ALIGNED(16) pi;
-      int i, voxel;
+      particle_mover_t * RESTRICT ALIGNED(16)  pm;
+      int i, k, n, r, n_run, a;
       int64_t nn;
 
+      nm = sp->nm;
+      if( !nm ) continue;
+
       // Note that particle movers for each species are processed in
       // reverse order.  This allows us to backfill holes in the
       // particle list created by boundary conditions and/or
@@ -192,83 +522,99 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
       // n=1...nm-1.  advance_p and inject_particle create movers with
       // property if all aged particle injection occurs after
       // advance_p and before this
+      //
+      // The pipelines handle the movers that are sent to neighbors
+      // or hit custom boundary conditions that allow it.  When there
+      // are too few movers to be worth dispatching, the host does it.
+
+      args->sp  = sp;
+      args->p0  = p0;
+      args->pb0 = pb0;
+      args->pm  = sp->pm;
+      for( face=0; face<6; face++ )
+        args->pi_send[face] = pi_send[face] ? pi_send[face] + n_send[face] : NULL;
+      args->ci  = ci + n_ci;
+      args->act = act;
+      args->nm  = nm;
+
+      if( N_PIPELINE>1 && nm>=MIN_PIPELINE_WORK*N_PIPELINE ) {
+        n_run = N_PIPELINE;
+        EXEC_PIPELINES( boundary_p_mover, args, 0 );
+        WAIT_PIPELINES();
+      } else {
+        n_run = 1;
+        boundary_p_mover_pipeline_scalar( args, 0, 1 );
+      }
 
-      for( ; nm; pm--, nm-- ) {
-        i = pm->i;
-        voxel = p0[i].i;
-        face = voxel & 7;
-        voxel >>= 3;
-        p0[i].i = voxel;
-        nn = neighbor[ 6*voxel + face ];
+      // Compact the injectors of the pipelines
+
+      for( r=0; r<n_run; r++ ) {
+        DISTRIBUTE( nm, 1, r, n_run, k, n );
+        for( face=0; face<6; face++ )
+          if( pi_send[face] ) {
+            n = seg[r].n_send[face];
+            MOVE( pi_send[face] + n_send[face], args->pi_send[face] + k, n );
+            n_send[face] += n;
+          }
+        n = seg[r].n_ci;
+        MOVE( ci + n_ci, args->ci + k, n );
+        n_ci += n;
+      }
+
+      // Finish the movers left to the host and backfill
 
-        // Absorb
+      pm = sp->pm + nm - 1;
+      for( k=0; k<nm; k++, pm-- ) {
+        i = pm->i;
+        a = act[k];
+        if( a!=MOVER_DONE ) {
+          face = a>>2;
+          if( pb0 ) { load_particle_pb( p = local_p, pb0, i ); p->i >>= 3; }
+          else      p = p0 + i; // Voxel already unpacked by the pipelines
 
-        if( nn==absorb_particles ) {
           // Ideally, we would batch all rhob accumulations together
           // for efficiency
-          accumulate_rhob( f, p0+i, g, sp_q );
-          goto backfill;
-        }
 
-        // Send to a neighboring node
-
-        if( ((nn>=0) & (nn< rangel)) | ((nn>rangeh) & (nn<=rangem)) ) {
-          pi = &pi_send[face][n_send[face]++];
-#         ifdef V4_ACCELERATION
-          copy_4x1( &pi->dx,    &p0[i].dx  );
-          copy_4x1( &pi->ux,    &p0[i].ux  );
-          copy_4x1( &pi->dispx, &pm->dispx );
-#         else
-          pi->dx=p0[i].dx; pi->dy=p0[i].dy; pi->dz=p0[i].dz;
-          pi->ux=p0[i].ux; pi->uy=p0[i].uy; pi->uz=p0[i].uz; pi->w=p0[i].w;
-          pi->dispx = pm->dispx; pi->dispy = pm->dispy; pi->dispz = pm->dispz;
-#         endif
-          (&pi->dx)[axis[face]] = dir[face];
-          pi->i                 = nn - range[face];
-          pi->sp_id             = sp_id;
-          goto backfill;
+          if( (a&3)==MOVER_ABSORB ) accumulate_rhob( f, p, g, sp_q );
+
+          // After a particle interacts with a boundary it is removed
+          // from the local particle list.  Thus, if a boundary handler
+          // does not want a particle destroyed,  it is the boundary
+          // handler's job to append the destroyed particle to the list
+          // of particles to inject.
+          //
+          // Note that these destruction and creation processes do _not_
+          // adjust rhob by default.  Thus, a boundary handler is
+          // responsible for insuring that the rhob is updated
+          // appropriate for the incident particle it destroys and for
+          // any particles it injects as a result too.
+          //
+          // Since most boundary handlers do local reinjection and are
+          // charge neutral, this means most boundary handlers do
+          // nothing to rhob.
+
+          else if( (a&3)==MOVER_INTERACT ) {
+            nn = -neighbor[ 6*p->i + face ] - 3;
+            n_ci += pbc_interact[nn]( pbc_params[nn], sp, p, pm,
+                                      ci+n_ci, 1, face, N_PIPELINE );
+          }
+
+          // Uh-oh: We fell through
+
+          else WARNING(( "Unknown boundary interaction ... dropping particle "
+                         "(species=%s)", sp->name ));
         }
 
-        // User-defined handling
-
-        // After a particle interacts with a boundary it is removed
-        // from the local particle list.  Thus, if a boundary handler
-        // does not want a particle destroyed,  it is the boundary
-        // handler's job to append the destroyed particle to the list
-        // of particles to inject.
-        //
-        // Note that these destruction and creation processes do _not_
-        // adjust rhob by default.  Thus, a boundary handler is
-        // responsible for insuring that the rhob is updated
-        // appropriate for the incident particle it destroys and for
-        // any particles it injects as a result too.
-        //
-        // Since most boundary handlers do local reinjection and are
-        // charge neutral, this means most boundary handlers do
-        // nothing to rhob.
-
-        nn = -nn - 3; // Assumes reflective/absorbing are -1, -2
-        if( (nn>=0) & (nn<nb) ) {
-          n_ci += pbc_interact[nn]( pbc_params[nn], sp, p0+i, pm,
-                                    ci+n_ci, 1, face );
-          goto backfill;
-        }
-
-        // Uh-oh: We fell through
-
-        WARNING(( "Unknown boundary interaction ... dropping particle "
-                  "(species=%s)", sp->name ));
-
-      backfill:
-
         np--;
+        if( pb0 ) copy_particle_pb( pb0, i, pb0, np );
+        else {
 #       ifdef V4_ACCELERATION
         copy_4x1( &p0[i].dx, &p0[np].dx );
         copy_4x1( &p0[i].ux, &p0[np].ux );
 #       else
         p0[i] = p0[np];
 #       endif
-
+        }
       }
 
       sp->np = np;
@@ -315,6 +661,41 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
                      bc[face], f2b[face] );
     }
 
+}
+
+void
+boundary_p_end( particle_bc_t       * RESTRICT pbc_list,
+                species_t           * RESTRICT sp_list,
+                field_array_t       * RESTRICT fa,
+                accumulator_array_t * RESTRICT aa ) {
+  DECLARE_ALIGNED_ARRAY( boundary_p_inject_pipeline_args_t, 128, args, 1 );
+  DECLARE_ALIGNED_ARRAY( boundary_p_inject_seg_t, 128, seg, MAX_PIPELINE+1 );
+
+  accumulator_t * ap[ MAX_PIPELINE ];
+
+  species_t * sp;
+  int face;
+
+  // Check input args
+
+  if( !sp_list ) return; // Nothing to do if no species
+  if( !fa || !aa || sp_list->g!=aa->g || fa->g!=aa->g )
+    ERROR(( "Bad args" ));
+
+  // Unpack fields and accumulator
+
+  grid_t * RESTRICT g = fa->g;
+
+  // Unpack the grid
+
+  /**/  mp_t    * RESTRICT              mp       = g->mp;
+  /*const*/ int bc[6], shared[6];
+  for( face=0; face<6; face++ ) {
+    bc[face] = g->bc[f2b[face]];
+    shared[face] = (bc[face]>=0) && (bc[face]<world_size) &&
+                   (bc[face]!=world_rank);
+  }
+
 # ifndef DISABLE_DYNAMIC_RESIZING
   // Resize particle storage to accomodate worst case inject
 
@@ -343,8 +724,9 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
         //float resize_ratio = (float)n/sp->max_np;
         WARNING(( "Resizing local %s particle storage from %i to %i",
                   sp->name, sp->max_np, n ));
-        MALLOC_ALIGNED( new_p, n, 128 );
-        COPY( new_p, sp->p, sp->np );
+        MALLOC_ALIGNED( new_p, PARTICLE_BLOCK_CEIL(n), 128 );
+        COPY( new_p, sp->p, PARTICLE_BLOCK_CEIL(sp->np) );
+        unplace_pipelines( sp->p );
         FREE_ALIGNED( sp->p );
         sp->p = new_p, sp->max_np = n;
 
@@ -364,8 +746,9 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
         //float resize_ratio = (float)n/sp->max_np;
         WARNING(( "Resizing (shrinking) local %s particle storage from "
                     "%i to %i", sp->name, sp->max_np, n));
-        MALLOC_ALIGNED( new_p, n, 128 );
-        COPY( new_p, sp->p, sp->np );
+        MALLOC_ALIGNED( new_p, PARTICLE_BLOCK_CEIL(n), 128 );
+        COPY( new_p, sp->p, PARTICLE_BLOCK_CEIL(sp->np) );
+        unplace_pipelines( sp->p );
         FREE_ALIGNED( sp->p );
         sp->p = new_p, sp->max_np = n;
 
@@ -409,106 +792,130 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
 
     // Unpack the species list for random acesss
 
-    particle_t       * RESTRICT ALIGNED(32) sp_p[ MAX_SP];
-    particle_mover_t * RESTRICT ALIGNED(32) sp_pm[MAX_SP];
-    float sp_q[MAX_SP];
-    int sp_np[MAX_SP];
-    int sp_nm[MAX_SP];
-
-#   ifdef DISABLE_DYNAMIC_RESIZING
-    int sp_max_np[64], n_dropped_particles[64];
-    int sp_max_nm[64], n_dropped_movers[64];
-#   endif
+    int sp_np[MAX_SP], sp_nm[MAX_SP];
+    int n_inj, n_run, r, b, k, n, id;
 
     if( num_species( sp_list ) > MAX_SP )
       ERROR(( "Update this to support more species" ));
     LIST_FOR_EACH( sp, sp_list ) {
-      sp_p[  sp->id ] = sp->p;
-      sp_pm[ sp->id ] = sp->pm;
-      sp_q[  sp->id ] = sp->q;
-      sp_np[ sp->id ] = sp->np;
-      sp_nm[ sp->id ] = sp->nm;
+      args->sp_p[  sp->id ] = sp->p;
+      args->sp_pb[ sp->id ] = sp->p_layout==particle_layout_aosoa ?
+                              (particle_block_t *)sp->p : NULL;
+      args->sp_pm[ sp->id ] = sp->pm;
+      args->sp_q[  sp->id ] = sp->q;
 #     ifdef DISABLE_DYNAMIC_RESIZING
-      sp_max_np[sp->id]=sp->max_np; n_dropped_particles[sp->id]=0;
-      sp_max_nm[sp->id]=sp->max_nm; n_dropped_movers[sp->id]=0;
+      args->sp_max_np[sp->id] = sp->max_np;
+      args->sp_max_nm[sp->id] = sp->max_nm;
 #     endif
+      sp_np[ sp->id ] = sp->np;
+      sp_nm[ sp->id ] = sp->nm;
     }
+    args->n_sp = num_species( sp_list );
 
-    // Inject particles.  We do custom local injection first to
-    // increase message overlap opportunities.
-
-    face = 5;
-    do {
-      /**/  particle_t          * RESTRICT ALIGNED(32) p;
-      /**/  particle_mover_t    * RESTRICT ALIGNED(16) pm;
-      const particle_injector_t * RESTRICT ALIGNED(16) pi;
-      int np, nm, n, id;
+    // Gather the injectors.  Custom local injection comes first.
+    // Reverse order injection is done to reduce thrashing of the
+    // particle list (particles are removed reverse order so the
+    // overall impact of removal + injection is to keep injected
+    // particles in order).
+    //
+    // WARNING: THIS TRUSTS THAT THE INJECTORS (INCLUDING THOSE
+    // RECEIVED FROM OTHER NODES) HAVE VALID PARTICLE IDS.
 
-      face++; if( face==7 ) face = 0;
-      if( face==6 ) pi = ci, n = n_ci;
-      else if( shared[face] ) {
+    args->n_buf = 0;
+    if( n_ci ) {
+      args->src[  args->n_buf   ] = ci;
+      args->n_src[args->n_buf++ ] = n_ci;
+    }
+    for( face=0; face<6; face++ )
+      if( shared[face] ) {
         mp_end_recv( mp, f2b[face] );
-        pi = (const particle_injector_t *)
+        if( !n_recv[face] ) continue;
+        args->src[  args->n_buf   ] = (const particle_injector_t *)
           (((char *)mp_recv_buffer(mp,f2b[face]))+16);
-        n  = n_recv[face];
-      } else continue;
+        args->n_src[args->n_buf++ ] = n_recv[face];
+      }
 
-      // Reverse order injection is done to reduce thrashing of the
-      // particle list (particles are removed reverse order so the
-      // overall impact of removal + injection is to keep injected
-      // particles in order).
-      //
-      // WARNING: THIS TRUSTS THAT THE INJECTORS (INCLUDING THOSE
-      // RECEIVED FROM OTHER NODES) HAVE VALID PARTICLE IDS.
+    n_inj = 0;
+    for( b=0; b<args->n_buf; b++ ) n_inj += args->n_src[b];
+    args->n_inj = n_inj;
+
+    // The pipelines move the injected particles with their own
+    // accumulators, which are reduced after boundary_p.  Tiled
+    // accumulators only cover the particles of the particle advance, so
+    // the host injects everything then.  It does so too when there are
+    // too few injectors to be worth dispatching.
+
+    args->seg = seg;
+    args->a0  = aa->a;
+    args->ap  = NULL;
+    args->g   = g;
+
+    n_run = 1;
+    if( N_PIPELINE>1 && !aa->tiled && n_inj>=MIN_PIPELINE_WORK*N_PIPELINE ) {
+      begin_pipeline_accumulators( aa, ap, N_PIPELINE );
+      args->ap = ap;
+      n_run    = N_PIPELINE;
+    }
 
-      pi += n-1;
-      for( ; n; pi--, n-- ) {
-        id = pi->sp_id;
-        p  = sp_p[id];  np = sp_np[id];
-        pm = sp_pm[id]; nm = sp_nm[id];
+    // Give each pipeline the particle and mover slots of its injectors
 
-#       ifdef DISABLE_DYNAMIC_RESIZING
-        if( np>=sp_max_np[id] ) { n_dropped_particles[id]++; continue; }
-#       endif
-#       ifdef V4_ACCELERATION
-        copy_4x1(  &p[np].dx,    &pi->dx    );
-        copy_4x1(  &p[np].ux,    &pi->ux    );
-#       else
-        p[np].dx=pi->dx; p[np].dy=pi->dy; p[np].dz=pi->dz; p[np].i=pi->i;
-        p[np].ux=pi->ux; p[np].uy=pi->uy; p[np].uz=pi->uz; p[np].w=pi->w;
-#       endif
-        sp_np[id] = np+1;
+    for( r=0; r<n_run; r++ ) {
+      for( id=0; id<args->n_sp; id++ ) {
+        seg[r].np[id] = sp_np[id];
+        seg[r].nm[id] = sp_nm[id];
+      }
+      DISTRIBUTE( n_inj, 1, r, n_run, k, n );
+      for( b=0; n && k>=args->n_src[b]; b++ ) k -= args->n_src[b];
+      for( ; n; n-- ) {
+        if( k==args->n_src[b] ) b++, k = 0;
+        id = args->src[b][ args->n_src[b] - 1 - k++ ].sp_id;
+        sp_np[id]++;
+        sp_nm[id]++;
+      }
+    }
 
-#       ifdef DISABLE_DYNAMIC_RESIZING
-        if( nm>=sp_max_nm[id] ) { n_dropped_movers[id]++;    continue; }
-#       endif
-#       ifdef V4_ACCELERATION
-        copy_4x1( &pm[nm].dispx, &pi->dispx );
-        pm[nm].i = np;
-#       else
-        pm[nm].dispx=pi->dispx; pm[nm].dispy=pi->dispy; pm[nm].dispz=pi->dispz;
-        pm[nm].i=np;
-#       endif
-        sp_nm[id] = nm + move_p( p, pm+nm, a0, g, sp_q[id] );
+    if( n_inj ) {
+      if( n_run>1 ) {
+        EXEC_PIPELINES( boundary_p_inject, args, 0 );
+        WAIT_PIPELINES();
+      } else {
+        boundary_p_inject_pipeline_scalar( args, 0, 1 );
       }
-    } while(face!=5);
+    }
+
+    // Compact the movers of the pipelines
 
     LIST_FOR_EACH( sp, sp_list ) {
+      id = sp->id;
+      n  = sp->nm;
+      if( n_inj )
+        for( r=0; r<n_run; r++ ) {
+          MOVE( sp->pm + n, sp->pm + seg[r].nm[id], seg[r].n_mover[id] );
+          n += seg[r].n_mover[id];
+        }
+
 #     ifdef DISABLE_DYNAMIC_RESIZING
-      if( n_dropped_particles[sp->id] )
+      int n_dropped_particles = 0, n_dropped_movers = 0;
+      if( n_inj )
+        for( r=0; r<n_run; r++ ) {
+          n_dropped_particles += seg[r].n_dropped_particles[id];
+          n_dropped_movers    += seg[r].n_dropped_movers[id];
+        }
+      if( n_dropped_particles )
         WARNING(( "Dropped %i particles from species \"%s\".  Use a larger "
                   "local particle allocation in your simulation setup for "
                   "this species on this node.",
-                  n_dropped_particles[sp->id], sp->name ));
-      if( n_dropped_movers[sp->id] )
+                  n_dropped_particles, sp->name ));
+      if( n_dropped_movers )
         WARNING(( "%i particles were not completed moved to their final "
                   "location this timestep for species \"%s\".  Use a larger "
                   "local particle mover buffer in your simulation setup "
                   "for this species on this node.",
-                  n_dropped_movers[sp->id], sp->name ));
+                  n_dropped_movers, sp->name ));
+      if( sp_np[id]>sp->max_np ) sp_np[id] = sp->max_np;
 #     endif
-      sp->np=sp_np[sp->id];
-      sp->nm=sp_nm[sp->id];
+      sp->np = sp_np[id];
+      sp->nm = n;
     }
 
   } while(0);
@@ -516,3 +923,12 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
   for( face=0; face<6; face++ )
     if( shared[face] ) mp_end_send(mp,f2b[face]);
 }
+
+void
+boundary_p( particle_bc_t       * RESTRICT pbc_list,
+            species_t           * RESTRICT sp_list,
+            field_array_t       * RESTRICT fa,
+            accumulator_array_t * RESTRICT aa ) {
+  boundary_p_begin( pbc_list, sp_list, fa, aa );
+  boundary_p_end(   pbc_list, sp_list, fa, aa );
+}
@@ -12,7 +12,14 @@
    interacting particle after the interaction, you must copy it
    over the to particle injector buffer.   It is the responsibility
    of these handlers update rhob according to net charge added and
-   removed from the simulation by these functions. */
+   removed from the simulation by these functions.
+
+   boundary_p calls the handlers of boundary conditions that set
+   pipelined to more than N_PIPELINE from the pipelines, concurrently
+   for different particles.  Such a handler may only modify state of
+   its own that is private to the calling pipeline, like generator
+   pipeline_rank of an rng pool.  Others are called from the host with
+   pipeline_rank N_PIPELINE. */
 
 typedef int /* Number of particles injected */
 (*particle_bc_func_t)(                   /* The boundary whose ... */
@@ -26,9 +33,10 @@ typedef int /* Number of particles injected */
   particle_injector_t * RESTRICT pi,     /* Injectors for particles created by
                                             the interaction */
   int                            max_pi, /* Max number injections allowed */
-  int                            face ); /* CONVENIENCE: Which face of the
+  int                            face,   /* CONVENIENCE: Which face of the
                                             the voxel containing the above
                                             particle was hit */
+  int                   pipeline_rank ); /* Pipeline making the call */
 
 typedef void
 (*delete_particle_bc_func_t)( particle_bc_t * RESTRICT pbc );
@@ -38,6 +46,8 @@ struct particle_bc {
   particle_bc_func_t interact;
   delete_particle_bc_func_t delete_pbc;
   int64_t id;
+  int pipelined; /* Pipeline ranks interact can be called with
+                    concurrently (0 if only from the host) */
   particle_bc_t * next;
 };
 
@@ -34,6 +34,16 @@
 //
 // dx_new = dx_old * (ux_new/ux_old) * sqrt((1+|u_old|**2)/(1+|u_new|**2))
 //
+// The refluxed momenta of a particle are drawn from a counter based
+// stream of the entropy pool given to maxwellian_reflux (see
+// seed_rng_counter and RNG_COUNTER_KEY) named by the species, the face
+// and the particle (see particle_stream).  They do not depend on which
+// pipeline or process refluxes the particle (see boundary_p_begin) or
+// on where it sits in the particle array, so each pipeline uses a
+// generator of its own in counter mode.  If there are fewer of these
+// than the pipelines (after a restart with more threads), the
+// interaction is left to the host, which uses the first one.
+//
 // Written by:  Brian J. Albright, X-1, LANL   April, 2005
 // Revamped by KJB, May 2008, Sep 2009
 
@@ -43,12 +53,18 @@
 /* Private interface ********************************************************/
 
 typedef struct maxwellian_reflux {
-  species_t * sp_list;
-  rng_t     * rng;
+  species_t  * sp_list;
+  rng_pool_t * rp;
+  rng_pool_t * crp; // Counter mode generators of the pipelines and host
   float     * ut_para;
   float     * ut_perp;
 } maxwellian_reflux_t;
 
+// Counter stream s0 of the refluxing of species sp_id off face
+
+#define REFLUX_STREAM( sp_id, face ) \
+  ( ( (uint32_t)0x52 << 24 ) | ( (uint32_t)(sp_id) << 3 ) | (uint32_t)(face) )
+
 #ifndef M_SQRT2
 #define M_SQRT2 (1.4142135623730950488016887242096981)
 #endif
@@ -61,14 +77,18 @@ interact_maxwellian_reflux( maxwellian_reflux_t * RESTRICT mr,
                             particle_mover_t    * RESTRICT pm,
                             particle_injector_t * RESTRICT pi,
                             int                            max_pi,
-                            int                            face ) {
+                            int                            face,
+                            int                            pipeline_rank ) {
   const grid_t * RESTRICT g   = sp->g;
-  /**/  rng_t  * RESTRICT rng = mr->rng;
+  /**/  rng_t  * RESTRICT rng =
+    mr->crp->rng[ pipeline_rank<mr->crp->n_rng ? pipeline_rank : 0 ];
 
   const int32_t sp_id   = sp->id;
   const float   ut_para = mr->ut_para[sp_id]; 
   const float   ut_perp = mr->ut_perp[sp_id];
 
+  global_voxel_map_t map[1];
+  uint32_t s1, s2;
   float u[3];                // u0 = para, u1 & u2 = perp
   float ux, uy, uz;          // x, y, z normalized momenta
   float dispx, dispy, dispz; // Particle displacement
@@ -116,7 +136,12 @@ interact_maxwellian_reflux( maxwellian_reflux_t * RESTRICT mr,
   // number.
 
   // Note: This assumes ut_para > 0
-  
+
+  global_voxel_map( map, g );
+  particle_stream( p, global_voxel( map, p->i ), (uint32_t)sp_id, &s1, &s2 );
+  seed_rng_counter( rng, RNG_COUNTER_KEY( mr->rp, g->step ),
+                    REFLUX_STREAM( sp_id, face ), s1, s2 );
+
   u[0] = ut_para*scale[face]*sqrtf(frande(rng));
   u[1] = ut_perp*frandn(rng);
   u[2] = ut_perp*frandn(rng);
@@ -182,7 +207,8 @@ checkpt_maxwellian_reflux( const particle_bc_t * RESTRICT pbc ) {
     (const maxwellian_reflux_t *)pbc->params;
   CHECKPT( mr, 1 );
   CHECKPT_PTR( mr->sp_list );
-  CHECKPT_PTR( mr->rng     );
+  CHECKPT_PTR( mr->rp      );
+  CHECKPT_PTR( mr->crp     );
   CHECKPT( mr->ut_para, num_species( mr->sp_list ) );
   CHECKPT( mr->ut_perp, num_species( mr->sp_list ) );
   checkpt_particle_bc_internal( pbc );
@@ -193,7 +219,8 @@ restore_maxwellian_reflux( void ) {
   maxwellian_reflux_t * mr;
   RESTORE( mr );
   RESTORE_PTR( mr->sp_list );
-  RESTORE_PTR( mr->rng     );
+  RESTORE_PTR( mr->rp      );
+  RESTORE_PTR( mr->crp     );
   RESTORE( mr->ut_para );
   RESTORE( mr->ut_perp );
   return restore_particle_bc_internal( mr );
@@ -201,6 +228,8 @@ restore_maxwellian_reflux( void ) {
 
 void
 delete_maxwellian_reflux( particle_bc_t * RESTRICT pbc ) {
+  maxwellian_reflux_t * RESTRICT mr = (maxwellian_reflux_t *)pbc->params;
+  delete_rng_pool( mr->crp );
   FREE( pbc->params );
   delete_particle_bc_internal( pbc );
 }
@@ -212,19 +241,23 @@ maxwellian_reflux( species_t  * RESTRICT sp_list,
                    rng_pool_t * RESTRICT rp ) {
   if( !sp_list || !rp ) ERROR(( "Bad args" ));
   maxwellian_reflux_t * mr;
+  particle_bc_t * pbc;
   MALLOC( mr, 1 );
   mr->sp_list = sp_list;
-  mr->rng     = rp->rng[0];
+  mr->rp      = rp;
+  mr->crp     = new_rng_pool( N_PIPELINE+1, 0, 0 );
   MALLOC( mr->ut_para, num_species( mr->sp_list ) );
   MALLOC( mr->ut_perp, num_species( mr->sp_list ) );
   CLEAR( mr->ut_para, num_species( mr->sp_list ) );
   CLEAR( mr->ut_perp, num_species( mr->sp_list ) );
-  return new_particle_bc_internal( mr,
-                                   (particle_bc_func_t)interact_maxwellian_reflux,
-                                   delete_maxwellian_reflux,
-                                   (checkpt_func_t)checkpt_maxwellian_reflux,
-                                   (restore_func_t)restore_maxwellian_reflux,
-                                   NULL );
+  pbc = new_particle_bc_internal( mr,
+                                  (particle_bc_func_t)interact_maxwellian_reflux,
+                                  delete_maxwellian_reflux,
+                                  (checkpt_func_t)checkpt_maxwellian_reflux,
+                                  (restore_func_t)restore_maxwellian_reflux,
+                                  NULL );
+  pbc->pipelined = mr->crp->n_rng;
+  return pbc;
 }
 
 /* FIXME: NOMINALLY, THIS INTERFACE SHOULD TAKE kT */
@@ -239,3 +272,9 @@ set_reflux_temp( /**/  particle_bc_t * RESTRICT pbc,
   mr->ut_perp[sp->id] = ut_perp;
 }
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( interact_maxwellian_reflux )
+REGISTER_SYMBOL( delete_maxwellian_reflux )
+REGISTER_SYMBOL( checkpt_maxwellian_reflux )
+REGISTER_SYMBOL( restore_maxwellian_reflux )
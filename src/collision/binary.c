@@ -43,10 +43,13 @@ checkpt_binary_collision_model( const collision_op_t * cop )
   CHECKPT_STR( cm->name );
   CHECKPT_SYM( cm->rate_constant );
   CHECKPT_SYM( cm->collision );
+  CHECKPT_SYM( cm->rate_constant_batch );
+  CHECKPT_SYM( cm->collision_batch );
   CHECKPT_PTR( cm->params );
   CHECKPT_PTR( cm->spi );
   CHECKPT_PTR( cm->spj );
   CHECKPT_PTR( cm->rp );
+  CHECKPT_PTR( cm->crp );
 
   checkpt_collision_op_internal( cop );
 }
@@ -60,10 +63,14 @@ restore_binary_collision_model( void )
   RESTORE_STR( cm->name );
   RESTORE_SYM( cm->rate_constant );
   RESTORE_SYM( cm->collision );
+  RESTORE_SYM( cm->rate_constant_batch );
+  RESTORE_SYM( cm->collision_batch );
   RESTORE_PTR( cm->params );
   RESTORE_PTR( cm->spi );
   RESTORE_PTR( cm->spj );
   RESTORE_PTR( cm->rp );
+  RESTORE_PTR( cm->crp );
+  CLEAR( &cm->scratch, 1 );
 
   return restore_collision_op_internal( cm );
 }
@@ -74,6 +81,8 @@ delete_binary_collision_model( collision_op_t * cop )
   binary_collision_model_t * cm
     = (binary_collision_model_t *) cop->params;
 
+  delete_rng_pool( cm->crp );
+  delete_voxel_scratch_internal( &cm->scratch );
   FREE( cm->name );
   FREE( cm );
 
@@ -83,27 +92,28 @@ delete_binary_collision_model( collision_op_t * cop )
 /* Public interface **********************************************************/
 
 collision_op_t *
-binary_collision_model( const char * RESTRICT name,
-                        binary_rate_constant_func_t rate_constant,
-                        binary_collision_func_t collision,
-                        void * RESTRICT params,
-                        species_t * RESTRICT spi,
-                        species_t * RESTRICT spj,
-                        rng_pool_t * RESTRICT rp,
-                        double sample,
-                        int interval )
+binary_batch_collision_model( const char * RESTRICT name,
+                              binary_rate_constant_func_t rate_constant,
+                              binary_rate_constant_batch_func_t rate_constant_batch,
+                              binary_collision_func_t collision,
+                              binary_collision_batch_func_t collision_batch,
+                              void * RESTRICT params,
+                              species_t * spi,
+                              species_t * spj,
+                              rng_pool_t * RESTRICT rp,
+                              double sample,
+                              int interval )
 {
   binary_collision_model_t * cm;
 
   size_t len = name ? strlen(name) : 0;
 
-  if ( !rate_constant         ||
-       !collision             ||
-       !spi                   ||
-       !spj                   ||
-       spi->g != spj->g       ||
-       !rp                    ||
-       rp->n_rng < N_PIPELINE )
+  if ( ( !rate_constant && !rate_constant_batch ) ||
+       ( !collision     && !collision_batch     ) ||
+       !spi                                       ||
+       !spj                                       ||
+       spi->g != spj->g                           ||
+       !rp                                        )
   {
     ERROR( ( "Bad args" ) );
   }
@@ -124,14 +134,26 @@ binary_collision_model( const char * RESTRICT name,
 
   strcpy( cm->name, name ); 
 
-  cm->rate_constant = rate_constant;
-  cm->collision     = collision;
-  cm->params        = params;
-  cm->spi           = spi;
-  cm->spj           = spj;
-  cm->rp            = rp;
-  cm->sample        = sample;
-  cm->interval      = interval;
+  // FNV-1a
+
+  cm->stream = 2166136261u;
+  for( ; *name; name++ )
+  {
+    cm->stream = ( cm->stream ^ (uint8_t) *name ) * 16777619u;
+  }
+
+  cm->rate_constant       = rate_constant;
+  cm->collision           = collision;
+  cm->rate_constant_batch = rate_constant_batch;
+  cm->collision_batch     = collision_batch;
+  cm->params              = params;
+  cm->spi                 = spi;
+  cm->spj                 = spj;
+  cm->rp                  = rp;
+  cm->crp                 = counter_rng_pool_internal( NULL );
+  CLEAR( &cm->scratch, 1 );
+  cm->sample              = sample;
+  cm->interval            = interval;
 
   return new_collision_op_internal( cm,
                                     ( collision_op_func_t ) apply_binary_collision_model,
@@ -140,3 +162,32 @@ binary_collision_model( const char * RESTRICT name,
                                     ( restore_func_t ) restore_binary_collision_model,
                                     NULL );
 }
+
+collision_op_t *
+binary_collision_model( const char * RESTRICT name,
+                        binary_rate_constant_func_t rate_constant,
+                        binary_collision_func_t collision,
+                        void * RESTRICT params,
+                        species_t * spi,
+                        species_t * spj,
+                        rng_pool_t * RESTRICT rp,
+                        double sample,
+                        int interval )
+{
+  if ( !rate_constant ||
+       !collision )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  return binary_batch_collision_model( name, rate_constant, NULL, collision,
+                                       NULL, params, spi, spj, rp, sample,
+                                       interval );
+}
+
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( apply_binary_collision_model )
+REGISTER_SYMBOL( delete_binary_collision_model )
+REGISTER_SYMBOL( checkpt_binary_collision_model )
+REGISTER_SYMBOL( restore_binary_collision_model )
@@ -3,21 +3,32 @@
 
 #include "collision_private.h"
 
+enum { BINARY_BATCH = 256 }; // Candidate pairs per batch of collision tests
+
 typedef struct binary_collision_model
 {
   char * name;
   binary_rate_constant_func_t rate_constant;
   binary_collision_func_t collision;
+  binary_rate_constant_batch_func_t rate_constant_batch;
+  binary_collision_batch_func_t collision_batch;
   void * params;
   species_t  * spi;
   species_t  * spj;
   rng_pool_t * rp;
+  rng_pool_t * crp;  // Counter mode generators of the pipelines
+  uint32_t stream;   // Counter stream of the model (hash of the name)
+  voxel_scratch_t scratch; // Voxel ordering scratch (not checkpointed)
   double sample;
   int interval;
   int n_large_pr[ MAX_PIPELINE ];
 } binary_collision_model_t;
 
+BEGIN_C_DECLS
+
 void
 apply_binary_collision_model_pipeline( binary_collision_model_t * cm );
 
+END_C_DECLS
+
 #endif /* _binary_h_ */
@@ -45,6 +45,138 @@ delete_collision_op_internal( collision_op_t * cop ) {
   FREE( cop );
 }
 
+rng_pool_t *
+counter_rng_pool_internal( rng_pool_t * crp ) {
+  if( crp && crp->n_rng>=N_PIPELINE ) return crp;
+  delete_rng_pool( crp );
+  return new_rng_pool( N_PIPELINE, 0, 0 );
+}
+
+typedef struct order_key {
+  uint64_t key;
+  int idx, pad;
+} order_key_t;
+
+/* Scratch bytes per particle: two key arrays, two stream words and a
+   block of deviates */
+
+#define ORDER_SCRATCH (2*sizeof(order_key_t)+6*sizeof(uint32_t))
+
+/* Sort the n keys at a using b as scratch with a least significant
+   digit radix sort, 8 bits a pass.  Returns which of the two holds the
+   result.  Each pass is stable, so keys that tie stay in idx order.
+   The digit counts of all passes are taken in a single sweep and a
+   pass whose digit is the same for every key is skipped.  The cost is
+   linear in n, whatever the density of the voxel. */
+
+static order_key_t *
+sort_order_keys( order_key_t * RESTRICT a,
+                 order_key_t * RESTRICT b,
+                 int n ) {
+  int count[8][256];
+  order_key_t * c;
+  uint64_t key;
+  int i, d, s, t, off;
+
+  CLEAR( &count[0][0], 8*256 );
+  for( i=0; i<n; i++ ) {
+    key = a[i].key;
+    for( d=0; d<8; d++ ) count[d][ ( key >> (8*d) ) & 255 ]++;
+  }
+
+  for( d=0; d<8; d++ ) {
+    if( count[d][ ( a[0].key >> (8*d) ) & 255 ]==n ) continue;
+    for( off=0, s=0; s<256; s++ ) t = count[d][s], count[d][s] = off, off += t;
+    for( i=0; i<n; i++ ) b[ count[d][ ( a[i].key >> (8*d) ) & 255 ]++ ] = a[i];
+    c = a, a = b, b = c;
+  }
+
+  return a;
+}
+
+void
+size_voxel_scratch_internal( voxel_scratch_t * vs,
+                             const species_t * spi,
+                             const species_t * spj ) {
+  const species_t * sp;
+  size_t sz;
+  int v, n, n_max = 0, s;
+
+  if( !vs || !spi || !spj ) ERROR(( "Bad args" ));
+
+  for( s=0; s<2; s++ ) {
+    sp = s ? spj : spi;
+    for( v=0; v<=sp->g->sfc_hi; v++ ) {
+      n = sp->partition[v+1] - sp->partition[v];
+      if( n_max<n ) n_max = n;
+    }
+  }
+
+  // Round the space of each pipeline up to a multiple of 128 bytes
+
+  sz = ( ( (size_t)n_max*ORDER_SCRATCH + 127 ) / 128 )*128;
+  if( vs->n_mem<sz*N_PIPELINE ) {
+    FREE_ALIGNED( vs->mem );
+    MALLOC_ALIGNED( vs->mem, sz*N_PIPELINE, 128 );
+    vs->n_mem = sz*N_PIPELINE;
+  }
+  vs->sz = sz;
+}
+
+void
+delete_voxel_scratch_internal( voxel_scratch_t * vs ) {
+  if( !vs ) return;
+  FREE_ALIGNED( vs->mem );
+  vs->sz = 0, vs->n_mem = 0;
+}
+
+void
+order_voxel_internal( particle_t * RESTRICT p,
+                      int n,
+                      int64_t gv,
+                      uint32_t id,
+                      uint64_t key,
+                      uint32_t s0,
+                      void * RESTRICT scratch ) {
+  order_key_t * RESTRICT a  = (order_key_t *)scratch;
+  order_key_t * RESTRICT b  = a + n;
+  uint32_t    * RESTRICT s1 = (uint32_t *)( b + n );
+  uint32_t    * RESTRICT s2 = s1 + n;
+  uint32_t    * RESTRICT u  = s2 + n;
+  particle_t t;
+  int k, i, j;
+
+  if( n<2 ) return;
+
+  for( k=0; k<n; k++ ) particle_stream( p + k, gv, id, s1 + k, s2 + k );
+  uirand_stream_fill( key, s0, s1, s2, u, n );
+  for( k=0; k<n; k++ ) {
+    a[k].key = ( (uint64_t)u[4*k] << 32 ) | (uint64_t)u[4*k+1];
+    a[k].idx = k;
+    a[k].pad = 0;
+  }
+
+  a = sort_order_keys( a, b, n );
+
+  /* Apply the permutation in place by following its cycles.  Element
+     k of the result is p[a[k].idx]; an element is marked as placed by
+     setting its idx to itself. */
+
+  for( k=0; k<n; k++ ) {
+    if( a[k].idx==k ) continue;
+    t = p[k];
+    for( i=k; a[i].idx!=k; i=j ) {
+      j = a[i].idx;
+      p[i] = p[j];
+      a[i].idx = i;
+    }
+    p[i] = t;
+    a[i].idx = i;
+  }
+}
+
+#undef ORDER_SCRATCH
+
 /* Public interface **********************************************************/
 
 int
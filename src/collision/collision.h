@@ -128,6 +128,59 @@ unary_collision_model( const char       * RESTRICT name,
                        /**/  rng_pool_t * RESTRICT rp,
                        int                         interval );
 
+/* A unary model can instead be given its microscopic physics a block
+   of particles at a time, which lets the model vectorize over the
+   particles of the block.  A unary_rate_constant_batch_func_t stores
+   the rate constants of the n particles p[0:n-1] in k[0:n-1] (same
+   meaning and units as above).  A unary_collision_batch_func_t
+   collides the n particles p[idx[0:n-1]] of a block in one call.
+   Particle p[idx[c]] must draw any random numbers it needs from its
+   own counter stream (ps->s0,ps->s1[c],ps->s2[c]) of ps->key (see
+   particle_stream), either in bulk with the _stream_fill generators or
+   by seeding rng on it with seed_rng_counter, such that what is drawn
+   does not depend on the order of the particles.  The per particle
+   function above is given rng already on the start of that stream.
+   Either can be NULL, in which case the model's per particle function
+   above is called on each particle instead.  */
+
+typedef struct particle_streams {
+  uint64_t key;                  /* Key (see RNG_COUNTER_KEY) */
+  uint32_t s0;                   /* Stream of all the particles */
+  const uint32_t * RESTRICT s1;  /* Stream of each particle (n) */
+  const uint32_t * RESTRICT s2;
+} particle_streams_t;
+
+typedef void
+(*unary_rate_constant_batch_func_t)( /**/  void       * RESTRICT params,
+                                     const species_t  * RESTRICT sp,
+                                     const particle_t * RESTRICT ALIGNED(32) p,
+                                     /**/  float      * RESTRICT k,
+                                     int                         n );
+
+typedef void
+(*unary_collision_batch_func_t)( /**/  void       * RESTRICT params,
+                                 const species_t  * RESTRICT sp,
+                                 /**/  particle_t * RESTRICT ALIGNED(32) p,
+                                 const int        * RESTRICT idx,
+                                 int                         n,
+                                 const particle_streams_t  * ps,
+                                 /**/  rng_t      * RESTRICT rng );
+
+/* Declare a unary collision model with batched microscopic physics.
+   rate_constant_batch or rate_constant must be given and likewise for
+   collision_batch or collision.  Otherwise, as above. */
+
+collision_op_t *
+unary_batch_collision_model( const char       * RESTRICT name,
+                             unary_rate_constant_func_t       rate_constant,
+                             unary_rate_constant_batch_func_t rate_constant_batch,
+                             unary_collision_func_t           collision,
+                             unary_collision_batch_func_t     collision_batch,
+                             /**/  void       * RESTRICT params,
+                             /**/  species_t  * RESTRICT sp,
+                             /**/  rng_pool_t * RESTRICT rp,
+                             int                         interval );
+
 /* In binary.c */
 
 /* A binary_rate_constant_func_t returns the lab-frame rate constant
@@ -239,12 +292,82 @@ binary_collision_model( const char       * RESTRICT name,
                         binary_rate_constant_func_t rate_constant,
                         binary_collision_func_t     collision,
                         /**/  void       * RESTRICT params,
-                        /**/  species_t  * RESTRICT spi,
-                        /**/  species_t  * RESTRICT spj,
+                        /**/  species_t  *          spi,
+                        /**/  species_t  *          spj,
                         /**/  rng_pool_t * RESTRICT rp,
                         double                      sample,
                         int                         interval );
 
+/* A binary model can instead be given its microscopic physics a block
+   of candidate pairs at a time, which lets the model vectorize over
+   the pairs of the block.  The n pairs of a block are pi[k[c]] and
+   pj[l[c]] for c on 0:n-1 (pi and pj are the particle arrays of spi
+   and spj, which are the same array for intraspecies collisions).  A
+   binary_rate_constant_batch_func_t stores the rate constants of the
+   pairs in K[0:n-1] (same meaning and units as above).  The rate
+   constants of a block are computed before any pair of the block
+   collides.  A binary_collision_batch_func_t collides the pairs with
+   the update types type[0:n-1] (as above).  A particle can appear in
+   more than one pair so the pairs must be collided in order.  Either
+   can be NULL, in which case the model's per pair function above is
+   called on each pair instead.  */
+
+typedef void
+(*binary_rate_constant_batch_func_t)( /**/  void       * RESTRICT params,
+                                      const species_t  * RESTRICT spi,
+                                      const species_t  * RESTRICT spj,
+                                      const particle_t * ALIGNED(128) pi,
+                                      const particle_t * ALIGNED(128) pj,
+                                      const int        * RESTRICT k,
+                                      const int        * RESTRICT l,
+                                      /**/  float      * RESTRICT K,
+                                      int                         n );
+
+typedef void
+(*binary_collision_batch_func_t)( /**/  void       * RESTRICT params,
+                                  const species_t  * RESTRICT spi,
+                                  const species_t  * RESTRICT spj,
+                                  /**/  particle_t * ALIGNED(128) pi,
+                                  /**/  particle_t * ALIGNED(128) pj,
+                                  const int        * RESTRICT k,
+                                  const int        * RESTRICT l,
+                                  const int        * RESTRICT type,
+                                  int                         n,
+                                  /**/  rng_t      * RESTRICT rng );
+
+/* Store the rate constants Kc |ui - uj| of the n pairs pi[k[c]],
+   pj[l[c]] in K[0:n-1] (the rate constant of hard_sphere and
+   large_angle_coulomb, for use by binary_rate_constant_batch_func_t).
+   This uses the widest v4, v8 or v16 kernel of the build (see
+   simd_width with run time simd dispatch).  K must be 64 byte
+   aligned. */
+
+void
+binary_speed_rate_constants( const particle_t * RESTRICT pi,
+                             const particle_t * RESTRICT pj,
+                             const int        * RESTRICT k,
+                             const int        * RESTRICT l,
+                             float                       Kc,
+                             /**/  float      * RESTRICT K,
+                             int                         n );
+
+/* Declare a binary collision model with batched microscopic physics.
+   rate_constant_batch or rate_constant must be given and likewise for
+   collision_batch or collision.  Otherwise, as above. */
+
+collision_op_t *
+binary_batch_collision_model( const char       * RESTRICT name,
+                              binary_rate_constant_func_t       rate_constant,
+                              binary_rate_constant_batch_func_t rate_constant_batch,
+                              binary_collision_func_t           collision,
+                              binary_collision_batch_func_t     collision_batch,
+                              /**/  void       * RESTRICT params,
+                              /**/  species_t  *          spi,
+                              /**/  species_t  *          spj,
+                              /**/  rng_pool_t * RESTRICT rp,
+                              double                      sample,
+                              int                         interval );
+
 /* In hard_sphere.c */
 
 /* Based on unary_collision_model */
@@ -267,9 +390,9 @@ hard_sphere_fluid( const char * RESTRICT name, /* Model name */
 
 collision_op_t *
 hard_sphere( const char * RESTRICT name, /* Model name */
-             species_t * RESTRICT spi,   /* Species-i */
+             species_t * spi,            /* Species-i */
              const float ri,             /* Species-i p. radius (LENGTH) */
-             species_t * RESTRICT spj,   /* Species-j */
+             species_t * spj,            /* Species-j */
              const float rj,             /* Species-j p. radius (LENGTH) */
              rng_pool_t * RESTRICT rp,   /* Entropy pool */
              const double sample,        /* Sampling density */
@@ -298,13 +421,40 @@ large_angle_coulomb_fluid(
 
 collision_op_t *
 large_angle_coulomb( const char * RESTRICT name, /* Model name */
-                     species_t * RESTRICT spi,   /* Species-i */
-                     species_t * RESTRICT spj,   /* Species-j */
+                     species_t * spi,            /* Species-i */
+                     species_t * spj,            /* Species-j */
                      const float bmax,           /* Impact parameter cutoff */
                      rng_pool_t * RESTRICT rp,   /* Entropy pool */
                      const double sample,        /* Sampling density */
                      const int interval );       /* How often to apply this */
 
+/* In takizuka_abe.c */
+
+/* Cumulative small angle Coulomb collisions between species spi and spj
+   (which can be the same species) by the binary collision method of
+   Takizuka and Abe (J Comput Phys 25, 205, 1977) extended to weighted
+   particles after Nanbu and Yonemura (J Comput Phys 145, 639, 1998).
+   Every interval timesteps, the particles in each voxel are randomly
+   paired up and every pair is scattered by an angle whose tangent of
+   the half angle is normal with variance:
+
+     <tan^2 theta/2> = qi^2 qj^2 n lnL dt interval /
+                       ( 8 pi eps0^2 mu^2 vr^3 )
+
+   where mu is the reduced mass, vr is the relative velocity of the
+   pair and n is the density seen by the pair.  Unlike the Monte-Carlo
+   pair samplers above, every particle is in a pair so the cost is
+   exactly proportional to the number of particles.  This is only
+   intended to be used when the species are non-relativistic. */
+
+collision_op_t *
+takizuka_abe( const char * RESTRICT name, /* Model name */
+              species_t * spi,            /* Species-i */
+              species_t * spj,            /* Species-j (can be spi) */
+              rng_pool_t * RESTRICT rp,   /* Entropy pool */
+              const double ln_lambda,     /* Coulomb logarithm */
+              const int interval );       /* How often to apply this */
+
 END_C_DECLS
 
 #endif /* _collision_h_ */
@@ -39,18 +39,77 @@ new_collision_op_internal( void * params,
 void
 delete_collision_op_internal( collision_op_t * cop );
 
+/* Collision operators draw from counter based streams (see
+   seed_rng_counter) keyed by the step (see RNG_COUNTER_KEY) and named
+   by the operator and a global voxel index (see global_voxel) or a
+   particle (see particle_stream) such that their results do not depend
+   on the number of pipelines or on the domain decomposition.
+   counter_rng_pool_internal returns a pool of N_PIPELINE generators
+   for this, replacing crp if it is NULL or too small (after a restart
+   with more threads). */
+
+rng_pool_t *
+counter_rng_pool_internal( rng_pool_t * crp );
+
+/* Voxel based operators (binary and Takizuka-Abe) name the streams of
+   a voxel by its global index.  As sort_p leaves the particles of a
+   voxel in an order that depends on the decomposition, they first put
+   them in a canonical order with order_voxel_internal, which sorts the
+   n particles p[0:n-1] of the voxel with global index gv of the species
+   with identity word id in place by a 64-bit key each particle draws
+   from its own stream (s0 and particle_stream) of key.  It costs O(n) (a radix sort of the keys
+   and an in place permutation), so ordering every voxel is linear in
+   the number of particles at any density.  The result is a uniformly
+   random permutation that only depends on the states of the particles
+   (keys only tie for identical states, barring a 2^-64 chance).
+   scratch is the space of the calling pipeline (see
+   voxel_scratch_t). */
+
+typedef struct voxel_scratch {
+  char * mem;   // N_PIPELINE scratch spaces of sz bytes
+  size_t sz;    // Bytes per pipeline
+  size_t n_mem; // Bytes allocated
+} voxel_scratch_t;
+
+/* Grow vs such that each pipeline can order the most crowded voxel of
+   spi and spj (which must be sorted).  A voxel_scratch_t is not
+   checkpointed; clear it on restore. */
+
+void
+size_voxel_scratch_internal( voxel_scratch_t * vs,
+                             const species_t * spi,
+                             const species_t * spj );
+
+void
+delete_voxel_scratch_internal( voxel_scratch_t * vs );
+
+void
+order_voxel_internal( particle_t * RESTRICT p,
+                      int n,
+                      int64_t gv,
+                      uint32_t id,
+                      uint64_t key,
+                      uint32_t s0,
+                      void * RESTRICT scratch );
+
 END_C_DECLS
 
 ///////////////////////////////////////////////////////////////////////////////
 // Langevin pipeline interface
 
+enum { LANGEVIN_BATCH = 256 }; // Particles per batch of normals
+
 typedef struct langevin_pipeline_args {
   MEM_PTR( particle_t, 128 ) p;
-  MEM_PTR( rng_t,      128 ) rng[ MAX_PIPELINE ];
+  global_voxel_map_t map; // Global voxel indices of the local voxels
+  uint64_t key;    // Counter stream key (see RNG_COUNTER_KEY) ...
+  uint32_t stream; // ... and operator
+  uint32_t id;     // Species identity word (see particle_stream)
   float decay; 
   float drive;
   int np;
-  PAD_STRUCT( (1+MAX_PIPELINE)*SIZEOF_MEM_PTR+2*sizeof(float)+sizeof(int) )
+  PAD_STRUCT( SIZEOF_MEM_PTR+sizeof(global_voxel_map_t)+sizeof(uint64_t)+
+              2*sizeof(uint32_t)+2*sizeof(float)+sizeof(int) )
 } langevin_pipeline_args_t;
 
 // PROTOTYPE_PIPELINE( langevin, langevin_pipeline_args_t );
@@ -109,6 +109,30 @@ hard_sphere_fluid_rate_constant( const hard_sphere_t * RESTRICT hs,
                (hs->ut2+ur2*gamma));
 }
 
+/* The same over a block of particles (straight line code the compiler
+   can vectorize). */
+
+void
+hard_sphere_fluid_rate_constant_batch( const hard_sphere_t * RESTRICT hs,
+                                       const species_t     * RESTRICT spi,
+                                       const particle_t    * RESTRICT pi,
+                                       /**/  float         * RESTRICT k,
+                                       int                            n ) {
+  static const float gamma = (3.*M_PI-8.)/(24.-6*M_PI);
+  const float udx = hs->udx, udy = hs->udy, udz = hs->udz;
+  const float a = hs->alpha_Kt2ut4, b = hs->beta_Kt2ut2, c = hs->gamma_Kt2;
+  const float ut2 = hs->ut2;
+  float urx, ury, urz, ur2;
+  int i;
+  for( i=0; i<n; i++ ) {
+    urx  = pi[i].ux - udx;
+    ury  = pi[i].uy - udy;
+    urz  = pi[i].uz - udz;
+    ur2  = urx*urx + ury*ury + urz*urz;
+    k[i] = sqrtf((a+ur2*(b+ur2*c))/(ut2+ur2*gamma));
+  }
+}
+
 /* The particle-particle case is much easier theoretically. */
 
 float
@@ -123,6 +147,22 @@ hard_sphere_rate_constant( const hard_sphere_t * RESTRICT hs,
   return hs->Kc*sqrtf( urx*urx + ury*ury + urz*urz );
 }
 
+/* The same over a block of candidate pairs (with the v4, v8 or v16
+   kernels of binary_speed_rate_constants). */
+
+void
+hard_sphere_rate_constant_batch( const hard_sphere_t * RESTRICT hs,
+                                 const species_t     * RESTRICT spi,
+                                 const species_t     * RESTRICT spj,
+                                 const particle_t    *          pi,
+                                 const particle_t    *          pj,
+                                 const int           * RESTRICT k,
+                                 const int           * RESTRICT l,
+                                 /**/  float         * RESTRICT K,
+                                 int                            n) {
+  binary_speed_rate_constants( pi, pj, k, l, hs->Kc, K, n );
+}
+
 /* Conservation of momentum, pi0+pj0 = pi1+pj1, implies that the
    center of mass velocity vcm = (pi+pj)/(mi+mj) is unchanged by the
    collision.  In an elastic collision, conservation of energy further
@@ -387,17 +427,18 @@ hard_sphere_fluid( const char * RESTRICT name, /* Model name */
   hs->ut2          += FLT_MIN;
 
   REGISTER_OBJECT( hs, checkpt_hard_sphere, restore_hard_sphere, NULL );
-  return unary_collision_model( name,
-                   (unary_rate_constant_func_t)hard_sphere_fluid_rate_constant,
-                   (unary_collision_func_t)    hard_sphere_fluid_collision,
-                                hs, sp, rp, interval );
+  return unary_batch_collision_model( name,
+             (unary_rate_constant_func_t)      hard_sphere_fluid_rate_constant,
+             (unary_rate_constant_batch_func_t)hard_sphere_fluid_rate_constant_batch,
+             (unary_collision_func_t)          hard_sphere_fluid_collision,
+                                      NULL, hs, sp, rp, interval );
 }
 
 collision_op_t *
 hard_sphere( const char * RESTRICT name, /* Model name */
-             species_t * RESTRICT spi,   /* Species-i */
+             species_t * spi,            /* Species-i */
              const float ri,             /* Species-i p. radius (LENGTH) */
-             species_t * RESTRICT spj,   /* Species-j */
+             species_t * spj,            /* Species-j */
              const float rj,             /* Species-j p. radius (LENGTH) */
              rng_pool_t * RESTRICT rp,   /* Entropy pool */
              const double sample,        /* Sampling density */
@@ -414,9 +455,20 @@ hard_sphere( const char * RESTRICT name, /* Model name */
   hs->Kc       = spi->g->cvac*M_PI*(ri+rj)*(ri+rj);
 
   REGISTER_OBJECT( hs, checkpt_hard_sphere, restore_hard_sphere, NULL );
-  return binary_collision_model( name,
-                        (binary_rate_constant_func_t)hard_sphere_rate_constant,
-                        (binary_collision_func_t)    hard_sphere_collision,
-                                 hs, spi, spj, rp, sample, interval );
+  return binary_batch_collision_model( name,
+                  (binary_rate_constant_func_t)      hard_sphere_rate_constant,
+                  (binary_rate_constant_batch_func_t)hard_sphere_rate_constant_batch,
+                  (binary_collision_func_t)          hard_sphere_collision,
+                                       NULL, hs, spi, spj, rp, sample, interval );
 }
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( hard_sphere_fluid_rate_constant )
+REGISTER_SYMBOL( hard_sphere_fluid_rate_constant_batch )
+REGISTER_SYMBOL( hard_sphere_rate_constant )
+REGISTER_SYMBOL( hard_sphere_rate_constant_batch )
+REGISTER_SYMBOL( hard_sphere_fluid_collision )
+REGISTER_SYMBOL( hard_sphere_collision )
+REGISTER_SYMBOL( checkpt_hard_sphere )
+REGISTER_SYMBOL( restore_hard_sphere )
@@ -87,3 +87,10 @@ langevin( float kT,
                                     ( restore_func_t ) restore_langevin,
                                     NULL );
 }
+
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( apply_langevin )
+REGISTER_SYMBOL( delete_langevin )
+REGISTER_SYMBOL( checkpt_langevin )
+REGISTER_SYMBOL( restore_langevin )
@@ -12,7 +12,11 @@ typedef struct langevin
   int interval;
 } langevin_t;
 
+BEGIN_C_DECLS
+
 void
 apply_langevin_pipeline( langevin_t * l );
 
+END_C_DECLS
+
 #endif /* _langevin_h_ */
@@ -37,6 +37,23 @@ large_angle_coulomb_rate_constant(
   return lac->Kc*sqrtf( urx*urx + ury*ury + urz*urz );
 }
 
+/* The same over a block of candidate pairs (with the v4, v8 or v16
+   kernels of binary_speed_rate_constants). */
+
+void
+large_angle_coulomb_rate_constant_batch(
+    const large_angle_coulomb_t * RESTRICT lac,
+    const species_t             * RESTRICT spi,
+    const species_t             * RESTRICT spj,
+    const particle_t            *          pi,
+    const particle_t            *          pj,
+    const int                   * RESTRICT k,
+    const int                   * RESTRICT l,
+    /**/  float                 * RESTRICT K,
+    int                                    n) {
+  binary_speed_rate_constants( pi, pj, k, l, lac->Kc, K, n );
+}
+
 /* See hard_sphere.c for a derivation of the basic structure of this.
 
    The only difference is that, in a large angle Coulomb collision,
@@ -250,8 +267,8 @@ large_angle_coulomb_fluid(
 
 collision_op_t *
 large_angle_coulomb( const char * RESTRICT name, /* Model name */
-                     species_t * RESTRICT spi,   /* Species-i */
-                     species_t * RESTRICT spj,   /* Species-j */
+                     species_t * spi,            /* Species-i */
+                     species_t * spj,            /* Species-j */
                      const float bmax,           /* Impact parameter cutoff */
                      rng_pool_t * RESTRICT rp,   /* Entropy pool */
                      const double sample,        /* Sampling density */
@@ -272,9 +289,19 @@ large_angle_coulomb( const char * RESTRICT name, /* Model name */
   REGISTER_OBJECT( lac,
                    checkpt_large_angle_coulomb,
                    restore_large_angle_coulomb, NULL );
-  return binary_collision_model( name,
-                (binary_rate_constant_func_t)large_angle_coulomb_rate_constant,
-                (binary_collision_func_t)    large_angle_coulomb_collision,
-                                 lac, spi, spj, rp, sample, interval );
+  return binary_batch_collision_model( name,
+          (binary_rate_constant_func_t)      large_angle_coulomb_rate_constant,
+          (binary_rate_constant_batch_func_t)large_angle_coulomb_rate_constant_batch,
+          (binary_collision_func_t)          large_angle_coulomb_collision,
+                                       NULL, lac, spi, spj, rp, sample, interval );
 }
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( large_angle_coulomb_fluid_rate_constant )
+REGISTER_SYMBOL( large_angle_coulomb_rate_constant )
+REGISTER_SYMBOL( large_angle_coulomb_rate_constant_batch )
+REGISTER_SYMBOL( large_angle_coulomb_fluid_collision )
+REGISTER_SYMBOL( large_angle_coulomb_collision )
+REGISTER_SYMBOL( checkpt_large_angle_coulomb )
+REGISTER_SYMBOL( restore_large_angle_coulomb )
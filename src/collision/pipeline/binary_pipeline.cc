@@ -0,0 +1,381 @@
+#define IN_collision
+
+/* #define HAS_V4_PIPELINE */
+
+#include "collision_pipeline.h"
+
+#include "../binary.h"
+
+#include "../../util/pipelines/pipelines_exec.h"
+
+/* FIXME: ADD SAMPLE TO UNARY */
+
+/* Private interface *********************************************************/
+
+/* Compute the probability that a physical particle in the species
+   whose candidate computational particle has the least weight (and
+   comoving with this computational particle) will collide off a beam
+   of physical particles of the density and momentum of the
+   computational particle in the other species.  If this probability is
+   bigger than one, make a note for diagnostic use.
+
+   If k and l have a collision, determine which computational particles
+   should be updated by the collision process.  We should always update
+   the particle of least weight.  The other particle should be updated
+   with probability of w_min / w_max, such that, on average, detailed
+   balance is preserved.
+
+   The rate constants in pr are replaced by the probabilities and the
+   number of large probabilities is returned.  This is a separate
+   function so the particles can be restrict qualified (they are only
+   read here, so this holds for intraspecies pairs too) and the pass
+   vectorizes. */
+
+static int
+binary_collision_tests( const particle_t * RESTRICT pi,
+                        const particle_t * RESTRICT pj,
+                        const int        * RESTRICT k,
+                        const int        * RESTRICT l,
+                        /**/  float      * RESTRICT pr,
+                        const float      * RESTRICT ut,
+                        /**/  int        * RESTRICT type,
+                        float                       pr_norm,
+                        int                         n )
+{
+  float wk, wl, w_max, w_min, pr_coll;
+  int c, t, n_large_pr = 0;
+
+  for( c=0; c<n; c++ )
+  {
+    wk          = pi[k[c]].w;
+    wl          = pj[l[c]].w;
+    w_max       = (wk>wl) ? wk : wl;
+    w_min       = (wk>wl) ? wl : wk;
+    pr_coll     = w_max * pr_norm * pr[c];
+    n_large_pr += pr_coll > 1;
+    pr[c]       = pr_coll;
+    t           = 1 + ( wl==w_min );
+    type[c]     = ( ( w_max==w_min ) | ( w_max*ut[c]<w_min ) ) ? 3 : t;
+  }
+
+  return n_large_pr;
+}
+
+/* Rate constants Kc |ui - uj| with the widest kernel of this build (see
+   collision.h).  With run time simd dispatch, the kernel is picked by
+   simd_width like the pipelines of SELECT_PIPELINE. */
+
+void
+binary_speed_rate_constants( const particle_t * RESTRICT pi,
+                             const particle_t * RESTRICT pj,
+                             const int        * RESTRICT k,
+                             const int        * RESTRICT l,
+                             float                       Kc,
+                             /**/  float      * RESTRICT K,
+                             int                         n )
+{
+  float urx, ury, urz;
+  int c;
+
+#if defined(VPIC_SIMD_DISPATCH)
+# if defined(VPIC_SIMD_DISPATCH_V16)
+  if ( simd_width >= 16 )
+  {
+    binary_speed_rate_constants_v16( pi, pj, k, l, Kc, K, n );
+    return;
+  }
+# endif
+# if defined(VPIC_SIMD_DISPATCH_V8)
+  if ( simd_width >= 8 )
+  {
+    binary_speed_rate_constants_v8( pi, pj, k, l, Kc, K, n );
+    return;
+  }
+# endif
+# if defined(V4_ACCELERATION)
+  if ( simd_width >= 4 )
+  {
+    binary_speed_rate_constants_v4( pi, pj, k, l, Kc, K, n );
+    return;
+  }
+# endif
+#elif defined(V16_ACCELERATION)
+  binary_speed_rate_constants_v16( pi, pj, k, l, Kc, K, n );
+  return;
+#elif defined(V8_ACCELERATION)
+  binary_speed_rate_constants_v8( pi, pj, k, l, Kc, K, n );
+  return;
+#elif defined(V4_ACCELERATION)
+  binary_speed_rate_constants_v4( pi, pj, k, l, Kc, K, n );
+  return;
+#endif
+
+  for( c=0; c<n; c++ )
+  {
+    urx  = pi[k[c]].ux - pj[l[c]].ux;
+    ury  = pi[k[c]].uy - pj[l[c]].uy;
+    urz  = pi[k[c]].uz - pj[l[c]].uz;
+    K[c] = Kc*sqrtf( urx*urx + ury*ury + urz*urz );
+  }
+}
+
+void
+binary_pipeline_scalar( binary_collision_model_t * RESTRICT cm,
+                        int pipeline_rank,
+                        int n_pipeline )
+{
+  if ( pipeline_rank == n_pipeline )
+  {
+    return; /* No host straggler cleanup */
+  }
+
+  binary_rate_constant_func_t       rate_constant       = cm->rate_constant;
+  binary_collision_func_t           collision           = cm->collision;
+  binary_rate_constant_batch_func_t rate_constant_batch = cm->rate_constant_batch;
+  binary_collision_batch_func_t     collision_batch     = cm->collision_batch;
+
+  /**/  void       * RESTRICT params        = cm->params;
+  /**/  species_t  *          spi           = cm->spi;
+  /**/  species_t  *          spj           = cm->spj;
+  /**/  rng_t      * RESTRICT rng           = cm->crp->rng[ pipeline_rank ];
+  const uint64_t              key           = RNG_COUNTER_KEY( cm->rp, spi->g->step );
+  /**/  char       *            scratch       = cm->scratch.mem +
+                                                cm->scratch.sz*pipeline_rank;
+
+  /**/  particle_t *          spi_p         = spi->p;
+  const int        * RESTRICT spi_partition = spi->partition;
+  const grid_t     * RESTRICT g             = spi->g;
+
+  /**/  particle_t *          spj_p         = spj->p;
+  const int        * RESTRICT spj_partition = spj->partition;
+
+  const double sample        = (spi_p==spj_p ? 0.5 : 1)*cm->sample;
+  const float  dtinterval_dV = ( g->dt * (float)cm->interval ) / g->dV;
+
+  DECLARE_ALIGNED_ARRAY( uint32_t, 64, uk,   BINARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( uint32_t, 64, ul,   BINARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( int,      64, k,    BINARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( int,      64, l,    BINARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, K,    BINARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, uc,   BINARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, ut,   BINARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( int,      64, type, BINARY_BATCH );
+
+  global_voxel_map_t map[1];
+  int64_t gv;
+  float pr_norm;
+  int v, v1, k0, nk, l0, nl, np, nc, n, c, m, n_large_pr = 0;
+
+  global_voxel_map( map, g );
+
+  /* Stripe the (mostly non-ghost) voxels over threads for load balance.
+     The partitions are indexed by voxel storage order (see g->sfc);
+     every voxel that can hold particles is at or below sfc_hi.  The
+     particles of a voxel are put in canonical order (see
+     order_voxel_internal) and its pairs and their collisions are then
+     drawn from the counter stream of the model and the global index of
+     the voxel, so the result does not depend on the number of
+     pipelines or on the domain decomposition. */
+
+  v  = pipeline_rank;
+  v1 = g->sfc_hi + 1;
+
+  for( ; v<v1; v+=n_pipeline )
+  {
+    /* Find the species i computational particles, k, and the species j
+       computational particles, l, in this voxel, determine the number
+       of computational particle pairs, np and the number of candidate
+       pairs, nc, to test for collisions within this voxel. */
+
+    k0 = spi_partition[v  ];
+    nk = spi_partition[v+1] - k0;
+    if( !nk ) continue; /* Nothing to do */
+
+    if ( spi == spj )
+    {
+      /* For intraspecies collisions:
+           np = nk(nk+1)/2
+         and:
+           nc = round( sample nk / 2 )
+         such that, for sample==1, on average every particle is tested
+         for collision once.  Note that the below pair sampling method
+         allows for the possibility of a computational particle
+         colliding with itself.  This isn't so silly when considering
+         that a computational particle represents many physical
+         particles.  At the same time, most microscopic physics
+         processes will give a zero collision rate constant for such as
+         the implied colliding physical particles are comoving. */
+
+      l0 = k0;
+      nl = nk;
+      np = nk*(nk+1) >> 1;
+      nc = (int)( 0.5 + sample*(double)nk );
+    }
+
+    else
+    {
+      /* For interspecies collisions:
+           np = nk nl
+         and:
+           nc = round( sample max( nk, nl ) )
+         such that, for sample==1, on average every particle is tested
+         for collision at least once. */
+
+      l0 = spj_partition[v  ];
+      nl = spj_partition[v+1] - l0;
+      if( !nl ) continue; /* Nothing to do */
+      np = nk*nl;
+      nc = (int)( 0.5 + sample*(double)(nk>nl ? nk : nl) );
+    }
+
+    /* Determine the collision rate to probability normalization:
+         pr_norm = ( dt interval np ) / ( dV nc ) */
+
+    pr_norm = dtinterval_dV*((float)np / (float)nc);
+
+    gv = global_voxel( map, spi_p[k0].i );
+
+    order_voxel_internal( spi_p + k0, nk, gv, (uint32_t) spi->id, key,
+                          ~cm->stream, scratch );
+    if ( spi != spj )
+    {
+      order_voxel_internal( spj_p + l0, nl, gv, (uint32_t) spj->id, key,
+                            ~cm->stream, scratch );
+    }
+
+    seed_rng_counter( rng, key, cm->stream, (uint32_t) gv,
+                      (uint32_t) ( (uint64_t) gv >> 32 ) );
+
+    /* Test the candidate pairs BINARY_BATCH at a time.  Each step
+       below is a branchless pass over the pairs of the batch such that
+       pair sampling, rate constant evaluation and the collision tests
+       vectorize. */
+
+    for( ; nc; nc-=n )
+    {
+      n = nc < BINARY_BATCH ? nc : BINARY_BATCH;
+
+      /* Pick the pairs of computational particles uniformly at random
+         from all pairs of particles in the voxel.  A 32-bit deviate u
+         is mapped onto 0:nk-1 by the high word of u nk (this uses the
+         preferred high order randgen bits and its bias is at most
+         nk/2^32). */
+
+      uirand_fill( rng, uk, 1, n );
+      uirand_fill( rng, ul, 1, n );
+
+      for( c=0; c<n; c++ )
+      {
+        k[c] = k0 + (int)( ( (uint64_t)uk[c]*(uint64_t)nk ) >> 32 );
+        l[c] = l0 + (int)( ( (uint64_t)ul[c]*(uint64_t)nl ) >> 32 );
+      }
+
+      /* Compute the rate constants of the pairs.  These are all
+         computed before any pair of the batch collides. */
+
+      if ( rate_constant_batch )
+      {
+        rate_constant_batch( params, spi, spj, spi_p, spj_p, k, l, K, n );
+      }
+
+      else
+      {
+        for( c=0; c<n; c++ )
+        {
+          K[c] = rate_constant( params, spi, spj, &spi_p[k[c]],
+                                &spj_p[l[c]] );
+        }
+      }
+
+      frand_c0_fill( rng, uc, 1, n );
+      frand_c0_fill( rng, ut, 1, n );
+
+      /* Determine the collision probabilities and the update types
+         of the pairs (see binary_collision_tests).  Yes, < so that 0
+         rate constants guarantee no collision and yes, _c0, so that 1
+         probabilities guarantee a collision.  The pairs that collided
+         are then packed at the front of k, l and type (in order). */
+
+      n_large_pr += binary_collision_tests( spi_p, spj_p, k, l, K, ut, type,
+                                            pr_norm, n );
+
+      for( c=0, m=0; c<n; c++ )
+      {
+        k[m]    = k[c];
+        l[m]    = l[c];
+        type[m] = type[c];
+        m      += uc[c] < K[c];
+      }
+
+      if ( collision_batch )
+      {
+        if ( m )
+        {
+          collision_batch( params, spi, spj, spi_p, spj_p, k, l, type, m,
+                           rng );
+        }
+      }
+
+      else
+      {
+        for( c=0; c<m; c++ )
+        {
+          collision( params, spi, spj, &spi_p[k[c]], &spj_p[l[c]], rng,
+                     type[c] );
+        }
+      }
+    }
+  }
+
+  cm->n_large_pr[pipeline_rank] = n_large_pr;
+}
+
+void
+apply_binary_collision_model_pipeline( binary_collision_model_t * cm )
+{
+  int p, n_large_pr = 0;
+
+  if ( cm->interval < 1 || ( cm->spi->g->step % cm->interval ) )
+  {
+    return;
+  }
+
+  if ( cm->spi->last_sorted != cm->spi->g->step )
+  {
+    sort_p( cm->spi );
+  }
+
+  if ( cm->spj->last_sorted != cm->spi->g->step )
+  {
+    sort_p( cm->spj );
+  }
+
+  // The collision kernels work on particle_t
+
+  convert_p( cm->spi, particle_layout_aos );
+  convert_p( cm->spj, particle_layout_aos );
+
+  cm->crp = counter_rng_pool_internal( cm->crp );
+
+  size_voxel_scratch_internal( &cm->scratch, cm->spi, cm->spj );
+
+  EXEC_PIPELINES( binary, cm, 0 );
+
+  WAIT_PIPELINES();
+
+  for( p = 0; p < N_PIPELINE; p++ )
+  {
+    n_large_pr += cm->n_large_pr[p];
+  }
+
+  if ( n_large_pr )
+  {
+    WARNING( ( "%i computational particle pairs between species \"%s\" and "
+               "species \"%s\" encountered a large collision probability in "
+               "collision model \"%s\".  The collision rate for such pairs "
+               "will be lower than it should be physically.  Consider lowering "
+               "the collision operator interval, increasing the sampling or "
+               "reducing the timestep.",
+               n_large_pr, cm->spi->name, cm->spj->name, cm->name ) );
+  }
+}
@@ -0,0 +1,69 @@
+#define IN_collision
+
+#include "collision_pipeline.h"
+
+#include "../../util/pipelines/pipelines_exec.h"
+
+#if defined(V4_ACCELERATION)
+
+using namespace v4;
+
+// Rate constants Kc |ui - uj| of the pairs 4 at a time (see
+// binary_speed_rate_constants in binary_pipeline.cc).  The momenta and
+// weights of 4 particles are gathered with a transposing load.
+
+void
+binary_speed_rate_constants_v4( const particle_t * RESTRICT pi,
+                                const particle_t * RESTRICT pj,
+                                const int        * RESTRICT k,
+                                const int        * RESTRICT l,
+                                float                       Kc,
+                                /**/  float      * RESTRICT K,
+                                int                         n )
+{
+  const v4float vKc( Kc );
+
+  v4float uix, uiy, uiz, wi, ujx, ujy, ujz, wj;
+  float urx, ury, urz;
+  int c;
+
+  for( c = 0; c + 4 <= n; c += 4, k += 4, l += 4 )
+  {
+    load_4x4_tr( &pi[k[ 0]].ux, &pi[k[ 1]].ux, &pi[k[ 2]].ux, &pi[k[ 3]].ux,
+                 uix, uiy, uiz, wi );
+
+    load_4x4_tr( &pj[l[ 0]].ux, &pj[l[ 1]].ux, &pj[l[ 2]].ux, &pj[l[ 3]].ux,
+                 ujx, ujy, ujz, wj );
+
+    uix -= ujx;
+    uiy -= ujy;
+    uiz -= ujz;
+
+    store_4x1( vKc*sqrt( uix*uix + uiy*uiy + uiz*uiz ), K + c );
+  }
+
+  for( ; c < n; c++, k++, l++ )
+  {
+    urx  = pi[*k].ux - pj[*l].ux;
+    ury  = pi[*k].uy - pj[*l].uy;
+    urz  = pi[*k].uz - pj[*l].uz;
+    K[c] = Kc*sqrtf( urx*urx + ury*ury + urz*urz );
+  }
+}
+
+#else
+
+void
+binary_speed_rate_constants_v4( const particle_t * RESTRICT pi,
+                                const particle_t * RESTRICT pj,
+                                const int        * RESTRICT k,
+                                const int        * RESTRICT l,
+                                float                       Kc,
+                                /**/  float      * RESTRICT K,
+                                int                         n )
+{
+  // No v4 implementation.
+  ERROR( ( "No binary_speed_rate_constants_v4 implementation." ) );
+}
+
+#endif
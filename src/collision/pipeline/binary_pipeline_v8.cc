@@ -0,0 +1,71 @@
+#define IN_collision
+
+#include "collision_pipeline.h"
+
+#include "../../util/pipelines/pipelines_exec.h"
+
+#if defined(V8_ACCELERATION)
+
+using namespace v8;
+
+// Rate constants Kc |ui - uj| of the pairs 8 at a time (see
+// binary_speed_rate_constants in binary_pipeline.cc).  The momenta and
+// weights of 8 particles are gathered with a transposing load.
+
+void
+binary_speed_rate_constants_v8( const particle_t * RESTRICT pi,
+                                const particle_t * RESTRICT pj,
+                                const int        * RESTRICT k,
+                                const int        * RESTRICT l,
+                                float                       Kc,
+                                /**/  float      * RESTRICT K,
+                                int                         n )
+{
+  const v8float vKc( Kc );
+
+  v8float uix, uiy, uiz, wi, ujx, ujy, ujz, wj;
+  float urx, ury, urz;
+  int c;
+
+  for( c = 0; c + 8 <= n; c += 8, k += 8, l += 8 )
+  {
+    load_8x4_tr( &pi[k[ 0]].ux, &pi[k[ 1]].ux, &pi[k[ 2]].ux, &pi[k[ 3]].ux,
+                 &pi[k[ 4]].ux, &pi[k[ 5]].ux, &pi[k[ 6]].ux, &pi[k[ 7]].ux,
+                 uix, uiy, uiz, wi );
+
+    load_8x4_tr( &pj[l[ 0]].ux, &pj[l[ 1]].ux, &pj[l[ 2]].ux, &pj[l[ 3]].ux,
+                 &pj[l[ 4]].ux, &pj[l[ 5]].ux, &pj[l[ 6]].ux, &pj[l[ 7]].ux,
+                 ujx, ujy, ujz, wj );
+
+    uix -= ujx;
+    uiy -= ujy;
+    uiz -= ujz;
+
+    store_8x1( vKc*sqrt( uix*uix + uiy*uiy + uiz*uiz ), K + c );
+  }
+
+  for( ; c < n; c++, k++, l++ )
+  {
+    urx  = pi[*k].ux - pj[*l].ux;
+    ury  = pi[*k].uy - pj[*l].uy;
+    urz  = pi[*k].uz - pj[*l].uz;
+    K[c] = Kc*sqrtf( urx*urx + ury*ury + urz*urz );
+  }
+}
+
+#else
+
+void
+binary_speed_rate_constants_v8( const particle_t * RESTRICT pi,
+                                const particle_t * RESTRICT pj,
+                                const int        * RESTRICT k,
+                                const int        * RESTRICT l,
+                                float                       Kc,
+                                /**/  float      * RESTRICT K,
+                                int                         n )
+{
+  // No v8 implementation.
+  ERROR( ( "No binary_speed_rate_constants_v8 implementation." ) );
+}
+
+#endif
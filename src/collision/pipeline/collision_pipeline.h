@@ -3,21 +3,111 @@
 
 #include "../binary.h"
 #include "../langevin.h"
+#include "../takizuka_abe.h"
 #include "../unary.h"
 
+BEGIN_C_DECLS
+
 void
 binary_pipeline_scalar( binary_collision_model_t * RESTRICT cm,
                         int pipeline_rank,
                         int n_pipeline );
 
+/* Rate constants Kc |ui - uj| of a batch of pairs (see
+   binary_speed_rate_constants in binary_pipeline.cc). */
+
+void
+binary_speed_rate_constants_v4( const particle_t * RESTRICT pi,
+                                const particle_t * RESTRICT pj,
+                                const int        * RESTRICT k,
+                                const int        * RESTRICT l,
+                                float                       Kc,
+                                /**/  float      * RESTRICT K,
+                                int                         n );
+
+void
+binary_speed_rate_constants_v8( const particle_t * RESTRICT pi,
+                                const particle_t * RESTRICT pj,
+                                const int        * RESTRICT k,
+                                const int        * RESTRICT l,
+                                float                       Kc,
+                                /**/  float      * RESTRICT K,
+                                int                         n );
+
+void
+binary_speed_rate_constants_v16( const particle_t * RESTRICT pi,
+                                 const particle_t * RESTRICT pj,
+                                 const int        * RESTRICT k,
+                                 const int        * RESTRICT l,
+                                 float                       Kc,
+                                 /**/  float      * RESTRICT K,
+                                 int                         n );
+
 void
 langevin_pipeline_scalar( langevin_pipeline_args_t * RESTRICT args,
                           int pipeline_rank,
                           int n_pipeline );
 
+void
+langevin_pipeline_v8( langevin_pipeline_args_t * RESTRICT args,
+                      int pipeline_rank,
+                      int n_pipeline );
+
+void
+langevin_pipeline_v16( langevin_pipeline_args_t * RESTRICT args,
+                       int pipeline_rank,
+                       int n_pipeline );
+
+/* Variance cap of the Takizuka-Abe scatterings.  The variance diverges
+   for comoving pairs (vr -> 0).  Capped, such pairs are still scattered
+   by a large angle (as physically expected) without risking an
+   overflow. */
+
+#define TAKIZUKA_ABE_VAR_MAX 1e8f
+
+/* Scatter a batch of n pairs (see takizuka_abe_pipeline.cc).  The
+   vector kernels also process the lanes past n of their last vector;
+   the batch arrays are TAKIZUKA_ABE_BATCH long and 64 byte aligned. */
+
+typedef void
+(*takizuka_abe_scatter_func_t)( float * RESTRICT uix, float * RESTRICT uiy,
+                                float * RESTRICT uiz, const float * RESTRICT wi,
+                                float * RESTRICT ujx, float * RESTRICT ujy,
+                                float * RESTRICT ujz, const float * RESTRICT wj,
+                                const float * RESTRICT g,
+                                const float * RESTRICT ph,
+                                const float * RESTRICT ut,
+                                float cvar,
+                                float mu_mi,
+                                float mu_mj,
+                                int n );
+
+void
+takizuka_abe_pipeline_internal( takizuka_abe_t * RESTRICT ta,
+                                takizuka_abe_scatter_func_t scatter,
+                                int pipeline_rank,
+                                int n_pipeline );
+
+void
+takizuka_abe_pipeline_scalar( takizuka_abe_t * RESTRICT ta,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+void
+takizuka_abe_pipeline_v8( takizuka_abe_t * RESTRICT ta,
+                          int pipeline_rank,
+                          int n_pipeline );
+
+void
+takizuka_abe_pipeline_v16( takizuka_abe_t * RESTRICT ta,
+                           int pipeline_rank,
+                           int n_pipeline );
+
 void
 unary_pipeline_scalar( unary_collision_model_t * RESTRICT cm,
                        int pipeline_rank,
                        int n_pipeline );
 
+END_C_DECLS
+
 #endif /* _collision_pipeline_h_ */
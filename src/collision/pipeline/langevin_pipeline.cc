@@ -1,5 +1,8 @@
 #define IN_collision
 
+#define HAS_V8_PIPELINE
+#define HAS_V16_PIPELINE
+
 #include "collision_pipeline.h"
 
 #include "../langevin.h"
@@ -8,6 +11,14 @@
 
 /* Private interface *********************************************************/
 
+/* The particles are processed in batches of LANGEVIN_BATCH.  Each
+   particle draws its x, y and z normals from its own counter stream
+   (see particle_stream), so the result does not depend on how the
+   particles are ordered or distributed over the pipelines and processes
+   (the vector variants stage the end of a batch so they give every
+   particle the same arithmetic).  The normals of a batch are drawn in
+   bulk, 4 per particle (the 4th is unused). */
+
 void
 langevin_pipeline_scalar( langevin_pipeline_args_t * RESTRICT args,
                           int pipeline_rank,
@@ -19,20 +30,38 @@ langevin_pipeline_scalar( langevin_pipeline_args_t * RESTRICT args,
   }
 
   particle_t * RESTRICT p     = args->p;
-  rng_t      * RESTRICT rng   = args->rng[ pipeline_rank ];
   float                 decay = args->decay;
   float                 drive = args->drive;
 
-  double n_target = (double)args->np / (double)n_pipeline;
+  DECLARE_ALIGNED_ARRAY( uint32_t, 64, s1, LANGEVIN_BATCH );
+  DECLARE_ALIGNED_ARRAY( uint32_t, 64, s2, LANGEVIN_BATCH );
+  DECLARE_ALIGNED_ARRAY( float, 64, g, 4*LANGEVIN_BATCH );
+
+  int b, nb, i, n, k;
 
-  /**/  int i  = (int)( 0.5 + n_target * (double)  pipeline_rank    );
-  const int i1 = (int)( 0.5 + n_target * (double) (pipeline_rank+1) );
+  DISTRIBUTE( ( args->np + LANGEVIN_BATCH - 1 ) / LANGEVIN_BATCH, 1,
+              pipeline_rank, n_pipeline, b, nb );
 
-  for( ; i < i1; i++ )
+  for( ; nb; b++, nb-- )
   {
-    p[i].ux = decay * p[i].ux + drive * frandn(rng);
-    p[i].uy = decay * p[i].uy + drive * frandn(rng);
-    p[i].uz = decay * p[i].uz + drive * frandn(rng);
+    i = b * LANGEVIN_BATCH;
+    n = args->np - i;
+    if ( n > LANGEVIN_BATCH ) n = LANGEVIN_BATCH;
+
+    for( k = 0; k < n; k++ )
+    {
+      particle_stream( p + i + k, global_voxel( &args->map, p[i+k].i ),
+                       args->id, s1 + k, s2 + k );
+    }
+
+    frandn_stream_fill( args->key, args->stream, s1, s2, g, n );
+
+    for( k = 0; k < n; k++, i++ )
+    {
+      p[i].ux = decay * p[i].ux + drive * g[4*k  ];
+      p[i].uy = decay * p[i].uy + drive * g[4*k+1];
+      p[i].uz = decay * p[i].uz + drive * g[4*k+2];
+    }
   }
 }
 
@@ -98,9 +127,17 @@ apply_langevin_pipeline( langevin_t * l )
 
   DECLARE_ALIGNED_ARRAY( langevin_pipeline_args_t, 128, args, 1 );
 
+  // The collision kernels work on particle_t
+
+  convert_p( l->sp, particle_layout_aos );
+
   args->p     = l->sp->p;
 
-  COPY( args->rng, l->rp->rng, N_PIPELINE );
+  global_voxel_map( &args->map, l->sp->g );
+
+  args->key    = RNG_COUNTER_KEY( l->rp, l->sp->g->step );
+  args->stream = ( (uint32_t) 0x4c << 24 ) | (uint32_t) l->sp->id;
+  args->id     = (uint32_t) l->sp->id;
 
   args->decay = exp( -nudt );
   args->drive = sqrt( ( -expm1( -2 * nudt ) * l->kT ) / ( l->sp->m * l->sp->g->cvac ) );
@@ -0,0 +1,115 @@
+#define IN_collision
+
+#include "collision_pipeline.h"
+
+#include "../../util/pipelines/pipelines_exec.h"
+
+#if defined(V16_ACCELERATION)
+
+using namespace v16;
+
+void
+langevin_pipeline_v16( langevin_pipeline_args_t * RESTRICT args,
+                      int pipeline_rank,
+                      int n_pipeline )
+{
+  if ( pipeline_rank == n_pipeline )
+  {
+    return; /* No host straggler cleanup */
+  }
+
+  particle_t * RESTRICT p     = args->p;
+  float                 decay = args->decay;
+  float                 drive = args->drive;
+
+  const v16float vdecay( decay );
+  const v16float vdrive( drive );
+
+  DECLARE_ALIGNED_ARRAY( uint32_t, 64, s1, LANGEVIN_BATCH );
+  DECLARE_ALIGNED_ARRAY( uint32_t, 64, s2, LANGEVIN_BATCH );
+  DECLARE_ALIGNED_ARRAY( float, 64, g, 4*LANGEVIN_BATCH );
+  DECLARE_ALIGNED_ARRAY( particle_t, 64, t, 16 );
+
+  particle_t * q;
+
+  v16float ux, uy, uz, w, gx, gy, gz, gw;
+
+  int b, nb, i, n, k, m, c;
+
+  DISTRIBUTE( ( args->np + LANGEVIN_BATCH - 1 ) / LANGEVIN_BATCH, 1,
+              pipeline_rank, n_pipeline, b, nb );
+
+  for( ; nb; b++, nb-- )
+  {
+    i = b * LANGEVIN_BATCH;
+    n = args->np - i;
+    if ( n > LANGEVIN_BATCH ) n = LANGEVIN_BATCH;
+
+    for( k = 0; k < n; k++ )
+    {
+      particle_stream( p + i + k, global_voxel( &args->map, p[i+k].i ),
+                       args->id, s1 + k, s2 + k );
+    }
+
+    frandn_stream_fill( args->key, args->stream, s1, s2, g, n );
+
+    // Process the particles of the batch 16 at a time.  The rest of
+    // the last batch is staged through a padded block so every particle
+    // gets the same arithmetic wherever it sits in the batch.
+
+    for( c = 4*n; c < 4*( ( n + 15 ) & ~15 ); c++ ) g[c] = 0;
+
+    for( k = 0; k < n; k += 16, i += 16 )
+    {
+      q = p + i;
+      m = n - k;
+
+      if ( m < 16 )
+      {
+        for( c = 0; c < m;  c++ ) t[c] = q[c];
+        for( ;      c < 16; c++ ) t[c] = q[0];
+        q = t;
+      }
+
+      load_16x4_tr( &q[ 0].ux, &q[ 1].ux, &q[ 2].ux, &q[ 3].ux,
+                    &q[ 4].ux, &q[ 5].ux, &q[ 6].ux, &q[ 7].ux,
+                    &q[ 8].ux, &q[ 9].ux, &q[10].ux, &q[11].ux,
+                    &q[12].ux, &q[13].ux, &q[14].ux, &q[15].ux,
+                    ux, uy, uz, w );
+
+      load_16x4_tr( g + 4*k +  0, g + 4*k +  4, g + 4*k +  8, g + 4*k + 12,
+                    g + 4*k + 16, g + 4*k + 20, g + 4*k + 24, g + 4*k + 28,
+                    g + 4*k + 32, g + 4*k + 36, g + 4*k + 40, g + 4*k + 44,
+                    g + 4*k + 48, g + 4*k + 52, g + 4*k + 56, g + 4*k + 60,
+                    gx, gy, gz, gw );
+
+      ux = vdecay * ux + vdrive * gx;
+      uy = vdecay * uy + vdrive * gy;
+      uz = vdecay * uz + vdrive * gz;
+
+      store_16x4_tr( ux, uy, uz, w,
+                     &q[ 0].ux, &q[ 1].ux, &q[ 2].ux, &q[ 3].ux,
+                     &q[ 4].ux, &q[ 5].ux, &q[ 6].ux, &q[ 7].ux,
+                     &q[ 8].ux, &q[ 9].ux, &q[10].ux, &q[11].ux,
+                     &q[12].ux, &q[13].ux, &q[14].ux, &q[15].ux );
+
+      if ( m < 16 )
+      {
+        for( c = 0; c < m; c++ ) p[i+c] = t[c];
+      }
+    }
+  }
+}
+
+#else
+
+void
+langevin_pipeline_v16( langevin_pipeline_args_t * RESTRICT args,
+                      int pipeline_rank,
+                      int n_pipeline )
+{
+  // No v16 implementation.
+  ERROR( ( "No langevin_pipeline_v16 implementation." ) );
+}
+
+#endif
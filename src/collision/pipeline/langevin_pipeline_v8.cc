@@ -0,0 +1,109 @@
+#define IN_collision
+
+#include "collision_pipeline.h"
+
+#include "../../util/pipelines/pipelines_exec.h"
+
+#if defined(V8_ACCELERATION)
+
+using namespace v8;
+
+void
+langevin_pipeline_v8( langevin_pipeline_args_t * RESTRICT args,
+                      int pipeline_rank,
+                      int n_pipeline )
+{
+  if ( pipeline_rank == n_pipeline )
+  {
+    return; /* No host straggler cleanup */
+  }
+
+  particle_t * RESTRICT p     = args->p;
+  float                 decay = args->decay;
+  float                 drive = args->drive;
+
+  const v8float vdecay( decay );
+  const v8float vdrive( drive );
+
+  DECLARE_ALIGNED_ARRAY( uint32_t, 64, s1, LANGEVIN_BATCH );
+  DECLARE_ALIGNED_ARRAY( uint32_t, 64, s2, LANGEVIN_BATCH );
+  DECLARE_ALIGNED_ARRAY( float, 64, g, 4*LANGEVIN_BATCH );
+  DECLARE_ALIGNED_ARRAY( particle_t, 64, t, 8 );
+
+  particle_t * q;
+
+  v8float ux, uy, uz, w, gx, gy, gz, gw;
+
+  int b, nb, i, n, k, m, c;
+
+  DISTRIBUTE( ( args->np + LANGEVIN_BATCH - 1 ) / LANGEVIN_BATCH, 1,
+              pipeline_rank, n_pipeline, b, nb );
+
+  for( ; nb; b++, nb-- )
+  {
+    i = b * LANGEVIN_BATCH;
+    n = args->np - i;
+    if ( n > LANGEVIN_BATCH ) n = LANGEVIN_BATCH;
+
+    for( k = 0; k < n; k++ )
+    {
+      particle_stream( p + i + k, global_voxel( &args->map, p[i+k].i ),
+                       args->id, s1 + k, s2 + k );
+    }
+
+    frandn_stream_fill( args->key, args->stream, s1, s2, g, n );
+
+    // Process the particles of the batch 8 at a time.  The rest of
+    // the last batch is staged through a padded block so every particle
+    // gets the same arithmetic wherever it sits in the batch.
+
+    for( c = 4*n; c < 4*( ( n + 7 ) & ~7 ); c++ ) g[c] = 0;
+
+    for( k = 0; k < n; k += 8, i += 8 )
+    {
+      q = p + i;
+      m = n - k;
+
+      if ( m < 8 )
+      {
+        for( c = 0; c < m;  c++ ) t[c] = q[c];
+        for( ;      c < 8; c++ ) t[c] = q[0];
+        q = t;
+      }
+
+      load_8x4_tr( &q[0].ux, &q[1].ux, &q[2].ux, &q[3].ux,
+                   &q[4].ux, &q[5].ux, &q[6].ux, &q[7].ux,
+                   ux, uy, uz, w );
+
+      load_8x4_tr( g + 4*k +  0, g + 4*k +  4, g + 4*k +  8, g + 4*k + 12,
+                   g + 4*k + 16, g + 4*k + 20, g + 4*k + 24, g + 4*k + 28,
+                   gx, gy, gz, gw );
+
+      ux = vdecay * ux + vdrive * gx;
+      uy = vdecay * uy + vdrive * gy;
+      uz = vdecay * uz + vdrive * gz;
+
+      store_8x4_tr( ux, uy, uz, w,
+                    &q[0].ux, &q[1].ux, &q[2].ux, &q[3].ux,
+                    &q[4].ux, &q[5].ux, &q[6].ux, &q[7].ux );
+
+      if ( m < 8 )
+      {
+        for( c = 0; c < m; c++ ) p[i+c] = t[c];
+      }
+    }
+  }
+}
+
+#else
+
+void
+langevin_pipeline_v8( langevin_pipeline_args_t * RESTRICT args,
+                      int pipeline_rank,
+                      int n_pipeline )
+{
+  // No v8 implementation.
+  ERROR( ( "No langevin_pipeline_v8 implementation." ) );
+}
+
+#endif
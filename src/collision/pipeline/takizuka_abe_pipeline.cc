@@ -0,0 +1,369 @@
+#define IN_collision
+
+#define HAS_V8_PIPELINE
+#define HAS_V16_PIPELINE
+
+#include "collision_pipeline.h"
+
+#include "../takizuka_abe.h"
+
+#include "../../util/pipelines/pipelines_exec.h"
+
+/* Private interface *********************************************************/
+
+/* Gather the momenta and weights of the n pairs pi[k[c]], pj[l[c]]. */
+
+static void
+gather_pairs( const particle_t * RESTRICT pi,
+              const particle_t * RESTRICT pj,
+              const int        * RESTRICT k,
+              const int        * RESTRICT l,
+              float * RESTRICT uix, float * RESTRICT uiy,
+              float * RESTRICT uiz, float * RESTRICT wi,
+              float * RESTRICT ujx, float * RESTRICT ujy,
+              float * RESTRICT ujz, float * RESTRICT wj,
+              int n )
+{
+  int c;
+
+  for( c = 0; c < n; c++ )
+  {
+    uix[c] = pi[k[c]].ux, ujx[c] = pj[l[c]].ux;
+    uiy[c] = pi[k[c]].uy, ujy[c] = pj[l[c]].uy;
+    uiz[c] = pi[k[c]].uz, ujz[c] = pj[l[c]].uz;
+    wi[c]  = pi[k[c]].w,  wj[c]  = pj[l[c]].w;
+  }
+}
+
+/* Scatter the n pairs.  Following Takizuka and Abe, the relative
+   momentum ur = ui - uj of a pair is rotated by theta, where
+   tan(theta/2) is a normal deviate of variance:
+
+     cvar max( wi, wj ) / |ur|^3
+
+   (cvar includes the density normalization, see takizuka_abe.c), about
+   a uniformly random azimuth phi.  Noting that:
+
+     sin theta     = 2 tan(theta/2) / ( 1 + tan^2(theta/2) )
+     1 - cos theta = 2 tan^2(theta/2) / ( 1 + tan^2(theta/2) )
+
+   the change in ur is (with urP = sqrt( urx^2 + ury^2 )):
+
+     dux =  (urx/urP) urz sin theta cos phi
+          - (ury/urP) |ur| sin theta sin phi - urx ( 1 - cos theta )
+     duy =  (ury/urP) urz sin theta cos phi
+          + (urx/urP) |ur| sin theta sin phi - ury ( 1 - cos theta )
+     duz = -urP sin theta cos phi - urz ( 1 - cos theta )
+
+   For urP = 0, urx/urP and ury/urP are replaced by 1 and 0 (any unit
+   vector perpendicular to ur works).  Conservation of momentum gives:
+
+     ui1 = ui0 + (mu/mi) du
+     uj1 = uj0 - (mu/mj) du
+
+   With weighted particles (Nanbu and Yonemura), the particle of least
+   weight is always updated and the other is updated with probability
+   w_min / w_max, as in binary_pipeline.cc.  g, ph and ut hold a normal
+   deviate and two uniform deviates on [0,1) per pair.  sin phi is
+   computed from cos phi (compilers otherwise fuse the two into a
+   sincos call that does not vectorize).  takizuka_abe_pipeline_v8.cc
+   and takizuka_abe_pipeline_v16.cc do the same arithmetic with the v8
+   and v16 classes. */
+
+static void
+scatter_pairs( float * RESTRICT uix, float * RESTRICT uiy,
+               float * RESTRICT uiz, const float * RESTRICT wi,
+               float * RESTRICT ujx, float * RESTRICT ujy,
+               float * RESTRICT ujz, const float * RESTRICT wj,
+               const float * RESTRICT g,
+               const float * RESTRICT ph,
+               const float * RESTRICT ut,
+               float cvar,
+               float mu_mi,
+               float mu_mj,
+               int n )
+{
+  static const float two_pi = 6.28318530717958647692f;
+  float urx, ury, urz, urP2, ur2, urP, ur, rP, cx, cy;
+  float w_max, w_min, var, d, t, sn, omc, cp, sp, fi, fj;
+  float dux, duy, duz;
+  int c, type;
+
+  for( c = 0; c < n; c++ )
+  {
+    urx   = uix[c] - ujx[c];
+    ury   = uiy[c] - ujy[c];
+    urz   = uiz[c] - ujz[c];
+    urP2  = urx*urx + ury*ury;
+    ur2   = urP2 + urz*urz;
+    urP   = sqrtf( urP2 );
+    ur    = sqrtf( ur2 );
+
+    w_max = ( wi[c] > wj[c] ) ? wi[c] : wj[c];
+    w_min = ( wi[c] > wj[c] ) ? wj[c] : wi[c];
+
+    /* Yes, the cap is written so that it also catches inf and nan */
+
+    var   = ( cvar * w_max ) / ( ur2 * ur );
+    var   = ( var < TAKIZUKA_ABE_VAR_MAX ) ? var : TAKIZUKA_ABE_VAR_MAX;
+    d     = sqrtf( var ) * g[c];
+    t     = 1 / ( 1 + d*d );
+    sn    = 2*d*t;
+    omc   = 2*d*d*t;
+    cp    = cosf( two_pi*ph[c] );
+    sp    = sqrtf( ( 1 - cp*cp ) > 0 ? ( 1 - cp*cp ) : 0 );
+    sp    = ( ph[c] < 0.5f ) ? sp : -sp;
+
+    rP    = 1 / ( urP + ( urP > 0 ? 0 : 1 ) );
+    cx    = ( urP > 0 ) ? urx*rP : 1;
+    cy    = ury*rP;
+
+    dux   = cx*urz*sn*cp - cy*ur*sn*sp - urx*omc;
+    duy   = cy*urz*sn*cp + cx*ur*sn*sp - ury*omc;
+    duz   = -urP*sn*cp - urz*omc;
+
+    type  = 1 + ( wj[c]==w_min );
+    type  = ( ( w_max==w_min ) | ( w_max*ut[c]<w_min ) ) ? 3 : type;
+    fi    = ( type & 1 ) ? mu_mi : 0;
+    fj    = ( type & 2 ) ? mu_mj : 0;
+
+    uix[c] += fi*dux, ujx[c] -= fj*dux;
+    uiy[c] += fi*duy, ujy[c] -= fj*duy;
+    uiz[c] += fi*duz, ujz[c] -= fj*duz;
+  }
+}
+
+/* Pair up and scatter the particles of the voxels of a pipeline.  The
+   pipeline variants only differ in the kernel that scatters a batch of
+   pairs (see scatter_pairs). */
+
+void
+takizuka_abe_pipeline_internal( takizuka_abe_t * RESTRICT ta,
+                                takizuka_abe_scatter_func_t scatter,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+
+  /**/  species_t  *          spi           = ta->spi;
+  /**/  species_t  *          spj           = ta->spj;
+  /**/  rng_t      * RESTRICT rng           = ta->crp->rng[ pipeline_rank ];
+  const uint64_t              key           = RNG_COUNTER_KEY( ta->rp, spi->g->step );
+  /**/  char       *            scratch       = ta->scratch.mem +
+                                                ta->scratch.sz*pipeline_rank;
+
+  /**/  particle_t *          spi_p         = spi->p;
+  const int        * RESTRICT spi_partition = spi->partition;
+  const grid_t     * RESTRICT g             = spi->g;
+
+  /**/  particle_t *          spj_p         = spj->p;
+  const int        * RESTRICT spj_partition = spj->partition;
+
+  const float mu_mi = ta->mu_mi;
+  const float mu_mj = ta->mu_mj;
+
+  DECLARE_ALIGNED_ARRAY( int,      64, k,   TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( int,      64, l,   TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, uix, TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, uiy, TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, uiz, TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, wi,  TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, ujx, TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, ujy, TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, ujz, TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, wj,  TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, gd,  TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, ph,  TAKIZUKA_ABE_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, ut,  TAKIZUKA_ABE_BATCH );
+
+  global_voxel_map_t map[1];
+  int64_t gv;
+  float cvar;
+  int v, v1, k0, nk, l0, nl, nr, np, p0, p1, n, c, i;
+
+  global_voxel_map( map, g );
+
+  /* Stripe the (mostly non-ghost) voxels over threads for load balance
+     as in binary_pipeline.cc.  The particles of a voxel are randomly
+     permuted in place by putting them in canonical order (see
+     order_voxel_internal), which lets the pairs below be formed from
+     adjacent particles.  The scatterings of a voxel are then drawn
+     from the counter stream of the model and the global index of the
+     voxel, so the result does not depend on the number of pipelines or
+     on the domain decomposition. */
+
+  v  = pipeline_rank;
+  v1 = g->sfc_hi + 1;
+
+  for( ; v<v1; v+=n_pipeline )
+  {
+    k0 = spi_partition[v  ];
+    nk = spi_partition[v+1] - k0;
+
+    if ( spi == spj )
+    {
+      if ( nk < 2 ) continue; /* Nothing to do */
+      l0 = k0;
+      nl = nk;
+    }
+
+    else
+    {
+      l0 = spj_partition[v  ];
+      nl = spj_partition[v+1] - l0;
+      if ( !nk || !nl ) continue; /* Nothing to do */
+    }
+
+    gv = global_voxel( map, spi_p[k0].i );
+
+    order_voxel_internal( spi_p + k0, nk, gv, (uint32_t) spi->id, key,
+                          ~ta->stream, scratch );
+    if ( spi != spj )
+    {
+      order_voxel_internal( spj_p + l0, nl, gv, (uint32_t) spj->id, key,
+                            ~ta->stream, scratch );
+    }
+
+    seed_rng_counter( rng, key, ta->stream, (uint32_t) gv,
+                      (uint32_t) ( (uint64_t) gv >> 32 ) );
+
+    /* Form the pairs.  For intraspecies collisions, the particles are
+       paired up with their neighbors.  If there is an odd number of
+       particles, the first three are collided as the pairs (0,1),
+       (1,2) and (2,0) at half the variance (as in Takizuka and Abe).
+       For interspecies collisions, every particle of the species with
+       more particles in the voxel is paired with one of the other
+       species, whose particles are used over in rounds of nr pairs.
+       The pairs of a round have no particles in common so they can be
+       scattered together.  In both cases, the density normalization
+       uses the number of particles of the species with fewer (see
+       takizuka_abe.c). */
+
+    if ( spi == spj )
+    {
+      nr   = nk;
+      np   = nk >> 1;
+      cvar = ta->cvar * (float) nk;
+
+      if ( nk & 1 )
+      {
+        for( c = 0; c < 3; c++ )
+        {
+          k[0] = k0 + c;
+          l[0] = k0 + ( c==2 ? 0 : c+1 );
+          gather_pairs( spi_p, spj_p, k, l, uix, uiy, uiz, wi,
+                        ujx, ujy, ujz, wj, 1 );
+          frandn_fill( rng, gd, 1, 1 );
+          frand_c0_fill( rng, ph, 1, 1 );
+          frand_c0_fill( rng, ut, 1, 1 );
+          scatter( uix, uiy, uiz, wi, ujx, ujy, ujz, wj, gd, ph, ut,
+                   0.5f*cvar, mu_mi, mu_mj, 1 );
+          spi_p[k[0]].ux = uix[0], spj_p[l[0]].ux = ujx[0];
+          spi_p[k[0]].uy = uiy[0], spj_p[l[0]].uy = ujy[0];
+          spi_p[k[0]].uz = uiz[0], spj_p[l[0]].uz = ujz[0];
+        }
+        k0 += 3;
+        np -= 1;
+      }
+    }
+
+    else
+    {
+      nr   = nk < nl ? nk : nl;
+      np   = nk < nl ? nl : nk;
+      cvar = ta->cvar * (float) nr;
+    }
+
+    for( p0 = 0; p0 < np; p0 = p1 )
+    {
+      /* Batches do not straddle rounds */
+
+      p1 = p0 + TAKIZUKA_ABE_BATCH;
+      i  = ( p0/nr + 1 )*nr;
+      if ( p1 > i  ) p1 = i;
+      if ( p1 > np ) p1 = np;
+      n  = p1 - p0;
+
+      if ( spi == spj )
+      {
+        for( c = 0; c < n; c++ )
+        {
+          k[c] = k0 + 2*( p0 + c );
+          l[c] = k[c] + 1;
+        }
+      }
+
+      else if ( nk < nl )
+      {
+        i = k0 + p0 % nr;
+        for( c = 0; c < n; c++ )
+        {
+          k[c] = i + c;
+          l[c] = l0 + p0 + c;
+        }
+      }
+
+      else
+      {
+        i = l0 + p0 % nr;
+        for( c = 0; c < n; c++ )
+        {
+          k[c] = k0 + p0 + c;
+          l[c] = i + c;
+        }
+      }
+
+      gather_pairs( spi_p, spj_p, k, l, uix, uiy, uiz, wi,
+                    ujx, ujy, ujz, wj, n );
+      frandn_fill( rng, gd, 1, n );
+      frand_c0_fill( rng, ph, 1, n );
+      frand_c0_fill( rng, ut, 1, n );
+      scatter( uix, uiy, uiz, wi, ujx, ujy, ujz, wj, gd, ph, ut,
+               cvar, mu_mi, mu_mj, n );
+
+      for( c = 0; c < n; c++ )
+      {
+        spi_p[k[c]].ux = uix[c], spj_p[l[c]].ux = ujx[c];
+        spi_p[k[c]].uy = uiy[c], spj_p[l[c]].uy = ujy[c];
+        spi_p[k[c]].uz = uiz[c], spj_p[l[c]].uz = ujz[c];
+      }
+    }
+  }
+}
+
+void
+takizuka_abe_pipeline_scalar( takizuka_abe_t * RESTRICT ta,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  if ( pipeline_rank == n_pipeline )
+  {
+    return; /* No host straggler cleanup */
+  }
+
+  takizuka_abe_pipeline_internal( ta, scatter_pairs, pipeline_rank,
+                                  n_pipeline );
+}
+
+#if defined(V4_ACCELERATION) && defined(HAS_V4_PIPELINE)
+
+#error "V4 pipeline not implemented"
+
+#endif
+
+void
+apply_takizuka_abe_pipeline( takizuka_abe_t * ta )
+{
+  // apply_takizuka_abe skips the steps off the interval and sorts the
+  // species.  The collision kernels work on particle_t.
+
+  convert_p( ta->spi, particle_layout_aos );
+  convert_p( ta->spj, particle_layout_aos );
+
+  ta->crp = counter_rng_pool_internal( ta->crp );
+
+  size_voxel_scratch_internal( &ta->scratch, ta->spi, ta->spj );
+
+  EXEC_PIPELINES( takizuka_abe, ta, 0 );
+
+  WAIT_PIPELINES();
+}
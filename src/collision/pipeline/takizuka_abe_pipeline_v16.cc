@@ -0,0 +1,122 @@
+#define IN_collision
+
+#include "collision_pipeline.h"
+
+#include "../../util/pipelines/pipelines_exec.h"
+
+#if defined(V16_ACCELERATION)
+
+using namespace v16;
+
+// Scatter the pairs 16 at a time (see scatter_pairs in
+// takizuka_abe_pipeline.cc for the arithmetic, which is done in the same
+// order here).
+
+static void
+scatter_pairs_v16( float * RESTRICT uix, float * RESTRICT uiy,
+                   float * RESTRICT uiz, const float * RESTRICT wi,
+                   float * RESTRICT ujx, float * RESTRICT ujy,
+                   float * RESTRICT ujz, const float * RESTRICT wj,
+                   const float * RESTRICT g,
+                   const float * RESTRICT ph,
+                   const float * RESTRICT ut,
+                   float cvar,
+                   float mu_mi,
+                   float mu_mj,
+                   int n )
+{
+  const v16float two_pi( 6.28318530717958647692f );
+  const v16float var_max( TAKIZUKA_ABE_VAR_MAX );
+  const v16float vcvar( cvar );
+  const v16float vmu_mi( mu_mi );
+  const v16float vmu_mj( mu_mj );
+  const v16float zero( 0.0f );
+  const v16float half( 0.5f );
+  const v16float one( 1.0f );
+  const v16float two( 2.0f );
+
+  v16float vix, viy, viz, vwi, vjx, vjy, vjz, vwj, vg, vph, vut;
+  v16float urx, ury, urz, urP2, ur2, urP, ur, rP, cx, cy;
+  v16float w_max, w_min, var, d, t, sn, omc, cp, sp, omc2, fi, fj;
+  v16float dux, duy, duz;
+  v16int  gt, rest;
+  int c;
+
+  for( c = 0; c < n; c += 16 )
+  {
+    load_16x1( uix + c, vix ); load_16x1( ujx + c, vjx );
+    load_16x1( uiy + c, viy ); load_16x1( ujy + c, vjy );
+    load_16x1( uiz + c, viz ); load_16x1( ujz + c, vjz );
+    load_16x1( wi  + c, vwi ); load_16x1( wj  + c, vwj );
+    load_16x1( g   + c, vg  );
+    load_16x1( ph  + c, vph );
+    load_16x1( ut  + c, vut );
+
+    urx   = vix - vjx;
+    ury   = viy - vjy;
+    urz   = viz - vjz;
+    urP2  = urx*urx + ury*ury;
+    ur2   = urP2 + urz*urz;
+    urP   = sqrt( urP2 );
+    ur    = sqrt( ur2 );
+
+    gt    = vwi > vwj;
+    w_max = merge( gt, vwi, vwj );
+    w_min = merge( gt, vwj, vwi );
+
+    var   = ( vcvar * w_max ) / ( ur2 * ur );
+    var   = merge( var < var_max, var, var_max );
+    d     = sqrt( var ) * vg;
+    t     = one / ( one + d*d );
+    sn    = two*d*t;
+    omc   = two*d*d*t;
+    cp    = cos( two_pi*vph );
+    omc2  = one - cp*cp;
+    sp    = sqrt( merge( omc2 > zero, omc2, zero ) );
+    sp    = merge( vph < half, sp, -sp );
+
+    gt    = urP > zero;
+    rP    = one / ( urP + merge( gt, zero, one ) );
+    cx    = merge( gt, urx*rP, one );
+    cy    = ury*rP;
+
+    dux   = cx*urz*sn*cp - cy*ur*sn*sp - urx*omc;
+    duy   = cy*urz*sn*cp + cx*ur*sn*sp - ury*omc;
+    duz   = -urP*sn*cp - urz*omc;
+
+    rest  = ( w_max == w_min ) | ( w_max*vut < w_min );
+    fi    = merge( ( vwj != w_min ) | rest, vmu_mi, zero );
+    fj    = merge( ( vwj == w_min ) | rest, vmu_mj, zero );
+
+    store_16x1( vix + fi*dux, uix + c ); store_16x1( vjx - fj*dux, ujx + c );
+    store_16x1( viy + fi*duy, uiy + c ); store_16x1( vjy - fj*duy, ujy + c );
+    store_16x1( viz + fi*duz, uiz + c ); store_16x1( vjz - fj*duz, ujz + c );
+  }
+}
+
+void
+takizuka_abe_pipeline_v16( takizuka_abe_t * RESTRICT ta,
+                           int pipeline_rank,
+                           int n_pipeline )
+{
+  if ( pipeline_rank == n_pipeline )
+  {
+    return; /* No host straggler cleanup */
+  }
+
+  takizuka_abe_pipeline_internal( ta, scatter_pairs_v16, pipeline_rank,
+                                  n_pipeline );
+}
+
+#else
+
+void
+takizuka_abe_pipeline_v16( takizuka_abe_t * RESTRICT ta,
+                           int pipeline_rank,
+                           int n_pipeline )
+{
+  // No v16 implementation.
+  ERROR( ( "No takizuka_abe_pipeline_v16 implementation." ) );
+}
+
+#endif
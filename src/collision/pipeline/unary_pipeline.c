@@ -10,6 +10,16 @@
 
 /* Private interface *********************************************************/
 
+/* The particles are processed in batches of UNARY_BATCH.  Each
+   particle draws the uniform deviate of its collision test from its own
+   counter stream (cm->stream and particle_stream) and any deviates its
+   collision needs from a second one (~cm->stream and particle_stream),
+   both keyed by the step (see RNG_COUNTER_KEY), so the result does not
+   depend on how the particles are ordered or distributed over the
+   pipelines and processes.  The collision tests of a batch are drawn
+   in bulk and a batched model collides the selected particles of a
+   batch in one call. */
+
 void
 unary_pipeline_scalar( unary_collision_model_t * RESTRICT cm,
                        int pipeline_rank,
@@ -20,44 +30,110 @@ unary_pipeline_scalar( unary_collision_model_t * RESTRICT cm,
     return; /* No host straggler cleanup */
   }
 
-  unary_rate_constant_func_t rate_constant = cm->rate_constant;
-  unary_collision_func_t     collision     = cm->collision;
+  unary_rate_constant_func_t       rate_constant       = cm->rate_constant;
+  unary_collision_func_t           collision           = cm->collision;
+  unary_rate_constant_batch_func_t rate_constant_batch = cm->rate_constant_batch;
+  unary_collision_batch_func_t     collision_batch     = cm->collision_batch;
 
   /**/  void       * RESTRICT params = cm->params;
   const species_t  * RESTRICT sp     = cm->sp;
   /**/  particle_t * RESTRICT p      = cm->sp->p;
-  /**/  rng_t      * RESTRICT rng    = cm->rp->rng[ pipeline_rank ];
+  /**/  rng_t      * RESTRICT rng    = cm->crp->rng[ pipeline_rank ];
+  const uint64_t              key    = RNG_COUNTER_KEY( cm->rp, sp->g->step );
 
   const float dt = sp->g->dt * (float) cm->interval;
 
-  double n_target = (double) sp->np / (double) n_pipeline;
-
-  /**/  int i  = (int) ( 0.5 + n_target * (double)  pipeline_rank    );
-  const int i1 = (int) ( 0.5 + n_target * (double) (pipeline_rank+1) );
+  DECLARE_ALIGNED_ARRAY( float,    64, k,   UNARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( float,    64, u,   4*UNARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( int,      64, idx, UNARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( uint32_t, 64, s1,  UNARY_BATCH );
+  DECLARE_ALIGNED_ARRAY( uint32_t, 64, s2,  UNARY_BATCH );
 
+  global_voxel_map_t map[1];
+  particle_streams_t ps[1];
   float pr_coll;
-  int n_large_pr = 0;
+  int b, nb, i, n, c, m, n_large_pr = 0;
+
+  global_voxel_map( map, sp->g );
 
-  /* For each computational particle assigned to this pipeline, compute
-     the probability a comoving physical particle had collision with
-     the background.  If this "probability" is greater than one, make
-     a note for diagnostic purposes.  Then flip a bias coin of that
-     probability to decide if this particle should undergo a collision. */
+  ps->key = key;
+  ps->s0  = ~cm->stream;
+  ps->s1  = s1;
+  ps->s2  = s2;
 
-  for( ; i < i1; i++ )
+  DISTRIBUTE( ( sp->np + UNARY_BATCH - 1 ) / UNARY_BATCH, 1,
+              pipeline_rank, n_pipeline, b, nb );
+
+  for( ; nb; b++, nb-- )
   {
-    pr_coll = dt * rate_constant( params, sp, &p[i] );
+    i = b * UNARY_BATCH;
+    n = sp->np - i;
+    if ( n > UNARY_BATCH ) n = UNARY_BATCH;
+
+    /* For each particle of the batch, compute the probability a
+       comoving physical particle had collision with the background.
+       If this "probability" is greater than one, make a note for
+       diagnostic purposes.  Then flip a bias coin of that probability
+       to decide if this particle should undergo a collision.  The
+       coin flips are branchless so this loop vectorizes. */
+
+    if ( rate_constant_batch )
+    {
+      rate_constant_batch( params, sp, p + i, k, n );
+    }
 
-    if ( pr_coll > 1 )
+    else
     {
-      n_large_pr++;
+      for( c = 0; c < n; c++ )
+      {
+        k[c] = rate_constant( params, sp, p + i + c );
+      }
     }
 
+    for( c = 0; c < n; c++ )
+    {
+      particle_stream( p + i + c, global_voxel( map, p[i+c].i ),
+                       (uint32_t) sp->id, s1 + c, s2 + c );
+    }
+
+    frand_c0_stream_fill( key, cm->stream, s1, s2, u, n );
+
     /* Yes, strictly < (so that 0 rate constants guarantee no collision,
        and, yes, _c0, so that 1 probabilities guarantee a collision  */
-    if ( frand_c0( rng ) < pr_coll )
+
+    for( c = 0, m = 0; c < n; c++ )
+    {
+      pr_coll     = dt * k[c];
+      n_large_pr += pr_coll > 1;
+      idx[m]      = c;
+      m          += u[4*c] < pr_coll;
+    }
+
+    /* Collide the selected particles, giving each the collision stream
+       of its particle (idx[c] >= c, so the streams of the selected
+       particles can be packed in place). */
+
+    for( c = 0; c < m; c++ )
+    {
+      s1[c] = s1[idx[c]];
+      s2[c] = s2[idx[c]];
+    }
+
+    if ( collision_batch )
     {
-      collision( params, sp, &p[i], rng );
+      if ( m )
+      {
+        collision_batch( params, sp, p + i, idx, m, ps, rng );
+      }
+    }
+
+    else
+    {
+      for( c = 0; c < m; c++ )
+      {
+        seed_rng_counter( rng, key, ps->s0, s1[c], s2[c] );
+        collision( params, sp, p + i + idx[c], rng );
+      }
     }
   }
 
@@ -75,6 +151,12 @@ apply_unary_collision_model_pipeline( unary_collision_model_t * cm )
     return;
   }
 
+  // The collision kernels work on particle_t
+
+  convert_p( cm->sp, particle_layout_aos );
+
+  cm->crp = counter_rng_pool_internal( cm->crp );
+
   EXEC_PIPELINES( unary, cm, 0 );
 
   WAIT_PIPELINES();
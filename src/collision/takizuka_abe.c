@@ -0,0 +1,171 @@
+#define IN_collision
+
+#include "takizuka_abe.h"
+
+/* Private interface *********************************************************/
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper apply_takizuka_abe
+// function.
+//----------------------------------------------------------------------------//
+
+void
+apply_takizuka_abe( takizuka_abe_t * ta )
+{
+  if ( ta->interval < 1 || ( ta->spi->g->step % ta->interval ) )
+  {
+    return;
+  }
+
+  if ( ta->spi->last_sorted != ta->spi->g->step )
+  {
+    sort_p( ta->spi );
+  }
+
+  if ( ta->spj->last_sorted != ta->spi->g->step )
+  {
+    sort_p( ta->spj );
+  }
+
+  // Conditionally execute this when more abstractions are available.
+  apply_takizuka_abe_pipeline( ta );
+}
+
+void
+checkpt_takizuka_abe( const collision_op_t * cop )
+{
+  const takizuka_abe_t * ta = ( const takizuka_abe_t * ) cop->params;
+
+  CHECKPT( ta, 1 );
+  CHECKPT_STR( ta->name );
+  CHECKPT_PTR( ta->spi );
+  CHECKPT_PTR( ta->spj );
+  CHECKPT_PTR( ta->rp );
+  CHECKPT_PTR( ta->crp );
+
+  checkpt_collision_op_internal( cop );
+}
+
+collision_op_t *
+restore_takizuka_abe( void )
+{
+  takizuka_abe_t * ta;
+
+  RESTORE( ta );
+  RESTORE_STR( ta->name );
+  RESTORE_PTR( ta->spi );
+  RESTORE_PTR( ta->spj );
+  RESTORE_PTR( ta->rp );
+  RESTORE_PTR( ta->crp );
+  CLEAR( &ta->scratch, 1 );
+
+  return restore_collision_op_internal( ta );
+}
+
+void
+delete_takizuka_abe( collision_op_t * cop )
+{
+  takizuka_abe_t * ta = ( takizuka_abe_t * ) cop->params;
+
+  delete_rng_pool( ta->crp );
+  delete_voxel_scratch_internal( &ta->scratch );
+  FREE( ta->name );
+  FREE( ta );
+
+  delete_collision_op_internal( cop );
+}
+
+/* Public interface **********************************************************/
+
+/* In normalized momenta, the relative velocity of a non-relativistic
+   pair is vr = cvac |ur| with ur = ui - uj.  A pair of particles of
+   weights wk and wl in a voxel in which the less numerous of the two
+   species has N computational particles sees the density:
+
+     n = max( wk, wl ) N / dV
+
+   (see takizuka_abe_pipeline.cc) such that the variance of a pair is:
+
+     <tan^2 theta/2> = cvar max( wk, wl ) N / |ur|^3
+
+   with:
+
+     cvar = qi^2 qj^2 lnL dt interval /
+            ( 8 pi eps0^2 mu^2 cvac^3 dV ) */
+
+collision_op_t *
+takizuka_abe( const char * RESTRICT name,
+              species_t * spi,
+              species_t * spj,
+              rng_pool_t * RESTRICT rp,
+              const double ln_lambda,
+              const int interval )
+{
+  takizuka_abe_t * ta;
+  const grid_t * g;
+  double mu, qq;
+
+  size_t len = name ? strlen(name) : 0;
+
+  if ( !spi              ||
+       !spj              ||
+       spi->g != spj->g  ||
+       !spi->q           ||
+       !spj->q           ||
+       spi->m <= 0       ||
+       spj->m <= 0       ||
+       !rp               ||
+       ln_lambda < 0 )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  if ( len == 0 )
+  {
+    ERROR( ( "Cannot specify a nameless collision model" ) );
+  }
+
+  MALLOC( ta, 1 );
+  MALLOC( ta->name, len+1 );
+
+  strcpy( ta->name, name );
+
+  // FNV-1a
+
+  ta->stream = 2166136261u;
+  for( ; *name; name++ )
+  {
+    ta->stream = ( ta->stream ^ (uint8_t) *name ) * 16777619u;
+  }
+
+  g  = spi->g;
+  mu = ( (double) spi->m * (double) spj->m ) /
+       ( (double) spi->m + (double) spj->m );
+  qq = (double) spi->q * (double) spj->q;
+
+  ta->spi      = spi;
+  ta->spj      = spj;
+  ta->rp       = rp;
+  ta->crp      = counter_rng_pool_internal( NULL );
+  CLEAR( &ta->scratch, 1 );
+  ta->cvar     = ( qq * qq * ln_lambda * g->dt * (double) interval ) /
+                 ( 8 * M_PI * g->eps0 * g->eps0 * mu * mu *
+                   g->cvac * g->cvac * g->cvac * g->dV );
+  ta->mu_mi    = mu / spi->m;
+  ta->mu_mj    = mu / spj->m;
+  ta->interval = interval;
+
+  return new_collision_op_internal( ta,
+                                    ( collision_op_func_t ) apply_takizuka_abe,
+                                    delete_takizuka_abe,
+                                    ( checkpt_func_t ) checkpt_takizuka_abe,
+                                    ( restore_func_t ) restore_takizuka_abe,
+                                    NULL );
+}
+
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( apply_takizuka_abe )
+REGISTER_SYMBOL( delete_takizuka_abe )
+REGISTER_SYMBOL( checkpt_takizuka_abe )
+REGISTER_SYMBOL( restore_takizuka_abe )
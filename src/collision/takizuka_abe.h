@@ -0,0 +1,32 @@
+#ifndef _takizuka_abe_h_
+#define _takizuka_abe_h_
+
+#include "collision_private.h"
+
+enum { TAKIZUKA_ABE_BATCH = 256 }; // Pairs per batch of scatterings
+
+typedef struct takizuka_abe
+{
+  char * name;
+  species_t  * spi;
+  species_t  * spj;
+  rng_pool_t * rp;
+  rng_pool_t * crp;  // Counter mode generators of the pipelines
+  uint32_t stream;   // Counter stream of the model (hash of the name)
+  voxel_scratch_t scratch; // Voxel ordering scratch (not checkpointed)
+  float cvar;        // Variance normalization (see takizuka_abe.c)
+  float mu_mi;       // mu / mi
+  float mu_mj;       // mu / mj
+  int interval;
+} takizuka_abe_t;
+
+BEGIN_C_DECLS
+
+// The species must be sorted this step (see apply_takizuka_abe)
+
+void
+apply_takizuka_abe_pipeline( takizuka_abe_t * ta );
+
+END_C_DECLS
+
+#endif /* _takizuka_abe_h_ */
@@ -32,9 +32,12 @@ checkpt_unary_collision_model( const collision_op_t * cop )
   CHECKPT_STR( cm->name );
   CHECKPT_SYM( cm->rate_constant );
   CHECKPT_SYM( cm->collision );
+  CHECKPT_SYM( cm->rate_constant_batch );
+  CHECKPT_SYM( cm->collision_batch );
   CHECKPT_PTR( cm->params );
   CHECKPT_PTR( cm->sp );
   CHECKPT_PTR( cm->rp );
+  CHECKPT_PTR( cm->crp );
 
   checkpt_collision_op_internal( cop );
 }
@@ -48,9 +51,12 @@ restore_unary_collision_model( void )
   RESTORE_STR( cm->name );
   RESTORE_SYM( cm->rate_constant );
   RESTORE_SYM( cm->collision );
+  RESTORE_SYM( cm->rate_constant_batch );
+  RESTORE_SYM( cm->collision_batch );
   RESTORE_PTR( cm->params );
   RESTORE_PTR( cm->sp );
   RESTORE_PTR( cm->rp );
+  RESTORE_PTR( cm->crp );
 
   return restore_collision_op_internal( cm );
 }
@@ -60,6 +66,7 @@ delete_unary_collision_model( collision_op_t * cop )
 {
   unary_collision_model_t * cm = ( unary_collision_model_t * ) cop->params;
 
+  delete_rng_pool( cm->crp );
   FREE( cm->name );
   FREE( cm );
 
@@ -69,23 +76,24 @@ delete_unary_collision_model( collision_op_t * cop )
 /* Public interface **********************************************************/
 
 collision_op_t *
-unary_collision_model( const char * RESTRICT name,
-                       unary_rate_constant_func_t rate_constant,
-                       unary_collision_func_t collision,
-                       void * RESTRICT params,
-                       species_t * RESTRICT sp,
-                       rng_pool_t * RESTRICT rp,
-                       int interval )
+unary_batch_collision_model( const char * RESTRICT name,
+                             unary_rate_constant_func_t rate_constant,
+                             unary_rate_constant_batch_func_t rate_constant_batch,
+                             unary_collision_func_t collision,
+                             unary_collision_batch_func_t collision_batch,
+                             void * RESTRICT params,
+                             species_t * RESTRICT sp,
+                             rng_pool_t * RESTRICT rp,
+                             int interval )
 {
   unary_collision_model_t * cm;
 
   size_t len = name ? strlen(name) : 0;
 
-  if ( !rate_constant         ||
-       !collision             ||
-       !sp                    ||
-       !rp                    ||
-       rp->n_rng < N_PIPELINE )
+  if ( ( !rate_constant && !rate_constant_batch ) ||
+       ( !collision     && !collision_batch     ) ||
+       !sp                                        ||
+       !rp )
   {
     ERROR( ( "Bad args" ) );
   }
@@ -106,12 +114,23 @@ unary_collision_model( const char * RESTRICT name,
 
   strcpy( cm->name, name ); 
 
-  cm->rate_constant = rate_constant;
-  cm->collision     = collision;
-  cm->params        = params;
-  cm->sp            = sp;
-  cm->rp            = rp;
-  cm->interval      = interval;
+  // FNV-1a
+
+  cm->stream = 2166136261u;
+  for( ; *name; name++ )
+  {
+    cm->stream = ( cm->stream ^ (uint8_t) *name ) * 16777619u;
+  }
+
+  cm->rate_constant       = rate_constant;
+  cm->collision           = collision;
+  cm->rate_constant_batch = rate_constant_batch;
+  cm->collision_batch     = collision_batch;
+  cm->params              = params;
+  cm->sp                  = sp;
+  cm->rp                  = rp;
+  cm->crp                 = counter_rng_pool_internal( NULL );
+  cm->interval            = interval;
 
   return new_collision_op_internal( cm,
                                     ( collision_op_func_t ) apply_unary_collision_model,
@@ -120,3 +139,29 @@ unary_collision_model( const char * RESTRICT name,
                                     ( restore_func_t ) restore_unary_collision_model,
                                     NULL );
 }
+
+collision_op_t *
+unary_collision_model( const char * RESTRICT name,
+                       unary_rate_constant_func_t rate_constant,
+                       unary_collision_func_t collision,
+                       void * RESTRICT params,
+                       species_t * RESTRICT sp,
+                       rng_pool_t * RESTRICT rp,
+                       int interval )
+{
+  if ( !rate_constant ||
+       !collision )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  return unary_batch_collision_model( name, rate_constant, NULL, collision,
+                                      NULL, params, sp, rp, interval );
+}
+
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( apply_unary_collision_model )
+REGISTER_SYMBOL( delete_unary_collision_model )
+REGISTER_SYMBOL( checkpt_unary_collision_model )
+REGISTER_SYMBOL( restore_unary_collision_model )
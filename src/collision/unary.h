@@ -3,14 +3,20 @@
 
 #include "collision_private.h"
 
+enum { UNARY_BATCH = 256 }; // Particles per batch of collision tests
+
 typedef struct unary_collision_model
 {
   char * name;
   unary_rate_constant_func_t rate_constant;
   unary_collision_func_t collision;
+  unary_rate_constant_batch_func_t rate_constant_batch;
+  unary_collision_batch_func_t collision_batch;
   void * params;
   species_t * sp;
   rng_pool_t * rp;
+  rng_pool_t * crp;  // Counter mode generators of the pipelines
+  uint32_t stream;   // Counter stream of the model (hash of the name)
   int interval;
   int n_large_pr[ MAX_PIPELINE ];
 } unary_collision_model_t;
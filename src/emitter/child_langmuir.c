@@ -67,19 +67,24 @@ emit_child_langmuir( child_langmuir_t * RESTRICT              cl,
   int nm = sp->nm, nm_skipped = 0;
 
   float w, ux, uy, uz;
-  int c, cc, i, np_emit;
+  int c, cc, i, j, np_emit;
+
+  // Emitted particles are written directly into sp->p
+
+  convert_p( sp, particle_layout_aos );
 
   // Loop over all components of the region
 
   for( c=0; c<n_component; c++ ) {
     cc = component[c];
     i  = EXTRACT_LOCAL_CELL( cc );
+    j  = g->sfc[i];
 
     // FIXME: COULD PROBABLY ACCELERATE BY GETTING RID OF SWITCH (USE
     // MAXWELLIAN_REFLUX TRICKS?)
 
 #   define EMIT_PARTICLES(X,Y,Z,dir)                                    \
-    w = fi[i].e##X;                                                     \
+    w = fi[j].e##X;                                                     \
     if( dir qsp*w > thresh ) { /* This face can emit */                 \
       w = norm_##X*sqrtf(fabsf(w*w*w));                                 \
       for( np_emit=np_emit_per_face; np_emit; np_emit-- ) {             \
@@ -209,3 +214,9 @@ child_langmuir( /**/  species_t            * RESTRICT sp,
                                NULL );
 }
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( emit_child_langmuir )
+REGISTER_SYMBOL( delete_child_langmuir )
+REGISTER_SYMBOL( checkpt_child_langmuir )
+REGISTER_SYMBOL( restore_child_langmuir )
@@ -24,6 +24,10 @@ checkpt_field_advance_kernels( const field_advance_kernels_t * kernel )
   CHECKPT_SYM( kernel->synchronize_jf            );
   CHECKPT_SYM( kernel->clear_rhof                );
   CHECKPT_SYM( kernel->synchronize_rho           );
+  CHECKPT_SYM( kernel->begin_synchronize_jf      );
+  CHECKPT_SYM( kernel->end_synchronize_jf        );
+  CHECKPT_SYM( kernel->begin_synchronize_rho     );
+  CHECKPT_SYM( kernel->end_synchronize_rho       );
   CHECKPT_SYM( kernel->compute_rhob              );
   CHECKPT_SYM( kernel->compute_curl_b            );
   CHECKPT_SYM( kernel->synchronize_tang_e_norm_b );
@@ -46,6 +50,10 @@ restore_field_advance_kernels( field_advance_kernels_t * kernel )
   RESTORE_SYM( kernel->synchronize_jf            );
   RESTORE_SYM( kernel->clear_rhof                );
   RESTORE_SYM( kernel->synchronize_rho           );
+  RESTORE_SYM( kernel->begin_synchronize_jf      );
+  RESTORE_SYM( kernel->end_synchronize_jf        );
+  RESTORE_SYM( kernel->begin_synchronize_rho     );
+  RESTORE_SYM( kernel->end_synchronize_rho       );
   RESTORE_SYM( kernel->compute_rhob              );
   RESTORE_SYM( kernel->compute_curl_b            );
   RESTORE_SYM( kernel->synchronize_tang_e_norm_b );
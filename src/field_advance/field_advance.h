@@ -194,6 +194,14 @@ typedef struct field_advance_kernels
   void (*clear_rhof     )( struct field_array * RESTRICT fa );
   void (*synchronize_rho)( struct field_array * RESTRICT fa );
 
+  // Split phase accumulator synchronization.  The shared face values of
+  // jf (rhof and rhob) must not be touched between begin and end.
+
+  void (*begin_synchronize_jf )( struct field_array * RESTRICT fa );
+  void (*end_synchronize_jf   )( struct field_array * RESTRICT fa );
+  void (*begin_synchronize_rho)( struct field_array * RESTRICT fa );
+  void (*end_synchronize_rho  )( struct field_array * RESTRICT fa );
+
   // Initialization interface
 
   void (*compute_rhob  )( struct field_array * RESTRICT fa );
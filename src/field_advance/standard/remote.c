@@ -414,33 +414,219 @@ synchronize_tang_e_norm_b( field_array_t * RESTRICT fa ) {
   return gerr;
 }
 
+/*****************************************************************************
+ * Split phase synchronization
+ *
+ * The begin functions post everything the shared faces, edges and
+ * corners need in one shot: a message to each face neighbor and small
+ * messages to the ranks diagonally adjacent through the shared faces
+ * holding the values on the shared edges (and, for nodal quantities,
+ * corners).  The end functions then reproduce the result of the three
+ * pass (x, then y, then z) exchange: before a face message is applied,
+ * its values on the edges shared with the other faces are combined with
+ * the diagonal messages as the sender would have in the earlier passes.
+ * Between begin and end, the synchronized quantities on the faces of the
+ * local domain must not be modified.
+ *
+ * The diagonal neighbors are found by walking the face connectivity of
+ * all ranks, which is gathered on first use.  Thus the face boundary
+ * conditions must not change after the first synchronization.
+ *****************************************************************************/
+
+// SIDE(i,n) => Plane on side i (-1 or 1) of an axis with n cells
+#define SIDE(i,n) ( (i)<0 ? 1 : (n)+1 )
+
+// x_LINE_EDGE_LOOP => Loop over x-oriented edges on the line at y-side j,
+// z-side k
+#define x_LINE_EDGE_LOOP(i,j,k) \
+  XYZ_LOOP(1,nx,SIDE(j,ny),SIDE(j,ny),SIDE(k,nz),SIDE(k,nz))
+#define y_LINE_EDGE_LOOP(i,j,k) \
+  XYZ_LOOP(SIDE(i,nx),SIDE(i,nx),1,ny,SIDE(k,nz),SIDE(k,nz))
+#define z_LINE_EDGE_LOOP(i,j,k) \
+  XYZ_LOOP(SIDE(i,nx),SIDE(i,nx),SIDE(j,ny),SIDE(j,ny),1,nz)
+
+// x_LINE_NODE_LOOP => Loop over nodes on the line at y-side j, z-side k
+#define x_LINE_NODE_LOOP(i,j,k) \
+  XYZ_LOOP(1,nx+1,SIDE(j,ny),SIDE(j,ny),SIDE(k,nz),SIDE(k,nz))
+#define y_LINE_NODE_LOOP(i,j,k) \
+  XYZ_LOOP(SIDE(i,nx),SIDE(i,nx),1,ny+1,SIDE(k,nz),SIDE(k,nz))
+#define z_LINE_NODE_LOOP(i,j,k) \
+  XYZ_LOOP(SIDE(i,nx),SIDE(i,nx),SIDE(j,ny),SIDE(j,ny),1,nz+1)
+
+// CORNER_NODE_LOOP => "Loop" over the node at corner (i,j,k)
+#define CORNER_NODE_LOOP(i,j,k) \
+  XYZ_LOOP(SIDE(i,nx),SIDE(i,nx),SIDE(j,ny),SIDE(j,ny),SIDE(k,nz),SIDE(k,nz))
+
+// Face neighbors of every rank, indexed 6*rank+face with the faces
+// ordered -x,-y,-z,+x,+y,+z
+
+static int * face_nbr = NULL;
+
+static void
+gather_face_nbr( const grid_t * g ) {
+  int nbr[6];
+
+  if( face_nbr ) return;
+
+  nbr[0] = g->bc[ BOUNDARY(-1, 0, 0) ];
+  nbr[1] = g->bc[ BOUNDARY( 0,-1, 0) ];
+  nbr[2] = g->bc[ BOUNDARY( 0, 0,-1) ];
+  nbr[3] = g->bc[ BOUNDARY( 1, 0, 0) ];
+  nbr[4] = g->bc[ BOUNDARY( 0, 1, 0) ];
+  nbr[5] = g->bc[ BOUNDARY( 0, 0, 1) ];
+
+  MALLOC( face_nbr, 6*world_size );
+  mp_allgather_i( nbr, face_nbr, 6 );
+}
+
+// Returns the rank reached by crossing the face of rank on side (-1, 0
+// or 1) of axis (0, 1 or 2).  Returns -1 if that face is not shared.
+
+static int
+cross_face( int rank,
+            int axis,
+            int side ) {
+  if( rank<0 || side==0 ) return rank;
+  rank = face_nbr[ 6*rank + axis + ( side<0 ? 0 : 3 ) ];
+  return ( rank>=0 && rank<world_size ) ? rank : -1;
+}
+
+// In the three pass exchange, data reaches the rank diagonally adjacent
+// in direction (i,j,k) by crossing the x, then the y, then the z faces.
+// Data from the rank diagonally adjacent in direction (i,j,k) arrives in
+// the same order so its path is walked in reverse.
+
+static int
+diagonal_dst( int i, int j, int k ) {
+  return cross_face( cross_face( cross_face( world_rank, 0,i ), 1,j ), 2,k );
+}
+
+static int
+diagonal_src( int i, int j, int k ) {
+  return cross_face( cross_face( cross_face( world_rank, 2,k ), 1,j ), 0,i );
+}
+
+// Port operations for the diagonal neighbors.  These mirror those in
+// grid_comm.c (i.e. the receive functions take the remote sending port).
+
+static void
+begin_recv_diagonal( int i, int j, int k,
+                     int size,
+                     const grid_t * g ) {
+  int port = BOUNDARY(-i,-j,-k), src = diagonal_src(-i,-j,-k);
+  if( src<0 ) return;
+  mp_size_recv_buffer( g->mp, port, size );
+  mp_begin_recv( g->mp, port, size, src, BOUNDARY(i,j,k) );
+}
+
+static float *
+end_recv_diagonal( int i, int j, int k,
+                   const grid_t * g ) {
+  int port = BOUNDARY(-i,-j,-k);
+  if( diagonal_src(-i,-j,-k)<0 ) return NULL;
+  mp_end_recv( g->mp, port );
+  return (float *)mp_recv_buffer( g->mp, port );
+}
+
+static float *
+size_send_diagonal( int i, int j, int k,
+                    int size,
+                    const grid_t * g ) {
+  int port = BOUNDARY( i, j, k);
+  if( diagonal_dst(i,j,k)<0 ) return NULL;
+  mp_size_send_buffer( g->mp, port, size );
+  return (float *)mp_send_buffer( g->mp, port );
+}
+
+static void
+begin_send_diagonal( int i, int j, int k,
+                     int size,
+                     const grid_t * g ) {
+  int port = BOUNDARY( i, j, k), dst = diagonal_dst(i,j,k);
+  if( dst<0 ) return;
+  mp_begin_send( g->mp, port, size, dst, port );
+}
+
+static void
+end_send_diagonal( int i, int j, int k,
+                   const grid_t * g ) {
+  if( diagonal_dst(i,j,k)<0 ) return;
+  mp_end_send( g->mp, BOUNDARY(i,j,k) );
+}
+
+// Replace n values (stride s) of a received message with the values the
+// sender had after it combined them with the values rd (unit stride) of
+// its own neighbor.  dl and dr are the cell sizes of the sender and its
+// neighbor normal to the face they share.  This is the same arithmetic
+// as in the end of the face exchanges.
+
+static void
+combine_jf( float * rf, int s,
+            const float * rd, int n,
+            float dl, float dr ) {
+  float lw, rw;
+  rw  = dr;
+  lw  = rw + dl;
+  rw /= lw;
+  lw  = dl/lw;
+  lw += lw;
+  rw += rw;
+  for( ; n; n--, rf+=s, rd++ ) *rf = lw*(*rf) + rw*(*rd);
+}
+
+static void
+combine_rho( float * rf, int s,
+             const float * rd, int n,
+             float dl, float dr ) {
+  float hlw, hrw, lw, rw;
+  hrw  = dr;
+  hlw  = hrw + dl;
+  hrw /= hlw;
+  hlw  = dl/hlw;
+  lw   = hlw + hlw;
+  rw   = hrw + hrw;
+  for( ; n; n--, rf+=2*s, rd+=2 ) {
+    rf[0] =  lw*rf[0] +  rw*rd[0];
+    rf[1] = hlw*rf[1] + hrw*rd[1];
+  }
+}
+
+// Face messages start with the sender cell dimensions (permuted to the
+// face axes X, Y, Z).  Diagonal messages start with the sender cell
+// dimensions (unpermuted).
+
+#define MSG(i,j,k) msg[ BOUNDARY(i,j,k) ]
+
 void
-synchronize_jf( field_array_t * RESTRICT fa ) {
-  field_t * field, * f;
+begin_synchronize_jf( field_array_t * RESTRICT fa ) {
+  field_t * field;
   grid_t * RESTRICT g;
   int size, face, x, y, z, nx, ny, nz;
-  float *p, lw, rw;
+  float *p;
 
   if( !fa ) ERROR(( "Bad args" ));
   field = fa->f;
   g     = fa->g;
 
   local_adjust_jf( field, g );
+  gather_face_nbr( g );
 
   nx = g->nx;
   ny = g->ny;
   nz = g->nz;
 
 # define BEGIN_RECV(i,j,k,X,Y,Z)                                        \
-  begin_recv_port(i,j,k, ( n##Y*(n##Z+1) +                              \
-                           n##Z*(n##Y+1) + 1 )*sizeof(float), g )
+  begin_recv_port(i,j,k, ( 3 + n##Y*(n##Z+1) +                          \
+                               n##Z*(n##Y+1) )*sizeof(float), g )
 
 # define BEGIN_SEND(i,j,k,X,Y,Z) BEGIN_PRIMITIVE {              \
-    size = ( n##Y*(n##Z+1) +                                    \
-             n##Z*(n##Y+1) + 1 )*sizeof(float);                 \
+    size = ( 3 + n##Y*(n##Z+1) +                                \
+                 n##Z*(n##Y+1) )*sizeof(float);                 \
     p = (float *)size_send_port( i, j, k, size, g );            \
     if( p ) {                                                   \
       (*(p++)) = g->d##X;                                       \
+      (*(p++)) = g->d##Y;                                       \
+      (*(p++)) = g->d##Z;                                       \
       face = (i+j+k)<0 ? 1 : n##X+1;                            \
       Y##Z##_EDGE_LOOP(face) (*(p++)) = field(x,y,z).jf##Y;     \
       Z##Y##_EDGE_LOOP(face) (*(p++)) = field(x,y,z).jf##Z;     \
@@ -448,15 +634,125 @@ synchronize_jf( field_array_t * RESTRICT fa ) {
     }                                                           \
   } END_PRIMITIVE
 
+  // Edge messages hold the currents along the shared edge (oriented
+  // along axis Z).
+
+# define BEGIN_RECV_EDGE(i,j,k,Z)                                       \
+  begin_recv_diagonal(i,j,k, ( 3 + n##Z )*sizeof(float), g )
+
+# define BEGIN_SEND_EDGE(i,j,k,Z) BEGIN_PRIMITIVE {             \
+    size = ( 3 + n##Z )*sizeof(float);                          \
+    p = size_send_diagonal( i, j, k, size, g );                 \
+    if( p ) {                                                   \
+      (*(p++)) = g->dx;                                         \
+      (*(p++)) = g->dy;                                         \
+      (*(p++)) = g->dz;                                         \
+      Z##_LINE_EDGE_LOOP(i,j,k) (*(p++)) = field(x,y,z).jf##Z;  \
+      begin_send_diagonal( i, j, k, size, g );                  \
+    }                                                           \
+  } END_PRIMITIVE
+
+  BEGIN_RECV((-1), 0, 0,x,y,z);
+  BEGIN_RECV( 1, 0, 0,x,y,z);
+  BEGIN_RECV( 0,(-1), 0,y,z,x);
+  BEGIN_RECV( 0, 1, 0,y,z,x);
+  BEGIN_RECV( 0, 0,(-1),z,x,y);
+  BEGIN_RECV( 0, 0, 1,z,x,y);
+
+  BEGIN_RECV_EDGE((-1),(-1), 0,z);
+  BEGIN_RECV_EDGE( 1,(-1), 0,z);
+  BEGIN_RECV_EDGE((-1), 1, 0,z);
+  BEGIN_RECV_EDGE( 1, 1, 0,z);
+  BEGIN_RECV_EDGE((-1), 0,(-1),y);
+  BEGIN_RECV_EDGE( 1, 0,(-1),y);
+  BEGIN_RECV_EDGE((-1), 0, 1,y);
+  BEGIN_RECV_EDGE( 1, 0, 1,y);
+  BEGIN_RECV_EDGE( 0,(-1),(-1),x);
+  BEGIN_RECV_EDGE( 0, 1,(-1),x);
+  BEGIN_RECV_EDGE( 0,(-1), 1,x);
+  BEGIN_RECV_EDGE( 0, 1, 1,x);
+
+  BEGIN_SEND((-1), 0, 0,x,y,z);
+  BEGIN_SEND( 1, 0, 0,x,y,z);
+  BEGIN_SEND( 0,(-1), 0,y,z,x);
+  BEGIN_SEND( 0, 1, 0,y,z,x);
+  BEGIN_SEND( 0, 0,(-1),z,x,y);
+  BEGIN_SEND( 0, 0, 1,z,x,y);
+
+  BEGIN_SEND_EDGE((-1),(-1), 0,z);
+  BEGIN_SEND_EDGE( 1,(-1), 0,z);
+  BEGIN_SEND_EDGE((-1), 1, 0,z);
+  BEGIN_SEND_EDGE( 1, 1, 0,z);
+  BEGIN_SEND_EDGE((-1), 0,(-1),y);
+  BEGIN_SEND_EDGE( 1, 0,(-1),y);
+  BEGIN_SEND_EDGE((-1), 0, 1,y);
+  BEGIN_SEND_EDGE( 1, 0, 1,y);
+  BEGIN_SEND_EDGE( 0,(-1),(-1),x);
+  BEGIN_SEND_EDGE( 0, 1,(-1),x);
+  BEGIN_SEND_EDGE( 0,(-1), 1,x);
+  BEGIN_SEND_EDGE( 0, 1, 1,x);
+
+# undef BEGIN_RECV
+# undef BEGIN_SEND
+# undef BEGIN_RECV_EDGE
+# undef BEGIN_SEND_EDGE
+}
+
+void
+end_synchronize_jf( field_array_t * RESTRICT fa ) {
+  field_t * field, * f;
+  grid_t * RESTRICT g;
+  int face, x, y, z, nx, ny, nz, i, j, k;
+  float *msg[27], *p, *q, lw, rw;
+
+  if( !fa ) ERROR(( "Bad args" ));
+  field = fa->f;
+  g     = fa->g;
+
+  nx = g->nx;
+  ny = g->ny;
+  nz = g->nz;
+
+  // Complete the receives
+
+  for( k=-1; k<=1; k++ )
+    for( j=-1; j<=1; j++ )
+      for( i=-1; i<=1; i++ )
+        switch( (i!=0) + (j!=0) + (k!=0) ) {
+        case 1:  MSG(i,j,k) = (float *)end_recv_port( i,j,k, g ); break;
+        case 2:  MSG(i,j,k) = end_recv_diagonal( i,j,k, g );     break;
+        default: MSG(i,j,k) = NULL;                              break;
+        }
+
+  // Bring the edges of the y-face messages up to date with the x-pass
+  // and the edges of the z-face messages up to date with the x and
+  // y-passes.  The y-face messages hold jfz (zx-edges) then jfx; the
+  // z-face messages hold jfx (xy-edges) then jfy (yx-edges).
+
+  for( j=-1; j<=1; j+=2 )
+    for( i=-1; i<=1; i+=2 )
+      if( (p=MSG(0,j,0)) && (q=MSG(i,j,0)) )
+        combine_jf( p+3+SIDE(-i,nx)-1, nx+1, q+3, nz, p[2], q[0] );
+
+  for( k=-1; k<=1; k+=2 ) {
+    for( j=-1; j<=1; j+=2 )
+      if( (p=MSG(0,0,k)) && (q=MSG(0,j,k)) )
+        combine_jf( p+3+(SIDE(-j,ny)-1)*nx, 1, q+3, nx, p[2], q[1] );
+    for( i=-1; i<=1; i+=2 )
+      if( (p=MSG(0,0,k)) && (q=MSG(i,0,k)) )
+        combine_jf( p+3+nx*(ny+1)+SIDE(-i,nx)-1, nx+1, q+3, ny, p[1], q[0] );
+  }
+
 # define END_RECV(i,j,k,X,Y,Z) BEGIN_PRIMITIVE {                \
-    p = (float *)end_recv_port(i,j,k,g);                        \
+    p = MSG(i,j,k);                                             \
     if( p ) {                                                   \
-      rw = (*(p++));                 /* Remote g->d##X */       \
+      rw = p[0];                     /* Remote g->d##X */       \
       lw = rw + g->d##X;                                        \
       rw /= lw;                                                 \
       lw = g->d##X/lw;                                          \
       lw += lw;                                                 \
       rw += rw;                                                 \
+      p += 3;                                                   \
       face = (i+j+k)<0 ? n##X+1 : 1; /* Twice weighted sum */   \
       Y##Z##_EDGE_LOOP(face) {                                  \
         f = &field(x,y,z);                                      \
@@ -469,42 +765,31 @@ synchronize_jf( field_array_t * RESTRICT fa ) {
     }                                                           \
   } END_PRIMITIVE
 
-# define END_SEND(i,j,k,X,Y,Z) end_send_port( i, j, k, g )
-
-  // Exchange x-faces
-  BEGIN_SEND((-1), 0, 0,x,y,z);
-  BEGIN_SEND( 1, 0, 0,x,y,z);
-  BEGIN_RECV((-1), 0, 0,x,y,z);
-  BEGIN_RECV( 1, 0, 0,x,y,z);
   END_RECV((-1), 0, 0,x,y,z);
   END_RECV( 1, 0, 0,x,y,z);
-  END_SEND((-1), 0, 0,x,y,z);
-  END_SEND( 1, 0, 0,x,y,z);
-
-  // Exchange y-faces
-  BEGIN_SEND( 0,(-1), 0,y,z,x);
-  BEGIN_SEND( 0, 1, 0,y,z,x);
-  BEGIN_RECV( 0,(-1), 0,y,z,x);
-  BEGIN_RECV( 0, 1, 0,y,z,x);
   END_RECV( 0,(-1), 0,y,z,x);
   END_RECV( 0, 1, 0,y,z,x);
-  END_SEND( 0,(-1), 0,y,z,x);
-  END_SEND( 0, 1, 0,y,z,x);
-
-  // Exchange z-faces
-  BEGIN_SEND( 0, 0,(-1),z,x,y);
-  BEGIN_SEND( 0, 0, 1,z,x,y);
-  BEGIN_RECV( 0, 0,(-1),z,x,y);
-  BEGIN_RECV( 0, 0, 1,z,x,y);
   END_RECV( 0, 0,(-1),z,x,y);
   END_RECV( 0, 0, 1,z,x,y);
-  END_SEND( 0, 0,(-1),z,x,y);
-  END_SEND( 0, 0, 1,z,x,y);
 
-# undef BEGIN_RECV
-# undef BEGIN_SEND
 # undef END_RECV
-# undef END_SEND
+
+  // Complete the sends
+
+  for( k=-1; k<=1; k++ )
+    for( j=-1; j<=1; j++ )
+      for( i=-1; i<=1; i++ )
+        switch( (i!=0) + (j!=0) + (k!=0) ) {
+        case 1: end_send_port( i,j,k, g );     break;
+        case 2: end_send_diagonal( i,j,k, g ); break;
+        default:                               break;
+        }
+}
+
+void
+synchronize_jf( field_array_t * RESTRICT fa ) {
+  begin_synchronize_jf( fa );
+  end_synchronize_jf( fa );
 }
 
 // Note: synchronize_rho assumes that rhof has _not_ been adjusted at
@@ -532,11 +817,11 @@ synchronize_jf( field_array_t * RESTRICT fa ) {
 // form.
 
 void
-synchronize_rho( field_array_t * RESTRICT fa ) {
+begin_synchronize_rho( field_array_t * RESTRICT fa ) {
   field_t * field, * f;
   grid_t * RESTRICT g;
   int size, face, x, y, z, nx, ny, nz;
-  float *p, hlw, hrw, lw, rw;
+  float *p;
 
   if( !fa ) ERROR(( "Bad args" ));
   field = fa->f;
@@ -544,19 +829,22 @@ synchronize_rho( field_array_t * RESTRICT fa ) {
 
   local_adjust_rhof( field, g );
   local_adjust_rhob( field, g );
+  gather_face_nbr( g );
 
   nx = g->nx;
   ny = g->ny;
   nz = g->nz;
 
 # define BEGIN_RECV(i,j,k,X,Y,Z) \
-  begin_recv_port(i,j,k, ( 1 + 2*(n##Y+1)*(n##Z+1) )*sizeof(float), g )
+  begin_recv_port(i,j,k, ( 3 + 2*(n##Y+1)*(n##Z+1) )*sizeof(float), g )
 
 # define BEGIN_SEND(i,j,k,X,Y,Z) BEGIN_PRIMITIVE {      \
-    size = ( 1 + 2*(n##Y+1)*(n##Z+1) )*sizeof(float);   \
+    size = ( 3 + 2*(n##Y+1)*(n##Z+1) )*sizeof(float);   \
     p = (float *)size_send_port( i, j, k, size, g );    \
     if( p ) {                                           \
       (*(p++)) = g->d##X;                               \
+      (*(p++)) = g->d##Y;                               \
+      (*(p++)) = g->d##Z;                               \
       face = (i+j+k)<0 ? 1 : n##X+1;                    \
       X##_NODE_LOOP(face) {                             \
         f = &field(x,y,z);                              \
@@ -567,15 +855,138 @@ synchronize_rho( field_array_t * RESTRICT fa ) {
     }                                                   \
   } END_PRIMITIVE
 
+  // Edge messages hold the nodes along the shared edge (oriented along
+  // axis Z) and corner messages hold the shared corner node.
+
+# define BEGIN_RECV_DIAGONAL(i,j,k,n) \
+  begin_recv_diagonal(i,j,k, ( 3 + 2*(n) )*sizeof(float), g )
+
+# define BEGIN_SEND_DIAGONAL(i,j,k,n,LOOP) BEGIN_PRIMITIVE {    \
+    size = ( 3 + 2*(n) )*sizeof(float);                         \
+    p = size_send_diagonal( i, j, k, size, g );                 \
+    if( p ) {                                                   \
+      (*(p++)) = g->dx;                                         \
+      (*(p++)) = g->dy;                                         \
+      (*(p++)) = g->dz;                                         \
+      LOOP(i,j,k) {                                             \
+        f = &field(x,y,z);                                      \
+        (*(p++)) = f->rhof;                                     \
+        (*(p++)) = f->rhob;                                     \
+      }                                                         \
+      begin_send_diagonal( i, j, k, size, g );                  \
+    }                                                           \
+  } END_PRIMITIVE
+
+# define DIAGONALS(OP)                                  \
+  OP((-1),(-1), 0,   nz+1, z_LINE_NODE_LOOP);           \
+  OP( 1,(-1), 0,     nz+1, z_LINE_NODE_LOOP);           \
+  OP((-1), 1, 0,     nz+1, z_LINE_NODE_LOOP);           \
+  OP( 1, 1, 0,       nz+1, z_LINE_NODE_LOOP);           \
+  OP((-1), 0,(-1),   ny+1, y_LINE_NODE_LOOP);           \
+  OP( 1, 0,(-1),     ny+1, y_LINE_NODE_LOOP);           \
+  OP((-1), 0, 1,     ny+1, y_LINE_NODE_LOOP);           \
+  OP( 1, 0, 1,       ny+1, y_LINE_NODE_LOOP);           \
+  OP( 0,(-1),(-1),   nx+1, x_LINE_NODE_LOOP);           \
+  OP( 0, 1,(-1),     nx+1, x_LINE_NODE_LOOP);           \
+  OP( 0,(-1), 1,     nx+1, x_LINE_NODE_LOOP);           \
+  OP( 0, 1, 1,       nx+1, x_LINE_NODE_LOOP);           \
+  OP((-1),(-1),(-1), 1,    CORNER_NODE_LOOP);           \
+  OP( 1,(-1),(-1),   1,    CORNER_NODE_LOOP);           \
+  OP((-1), 1,(-1),   1,    CORNER_NODE_LOOP);           \
+  OP( 1, 1,(-1),     1,    CORNER_NODE_LOOP);           \
+  OP((-1),(-1), 1,   1,    CORNER_NODE_LOOP);           \
+  OP( 1,(-1), 1,     1,    CORNER_NODE_LOOP);           \
+  OP((-1), 1, 1,     1,    CORNER_NODE_LOOP);           \
+  OP( 1, 1, 1,       1,    CORNER_NODE_LOOP)
+
+# define RECV_OP(i,j,k,n,LOOP) BEGIN_RECV_DIAGONAL(i,j,k,n)
+
+  BEGIN_RECV((-1), 0, 0,x,y,z);
+  BEGIN_RECV( 1, 0, 0,x,y,z);
+  BEGIN_RECV( 0,(-1), 0,y,z,x);
+  BEGIN_RECV( 0, 1, 0,y,z,x);
+  BEGIN_RECV( 0, 0,(-1),z,x,y);
+  BEGIN_RECV( 0, 0, 1,z,x,y);
+  DIAGONALS(RECV_OP);
+
+  BEGIN_SEND((-1), 0, 0,x,y,z);
+  BEGIN_SEND( 1, 0, 0,x,y,z);
+  BEGIN_SEND( 0,(-1), 0,y,z,x);
+  BEGIN_SEND( 0, 1, 0,y,z,x);
+  BEGIN_SEND( 0, 0,(-1),z,x,y);
+  BEGIN_SEND( 0, 0, 1,z,x,y);
+  DIAGONALS(BEGIN_SEND_DIAGONAL);
+
+# undef BEGIN_RECV
+# undef BEGIN_SEND
+# undef BEGIN_RECV_DIAGONAL
+# undef BEGIN_SEND_DIAGONAL
+# undef DIAGONALS
+# undef RECV_OP
+}
+
+void
+end_synchronize_rho( field_array_t * RESTRICT fa ) {
+  field_t * field, * f;
+  grid_t * RESTRICT g;
+  int face, x, y, z, nx, ny, nz, i, j, k;
+  float *msg[27], *p, *q, *r, hlw, hrw, lw, rw;
+
+  if( !fa ) ERROR(( "Bad args" ));
+  field = fa->f;
+  g     = fa->g;
+
+  nx = g->nx;
+  ny = g->ny;
+  nz = g->nz;
+
+  // Complete the receives
+
+  for( k=-1; k<=1; k++ )
+    for( j=-1; j<=1; j++ )
+      for( i=-1; i<=1; i++ )
+        switch( (i!=0) + (j!=0) + (k!=0) ) {
+        case 0:  MSG(i,j,k) = NULL;                              break;
+        case 1:  MSG(i,j,k) = (float *)end_recv_port( i,j,k, g ); break;
+        default: MSG(i,j,k) = end_recv_diagonal( i,j,k, g );     break;
+        }
+
+  // Bring the edges of the y-face messages up to date with the x-pass.
+  // For the z-face messages, first bring the corners of the yz-edge
+  // messages up to date with the x-pass, then the edges of the z-face
+  // messages up to date with the x and then the y-pass.  The y-face
+  // messages hold nodes in (x,z) order and the z-face messages in (x,y)
+  // order.
+
+  for( j=-1; j<=1; j+=2 )
+    for( i=-1; i<=1; i+=2 )
+      if( (p=MSG(0,j,0)) && (q=MSG(i,j,0)) )
+        combine_rho( p+3+2*(SIDE(-i,nx)-1), nx+1, q+3, nz+1, p[2], q[0] );
+
+  for( k=-1; k<=1; k+=2 ) {
+    for( j=-1; j<=1; j+=2 )
+      for( i=-1; i<=1; i+=2 )
+        if( (q=MSG(0,j,k)) && (r=MSG(i,j,k)) )
+          combine_rho( q+3+2*(SIDE(-i,nx)-1), 1, r+3, 1, q[0], r[0] );
+    if( !(p=MSG(0,0,k)) ) continue;
+    for( i=-1; i<=1; i+=2 )
+      if( (q=MSG(i,0,k)) )
+        combine_rho( p+3+2*(SIDE(-i,nx)-1), nx+1, q+3, ny+1, p[1], q[0] );
+    for( j=-1; j<=1; j+=2 )
+      if( (q=MSG(0,j,k)) )
+        combine_rho( p+3+2*(SIDE(-j,ny)-1)*(nx+1), 1, q+3, nx+1, p[2], q[1] );
+  }
+
 # define END_RECV(i,j,k,X,Y,Z) BEGIN_PRIMITIVE {                \
-    p = (float *)end_recv_port(i,j,k,g);                        \
+    p = MSG(i,j,k);                                             \
     if( p ) {                                                   \
-      hrw  = (*(p++));               /* Remote g->d##X */       \
+      hrw  = p[0];                   /* Remote g->d##X */       \
       hlw  = hrw + g->d##X;                                     \
       hrw /= hlw;                                               \
       hlw  = g->d##X/hlw;                                       \
       lw   = hlw + hlw;                                         \
       rw   = hrw + hrw;                                         \
+      p   += 3;                                                 \
       face = (i+j+k)<0 ? n##X+1 : 1;                            \
       X##_NODE_LOOP(face) {					\
         f = &field(x,y,z);					\
@@ -585,41 +996,29 @@ synchronize_rho( field_array_t * RESTRICT fa ) {
     }                                                           \
   } END_PRIMITIVE
 
-# define END_SEND(i,j,k,X,Y,Z) end_send_port( i, j, k, g )
-
-  // Exchange x-faces
-  BEGIN_SEND((-1), 0, 0,x,y,z);
-  BEGIN_SEND( 1, 0, 0,x,y,z);
-  BEGIN_RECV((-1), 0, 0,x,y,z);
-  BEGIN_RECV( 1, 0, 0,x,y,z);
   END_RECV((-1), 0, 0,x,y,z);
   END_RECV( 1, 0, 0,x,y,z);
-  END_SEND((-1), 0, 0,x,y,z);
-  END_SEND( 1, 0, 0,x,y,z);
-
-  // Exchange y-faces
-  BEGIN_SEND( 0,(-1), 0,y,z,x);
-  BEGIN_SEND( 0, 1, 0,y,z,x);
-  BEGIN_RECV( 0,(-1), 0,y,z,x);
-  BEGIN_RECV( 0, 1, 0,y,z,x);
   END_RECV( 0,(-1), 0,y,z,x);
   END_RECV( 0, 1, 0,y,z,x);
-  END_SEND( 0,(-1), 0,y,z,x);
-  END_SEND( 0, 1, 0,y,z,x);
-
-  // Exchange z-faces
-  BEGIN_SEND( 0, 0,(-1),z,x,y);
-  BEGIN_SEND( 0, 0, 1,z,x,y);
-  BEGIN_RECV( 0, 0,(-1),z,x,y);
-  BEGIN_RECV( 0, 0, 1,z,x,y);
   END_RECV( 0, 0,(-1),z,x,y);
   END_RECV( 0, 0, 1,z,x,y);
-  END_SEND( 0, 0,(-1),z,x,y);
-  END_SEND( 0, 0, 1,z,x,y);
 
-# undef BEGIN_RECV
-# undef BEGIN_SEND
 # undef END_RECV
-# undef END_SEND
+
+  // Complete the sends
+
+  for( k=-1; k<=1; k++ )
+    for( j=-1; j<=1; j++ )
+      for( i=-1; i<=1; i++ )
+        switch( (i!=0) + (j!=0) + (k!=0) ) {
+        case 0:                                break;
+        case 1: end_send_port( i,j,k, g );     break;
+        default: end_send_diagonal( i,j,k, g ); break;
+        }
 }
 
+void
+synchronize_rho( field_array_t * RESTRICT fa ) {
+  begin_synchronize_rho( fa );
+  end_synchronize_rho( fa );
+}
@@ -21,6 +21,8 @@ static field_advance_kernels_t sfa_kernels = {
 
   clear_jf,   synchronize_jf,
   clear_rhof, synchronize_rho,
+  begin_synchronize_jf,  end_synchronize_jf,
+  begin_synchronize_rho, end_synchronize_rho,
 
   // Initialize interface
 
@@ -246,3 +248,35 @@ clear_rhof( field_array_t * RESTRICT fa ) {
 
 // FIXME: ADD clear_jf_and_rhof CALL AND/OR ELIMINATE SOME OF THE ABOVE
 // (MORE EFFICIENT TOO).
+
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( delete_standard_field_array )
+REGISTER_SYMBOL( checkpt_standard_field_array )
+REGISTER_SYMBOL( restore_standard_field_array )
+REGISTER_SYMBOL( advance_b )
+REGISTER_SYMBOL( advance_e )
+REGISTER_SYMBOL( energy_f )
+REGISTER_SYMBOL( clear_jf )
+REGISTER_SYMBOL( synchronize_jf )
+REGISTER_SYMBOL( clear_rhof )
+REGISTER_SYMBOL( synchronize_rho )
+REGISTER_SYMBOL( begin_synchronize_jf )
+REGISTER_SYMBOL( end_synchronize_jf )
+REGISTER_SYMBOL( begin_synchronize_rho )
+REGISTER_SYMBOL( end_synchronize_rho )
+REGISTER_SYMBOL( compute_rhob )
+REGISTER_SYMBOL( compute_curl_b )
+REGISTER_SYMBOL( synchronize_tang_e_norm_b )
+REGISTER_SYMBOL( compute_div_e_err )
+REGISTER_SYMBOL( compute_rms_div_e_err )
+REGISTER_SYMBOL( clean_div_e )
+REGISTER_SYMBOL( compute_div_b_err )
+REGISTER_SYMBOL( compute_rms_div_b_err )
+REGISTER_SYMBOL( clean_div_b )
+REGISTER_SYMBOL( vacuum_advance_e )
+REGISTER_SYMBOL( vacuum_energy_f )
+REGISTER_SYMBOL( vacuum_compute_rhob )
+REGISTER_SYMBOL( vacuum_compute_curl_b )
+REGISTER_SYMBOL( vacuum_compute_div_e_err )
+REGISTER_SYMBOL( vacuum_clean_div_e )
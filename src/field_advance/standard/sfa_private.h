@@ -385,6 +385,18 @@ synchronize_jf( field_array_t * RESTRICT fa );
 void
 synchronize_rho( field_array_t * RESTRICT fa );
 
+void
+begin_synchronize_jf( field_array_t * RESTRICT fa );
+
+void
+end_synchronize_jf( field_array_t * RESTRICT fa );
+
+void
+begin_synchronize_rho( field_array_t * RESTRICT fa );
+
+void
+end_synchronize_rho( field_array_t * RESTRICT fa );
+
 // In local.c
 
 void
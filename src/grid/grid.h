@@ -70,6 +70,34 @@ enum grid_enums {
 
 };
 
+// Voxel storage orders.  These determine the order in which voxel
+// indexed particle data (the particle sort, interpolators and
+// accumulators) is laid out in memory.  Fields and hydro arrays are
+// always stored in FORTRAN order.
+
+enum sfc_enums {
+  fortran_order = 0, // Voxels stored in FORTRAN order (g->sfc[i]==i)
+  morton_order  = 1, // Non-ghost voxels stored along a Morton (Z) curve
+  hilbert_order = 2  // Non-ghost voxels stored along a Hilbert curve
+
+  // For the space filling curve orders, the non-ghost voxels occupy
+  // storage indices 0:nx*ny*nz-1 in curve order and the ghost voxels
+  // occupy the remaining storage indices in FORTRAN order.  Curves
+  // are defined on the smallest power-of-two cube that covers the
+  // local domain; voxels outside the domain are simply skipped.
+};
+
+// Global domain decompositions.  These record which of the
+// partition_*_box functions built the grid.  Only such grids can be
+// repartitioned.
+
+enum partition_enums {
+  custom_partition    = 0, // Grid assembled with size_grid / join_grid
+  periodic_partition  = 1, // partition_periodic_box
+  absorbing_partition = 2, // partition_absorbing_box
+  metal_partition     = 3  // partition_metal_box
+};
+
 typedef struct grid {
 
   // System of units
@@ -128,6 +156,33 @@ typedef struct grid {
   // Nearest neighbor communications ports
   mp_t * mp;
 
+  // Voxel storage order
+  int sfc_order;          // Voxel storage order (see sfc_enums)
+  int * ALIGNED(128) sfc; // (0:nv-1) indexed array giving the storage
+                          // index of the voxel with local index i.
+                          // Interpolators and accumulators for voxel i
+                          // live at sfc[i] and species partitions are
+                          // indexed by sfc[i].  Storage indices of
+                          // non-ghost voxels lie on [sfc_lo,sfc_hi].
+  int sfc_lo, sfc_hi;     // (CONVENIENCE)
+
+  // Global domain decomposition (see partition_enums).  Only valid
+  // if partition!=custom_partition.
+  int partition;          // How the grid was partitioned
+  double gx0, gy0, gz0;   // Min corner global domain
+  double gx1, gy1, gz1;   // Max corner global domain
+  int gnx, gny, gnz;      // Global voxel mesh resolution
+  int gpx, gpy, gpz;      // Process mesh resolution.  The rank at
+                          // process mesh coordinates (px,py,pz) is
+                          // px + gpx*( py + gpy*pz ).
+  int * ALIGNED(16) cut;  // (0:gpx+gpy+gpz+2) indexed array of
+                          // rectilinear domain cuts.  With cx = cut,
+                          // cy = cx+gpx+1 and cz = cy+gpy+1, the
+                          // ranks at process mesh coordinate px own
+                          // global voxels cx[px]+1:cx[px+1] along x
+                          // (and similarly for y and z).  cx[0] = 0
+                          // and cx[gpx] = gnx.
+
 } grid_t;
 
 // Given a voxel mesh coordinates (on 0:nx+1,0:ny+1,0:nz+1) and
@@ -135,6 +190,36 @@ typedef struct grid {
 
 #define VOXEL(x,y,z, nx,ny,nz) ((x) + ((nx)+2)*((y) + ((ny)+2)*(z)))
 
+// A global_voxel_map_t converts local voxel indices into global voxel
+// indices (see global_voxel_map and global_voxel).  The global index
+// of a voxel of a grid built by one of the partition_*_box functions
+// is VOXEL(gx,gy,gz, gnx,gny,gnz) with (gx,gy,gz) the voxel's
+// coordinates on the global voxel mesh, so it does not depend on the
+// domain decomposition.  Grids assembled with size_grid / join_grid
+// have no global voxel mesh; their voxels get rangel plus the local
+// index.
+
+typedef struct global_voxel_map {
+  int64_t g0;             // Global index of local voxel 0
+  int64_t gsy, gsz;       // Global index strides along y and z
+  int sy, sz;             // Local index strides along y and z
+  double rsy, rsz;        // 1/sy and 1/sz
+} global_voxel_map_t;
+
+// Return the global index of the local voxel v (on 0:nv-1).  The local
+// voxel coordinates are recovered with floating point reciprocals
+// instead of integer divides; this is exact for any index that fits
+// in an int.
+
+STATIC_INLINE int64_t
+global_voxel( const global_voxel_map_t * RESTRICT m,
+              int v ) {
+  int y, z;
+  z  = (int)( ( (double)v + 0.5 )*m->rsz ); v -= z*m->sz;
+  y  = (int)( ( (double)v + 0.5 )*m->rsy ); v -= y*m->sy;
+  return m->g0 + (int64_t)v + m->gsy*(int64_t)y + m->gsz*(int64_t)z;
+}
+
 // Advance the voxel mesh index (v) and corresponding voxel mesh
 // coordinates (x,y,z) in a region with min- and max-corners of
 // (xl,yl,zl) and (xh,yh,zh) of a (nx,ny,nz) resolution voxel mesh in
@@ -185,6 +270,15 @@ set_fbc( grid_t *g, int bound, int fbc );
 void
 set_pbc( grid_t *g, int bound, int pbc );
 
+// Select the voxel storage order (see sfc_enums).  Can be called
+// before or after the grid is sized.  This must be done before any
+// particles are advanced as previously sorted species partitions,
+// loaded interpolators and accumulators (see reset_accumulator_array)
+// are invalidated.  vpic's set_domain_voxel_order resets them.
+
+void
+set_sfc_order( grid_t *g, int sfc_order );
+
 // In partition.c
 
 // g->{n,d}{x,y,z} is _coherent_ on all nodes in the domain after
@@ -240,6 +334,39 @@ partition_metal_box( grid_t *g,
                      int gnx, int gny, int gnz,
                      int gpx, int gpy, int gpz );
 
+// Repartition a grid built by one of the above with the rectilinear
+// domain cuts cut (see grid_t).  The grid is resized and rejoined to
+// its neighbors with the same global boundary conditions.  Everybody
+// must repartition in parallel with the same cuts.  Any local data
+// indexed by voxel is invalidated.
+
+void
+repartition_box( grid_t *g,
+                 const int * cut );
+
+// Repartition a grid built by one of the above onto a gpx x gpy x gpz
+// process mesh (which may differ from the one it was built with) with
+// the rectilinear domain cuts cut.  Restarting on a different number of
+// ranks uses this.  fbc and pbc give the field and particle boundary
+// conditions of the global domain faces in the order -x, -y, -z, +x,
+// +y, +z.  Faces with a negative fbc get them; the others stay
+// periodic.  Must be called in parallel like repartition_box.
+
+void
+remesh_box( grid_t *g,
+            int gpx, int gpy, int gpz,
+            const int * cut,
+            const int * fbc,
+            const int64_t * pbc );
+
+// Fill m with the global voxel index map of the local grid (see
+// global_voxel_map_t).  The map is invalidated when the grid is
+// repartitioned, remeshed or resized.
+
+void
+global_voxel_map( global_voxel_map_t * m,
+                  const grid_t * g );
+
 // In grid_comm.c
 
 // FIXME: SHOULD TAKE A RAW PORT INDEX INSTEAD OF A PORT COORDS
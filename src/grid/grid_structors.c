@@ -18,6 +18,8 @@ checkpt_grid( const grid_t * g ) {
   CHECKPT( g, 1 );
   if( g->range    ) CHECKPT_ALIGNED( g->range, world_size+1, 16 );
   if( g->neighbor ) CHECKPT_ALIGNED( g->neighbor, 6*g->nv, 128 );
+  if( g->sfc      ) CHECKPT_ALIGNED( g->sfc, g->nv, 128 );
+  if( g->cut      ) CHECKPT_ALIGNED( g->cut, g->gpx+g->gpy+g->gpz+3, 16 );
   CHECKPT_PTR( g->mp );
 }
 
@@ -27,6 +29,8 @@ restore_grid( void ) {
   RESTORE( g );
   if( g->range    ) RESTORE_ALIGNED( g->range );
   if( g->neighbor ) RESTORE_ALIGNED( g->neighbor );
+  if( g->sfc      ) RESTORE_ALIGNED( g->sfc );
+  if( g->cut      ) RESTORE_ALIGNED( g->cut );
   RESTORE_PTR( g->mp );
   return g;
 }
@@ -48,9 +52,15 @@ void
 delete_grid( grid_t * g ) {
   if( !g ) return;
   UNREGISTER_OBJECT( g );
+  FREE_ALIGNED( g->cut );
+  FREE_ALIGNED( g->sfc );
   FREE_ALIGNED( g->neighbor );
   FREE_ALIGNED( g->range );
   delete_mp( g->mp );
   FREE( g );
 }
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( checkpt_grid )
+REGISTER_SYMBOL( restore_grid )
@@ -13,6 +13,111 @@
 #define LOCAL_CELL_ID(x,y,z)  VOXEL(x,y,z, lnx,lny,lnz)
 #define REMOTE_CELL_ID(x,y,z) VOXEL(x,y,z, rnx,rny,rnz)
 
+// Space filling curve keys of the voxel mesh coordinates (x,y,z) on
+// a 2^b x 2^b x 2^b cube.  x is the fastest varying coordinate of
+// the curves (as it is for FORTRAN ordering).
+
+static int64_t
+morton_key( int x, int y, int z, int b ) {
+  int64_t key = 0;
+  int j;
+  for( j=b-1; j>=0; j-- )
+    key = (key<<3) | (((z>>j)&1)<<2) | (((y>>j)&1)<<1) | ((x>>j)&1);
+  return key;
+}
+
+// Uses J. Skilling's transpose algorithm ("Programming the Hilbert
+// curve", AIP Conf. Proc. 707, 2004).
+
+static int64_t
+hilbert_key( int x, int y, int z, int b ) {
+  int X[3], P, Q, t, i, j;
+  int64_t key = 0;
+  X[0] = z; X[1] = y; X[2] = x;
+  for( Q=1<<(b-1); Q>1; Q>>=1 ) { // Inverse undo excess work
+    P = Q-1;
+    for( i=0; i<3; i++ )
+      if( X[i] & Q ) X[0] ^= P;
+      else { t = (X[0]^X[i]) & P; X[0] ^= t; X[i] ^= t; }
+  }
+  for( i=1; i<3; i++ ) X[i] ^= X[i-1]; // Gray encode
+  for( t=0, Q=1<<(b-1); Q>1; Q>>=1 ) if( X[2] & Q ) t ^= Q-1;
+  for( i=0; i<3; i++ ) X[i] ^= t;
+  for( j=b-1; j>=0; j-- )              // Interleave the transpose
+    for( i=0; i<3; i++ ) key = (key<<1) | ((X[i]>>j)&1);
+  return key;
+}
+
+typedef struct sfc_voxel {
+  int64_t key; // Curve key
+  int v;       // Local voxel index
+} sfc_voxel_t;
+
+static int
+compare_sfc_voxel( const void * _a, const void * _b ) {
+  const sfc_voxel_t * a = (const sfc_voxel_t *)_a;
+  const sfc_voxel_t * b = (const sfc_voxel_t *)_b;
+  return a->key<b->key ? -1 : a->key>b->key ? 1 : 0;
+}
+
+void
+set_sfc_order( grid_t * g,
+               int sfc_order ) {
+  int lnx, lny, lnz, x, y, z, b, n, nv;
+  sfc_voxel_t * cv;
+
+  if( !g || sfc_order<fortran_order || sfc_order>hilbert_order )
+    ERROR(( "Bad args" ));
+
+  g->sfc_order = sfc_order;
+  if( !g->nv ) return; // size_grid will finish the job
+
+  lnx = g->nx;
+  lny = g->ny;
+  lnz = g->nz;
+  nv  = g->nv;
+
+  FREE_ALIGNED( g->sfc );
+  MALLOC_ALIGNED( g->sfc, nv, 128 );
+
+  if( sfc_order==fortran_order ) {
+    for( n=0; n<nv; n++ ) g->sfc[n] = n;
+    g->sfc_lo = LOCAL_CELL_ID(1,1,1);
+    g->sfc_hi = LOCAL_CELL_ID(lnx,lny,lnz);
+    return;
+  }
+
+  // Rank the non-ghost voxels by their curve key and append the ghost
+  // voxels in FORTRAN order.  This is only done at setup so a simple
+  // sort is fine.
+
+  for( b=1; (1<<b)<lnx || (1<<b)<lny || (1<<b)<lnz; b++ );
+  if( 3*b>63 ) ERROR(( "Local domain too large for a space filling curve" ));
+
+  MALLOC( cv, lnx*lny*lnz );
+  n = 0;
+  for( z=1; z<=lnz; z++ )
+    for( y=1; y<=lny; y++ )
+      for( x=1; x<=lnx; x++ ) {
+        cv[n].key = sfc_order==morton_order ? morton_key( x-1,y-1,z-1, b ) :
+                                              hilbert_key( x-1,y-1,z-1, b );
+        cv[n].v   = LOCAL_CELL_ID(x,y,z);
+        n++;
+      }
+  qsort( cv, n, sizeof(*cv), compare_sfc_voxel );
+  for( n=0; n<lnx*lny*lnz; n++ ) g->sfc[ cv[n].v ] = n;
+  FREE( cv );
+
+  for( z=0; z<=lnz+1; z++ )
+    for( y=0; y<=lny+1; y++ )
+      for( x=0; x<=lnx+1; x++ )
+        if( x==0 || x==lnx+1 || y==0 || y==lny+1 || z==0 || z==lnz+1 )
+          g->sfc[ LOCAL_CELL_ID(x,y,z) ] = n++;
+
+  g->sfc_lo = 0;
+  g->sfc_hi = lnx*lny*lnz-1;
+}
+
 // Everybody must size their local grid in parallel
 
 void
@@ -85,34 +190,9 @@ size_grid( grid_t * g,
         }
       }
 
-# if 0
-  // Setup the space filling curve
-  // FIXME: THIS IS A CRUDE HACK UNTIL A GOOD SFC CAN BE WRITTEN
-  // CURRENT SFC IS GOOD FOR THREADING WITH POWER-OF-TWO NUMBER OF THREADS.
-  // UP TO AND INCLUDING 8 THREADS.
+  // Setup the voxel storage order
 
-  FREE_ALIGNED( g->sfc );
-  MALLOC_ALIGNED( g->sfc, g->nv, 128 );
-
-  do {
-    int off;
-    int ox, oy, oz;
-    int nx, ny, nz;
-    int nx1 = (lnx+2)/2,   ny1 = (lny+2)/2,   nz1 = (lnz+2)/2;
-    int nx0 = (lnx+2)-nx1, ny0 = (lny+2)-ny1, nz0 = (lnz+2)-nz1;
-
-    for( z=0; z<=lnz+1; z++ )
-      for( y=0; y<=lny+1; y++ )
-        for( x=0; x<=lnx+1; x++ ) {
-          i = LOCAL_CELL_ID(x,y,z);
-          off = 0;
-          ox=x; nx=nx0; if(ox>=nx) ox-=nx, off+=nx,                 nx=nx1;
-          oy=y; ny=ny0; if(oy>=ny) oy-=ny, off+=ny*(lnx+2),         ny=ny1;
-          oz=z; nz=nz0; if(oz>=nz) oz-=nz, off+=nz*(lnx+2)*(lny+2), nz=nz1;
-          g->sfc[i] = off + ox + nx*( oy + ny*oz );
-        }
-  } while(0);
-# endif
+  set_sfc_order( g, g->sfc_order );
 }
 
 void
@@ -32,25 +32,18 @@
     (rank) = _ix + gpx*( _iy + gpy*_iz );            \
   } while(0)
 
-void
-partition_periodic_box( grid_t * g,
-                        double gx0, double gy0, double gz0,
-                        double gx1, double gy1, double gz1,
-                        int gnx, int gny, int gnz,
-                        int gpx, int gpy, int gpz ) {
+// Size the local grid and join it to its neighbors according to the
+// global domain decomposition recorded in the grid
+
+static void
+partition_box( grid_t * g ) {
+  const int gpx = g->gpx, gpy = g->gpy, gpz = g->gpz;
+  const int * cx = g->cut, * cy = cx+gpx+1, * cz = cy+gpy+1;
+  const double gx0 = g->gx0, gy0 = g->gy0, gz0 = g->gz0;
+  const double gx1 = g->gx1, gy1 = g->gy1, gz1 = g->gz1;
+  const int gnx = g->gnx, gny = g->gny, gnz = g->gnz;
   double f;
-  int rank, px, py, pz; 
-
-  // Make sure the grid can be setup
-
-  if( !g ) ERROR(( "NULL grid" ));
-
-  if( gpx<1 || gpy<1 || gpz<1 || gpx*gpy*gpz!=world_size )
-    ERROR(( "Bad domain decompostion (%ix%ix%i)", gpx, gpy, gpz ));
-
-  if( gnx<1 || gny<1 || gnz<1 || gnx%gpx!=0 || gny%gpy!=0 || gnz%gpz!=0 )
-    ERROR(( "Bad resolution (%ix%ix%i) for domain decomposition",
-            gnx, gny, gnz, gpx, gpy, gpz ));
+  int rank, px, py, pz;
 
   // Setup basic variables
   RANK_TO_INDEX( world_rank, px,py,pz );
@@ -69,16 +62,16 @@ partition_periodic_box( grid_t * g,
            ((double)gny/(gy1-gy0))*
            ((double)gnz/(gz1-gz0))*0.125;
 
-  f = (double) px   /(double)gpx; g->x0 = gx0*(1-f) + gx1*f;
-  f = (double) py   /(double)gpy; g->y0 = gy0*(1-f) + gy1*f;
-  f = (double) pz   /(double)gpz; g->z0 = gz0*(1-f) + gz1*f;
+  f = (double)cx[px  ]/(double)gnx; g->x0 = gx0*(1-f) + gx1*f;
+  f = (double)cy[py  ]/(double)gny; g->y0 = gy0*(1-f) + gy1*f;
+  f = (double)cz[pz  ]/(double)gnz; g->z0 = gz0*(1-f) + gz1*f;
 
-  f = (double)(px+1)/(double)gpx; g->x1 = gx0*(1-f) + gx1*f;
-  f = (double)(py+1)/(double)gpy; g->y1 = gy0*(1-f) + gy1*f;
-  f = (double)(pz+1)/(double)gpz; g->z1 = gz0*(1-f) + gz1*f;
+  f = (double)cx[px+1]/(double)gnx; g->x1 = gx0*(1-f) + gx1*f;
+  f = (double)cy[py+1]/(double)gny; g->y1 = gy0*(1-f) + gy1*f;
+  f = (double)cz[pz+1]/(double)gnz; g->z1 = gz0*(1-f) + gz1*f;
 
   // Size the local grid
-  size_grid(g,gnx/gpx,gny/gpy,gnz/gpz);
+  size_grid(g,cx[px+1]-cx[px],cy[py+1]-cy[py],cz[pz+1]-cz[pz]);
 
   // Join the grid to neighbors
   INDEX_TO_RANK(px-1,py,  pz,  rank); join_grid(g,BOUNDARY(-1, 0, 0),rank);
@@ -89,6 +82,42 @@ partition_periodic_box( grid_t * g,
   INDEX_TO_RANK(px,  py,  pz+1,rank); join_grid(g,BOUNDARY( 0, 0, 1),rank);
 }
 
+void
+partition_periodic_box( grid_t * g,
+                        double gx0, double gy0, double gz0,
+                        double gx1, double gy1, double gz1,
+                        int gnx, int gny, int gnz,
+                        int gpx, int gpy, int gpz ) {
+  int * cut, p;
+
+  // Make sure the grid can be setup
+
+  if( !g ) ERROR(( "NULL grid" ));
+
+  if( gpx<1 || gpy<1 || gpz<1 || gpx*gpy*gpz!=world_size )
+    ERROR(( "Bad domain decompostion (%ix%ix%i)", gpx, gpy, gpz ));
+
+  if( gnx<1 || gny<1 || gnz<1 || gnx%gpx!=0 || gny%gpy!=0 || gnz%gpz!=0 )
+    ERROR(( "Bad resolution (%ix%ix%i) for domain decomposition",
+            gnx, gny, gnz, gpx, gpy, gpz ));
+
+  // Record the global domain and uniformly decompose it
+
+  g->partition = periodic_partition;
+  g->gx0 = gx0; g->gy0 = gy0; g->gz0 = gz0;
+  g->gx1 = gx1; g->gy1 = gy1; g->gz1 = gz1;
+  g->gnx = gnx; g->gny = gny; g->gnz = gnz;
+  g->gpx = gpx; g->gpy = gpy; g->gpz = gpz;
+
+  FREE_ALIGNED( g->cut );
+  MALLOC_ALIGNED( g->cut, gpx+gpy+gpz+3, 16 );
+  cut = g->cut;             for( p=0; p<=gpx; p++ ) cut[p] = p*(gnx/gpx);
+  cut = g->cut + gpx+1;     for( p=0; p<=gpy; p++ ) cut[p] = p*(gny/gpy);
+  cut = g->cut + gpx+gpy+2; for( p=0; p<=gpz; p++ ) cut[p] = p*(gnz/gpz);
+
+  partition_box( g );
+}
+
 void
 partition_absorbing_box( grid_t * g,
                          double gx0, double gy0, double gz0,
@@ -106,6 +135,8 @@ partition_absorbing_box( grid_t * g,
 
   // Override periodic boundary conditions
 
+  g->partition = absorbing_partition;
+
   RANK_TO_INDEX( world_rank, px,py,pz );
 
   if( px==0 && gnx>1 ) { 
@@ -158,6 +189,8 @@ partition_metal_box( grid_t * g,
 
   // Override periodic boundary conditions
 
+  g->partition = metal_partition;
+
   RANK_TO_INDEX( world_rank, px,py,pz );
 
   if( px==0 && gnx>1 ) {
@@ -190,3 +223,136 @@ partition_metal_box( grid_t * g,
     set_pbc(g,BOUNDARY(0,0,1),reflect_particles);
   }
 }
+
+void
+repartition_box( grid_t * g,
+                 const int * cut ) {
+  const int face[6] = { BOUNDARY(-1, 0, 0), BOUNDARY( 0,-1, 0),
+                        BOUNDARY( 0, 0,-1), BOUNDARY( 1, 0, 0),
+                        BOUNDARY( 0, 1, 0), BOUNDARY( 0, 0, 1) };
+  const int * c;
+  int64_t pbc[6];
+  int fbc[6], a, f, p, n, np, v;
+
+  if( !g || !cut ) ERROR(( "Bad args" ));
+
+  if( g->partition==custom_partition )
+    ERROR(( "Only grids built by the partition_*_box functions can be "
+            "repartitioned" ));
+
+  for( c=cut, a=0; a<3; c+=np+1, a++ ) {
+    n  = a==0 ? g->gnx : a==1 ? g->gny : g->gnz;
+    np = a==0 ? g->gpx : a==1 ? g->gpy : g->gpz;
+    if( c[0]!=0 || c[np]!=n ) ERROR(( "Bad domain cuts" ));
+    for( p=0; p<np; p++ )
+      if( c[p+1]<=c[p] ) ERROR(( "Bad domain cuts" ));
+  }
+
+  // A rank on a global domain face stays on it when the cuts move.
+  // Save the boundary conditions on such faces (partition_absorbing_box,
+  // partition_metal_box and set_domain_*_bc may have overridden them)
+  // so they survive rejoining the grid.
+
+  for( f=0; f<6; f++ ) {
+    fbc[f] = g->bc[ face[f] ];
+    v = f<3 ? VOXEL(1,1,1, g->nx,g->ny,g->nz) :
+                VOXEL(g->nx,g->ny,g->nz, g->nx,g->ny,g->nz);
+    pbc[f] = g->neighbor[ 6*v + f ];
+  }
+
+  COPY( g->cut, cut, g->gpx+g->gpy+g->gpz+3 );
+  partition_box( g );
+
+  for( f=0; f<6; f++ )
+    if( fbc[f]<0 ) {
+      set_fbc( g, face[f], fbc[f] );
+      set_pbc( g, face[f], pbc[f] );
+    }
+}
+
+void
+remesh_box( grid_t * g,
+            int gpx,
+            int gpy,
+            int gpz,
+            const int * cut,
+            const int * fbc,
+            const int64_t * pbc ) {
+  const int face[6] = { BOUNDARY(-1, 0, 0), BOUNDARY( 0,-1, 0),
+                        BOUNDARY( 0, 0,-1), BOUNDARY( 1, 0, 0),
+                        BOUNDARY( 0, 1, 0), BOUNDARY( 0, 0, 1) };
+  const int * c;
+  int px, py, pz, a, f, p, n, np, on_face;
+
+  if( !g || !cut || !fbc || !pbc ) ERROR(( "Bad args" ));
+
+  if( g->partition==custom_partition )
+    ERROR(( "Only grids built by the partition_*_box functions can be "
+            "remeshed" ));
+
+  if( gpx<1 || gpy<1 || gpz<1 || gpx*gpy*gpz!=world_size )
+    ERROR(( "Bad domain decompostion (%ix%ix%i)", gpx, gpy, gpz ));
+
+  for( c=cut, a=0; a<3; c+=np+1, a++ ) {
+    n  = a==0 ? g->gnx : a==1 ? g->gny : g->gnz;
+    np = a==0 ? gpx    : a==1 ? gpy    : gpz;
+    if( c[0]!=0 || c[np]!=n ) ERROR(( "Bad domain cuts" ));
+    for( p=0; p<np; p++ )
+      if( c[p+1]<=c[p] ) ERROR(( "Bad domain cuts" ));
+  }
+
+  g->gpx = gpx; g->gpy = gpy; g->gpz = gpz;
+
+  FREE_ALIGNED( g->cut );
+  MALLOC_ALIGNED( g->cut, gpx+gpy+gpz+3, 16 );
+  COPY( g->cut, cut, gpx+gpy+gpz+3 );
+  g->bc[ BOUNDARY(0,0,0) ] = world_rank;
+  partition_box( g );
+
+  RANK_TO_INDEX( world_rank, px,py,pz );
+
+  for( f=0; f<6; f++ ) {
+    switch( f ) {
+    case 0:  on_face = px==0;     break;
+    case 1:  on_face = py==0;     break;
+    case 2:  on_face = pz==0;     break;
+    case 3:  on_face = px==gpx-1; break;
+    case 4:  on_face = py==gpy-1; break;
+    default: on_face = pz==gpz-1; break;
+    }
+    if( on_face && fbc[f]<0 ) {
+      set_fbc( g, face[f], fbc[f] );
+      set_pbc( g, face[f], pbc[f] );
+    }
+  }
+}
+
+void
+global_voxel_map( global_voxel_map_t * m,
+                  const grid_t * g ) {
+  int gpx, gpy, px, py, pz;
+
+  if( !m || !g ) ERROR(( "Bad args" ));
+
+  m->sy  = g->nx+2;
+  m->sz  = (g->nx+2)*(g->ny+2);
+  m->rsy = 1./(double)m->sy;
+  m->rsz = 1./(double)m->sz;
+
+  if( g->partition==custom_partition ) {
+    m->g0  = g->rangel;
+    m->gsy = m->sy;
+    m->gsz = m->sz;
+    return;
+  }
+
+  // Local voxel (x,y,z) is global voxel (cx[px]+x,cy[py]+y,cz[pz]+z)
+
+  gpx = g->gpx, gpy = g->gpy;
+  RANK_TO_INDEX( world_rank, px,py,pz );
+  m->gsy = (int64_t)g->gnx+2;
+  m->gsz = ((int64_t)g->gnx+2)*((int64_t)g->gny+2);
+  m->g0  = (int64_t)g->cut[px] +
+           m->gsy*(int64_t)g->cut[gpx+1+py] +
+           m->gsz*(int64_t)g->cut[gpx+gpy+2+pz];
+}
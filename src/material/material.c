@@ -113,3 +113,7 @@ material( const char * name,
   return m;
 }
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( checkpt_material )
+REGISTER_SYMBOL( restore_material )
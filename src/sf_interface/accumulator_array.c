@@ -28,23 +28,62 @@ aa_n_pipeline(void)
   return n; // max( {serial,thread}.n_pipeline )
 }
 
+// Zero n_array accumulator arrays.  When the pipelines are bound to cores,
+// pipeline r first touches the array 1+r it accumulates into (see
+// pipeline_affinity).
+
+static void
+clear_accumulators( accumulator_t * ALIGNED(128) a,
+                    int n_array,
+                    int stride ) {
+  if( !pipeline_affinity || n_array<2 ) {
+    CLEAR( a, (size_t)n_array*(size_t)stride );
+    return;
+  }
+  CLEAR( a, stride );
+  clear_pipelines( a + stride, (size_t)stride*sizeof(accumulator_t),
+                   n_array-1, 1 );
+}
+
+/* Only the host accumulators are written, without their padding (see
+   ACCUMULATOR_RECORD_SIZE).  The pipeline accumulators are allocated and
+   cleared on restore and are resized if the number of pipelines
+   changed. */
+
 void
 checkpt_accumulator_array( const accumulator_array_t * aa ) {
   CHECKPT( aa, 1 );
-  CHECKPT_ALIGNED( aa->a, (size_t)(aa->n_pipeline+1)*(size_t)aa->stride, 128 );
+  checkpt_data( aa->a, ACCUMULATOR_RECORD_SIZE, sizeof(accumulator_t),
+                aa->stride, (size_t)aa->n_array*(size_t)aa->stride, 128 );
   CHECKPT_PTR( aa->g );
 }
 
 accumulator_array_t *
 restore_accumulator_array( void ) {
   accumulator_array_t * aa;
+  accumulator_t * a;
+  size_t sz;
   RESTORE( aa );
-  RESTORE_ALIGNED( aa->a );
+  RESTORE_STRIDED( aa->a );
   RESTORE_PTR( aa->g );
-  if( aa->n_pipeline!=aa_n_pipeline() )
-    ERROR(( "Number of accumulators restored is not the same as the number of "
-            "accumulators checkpointed.  Did you change the number of threads "
-            "per process between checkpt and restore?" ));
+  sz = (size_t)aa->n_array*(size_t)aa->stride;
+  CLEAR( aa->a + aa->stride, sz - aa->stride );
+  if( aa->n_pipeline!=aa_n_pipeline() ) {
+    aa->n_pipeline = aa_n_pipeline();
+    aa->n_array    = aa->tiled ? 1 : aa->n_pipeline+1;
+    sz = (size_t)aa->n_array*(size_t)aa->stride;
+    MALLOC_ALIGNED( a, sz, 128 );
+    clear_accumulators( a, aa->n_array, aa->stride );
+    COPY( a, aa->a, aa->stride );
+    FREE_ALIGNED( aa->a );
+    aa->a = a;
+  }
+  // The tiles are rebuilt as needed
+  aa->tile  = NULL;
+  aa->t     = NULL;
+  aa->max_t = 0;
+  aa->nbr   = NULL;
+  if( aa->tiled ) MALLOC( aa->tile, aa->n_pipeline );
   return aa;
 }
 
@@ -56,8 +95,14 @@ new_accumulator_array( grid_t * g ) {
   aa->n_pipeline = aa_n_pipeline();
   aa->stride     = POW2_CEIL(g->nv,2);
   aa->g          = g;
-  MALLOC_ALIGNED( aa->a, (size_t)(aa->n_pipeline+1)*(size_t)aa->stride, 128 );
-  CLEAR( aa->a, (size_t)(aa->n_pipeline+1)*(size_t)aa->stride );
+  aa->tiled      = 0;
+  aa->n_array    = aa->n_pipeline+1;
+  aa->tile       = NULL;
+  aa->t          = NULL;
+  aa->max_t      = 0;
+  aa->nbr        = NULL;
+  MALLOC_ALIGNED( aa->a, (size_t)aa->n_array*(size_t)aa->stride, 128 );
+  clear_accumulators( aa->a, aa->n_array, aa->stride );
   REGISTER_OBJECT( aa, checkpt_accumulator_array, restore_accumulator_array,
                   NULL );
   return aa;
@@ -67,7 +112,63 @@ void
 delete_accumulator_array( accumulator_array_t * aa ) {
   if( !aa ) return;
   UNREGISTER_OBJECT( aa );
+  FREE_ALIGNED( aa->nbr );
+  FREE_ALIGNED( aa->t );
+  FREE( aa->tile );
   FREE_ALIGNED( aa->a );
   FREE( aa );
 }
 
+void
+set_accumulator_array_tiling( accumulator_array_t * aa,
+                              int tiled ) {
+  accumulator_t * ALIGNED(128) a;
+  size_t sz;
+
+  if( !aa ) ERROR(( "Bad args" ));
+
+  tiled = tiled ? 1 : 0;
+  if( aa->tiled==tiled ) return;
+
+  aa->tiled   = tiled;
+  aa->n_array = tiled ? 1 : aa->n_pipeline+1;
+
+  sz = (size_t)aa->n_array*(size_t)aa->stride;
+  MALLOC_ALIGNED( a, sz, 128 );
+  clear_accumulators( a, aa->n_array, aa->stride );
+  COPY( a, aa->a, aa->stride );
+  FREE_ALIGNED( aa->a );
+  aa->a = a;
+
+  if( tiled ) {
+    MALLOC( aa->tile, aa->n_pipeline );
+  } else {
+    FREE( aa->tile );
+    FREE_ALIGNED( aa->t );
+    aa->max_t = 0;
+  }
+}
+
+void
+reset_accumulator_array( accumulator_array_t * aa ) {
+  size_t sz;
+
+  if( !aa ) ERROR(( "Bad args" ));
+
+  FREE_ALIGNED( aa->a );
+  aa->stride = POW2_CEIL( aa->g->nv, 2 );
+  sz = (size_t)aa->n_array*(size_t)aa->stride;
+  MALLOC_ALIGNED( aa->a, sz, 128 );
+  clear_accumulators( aa->a, aa->n_array, aa->stride );
+
+  FREE_ALIGNED( aa->nbr );
+}
+
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( checkpt_accumulator_array )
+REGISTER_SYMBOL( restore_accumulator_array )
+
+/* Arrays checkpointed raw (see REGISTER_LAYOUT) */
+
+REGISTER_LAYOUT_SIZE( accumulator_t, ACCUMULATOR_RECORD_SIZE )
@@ -220,3 +220,11 @@ synchronize_hydro_array( hydro_array_t * ha ) {
 # undef END_SEND
 }
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( checkpt_hydro_array )
+REGISTER_SYMBOL( restore_hydro_array )
+
+/* Arrays checkpointed raw (see REGISTER_LAYOUT) */
+
+REGISTER_LAYOUT( hydro_t )
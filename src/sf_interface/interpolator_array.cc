@@ -6,7 +6,8 @@ void
 checkpt_interpolator_array( const interpolator_array_t * ia )
 {
   CHECKPT( ia, 1 );
-  CHECKPT_ALIGNED( ia->i, ia->g->nv, 128 );
+  checkpt_data( ia->i, INTERPOLATOR_RECORD_SIZE, sizeof(interpolator_t),
+                ia->g->nv, ia->g->nv, 128 );
   CHECKPT_PTR( ia->g );
 }
 
@@ -15,7 +16,7 @@ restore_interpolator_array( void )
 {
   interpolator_array_t * ia;
   RESTORE( ia );
-  RESTORE_ALIGNED( ia->i );
+  RESTORE_STRIDED( ia->i );
   RESTORE_PTR( ia->g );
   return ia;
 }
@@ -27,7 +28,9 @@ new_interpolator_array( grid_t * g )
   if( !g ) ERROR(( "NULL grid" ));
   MALLOC( ia, 1 );
   MALLOC_ALIGNED( ia->i, g->nv, 128 );
-  CLEAR( ia->i, g->nv );
+  if( pipeline_affinity ) clear_pipelines( ia->i, sizeof(interpolator_t),
+                                           g->nv, 1 ); // First touch
+  else                    CLEAR( ia->i, g->nv );
   ia->g = g;
   REGISTER_OBJECT( ia, checkpt_interpolator_array, restore_interpolator_array,
                    NULL );
@@ -131,3 +134,12 @@ load_interpolator_array( interpolator_array_t * RESTRICT ia,
   }
 # endif
 }
+
+// Named for checkpt_sym (see REGISTER_SYMBOL)
+
+REGISTER_SYMBOL( checkpt_interpolator_array )
+REGISTER_SYMBOL( restore_interpolator_array )
+
+// Arrays checkpointed raw (see REGISTER_LAYOUT)
+
+REGISTER_LAYOUT_SIZE( interpolator_t, INTERPOLATOR_RECORD_SIZE )
@@ -34,8 +34,6 @@ clear_accumulators_pipeline_scalar( accumulators_pipeline_args_t * args,
 
 #endif
 
-#define VOX(x,y,z) VOXEL( x, y, z, aa->g->nx, aa->g->ny, aa->g->nz )
-
 void
 clear_accumulator_array_pipeline( accumulator_array_t * RESTRICT aa )
 {
@@ -48,11 +46,14 @@ clear_accumulator_array_pipeline( accumulator_array_t * RESTRICT aa )
     ERROR( ( "Bad args" ) );
   }
 
-  i0 = ( VOX(1,1,1) / 2 ) * 2; // Round i0 down to even for 128B align on Cell */
+  // Only the accumulators of voxels that can hold particles, sfc_lo
+  // through sfc_hi in voxel storage order, are touched.
+
+  i0 = ( aa->g->sfc_lo / 2 ) * 2; // Round i0 down to even for 128B align on Cell */
 
   args->a       = aa->a + i0;
-  args->n       = ( ( ( VOX(aa->g->nx,aa->g->ny,aa->g->nz) - i0 + 1 ) + 1 ) / 2 ) * 2;
-  args->n_array = aa->n_pipeline + 1;
+  args->n       = ( ( ( aa->g->sfc_hi - i0 + 1 ) + 1 ) / 2 ) * 2;
+  args->n_array = aa->n_array;
   args->s_array = aa->stride;
 
   EXEC_PIPELINES( clear_accumulators, args, 0 );
@@ -13,7 +13,7 @@
 
 #include "../../util/pipelines/pipelines_exec.h"
 
-#define fi(x,y,z) fi[   VOXEL( x, y, z, nx, ny, nz ) ]
+#define fi(x,y,z) fi[ sfc[ VOXEL( x, y, z, nx, ny, nz ) ] ]
 #define f(x,y,z)  f [   VOXEL( x, y, z, nx, ny, nz ) ]
 #define nb(x,y,z) nb[ 6*VOXEL( x, y, z, nx, ny, nz ) ]
 
@@ -24,6 +24,7 @@ load_interpolator_pipeline_scalar( load_interpolator_pipeline_args_t * args,
 {
   interpolator_t * ALIGNED(128) fi = args->fi;
   const field_t  * ALIGNED(128) f  = args->f;
+  const int      * ALIGNED(128) sfc = args->sfc;
 
   interpolator_t * ALIGNED(16) pi;
 
@@ -31,7 +32,7 @@ load_interpolator_pipeline_scalar( load_interpolator_pipeline_args_t * args,
   const field_t  * ALIGNED(16) pfx,  * ALIGNED(16) pfy,  * ALIGNED(16) pfz;
   const field_t  * ALIGNED(16) pfyz, * ALIGNED(16) pfzx, * ALIGNED(16) pfxy;
 
-  int x, y, z, n_voxel;
+  int x, y, z, v, n_voxel;
 
   const int nx = args->nx;
   const int ny = args->ny;
@@ -50,7 +51,7 @@ load_interpolator_pipeline_scalar( load_interpolator_pipeline_args_t * args,
                      pipeline_rank, n_pipeline, x, y, z, n_voxel );
 
 # define LOAD_STENCIL()    \
-  pi   = &fi(x,  y,  z  ); \
+  v    = VOXEL(x,y,z, nx,ny,nz); \
   pf0  =  &f(x,  y,  z  ); \
   pfx  =  &f(x+1,y,  z  ); \
   pfy  =  &f(x,  y+1,z  ); \
@@ -63,6 +64,8 @@ load_interpolator_pipeline_scalar( load_interpolator_pipeline_args_t * args,
   
   for( ; n_voxel; n_voxel-- )
   {
+    pi = &fi[ sfc[v] ];
+
     // ex interpolation
     w0 = pf0->ex;
     w1 = pfy->ex;
@@ -111,7 +114,7 @@ load_interpolator_pipeline_scalar( load_interpolator_pipeline_args_t * args,
     pi->cbz    = half*( w1 + w0 );
     pi->dcbzdz = half*( w1 - w0 );
 
-    pi++; pf0++; pfx++; pfy++; pfz++; pfyz++; pfzx++; pfxy++;
+    v++;  pf0++; pfx++; pfy++; pfz++; pfyz++; pfzx++; pfxy++;
 
     x++;
     if ( x > nx )
@@ -136,13 +139,14 @@ load_interpolator_pipeline_v4( load_interpolator_pipeline_args_t * args,
 {
   interpolator_t * ALIGNED(128) fi = args->fi;
   const field_t  * ALIGNED(128) f  = args->f;
+  const int      * ALIGNED(128) sfc = args->sfc;
 
   interpolator_t * ALIGNED(16) pi;
 
   const field_t * ALIGNED(16) pf0;
   const field_t * ALIGNED(16) pfx,  * ALIGNED(16) pfy,  * ALIGNED(16) pfz;
   const field_t * ALIGNED(16) pfyz, * ALIGNED(16) pfzx, * ALIGNED(16) pfxy;
-  int x, y, z, n_voxel;
+  int x, y, z, v, n_voxel;
 
   const int nx = args->nx;
   const int ny = args->ny;
@@ -167,7 +171,7 @@ load_interpolator_pipeline_v4( load_interpolator_pipeline_args_t * args,
                      x, y, z, n_voxel );
   
 # define LOAD_STENCIL()    \
-  pi   = &fi(x,  y,  z  ); \
+  v    = VOXEL(x,y,z, nx,ny,nz); \
   pf0  =  &f(x,  y,  z  ); \
   pfx  =  &f(x+1,y,  z  ); \
   pfy  =  &f(x,  y+1,z  ); \
@@ -180,6 +184,8 @@ load_interpolator_pipeline_v4( load_interpolator_pipeline_args_t * args,
   
   for( ; n_voxel; n_voxel-- )
   {
+    pi = &fi[ sfc[v] ];
+
     // ex interpolation coefficients 
     w0 = toggle_bits( sgn_1_2, v4float( pf0->ex) ); // [ w0 -w0 -w0 w0 ]
     w1 =                       v4float( pfy->ex);   // [ w1  w1  w1 w1 ]
@@ -224,7 +230,7 @@ load_interpolator_pipeline_v4( load_interpolator_pipeline_args_t * args,
 
     store_4x1( half*( w1 + w0 ), &pi->cbz ); // Note: Padding after bz coeff!
 
-    pi++; pf0++; pfx++; pfy++; pfz++; pfyz++; pfzx++; pfxy++;
+    v++;  pf0++; pfx++; pfy++; pfz++; pfyz++; pfzx++; pfxy++;
 
     x++;
     if ( x > nx )
@@ -322,8 +328,9 @@ load_interpolator_array_pipeline( interpolator_array_t * RESTRICT ia,
   }
 # endif
 
-  args->fi = ia->i;
-  args->f  = fa->f;
+  args->fi  = ia->i;
+  args->f   = fa->f;
+  args->sfc = ia->g->sfc;
   args->nb = ia->g->neighbor;
   args->nx = ia->g->nx;
   args->ny = ia->g->ny;
@@ -0,0 +1,88 @@
+#define IN_sf_interface
+
+#include "sf_interface_pipeline.h"
+
+#include "../sf_interface_private.h"
+
+#include "../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Each pipeline merges a block of storage indices.  Within the block, the
+// tiles are added to the host accumulator in pipeline order, such that
+// the result does not depend on how the blocks are distributed, and are
+// zeroed for the next particle advance.
+//----------------------------------------------------------------------------//
+
+void
+merge_tiles_pipeline_scalar( merge_tiles_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline )
+{
+  const accumulator_tile_t * tile = args->tile;
+  const int si = sizeof(accumulator_t) / sizeof(float);
+
+  accumulator_t * ALIGNED(16) b;
+  float * RESTRICT ALIGNED(16) fa;
+  const float * RESTRICT ALIGNED(16) fb;
+
+  int i0, i1, r, lo, hi, k;
+
+  DISTRIBUTE( args->n, accumulators_n_block, pipeline_rank, n_pipeline,
+              i0, i1 );
+
+  i0 += args->s0;
+  i1 += i0;
+
+  for( r = 0; r < args->n_tile; r++ )
+  {
+    lo = tile[r].lo > i0   ? tile[r].lo   : i0;
+    hi = tile[r].hi < i1-1 ? tile[r].hi+1 : i1;
+    if ( lo >= hi ) continue;
+
+    b  = args->t + tile[r].off + ( lo - tile[r].lo );
+    fa = args->a[lo].jx;
+    fb = b->jx;
+
+    for( k = 0; k < (hi-lo)*si; k++ ) fa[k] += fb[k];
+
+    CLEAR( b, hi-lo );
+  }
+}
+
+void
+merge_accumulator_tiles_pipeline( accumulator_array_t * RESTRICT aa,
+                                  int n_tile )
+{
+  DECLARE_ALIGNED_ARRAY( merge_tiles_pipeline_args_t, 128, args, 1 );
+
+  int r, s0, s1;
+
+  if ( !aa )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  // Only the storage indices covered by some tile are merged.
+
+  s0 = aa->stride;
+  s1 = -1;
+  for( r = 0; r < n_tile; r++ )
+  {
+    if ( aa->tile[r].lo > aa->tile[r].hi ) continue;
+    if ( s0 > aa->tile[r].lo ) s0 = aa->tile[r].lo;
+    if ( s1 < aa->tile[r].hi ) s1 = aa->tile[r].hi;
+  }
+
+  if ( s0 > s1 ) return;
+
+  args->a      = aa->a;
+  args->t      = aa->t;
+  args->tile   = aa->tile;
+  args->n_tile = n_tile;
+  args->s0     = s0;
+  args->n      = s1 - s0 + 1;
+
+  EXEC_PIPELINES( merge_tiles, args, 0 );
+
+  WAIT_PIPELINES();
+}
@@ -15,11 +15,12 @@ typedef struct load_interpolator_pipeline_args
   MEM_PTR( interpolator_t, 128 ) fi;
   MEM_PTR( const field_t,  128 ) f;
   MEM_PTR( const int64_t,  128 ) nb;
+  MEM_PTR( const int,      128 ) sfc; // Voxel to interpolator storage index
   int nx;
   int ny;
   int nz;
 
-  PAD_STRUCT( 3*SIZEOF_MEM_PTR + 3*sizeof(int) )
+  PAD_STRUCT( 4*SIZEOF_MEM_PTR + 3*sizeof(int) )
 
 } load_interpolator_pipeline_args_t;
 
@@ -66,20 +67,45 @@ reduce_accumulators_pipeline_scalar( accumulators_pipeline_args_t * args,
                                      int pipeline_rank,
                                      int n_pipeline );
 
+///////////////////////////////////////////////////////////////////////////////
+// merge_tiles_pipeline interface
+
+typedef struct merge_tiles_pipeline_args
+{
+  MEM_PTR( accumulator_t,            128 ) a;    // Host accumulator
+  MEM_PTR( accumulator_t,            128 ) t;    // Tile storage
+  MEM_PTR( const accumulator_tile_t, 16  ) tile; // Tiles of the pipelines
+  int n_tile;                                    // Number of tiles
+  int s0;                                        // First storage index
+  int n;                                         // Number of storage indices
+
+  PAD_STRUCT( 3*SIZEOF_MEM_PTR + 3*sizeof(int) )
+
+} merge_tiles_pipeline_args_t;
+
+void
+merge_tiles_pipeline_scalar( merge_tiles_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline );
+
 ///////////////////////////////////////////////////////////////////////////////
 
 typedef struct unload_accumulator_pipeline_args
 {
   MEM_PTR( field_t, 128 ) f;             // Reduce accumulators to this
   MEM_PTR( const accumulator_t, 128 ) a; // Accumulator array to reduce
+  MEM_PTR( const int, 128 ) sfc;         // Voxel to accumulator index
   int nx;                                // Local domain x-resolution
   int ny;                                // Local domain y-resolution
   int nz;                                // Local domain z-resolution
+  int x0, x1;                            // Block of nodes to unload
+  int y0, y1;
+  int z0, z1;
   float cx;                              // x-axis coupling constant
   float cy;                              // y-axis coupling constant
   float cz;                              // z-axis coupling constant
 
-  PAD_STRUCT( 2*SIZEOF_MEM_PTR + 3*sizeof(int) + 3*sizeof(float) )
+  PAD_STRUCT( 3*SIZEOF_MEM_PTR + 9*sizeof(int) + 3*sizeof(float) )
 
 } unload_accumulator_pipeline_args_t;
 
@@ -21,6 +21,7 @@ unload_accumulator_pipeline_scalar( unload_accumulator_pipeline_args_t * args,
 {
   field_t             * ALIGNED(128) f = args->f;
   const accumulator_t * ALIGNED(128) a = args->a;
+  const int           * ALIGNED(128) sfc = args->sfc;
 
   const accumulator_t * ALIGNED(16) a0;
   const accumulator_t * ALIGNED(16) ax,  * ALIGNED(16) ay,  * ALIGNED(16) az;
@@ -28,11 +29,14 @@ unload_accumulator_pipeline_scalar( unload_accumulator_pipeline_args_t * args,
 
   field_t * ALIGNED(16) f0;
 
-  int x, y, z, n_voxel;
+  int x, y, z, v, n_voxel;
 
   const int nx = args->nx;
   const int ny = args->ny;
-  const int nz = args->nz;
+
+  const int sx = 1;
+  const int sy = nx + 2;
+  const int sz = sy*( ny + 2 );
 
   const float cx = args->cx;
   const float cy = args->cy;
@@ -45,30 +49,40 @@ unload_accumulator_pipeline_scalar( unload_accumulator_pipeline_args_t * args,
     return; // No need for straggler cleanup
   }
 
-  DISTRIBUTE_VOXELS( 1, nx+1, 1, ny+1, 1, nz+1, 1,
+  DISTRIBUTE_VOXELS( args->x0, args->x1, args->y0, args->y1,
+                     args->z0, args->z1, 1,
                      pipeline_rank, n_pipeline, x, y, z, n_voxel );
 
+  // The accumulators are stored in the grid's voxel storage order, so
+  // the stencil is gathered through sfc as we walk the voxels.
+
 # define LOAD_STENCIL()                                                 \
-  f0  = &f(x,  y,  z  );                                                \
-  a0  = &a(x,  y,  z  );                                                \
-  ax  = &a(x-1,y,  z  ); ay  = &a(x,  y-1,z  ); az  = &a(x,  y,  z-1);  \
-  ayz = &a(x,  y-1,z-1); azx = &a(x-1,y,  z-1); axy = &a(x-1,y-1,z  )
+  v   = sx*x + sy*y + sz*z;                                             \
+  f0  = f + v
 
   LOAD_STENCIL();
 
   for( ; n_voxel; n_voxel-- )
   {
+    a0  = a + sfc[ v           ];
+    ax  = a + sfc[ v - sx      ];
+    ay  = a + sfc[ v - sy      ];
+    az  = a + sfc[ v - sz      ];
+    ayz = a + sfc[ v - sy - sz ];
+    azx = a + sfc[ v - sz - sx ];
+    axy = a + sfc[ v - sx - sy ];
+
     f0->jfx += cx*( a0->jx[0] + ay->jx[1] + az->jx[2] + ayz->jx[3] );
     f0->jfy += cy*( a0->jy[0] + az->jy[1] + ax->jy[2] + azx->jy[3] );
     f0->jfz += cz*( a0->jz[0] + ax->jz[1] + ay->jz[2] + axy->jz[3] );
 
-    f0++; a0++; ax++; ay++; az++; ayz++; azx++; axy++;
+    f0++; v++;
 
     x++;
-    if ( x > nx + 1 )
+    if ( x > args->x1 )
     {
-      x=1, y++;
-      if ( y > ny + 1 ) y=1, z++;
+      x=args->x0, y++;
+      if ( y > args->y1 ) y=args->y0, z++;
       LOAD_STENCIL();
     }
   }
@@ -85,7 +99,10 @@ unload_accumulator_pipeline_scalar( unload_accumulator_pipeline_args_t * args,
 
 void
 unload_accumulator_array_pipeline( field_array_t * RESTRICT fa,
-                                   const accumulator_array_t * RESTRICT aa )
+                                   const accumulator_array_t * RESTRICT aa,
+                                   int x0, int x1,
+                                   int y0, int y1,
+                                   int z0, int z1 )
 {
   unload_accumulator_pipeline_args_t args[1];
 
@@ -121,12 +138,17 @@ unload_accumulator_array_pipeline( field_array_t * RESTRICT fa,
 
 # endif
 
-  args->f  = fa->f;
-  args->a  = aa->a;
+  args->f   = fa->f;
+  args->a   = aa->a;
+  args->sfc = fa->g->sfc;
   args->nx = fa->g->nx;
   args->ny = fa->g->ny;
   args->nz = fa->g->nz;
 
+  args->x0 = x0; args->x1 = x1;
+  args->y0 = y0; args->y1 = y1;
+  args->z0 = z0; args->z1 = z1;
+
   args->cx = 0.25 * fa->g->rdy * fa->g->rdz / fa->g->dt;
   args->cy = 0.25 * fa->g->rdz * fa->g->rdx / fa->g->dt;
   args->cz = 0.25 * fa->g->rdx * fa->g->rdy / fa->g->dt;
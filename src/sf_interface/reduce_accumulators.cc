@@ -15,6 +15,11 @@ reduce_accumulator_array( accumulator_array_t * RESTRICT aa )
     ERROR( ( "Bad args" ) );
   }
 
+  // In tiled mode, the particle advance already merged the pipeline
+  // tiles into the host accumulator.
+
+  if ( aa->tiled ) return;
+
   // Conditionally execute this when more abstractions are available.
   reduce_accumulator_array_pipeline( aa );
 }
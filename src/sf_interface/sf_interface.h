@@ -18,14 +18,16 @@
 // be properly aligned for performance and also for various intrinsics calls
 // because many intrinsics will fail if not operating on properly aligned
 // data. Check for the most restrictive alignment need first and make sure it
-// has priority in being satisfied.
+// has priority in being satisfied.  With run time simd dispatch, the widest
+// ISA that was compiled in decides so all files agree on the layout.
 //----------------------------------------------------------------------------//
 
 //----------------------------------------------------------------------------//
 // 64-byte align
 
 #if defined(USE_V16_PORTABLE) || \
-    defined(USE_V16_AVX512)
+    defined(USE_V16_AVX512)   || \
+    defined(VPIC_SIMD_DISPATCH_V16)
 
 #define PAD_SIZE_INTERPOLATOR 14
 #define PAD_SIZE_ACCUMULATOR   4
@@ -36,7 +38,8 @@
 
 #elif defined(USE_V8_PORTABLE) || \
       defined(USE_V8_AVX)      || \
-      defined(USE_V8_AVX2)
+      defined(USE_V8_AVX2)     || \
+      defined(VPIC_SIMD_DISPATCH_V8)
 
 #define PAD_SIZE_INTERPOLATOR 6
 #define PAD_SIZE_ACCUMULATOR  4
@@ -73,6 +76,11 @@ typedef struct interpolator
   // float _pad3[8];  // More padding to get 64-byte align, make conditional
 } interpolator_t;
 
+// The bytes of an interpolator_t that are checkpointed (the padding
+// depends on the SIMD width of the build)
+
+#define INTERPOLATOR_RECORD_SIZE ( 18*sizeof(float) )
+
 typedef struct interpolator_array
 {
   interpolator_t * ALIGNED(128) i;
@@ -122,12 +130,47 @@ typedef struct accumulator
   #endif
 } accumulator_t;
 
+// The bytes of an accumulator_t that are checkpointed (the padding
+// depends on the SIMD width of the build)
+
+#define ACCUMULATOR_RECORD_SIZE ( 12*sizeof(float) )
+
+// In tiled mode (see set_accumulator_array_tiling), only a(:,:,:,0) is
+// allocated.  Each pipeline of a particle advance instead accumulates to
+// a tile holding the accumulators with storage indices lo:hi, the range
+// its particles can touch this step.  The tiles are merged into
+// a(:,:,:,0) at the end of each particle advance.  Particles not sorted
+// (see sort_p) this step are partitioned by slices of the local domain
+// going into the advance; within a slice, they can be in any order.  The
+// tiles of the pipelines are then roughly disjoint slices of the local
+// domain padded by a halo no wider than the nbr ranges, such that
+// accumulator memory and merge cost scale with the local domain rather
+// than with the local domain times the number of pipelines.  Faces that
+// wrap periodically onto the local domain widen the halo of the pipelines
+// holding them to the extent of the local domain along that axis.
+
+typedef struct accumulator_tile
+{
+  int lo, hi; // Storage indices covered by the tile (empty if lo>hi)
+  size_t off; // Location of the accumulator of storage index lo in t
+} accumulator_tile_t;
+
 typedef struct accumulator_array
 {
   accumulator_t * ALIGNED(128) a;
   int n_pipeline; // Number of pipelines supported by this accumulator
   int stride;     // Stride be each pipeline's accumulator array
   grid_t * g;
+
+  int tiled;                      // Nonzero in tiled mode
+  int n_array;                    // Number of arrays in a (1 in tiled mode)
+  accumulator_tile_t * tile;      // Tile of each pipeline (tiled mode)
+  accumulator_t * ALIGNED(128) t; // Tile storage, all zero between advances
+  size_t max_t;                   // Number of accumulators in t
+  int * ALIGNED(128) nbr;         // (0:2*nv-1) storage index range of the
+                                  // accumulators a particle in voxel v can
+                                  // touch during a step is
+                                  // nbr[2*v]:nbr[2*v+1] (built on first use)
 } accumulator_array_t;
 
 BEGIN_C_DECLS
@@ -140,6 +183,45 @@ new_accumulator_array( grid_t * g );
 void
 delete_accumulator_array( accumulator_array_t * a );
 
+// Selects tiled mode (tiled nonzero) or full per pipeline accumulator
+// arrays (tiled zero).  The host accumulator is preserved.  This must not
+// be called during a particle advance.
+
+void
+set_accumulator_array_tiling( accumulator_array_t * aa,
+                              int tiled );
+
+// Resizes the accumulator array after the local domain changed size.
+// All accumulated values are discarded.
+
+void
+reset_accumulator_array( accumulator_array_t * aa );
+
+// In tile_accumulators.c
+
+// Going into begin_pipeline_accumulators in tiled mode, the particle
+// advance has set aa->tile[r].lo and aa->tile[r].hi of each pipeline r
+// from the aa->nbr ranges of the voxels of its particles (see
+// tile_accumulator_ranges).  begin_pipeline_accumulators sets ap[r] such
+// that ap[r][g->sfc[v]] is the accumulator of voxel v for pipeline r,
+// 0<=r<n_pipeline.  end_pipeline_accumulators merges the tiles into the
+// host accumulator in a deterministic order and does nothing if not in
+// tiled mode.
+
+void
+begin_pipeline_accumulators( accumulator_array_t * RESTRICT aa,
+                             accumulator_t ** ap,
+                             int n_pipeline );
+
+void
+end_pipeline_accumulators( accumulator_array_t * RESTRICT aa,
+                           int n_pipeline );
+
+// Returns aa->nbr, building it if necessary.
+
+const int *
+tile_accumulator_ranges( accumulator_array_t * RESTRICT aa );
+
 // In clear_accumulators.c
 
 // This zeros out all the accumulator arrays in a pipelined fashion.
@@ -173,6 +255,20 @@ void
 unload_accumulator_array( /**/  field_array_t       * RESTRICT fa, 
                           const accumulator_array_t * RESTRICT aa );
 
+// unload_accumulator_array split in two: the nodes on the faces of the
+// local domain, which hold all the currents shared with neighboring
+// domains, and the remaining interior nodes.  Together they are
+// equivalent to unload_accumulator_array.  This allows the shared
+// currents to be synchronized while the interior is unloaded.
+
+void
+unload_accumulator_array_faces( /**/  field_array_t       * RESTRICT fa,
+                                const accumulator_array_t * RESTRICT aa );
+
+void
+unload_accumulator_array_interior( /**/  field_array_t       * RESTRICT fa,
+                                   const accumulator_array_t * RESTRICT aa );
+
 END_C_DECLS
 
 /*****************************************************************************/
@@ -0,0 +1,156 @@
+#define IN_sf_interface
+
+#include "sf_interface_private.h"
+
+//----------------------------------------------------------------------------//
+// Build the range of accumulator storage indices a particle in each voxel
+// can touch during a step.  A particle moves less than a cell per step so
+// it crosses at most one face along each axis.  The crossings follow the
+// local neighbors of the grid, which include faces that wrap periodically
+// onto the local domain.  Ghost voxels never hold particles; their range
+// is their own storage index.
+//----------------------------------------------------------------------------//
+
+const int *
+tile_accumulator_ranges( accumulator_array_t * RESTRICT aa )
+{
+  const grid_t  * g;
+  const int     * sfc;
+  const int64_t * neighbor;
+  int * ALIGNED(128) nbr;
+  int reach[27];
+  int64_t rangel, rangeh, nb;
+  int nx, ny, nz, x, y, z, v, n, m, k, axis, face, lo, hi;
+
+  if ( !aa )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  if ( aa->nbr ) return aa->nbr;
+
+  g        = aa->g;
+  sfc      = g->sfc;
+  neighbor = g->neighbor;
+  rangel   = g->rangel;
+  rangeh   = g->rangeh;
+  nx       = g->nx;
+  ny       = g->ny;
+  nz       = g->nz;
+
+  MALLOC_ALIGNED( nbr, 2*g->nv, 128 );
+
+  for( v = 0; v < g->nv; v++ )
+  {
+    nbr[2*v  ] = sfc[v];
+    nbr[2*v+1] = sfc[v];
+  }
+
+  for( z = 1; z <= nz; z++ )
+    for( y = 1; y <= ny; y++ )
+      for( x = 1; x <= nx; x++ )
+      {
+        v = VOXEL( x, y, z, nx, ny, nz );
+
+        reach[0] = v;
+        n = 1;
+
+        for( axis = 0; axis < 3; axis++ )
+        {
+          m = n;
+          for( k = 0; k < m; k++ )
+            for( face = axis; face < 6; face += 3 )
+            {
+              nb = neighbor[ 6*(int64_t)reach[k] + face ];
+              if ( nb >= rangel && nb <= rangeh )
+                reach[n++] = (int)( nb - rangel );
+            }
+        }
+
+        lo = hi = sfc[v];
+        for( k = 1; k < n; k++ )
+        {
+          if ( lo > sfc[ reach[k] ] ) lo = sfc[ reach[k] ];
+          if ( hi < sfc[ reach[k] ] ) hi = sfc[ reach[k] ];
+        }
+
+        nbr[2*v  ] = lo;
+        nbr[2*v+1] = hi;
+      }
+
+  aa->nbr = nbr;
+
+  return nbr;
+}
+
+//----------------------------------------------------------------------------//
+// Lay out the tiles of the pipelines in the tile storage.  The tiles are
+// placed in pipeline order and no tile starts before its lo such that the
+// biased tile pointers all point into the tile storage.
+//----------------------------------------------------------------------------//
+
+void
+begin_pipeline_accumulators( accumulator_array_t * RESTRICT aa,
+                             accumulator_t ** ap,
+                             int n_pipeline )
+{
+  accumulator_tile_t * tile;
+  size_t off;
+  int r;
+
+  if ( !aa || !ap || n_pipeline < 0 || n_pipeline > aa->n_pipeline )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  if ( !aa->tiled )
+  {
+    for( r = 0; r < n_pipeline; r++ )
+      ap[r] = aa->a + (size_t)( 1 + r )*(size_t)aa->stride;
+
+    return;
+  }
+
+  off = 0;
+  for( r = 0; r < n_pipeline; r++ )
+  {
+    tile = aa->tile + r;
+    if ( tile->lo > tile->hi ) continue;
+    if ( off < (size_t)tile->lo ) off = tile->lo;
+    tile->off = off;
+    off += tile->hi - tile->lo + 1;
+  }
+
+  if ( off > aa->max_t )
+  {
+    FREE_ALIGNED( aa->t );
+    MALLOC_ALIGNED( aa->t, off, 128 );
+    CLEAR( aa->t, off );
+    aa->max_t = off;
+  }
+
+  for( r = 0; r < n_pipeline; r++ )
+  {
+    tile  = aa->tile + r;
+    ap[r] = tile->lo > tile->hi ? aa->t : aa->t + ( tile->off - tile->lo );
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper tile merge function.
+//----------------------------------------------------------------------------//
+
+void
+end_pipeline_accumulators( accumulator_array_t * RESTRICT aa,
+                           int n_pipeline )
+{
+  if ( !aa || n_pipeline < 0 || n_pipeline > aa->n_pipeline )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  if ( !aa->tiled ) return;
+
+  // Conditionally execute this when more abstractions are available.
+  merge_accumulator_tiles_pipeline( aa, n_pipeline );
+}
@@ -2,6 +2,26 @@
 
 #include "sf_interface_private.h"
 
+//----------------------------------------------------------------------------//
+// Unload the accumulators onto the block of nodes (x0:x1,y0:y1,z0:z1).
+//----------------------------------------------------------------------------//
+
+static void
+unload_accumulator_block( field_array_t * RESTRICT fa,
+                          const accumulator_array_t * RESTRICT aa,
+                          int x0, int x1,
+                          int y0, int y1,
+                          int z0, int z1 )
+{
+  if ( x0 > x1 || y0 > y1 || z0 > z1 )
+  {
+    return;
+  }
+
+  // Conditionally execute this when more abstractions are available.
+  unload_accumulator_array_pipeline( fa, aa, x0, x1, y0, y1, z0, z1 );
+}
+
 //----------------------------------------------------------------------------//
 // Top level function to select and call the proper unload_accumulator_array
 // function.
@@ -18,6 +38,59 @@ unload_accumulator_array( field_array_t * RESTRICT fa,
     ERROR( ( "Bad args" ) );
   }
 
-  // Conditionally execute this when more abstractions are available.
-  unload_accumulator_array_pipeline( fa, aa );
+  unload_accumulator_block( fa, aa, 1, fa->g->nx + 1,
+                                    1, fa->g->ny + 1,
+                                    1, fa->g->nz + 1 );
+}
+
+//----------------------------------------------------------------------------//
+// Unload the accumulators onto the nodes on the faces of the local domain.
+// Each face is unloaded as a slab such that no node is unloaded twice.
+//----------------------------------------------------------------------------//
+
+void
+unload_accumulator_array_faces( field_array_t * RESTRICT fa,
+                                const accumulator_array_t * RESTRICT aa )
+{
+  int nx, ny, nz;
+
+  if ( !fa              ||
+       !aa              ||
+       fa->g != aa->g )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  nx = fa->g->nx;
+  ny = fa->g->ny;
+  nz = fa->g->nz;
+
+  unload_accumulator_block( fa, aa, 1,    1,    1, ny+1, 1, nz+1 );
+  unload_accumulator_block( fa, aa, nx+1, nx+1, 1, ny+1, 1, nz+1 );
+  unload_accumulator_block( fa, aa, 2,    nx,   1,    1, 1, nz+1 );
+  unload_accumulator_block( fa, aa, 2,    nx,   ny+1, ny+1, 1, nz+1 );
+  unload_accumulator_block( fa, aa, 2,    nx,   2,    ny,   1,    1 );
+  unload_accumulator_block( fa, aa, 2,    nx,   2,    ny,   nz+1, nz+1 );
+}
+
+//----------------------------------------------------------------------------//
+// Unload the accumulators onto the nodes not on the faces of the local
+// domain.  None of the currents these nodes hold are shared with other
+// domains.
+//----------------------------------------------------------------------------//
+
+void
+unload_accumulator_array_interior( field_array_t * RESTRICT fa,
+                                   const accumulator_array_t * RESTRICT aa )
+{
+  if ( !fa              ||
+       !aa              ||
+       fa->g != aa->g )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  unload_accumulator_block( fa, aa, 2, fa->g->nx,
+                                    2, fa->g->ny,
+                                    2, fa->g->nz );
 }
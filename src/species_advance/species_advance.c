@@ -14,11 +14,25 @@
 
 void
 checkpt_species( const species_t * sp ) {
-  CHECKPT( sp, 1 );
+  // Checkpoints always hold AoS particles.  AoSoA particles are gathered
+  // into a scratch array for the checkpt (which copies what it is given)
+  // such that the species itself is not touched.
+  species_t aos[1];
+  particle_t * ALIGNED(128) p = sp->p;
+  int n;
+  COPY( aos, sp, 1 );
+  if( sp->p_layout==particle_layout_aosoa ) {
+    aos->p_layout = particle_layout_aos;
+    MALLOC_ALIGNED( p, PARTICLE_BLOCK_CEIL(sp->np), 128 );
+    for( n=0; n<sp->np; n++ )
+      load_particle_pb( p+n, (const particle_block_t *)sp->p, n );
+  }
+  CHECKPT( aos, 1 );
   CHECKPT_STR( sp->name );
-  checkpt_data( sp->p,
-                sp->np    *sizeof(particle_t),
-                sp->max_np*sizeof(particle_t), 1, 1, 128 );
+  checkpt_data( p,
+                sp->np*sizeof(particle_t),
+                PARTICLE_BLOCK_CEIL(sp->max_np)*sizeof(particle_t), 1, 1, 128 );
+  if( p!=sp->p ) FREE_ALIGNED( p );
   checkpt_data( sp->pm,
                 sp->nm    *sizeof(particle_mover_t),
                 sp->max_nm*sizeof(particle_mover_t), 1, 1, 128 );
@@ -34,6 +48,9 @@ restore_species( void ) {
   RESTORE_STR( sp->name );
   sp->p  = (particle_t *)      restore_data();
   sp->pm = (particle_mover_t *)restore_data();
+  // Restoring touched every page from the host (see pipeline_affinity)
+  unplace_pipelines( sp->p );
+  place_pipelines( sp->p, sizeof(particle_t), sp->np, 16 );
   RESTORE_ALIGNED( sp->partition );
   RESTORE_PTR( sp->g );
   RESTORE_PTR( sp->next );
@@ -45,6 +62,7 @@ delete_species( species_t * sp ) {
   UNREGISTER_OBJECT( sp );
   FREE_ALIGNED( sp->partition );
   FREE_ALIGNED( sp->pm );
+  unplace_pipelines( sp->p );
   FREE_ALIGNED( sp->p );
   FREE( sp->name );
   FREE( sp );
@@ -126,9 +144,18 @@ species( const char * name,
   sp->q = q;
   sp->m = m;
 
-  MALLOC_ALIGNED( sp->p, max_local_np, 128 );
+  MALLOC_ALIGNED( sp->p, PARTICLE_BLOCK_CEIL(max_local_np), 128 );
   sp->max_np = max_local_np;
 
+  // Have the pipelines touch the particles first (see pipeline_affinity).
+  // This splits max_np over the pipelines while the pushers split np, so
+  // the particles are placed again once they are loaded and when they are
+  // sorted (see place_pipelines).
+
+  if( pipeline_affinity )
+    clear_pipelines( sp->p, sizeof(particle_t),
+                     (int)PARTICLE_BLOCK_CEIL(max_local_np), 16 );
+
   MALLOC_ALIGNED( sp->pm, max_local_nm, 128 );
   sp->max_nm = max_local_nm;
 
@@ -144,3 +171,27 @@ species( const char * name,
   REGISTER_OBJECT( sp, checkpt_species, restore_species, NULL );
   return sp;
 }
+
+void
+set_species_layout( species_t * sp,
+                    int layout ) {
+  if( !sp ) ERROR(( "Bad args" ));
+  if( layout!=particle_layout_aos && layout!=particle_layout_aosoa )
+    ERROR(( "Unknown particle layout %i", layout ));
+# ifdef ENABLE_PARTICLE_TAG
+  if( layout==particle_layout_aosoa )
+    ERROR(( "The AoSoA particle layout does not support particle tags" ));
+# endif
+  sp->layout = layout;
+  convert_p( sp, layout );
+}
+
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( checkpt_species )
+REGISTER_SYMBOL( restore_species )
+
+/* Arrays checkpointed raw (see REGISTER_LAYOUT) */
+
+REGISTER_LAYOUT( particle_t )
+REGISTER_LAYOUT( particle_block_t )
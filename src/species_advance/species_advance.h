@@ -15,10 +15,73 @@
 #include "../sf_interface/sf_interface.h"
 
 //----------------------------------------------------------------------------//
-// Choose between using AoSoA or AoS data layout for the particles.
+// Particles are stored as AoS by default.  A species can opt into an
+// AoSoA layout at run time (see species_advance_aosoa.h).
 //----------------------------------------------------------------------------//
 
 #include "species_advance_aos.h"
+#include "species_advance_aosoa.h"
+
+//----------------------------------------------------------------------------//
+// Operators that draw random numbers per particle draw them from a
+// counter based stream (see seed_rng_counter) keyed by the step (see
+// RNG_COUNTER_KEY) and named (s0,s1,s2) with s0 naming the operator and
+// (s1,s2) given by particle_stream from the particle's state, the global
+// index gv of its voxel (see global_voxel) and the identity word id of
+// its species (the species id).  With particle tags (ENABLE_PARTICLE_TAG),
+// the tag is the particle's persistent identity and is hashed as well.
+// What a particle draws then does not depend on where it sits in the
+// particle array, on which pipeline or process advances it or on the
+// domain decomposition.  Identical particles of different species or
+// with different tags draw different numbers; without tags, particles of
+// a species with identical state in the same voxel can not be told apart
+// and draw the same numbers.  The words are hashed with two MurmurHash3
+// style hashes with different seeds.
+//----------------------------------------------------------------------------//
+
+#define PARTICLE_STREAM_MIX(h,k) do {                               \
+    uint32_t _k = (k)*(uint32_t)0xcc9e2d51;                         \
+    _k  = ( _k<<15 ) | ( _k>>17 );                                  \
+    (h) ^= _k*(uint32_t)0x1b873593;                                 \
+    (h)  = ( ( (h)<<13 ) | ( (h)>>19 ) )*5 + (uint32_t)0xe6546b64;  \
+  } while(0)
+
+#define PARTICLE_STREAM_FINAL(h) do {                               \
+    (h) ^= (h)>>16; (h) *= (uint32_t)0x85ebca6b;                    \
+    (h) ^= (h)>>13; (h) *= (uint32_t)0xc2b2ae35;                    \
+    (h) ^= (h)>>16;                                                 \
+  } while(0)
+
+STATIC_INLINE void
+particle_stream( const particle_t * RESTRICT p,
+                 int64_t gv,
+                 uint32_t id,
+                 uint32_t * RESTRICT s1,
+                 uint32_t * RESTRICT s2 ) {
+# ifdef ENABLE_PARTICLE_TAG
+  enum { N_WORD = 12 };
+# else
+  enum { N_WORD = 10 };
+# endif
+  union { float f; uint32_t u; } w[N_WORD];
+  uint32_t h1 = (uint32_t)0x9e3779b9, h2 = (uint32_t)0x7f4a7c15;
+  int n;
+  w[0].f = p->dx; w[1].f = p->dy; w[2].f = p->dz;
+  w[3].f = p->ux; w[4].f = p->uy; w[5].f = p->uz; w[6].f = p->w;
+  w[7].u = (uint32_t)gv; w[8].u = (uint32_t)( (uint64_t)gv>>32 );
+  w[9].u = id;
+# ifdef ENABLE_PARTICLE_TAG
+  w[10].u = (uint32_t)p->tag; w[11].u = (uint32_t)( (uint64_t)p->tag>>32 );
+# endif
+  for( n=0; n<N_WORD; n++ ) {
+    PARTICLE_STREAM_MIX( h1, w[n].u );
+    PARTICLE_STREAM_MIX( h2, w[n].u );
+  }
+  h1 ^= 4*N_WORD; PARTICLE_STREAM_FINAL( h1 );
+  h2 ^= 4*N_WORD; PARTICLE_STREAM_FINAL( h2 );
+  *s1 = h1;
+  *s2 = h2;
+}
 
 //----------------------------------------------------------------------------//
 // Declare methods.
@@ -56,10 +119,26 @@ species( const char * name,
          int sort_out_of_place,
          grid_t * g );
 
+// Set the particle layout the species should use for its advance
+// (particle_layout_aos or particle_layout_aosoa).
+
+void
+set_species_layout( species_t * sp,
+                    int layout );
+
 // FIXME: TEMPORARY HACK UNTIL THIS SPECIES_ADVANCE KERNELS
 // CAN BE CONSTRUCTED ANALOGOUS TO THE FIELD_ADVANCE KERNELS
 // (THESE FUNCTIONS ARE NECESSARY FOR HIGHER LEVEL CODE)
 
+// In convert_p.c
+
+// Transpose the particles of a species in place into the given layout.
+// This is a no-op if the particles are already in that layout.
+
+void
+convert_p( species_t * RESTRICT sp,
+           int layout );
+
 // In sort_p.c
 
 void
@@ -68,6 +147,9 @@ sort_p( species_t * RESTRICT sp );
 void
 sort_p_pipeline( species_t * sp );
 
+void
+sort_pb_pipeline( species_t * sp );
+
 // In advance_p.cxx
 
 void
@@ -75,10 +157,54 @@ advance_p( species_t * RESTRICT sp,
            accumulator_array_t * RESTRICT aa,
            const interpolator_array_t * RESTRICT ia );
 
+// Advance only the particles [n0,n1) of a species.  n0 must be a multiple
+// of PARTICLE_BLOCK_SIZE.  Movers are appended to any already on the mover
+// list of the species.
+
+void
+advance_p_range( species_t * RESTRICT sp,
+                 accumulator_array_t * RESTRICT aa,
+                 const interpolator_array_t * RESTRICT ia,
+                 int n0,
+                 int n1 );
+
 void
 advance_p_pipeline( species_t * RESTRICT sp,
                     accumulator_array_t * RESTRICT aa,
-                    const interpolator_array_t * RESTRICT ia );
+                    const interpolator_array_t * RESTRICT ia,
+                    int n0,
+                    int n1 );
+
+void
+advance_pb_pipeline( species_t * RESTRICT sp,
+                     accumulator_array_t * RESTRICT aa,
+                     const interpolator_array_t * RESTRICT ia,
+                     int n0,
+                     int n1 );
+
+// In face_p.c
+
+// Finds up to max_range of the most populated ranges of particles of a
+// species that are all in voxels not on faces shared with other ranks.
+// Range k is [range[2*k],range[2*k+1]), the ranges are disjoint and in
+// increasing order, and their ends are multiples of PARTICLE_BLOCK_SIZE.
+// If the species was sorted this step (see sort_p), the particles are
+// not modified.  Otherwise, the particles in face voxels are moved to the
+// front of the particle array (see partition_face_p_pipeline) and the
+// rest is returned as one range.  Returns the number of ranges.
+
+int
+interior_p_ranges( species_t * RESTRICT sp,
+                   int * RESTRICT range,
+                   int max_range );
+
+// Reorders the particles of a species such that the particles in the
+// voxels flagged in face (by storage index) come first.  Returns their
+// number.
+
+int
+partition_face_p_pipeline( species_t * RESTRICT sp,
+                           const char * RESTRICT face );
 
 // In center_p.cxx
 
@@ -95,6 +221,10 @@ void
 center_p_pipeline( species_t * RESTRICT sp,
                    const interpolator_array_t * RESTRICT ia );
 
+void
+center_pb_pipeline( species_t * RESTRICT sp,
+                    const interpolator_array_t * RESTRICT ia );
+
 // In uncenter_p.cxx
 
 // This is the inverse of center_p.  Thus, particles with r and u at
@@ -109,6 +239,10 @@ void
 uncenter_p_pipeline( species_t * RESTRICT sp,
                      const interpolator_array_t * RESTRICT ia );
 
+void
+uncenter_pb_pipeline( species_t * RESTRICT sp,
+                      const interpolator_array_t * RESTRICT ia );
+
 // In energy.cxx
 
 // This computes the kinetic energy stored in the particles.  The
@@ -123,12 +257,44 @@ double
 energy_p_pipeline( const species_t * RESTRICT sp,
                    const interpolator_array_t * RESTRICT ia );
 
+double
+energy_pb_pipeline( const species_t * RESTRICT sp,
+                    const interpolator_array_t * RESTRICT ia );
+
 // In rho_p.cxx
 
 void
 accumulate_rho_p( field_array_t * RESTRICT fa,
                   const species_t * RESTRICT sp );
 
+void
+accumulate_rho_p_pipeline( field_array_t * RESTRICT fa,
+                           const species_t * RESTRICT sp );
+
+// accumulate_rho_p for every species of a list split in two, like
+// unload_accumulator_array_faces and _interior: the charge of the list
+// is deposited and added to the rhof of the nodes on the faces of the
+// local domain, which hold all the charge shared with neighboring
+// domains, then to the remaining interior nodes.  Nothing else may
+// accumulate rhof in between.  Together they are equivalent to calling
+// accumulate_rho_p for each species (up to the order the species are
+// summed).  This allows the shared charge to be synchronized while the
+// interior is reduced.
+
+void
+accumulate_rho_p_list_faces( field_array_t * RESTRICT fa,
+                             const species_t * RESTRICT sp_list );
+
+void
+accumulate_rho_p_list_interior( field_array_t * RESTRICT fa );
+
+void
+accumulate_rho_p_list_faces_pipeline( field_array_t * RESTRICT fa,
+                                      const species_t * RESTRICT sp_list );
+
+void
+accumulate_rho_p_list_interior_pipeline( field_array_t * RESTRICT fa );
+
 void
 accumulate_rhob( field_t * RESTRICT ALIGNED(128) f,
                  const particle_t * RESTRICT ALIGNED(32)  p,
@@ -142,6 +308,11 @@ accumulate_hydro_p( hydro_array_t * RESTRICT ha,
                     const species_t * RESTRICT sp,
                     const interpolator_array_t * RESTRICT ia );
 
+void
+accumulate_hydro_p_pipeline( hydro_array_t * RESTRICT ha,
+                             const species_t * RESTRICT sp,
+                             const interpolator_array_t * RESTRICT ia );
+
 // In move_p.cxx
 
 int
@@ -151,6 +322,15 @@ move_p( particle_t       * ALIGNED(128) p0,    // Particle array
         const grid_t     *              g,     // Grid parameters
         const float                     qsp ); // Species particle charge
 
+// Same as move_p but for particles in the AoSoA layout
+
+int
+move_pb( particle_block_t * ALIGNED(128) pb0,   // Particle block array
+         particle_mover_t * ALIGNED(16)  m,     // Particle mover to apply
+         accumulator_t    * ALIGNED(128) a0,    // Accumulator to use
+         const grid_t     *              g,     // Grid parameters
+         const float                     qsp ); // Species particle charge
+
 END_C_DECLS
 
 #endif // _species_advance_h_
@@ -61,6 +61,9 @@ typedef struct species {
 
   int np, max_np;                     // Number and max local particles
   particle_t * ALIGNED(128) p;        // Array of particles for the species
+  int layout;                         // Preferred particle layout
+  int p_layout;                       // Layout p is currently in (see
+  /**/                                // species_advance_aosoa.h)
 
   int nm, max_nm;                     // Number and max local movers in use
   particle_mover_t * ALIGNED(128) pm; // Particle movers
@@ -88,8 +91,8 @@ typedef struct species {
   /**/                                //          sp->partition[ j+1 ] ]
   /**/                                // are all the particles in voxel
   /**/                                // with space filling curve index j.
-  /**/                                // Note: SFC NOT IN USE RIGHT NOW THUS
-  /**/                                // g->sfc[i]=i ABOVE.
+  /**/                                // Note: in fortran_order (the
+  /**/                                // default) g->sfc[i]==i ABOVE.
 
   grid_t * g;                         // Underlying grid
   species_id id;                      // Unique identifier for a species
@@ -0,0 +1,93 @@
+#ifndef _species_advance_aosoa_h_
+#define _species_advance_aosoa_h_
+
+#ifndef _species_advance_h_
+#error "Do not include species_advance_aosoa.h; include species_advance.h"
+#endif
+
+// A species can opt into storing its particles as an array of
+// structures of arrays (AoSoA) instead of the default array of
+// structures (AoS).  In the AoSoA layout, particles are grouped in
+// blocks of PARTICLE_BLOCK_SIZE and each block holds each particle
+// field contiguously.  The v8 and v16 kernels can then load and store
+// particles with aligned vector loads and stores instead of transposing
+// them on the way in and out.
+//
+// A block of PARTICLE_BLOCK_SIZE particle_t is exactly the same size as
+// a particle_block_t.  Thus, the layout of sp->p is changed in place
+// by transposing each block (see convert_p) and particle indices
+// (e.g. particle_mover_t::i and sp->partition) mean the same thing in
+// either layout: particle n lives in lane n%PARTICLE_BLOCK_SIZE of
+// block n/PARTICLE_BLOCK_SIZE.  Particle arrays are allocated in whole
+// blocks such that the last partial block can always be transposed.
+//
+// sp->layout is the layout the species prefers for its advance.
+// sp->p_layout is the layout sp->p is currently in.  Kernels that have
+// a native AoSoA implementation (advance_p, center_p, uncenter_p,
+// energy_p, sort_p, boundary_p, move_p, accumulate_rho_p and
+// accumulate_hydro_p), inject_particle and checkpoints work in either
+// layout.  Everything else that touches sp->p directly (dumps,
+// emitters, collisions, user decks, ...) should call convert_p( sp,
+// particle_layout_aos ) first; the next advance_p or sort_p converts
+// the particles back to the preferred layout.
+
+enum particle_layout_enums {
+  particle_layout_aos   = 0, // Array of particle_t (default)
+  particle_layout_aosoa = 1  // Array of particle_block_t
+};
+
+#define PARTICLE_BLOCK_SIZE 16
+
+// Round a number of particles up to a whole number of blocks
+
+#define PARTICLE_BLOCK_CEIL(n) \
+  ( ( (n) + PARTICLE_BLOCK_SIZE - 1 ) & ~( PARTICLE_BLOCK_SIZE - 1 ) )
+
+typedef struct particle_block {
+  float   dx[ PARTICLE_BLOCK_SIZE ]; // Particle position in cell coords
+  float   dy[ PARTICLE_BLOCK_SIZE ];
+  float   dz[ PARTICLE_BLOCK_SIZE ];
+  int32_t i[  PARTICLE_BLOCK_SIZE ]; // Voxel containing the particle
+  float   ux[ PARTICLE_BLOCK_SIZE ]; // Particle normalized momentum
+  float   uy[ PARTICLE_BLOCK_SIZE ];
+  float   uz[ PARTICLE_BLOCK_SIZE ];
+  float   w[  PARTICLE_BLOCK_SIZE ]; // Particle weight
+} particle_block_t;
+
+// Gather particle n of a block array into p
+
+STATIC_INLINE void
+load_particle_pb( particle_t             * RESTRICT p,
+                  const particle_block_t * RESTRICT pb,
+                  int n ) {
+  pb += n / PARTICLE_BLOCK_SIZE, n %= PARTICLE_BLOCK_SIZE;
+  p->dx = pb->dx[n]; p->dy = pb->dy[n]; p->dz = pb->dz[n]; p->i = pb->i[n];
+  p->ux = pb->ux[n]; p->uy = pb->uy[n]; p->uz = pb->uz[n]; p->w = pb->w[n];
+}
+
+// Scatter p into particle n of a block array
+
+STATIC_INLINE void
+store_particle_pb( particle_block_t * RESTRICT pb,
+                   int n,
+                   const particle_t * RESTRICT p ) {
+  pb += n / PARTICLE_BLOCK_SIZE, n %= PARTICLE_BLOCK_SIZE;
+  pb->dx[n] = p->dx; pb->dy[n] = p->dy; pb->dz[n] = p->dz; pb->i[n] = p->i;
+  pb->ux[n] = p->ux; pb->uy[n] = p->uy; pb->uz[n] = p->uz; pb->w[n] = p->w;
+}
+
+// Copy particle j of block array src into particle i of block array
+// dst (src and dst may be the same array)
+
+STATIC_INLINE void
+copy_particle_pb( particle_block_t       * dst, int i,
+                  const particle_block_t * src, int j ) {
+  dst += i / PARTICLE_BLOCK_SIZE, i %= PARTICLE_BLOCK_SIZE;
+  src += j / PARTICLE_BLOCK_SIZE, j %= PARTICLE_BLOCK_SIZE;
+  dst->dx[i] = src->dx[j]; dst->dy[i] = src->dy[j];
+  dst->dz[i] = src->dz[j]; dst->i[i]  = src->i[j];
+  dst->ux[i] = src->ux[j]; dst->uy[i] = src->uy[j];
+  dst->uz[i] = src->uz[j]; dst->w[i]  = src->w[j];
+}
+
+#endif // _species_advance_aosoa_h_
@@ -8,12 +8,37 @@
 // available is the pipeline abstraction.
 //----------------------------------------------------------------------------//
 
+void
+advance_p_range( species_t * RESTRICT sp,
+                 accumulator_array_t * RESTRICT aa,
+                 const interpolator_array_t * RESTRICT ia,
+                 int n0,
+                 int n1 )
+{
+  // Once more options are available, this should be conditionally executed
+  // based on user choice.
+  if ( sp->layout == particle_layout_aosoa )
+  {
+    convert_p( sp, particle_layout_aosoa );
+
+    advance_pb_pipeline( sp, aa, ia, n0, n1 );
+  }
+
+  else
+  {
+    advance_p_pipeline( sp, aa, ia, n0, n1 );
+  }
+}
+
 void
 advance_p( species_t * RESTRICT sp,
            accumulator_array_t * RESTRICT aa,
            const interpolator_array_t * RESTRICT ia )
 {
-  // Once more options are available, this should be conditionally executed
-  // based on user choice.
-  advance_p_pipeline( sp, aa, ia );
+  if ( !sp )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  advance_p_range( sp, aa, ia, 0, sp->np );
 }
@@ -13,6 +13,15 @@ center_p( species_t * RESTRICT sp,
           const interpolator_array_t * RESTRICT ia )
 {
   // Once more options are available, this should be conditionally executed
-  // based on user choice.
-  center_p_pipeline( sp, ia );
+  // based on user choice.  The particles are centered in whatever layout
+  // they are currently in.
+  if ( sp->p_layout == particle_layout_aosoa )
+  {
+    center_pb_pipeline( sp, ia );
+  }
+
+  else
+  {
+    center_p_pipeline( sp, ia );
+  }
 }
@@ -0,0 +1,70 @@
+#define IN_spa
+
+#include "../species_advance.h"
+
+//----------------------------------------------------------------------------//
+// Change the layout of the particles of a species in place.  A block of
+// PARTICLE_BLOCK_SIZE particle_t and a particle_block_t are both a
+// PARTICLE_BLOCK_SIZE x 8 array of 32-bit words stored in opposite
+// orders, so the conversion is a transpose of each block through a
+// small stack buffer.  The last block is transposed whole; the lanes
+// past sp->np are garbage either way.
+//----------------------------------------------------------------------------//
+
+enum { n_word = sizeof(particle_t) / sizeof(int32_t) };
+
+void
+convert_p( species_t * RESTRICT sp,
+           int layout )
+{
+  int32_t * RESTRICT ALIGNED(128) b;
+
+  int32_t t[ PARTICLE_BLOCK_SIZE*n_word ];
+
+  int nb, n, j, k;
+
+  if ( !sp )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  if ( layout == sp->p_layout )
+  {
+    return;
+  }
+
+  if ( layout != particle_layout_aos && layout != particle_layout_aosoa )
+  {
+    ERROR( ( "Unknown particle layout %i", layout ) );
+  }
+
+  if ( sizeof( particle_block_t ) != PARTICLE_BLOCK_SIZE*sizeof( particle_t ) )
+  {
+    ERROR( ( "The AoSoA particle layout is not supported for this "
+             "particle_t" ) );
+  }
+
+  b  = (int32_t *) sp->p;
+  nb = PARTICLE_BLOCK_CEIL( sp->np ) / PARTICLE_BLOCK_SIZE;
+
+  for( n = 0; n < nb; n++, b += PARTICLE_BLOCK_SIZE*n_word )
+  {
+    COPY( t, b, PARTICLE_BLOCK_SIZE*n_word );
+
+    if ( layout == particle_layout_aosoa )
+    {
+      for( j = 0; j < PARTICLE_BLOCK_SIZE; j++ )
+        for( k = 0; k < n_word; k++ )
+          b[ k*PARTICLE_BLOCK_SIZE + j ] = t[ j*n_word + k ];
+    }
+
+    else
+    {
+      for( j = 0; j < PARTICLE_BLOCK_SIZE; j++ )
+        for( k = 0; k < n_word; k++ )
+          b[ j*n_word + k ] = t[ k*PARTICLE_BLOCK_SIZE + j ];
+    }
+  }
+
+  sp->p_layout = layout;
+}
@@ -15,8 +15,17 @@ energy_p( const species_t * RESTRICT sp,
   double energy_particles;
 
   // Once more options are available, this should be conditionally executed
-  // based on user choice.
-  energy_particles = energy_p_pipeline( sp, ia );
+  // based on user choice.  The energy is computed in whatever layout the
+  // particles are currently in.
+  if ( sp->p_layout == particle_layout_aosoa )
+  {
+    energy_particles = energy_pb_pipeline( sp, ia );
+  }
+
+  else
+  {
+    energy_particles = energy_p_pipeline( sp, ia );
+  }
 
   return energy_particles;
 }
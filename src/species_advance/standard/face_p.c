@@ -0,0 +1,138 @@
+#define IN_spa
+
+#include "../species_advance.h"
+
+//----------------------------------------------------------------------------//
+// Flag the face voxels of a grid by storage index.  Since a particle moves
+// less than a cell per step, only particles in face voxels can leave the
+// local domain during the next advance_p.  Faces that wrap periodically
+// onto the local domain itself are not counted as such particles never
+// leave the local domain.
+//----------------------------------------------------------------------------//
+
+static char *
+face_voxels( const grid_t * g )
+{
+  const int * ALIGNED(128) sfc = g->sfc;
+  const int nx = g->nx, ny = g->ny, nz = g->nz;
+  char * ALIGNED(128) face;
+  int x, y, z, x0, y0, z0, x1, y1, z1;
+
+# define OPEN(i,j,k) ( g->bc[ BOUNDARY(i,j,k) ] != world_rank )
+  x0 = OPEN(-1, 0, 0) ? 1  : 0;  x1 = OPEN( 1, 0, 0) ? nx : nx+1;
+  y0 = OPEN( 0,-1, 0) ? 1  : 0;  y1 = OPEN( 0, 1, 0) ? ny : ny+1;
+  z0 = OPEN( 0, 0,-1) ? 1  : 0;  z1 = OPEN( 0, 0, 1) ? nz : nz+1;
+# undef OPEN
+
+  MALLOC_ALIGNED( face, g->nv, 128 );
+  CLEAR( face, g->nv );
+
+  for( z = 1; z <= nz; z++ )
+    for( y = 1; y <= ny; y++ )
+      for( x = 1; x <= nx; x++ )
+        face[ sfc[ VOXEL( x, y, z, nx, ny, nz ) ] ] =
+          ( x <= x0 || x >= x1 || y <= y0 || y >= y1 || z <= z0 || z >= z1 );
+
+  return face;
+}
+
+//----------------------------------------------------------------------------//
+// Find the largest runs of particles of a species that are all in interior
+// voxels.  If the species was sorted this step, the particles are not
+// touched: sort_p left the particles of each voxel at
+// partition[sfc[v]]:partition[sfc[v]+1]-1, so the runs of interior voxels
+// in storage order give runs of interior particles.  Ghost voxels hold no
+// particles and do not break a run.  Otherwise, partition_face_p_pipeline
+// moves the face particles to the front of the particle array in a few
+// pipelined passes over the voxel indices of the particles, which is much
+// cheaper than a sort, and the rest is a single run.  Each particle run is
+// shrunk to whole particle blocks.
+//----------------------------------------------------------------------------//
+
+int
+interior_p_ranges( species_t * RESTRICT sp,
+                   int * RESTRICT range,
+                   int max_range )
+{
+  const grid_t * g;
+  const int * ALIGNED(128) partition;
+  char * ALIGNED(128) face;
+  int s, s0, n, n0, n1, k, n_range;
+
+  if ( !sp || ( !range && max_range ) || max_range < 0 )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  g = sp->g;
+
+  if ( !max_range || !sp->np ) return 0;
+
+  face = face_voxels( g );
+
+  if ( sp->last_sorted != g->step )
+  {
+    n0 = PARTICLE_BLOCK_CEIL( partition_face_p_pipeline( sp, face ) );
+    n1 = sp->np & ~( PARTICLE_BLOCK_SIZE - 1 );
+
+    FREE_ALIGNED( face );
+
+    if ( n0 >= n1 ) return 0;
+
+    range[0] = n0;
+    range[1] = n1;
+
+    return 1;
+  }
+
+  partition = sp->partition;
+
+  // Keep the max_range most populated runs, largest first.
+
+  n_range = 0;
+
+  for( s = g->sfc_lo; s <= g->sfc_hi+1; s = s0+1 )
+  {
+    for( s0 = s; s0 <= g->sfc_hi && !face[s0]; s0++ ) ;
+
+    n0 = ( partition[s ] + PARTICLE_BLOCK_SIZE - 1 ) & ~( PARTICLE_BLOCK_SIZE - 1 );
+    n1 =   partition[s0]                             & ~( PARTICLE_BLOCK_SIZE - 1 );
+    n  = n1 - n0;
+
+    if ( n <= 0 ) continue;
+    if ( n_range == max_range && n <= range[2*n_range-1] - range[2*n_range-2] )
+      continue;
+
+    if ( n_range < max_range ) n_range++;
+
+    for( k = n_range-1; k > 0 && n > range[2*k-1] - range[2*k-2]; k-- )
+    {
+      range[2*k  ] = range[2*k-2];
+      range[2*k+1] = range[2*k-1];
+    }
+
+    range[2*k  ] = n0;
+    range[2*k+1] = n1;
+  }
+
+  FREE_ALIGNED( face );
+
+  // Return the runs in particle order.
+
+  for( n = 1; n < n_range; n++ )
+  {
+    n0 = range[2*n  ];
+    n1 = range[2*n+1];
+
+    for( k = n; k > 0 && range[2*k-2] > n0; k-- )
+    {
+      range[2*k  ] = range[2*k-2];
+      range[2*k+1] = range[2*k-1];
+    }
+
+    range[2*k  ] = n0;
+    range[2*k+1] = n1;
+  }
+
+  return n_range;
+}
@@ -141,9 +141,9 @@ move_p( particle_t       * RESTRICT ALIGNED(128) p,
 
     transpose( v0, v1, v2, v3 );
 
-    increment_4x1( a[voxel].jx, v0 );
-    increment_4x1( a[voxel].jy, v1 );
-    increment_4x1( a[voxel].jz, v2 );
+    increment_4x1( a[ g->sfc[voxel] ].jx, v0 );
+    increment_4x1( a[ g->sfc[voxel] ].jy, v1 );
+    increment_4x1( a[ g->sfc[voxel] ].jz, v2 );
 
     // If streak ended at the end of the particle track, this mover
     // was succesfully processed.  Should be just under ~50% of the
@@ -272,7 +272,7 @@ move_p( particle_t       * ALIGNED(128) p0,
     // the total physical charge that passed through the appropriate
     // current quadrant in a time-step
     v5 = q*s_dispx*s_dispy*s_dispz*(1./3.);
-    a = (float *)(a0 + p->i);
+    a = (float *)(a0 + g->sfc[p->i]);
 #   define accumulate_j(X,Y,Z)                                        \
     v4  = q*s_disp##X;    /* v2 = q ux                            */  \
     v1  = v4*s_mid##Y;    /* v1 = q ux dy                         */  \
@@ -353,3 +353,138 @@ move_p( particle_t       * ALIGNED(128) p0,
 }
 
 #endif
+
+// move_pb is move_p for particles in the AoSoA layout (m->i is the
+// index of the particle in the block array).  It is the reference
+// move_p above with the particle held in registers; it is used for all
+// builds as the particle lanes of a block cannot be loaded as a v4.
+
+int
+move_pb( particle_block_t * ALIGNED(128) pb0,
+         particle_mover_t * ALIGNED(16)  pm,
+         accumulator_t    * ALIGNED(128) a0,
+         const grid_t     *              g,
+         const float                     qsp ) {
+  float s_midx, s_midy, s_midz;
+  float s_dispx, s_dispy, s_dispz;
+  float s_dir[3], r[3], u[3];
+  float v0, v1, v2, v3, v4, v5, q;
+  int axis, face, ret = 0;
+  int32_t voxel;
+  int64_t neighbor;
+  float *a;
+  particle_block_t * ALIGNED(128) pb = pb0 + pm->i / PARTICLE_BLOCK_SIZE;
+  const int j = pm->i % PARTICLE_BLOCK_SIZE;
+
+  r[0] = pb->dx[j]; r[1] = pb->dy[j]; r[2] = pb->dz[j]; voxel = pb->i[j];
+  u[0] = pb->ux[j]; u[1] = pb->uy[j]; u[2] = pb->uz[j];
+  q = qsp*pb->w[j];
+
+  for(;;) {
+    s_midx = r[0];
+    s_midy = r[1];
+    s_midz = r[2];
+
+    s_dispx = pm->dispx;
+    s_dispy = pm->dispy;
+    s_dispz = pm->dispz;
+
+    s_dir[0] = (s_dispx>0.0f) ? 1.0f : -1.0f;
+    s_dir[1] = (s_dispy>0.0f) ? 1.0f : -1.0f;
+    s_dir[2] = (s_dispz>0.0f) ? 1.0f : -1.0f;
+
+    // Compute the twice the fractional distance to each potential
+    // streak/cell face intersection.
+    v0 = (s_dispx==0.0f) ? 3.4e38f : (s_dir[0]-s_midx)/s_dispx;
+    v1 = (s_dispy==0.0f) ? 3.4e38f : (s_dir[1]-s_midy)/s_dispy;
+    v2 = (s_dispz==0.0f) ? 3.4e38f : (s_dir[2]-s_midz)/s_dispz;
+
+    // Determine the fractional length and axis of current streak.
+    /**/      v3=2.0f, axis=3;
+    if(v0<v3) v3=v0,   axis=0;
+    if(v1<v3) v3=v1,   axis=1;
+    if(v2<v3) v3=v2,   axis=2;
+    v3 *= 0.5f;
+
+    // Compute the midpoint and the normalized displacement of the streak
+    s_dispx *= v3;
+    s_dispy *= v3;
+    s_dispz *= v3;
+    s_midx += s_dispx;
+    s_midy += s_dispy;
+    s_midz += s_dispz;
+
+    // Accumulate the streak
+    v5 = q*s_dispx*s_dispy*s_dispz*(1./3.);
+    a = (float *)(a0 + g->sfc[voxel]);
+#   define accumulate_j(X,Y,Z)                                        \
+    v4  = q*s_disp##X;    /* v2 = q ux                            */  \
+    v1  = v4*s_mid##Y;    /* v1 = q ux dy                         */  \
+    v0  = v4-v1;          /* v0 = q ux (1-dy)                     */  \
+    v1 += v4;             /* v1 = q ux (1+dy)                     */  \
+    v4  = 1+s_mid##Z;     /* v4 = 1+dz                            */  \
+    v2  = v0*v4;          /* v2 = q ux (1-dy)(1+dz)               */  \
+    v3  = v1*v4;          /* v3 = q ux (1+dy)(1+dz)               */  \
+    v4  = 1-s_mid##Z;     /* v4 = 1-dz                            */  \
+    v0 *= v4;             /* v0 = q ux (1-dy)(1-dz)               */  \
+    v1 *= v4;             /* v1 = q ux (1+dy)(1-dz)               */  \
+    v0 += v5;             /* v0 = q ux [ (1-dy)(1-dz) + uy*uz/3 ] */  \
+    v1 -= v5;             /* v1 = q ux [ (1+dy)(1-dz) - uy*uz/3 ] */  \
+    v2 -= v5;             /* v2 = q ux [ (1-dy)(1+dz) - uy*uz/3 ] */  \
+    v3 += v5;             /* v3 = q ux [ (1+dy)(1+dz) + uy*uz/3 ] */  \
+    a[0] += v0;                                                       \
+    a[1] += v1;                                                       \
+    a[2] += v2;                                                       \
+    a[3] += v3
+    accumulate_j(x,y,z); a += 4;
+    accumulate_j(y,z,x); a += 4;
+    accumulate_j(z,x,y);
+#   undef accumulate_j
+
+    // Compute the remaining particle displacment
+    pm->dispx -= s_dispx;
+    pm->dispy -= s_dispy;
+    pm->dispz -= s_dispz;
+
+    // Compute the new particle offset
+    r[0] += s_dispx+s_dispx;
+    r[1] += s_dispy+s_dispy;
+    r[2] += s_dispz+s_dispz;
+
+    // If an end streak, return success
+
+    if( axis==3 ) break;
+
+    // Determine if the particle crossed into a local cell or if it
+    // hit a boundary and convert the coordinate system accordingly.
+
+    v0 = s_dir[axis];
+    r[axis] = v0; // Avoid roundoff fiascos
+    face = axis; if( v0>0 ) face += 3;
+    neighbor = g->neighbor[ 6*voxel + face ];
+
+    if( UNLIKELY( neighbor==reflect_particles ) ) {
+      // Hit a reflecting boundary condition.
+      u[axis] = -u[axis];
+      (&(pm->dispx))[axis] = -(&(pm->dispx))[axis];
+      continue;
+    }
+
+    if( UNLIKELY( neighbor<g->rangel || neighbor>g->rangeh ) ) {
+      // Cannot handle the boundary condition here.
+      voxel = 8*voxel + face;
+      ret = 1; // Mover still in use
+      break;
+    }
+
+    // Crossed into a normal voxel.
+
+    voxel = neighbor - g->rangel; // Compute local index of neighbor
+    r[axis] = -v0;                // Convert coordinate system
+  }
+
+  pb->dx[j] = r[0]; pb->dy[j] = r[1]; pb->dz[j] = r[2]; pb->i[j] = voxel;
+  pb->ux[j] = u[0]; pb->uy[j] = u[1]; pb->uz[j] = u[2];
+
+  return ret;
+}
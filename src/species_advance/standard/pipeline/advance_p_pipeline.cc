@@ -16,15 +16,16 @@
 // make use of explicit calls to vector intrinsic functions.
 //----------------------------------------------------------------------------//
 
-void
-advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
-                           int pipeline_rank,
-                           int n_pipeline )
+static void
+advance_p_chunk_scalar( advance_p_pipeline_args_t * args,
+                        accumulator_t * ALIGNED(128) a0,
+                        int chunk,
+                        int n_chunk )
 {
   particle_t           * ALIGNED(128) p0 = args->p0;
-  accumulator_t        * ALIGNED(128) a0 = args->a0;
   const interpolator_t * ALIGNED(128) f0 = args->f0;
   const grid_t *                      g  = args->g;
+  const int            * ALIGNED(128) sfc = g->sfc;
 
   particle_t           * ALIGNED(32)  p;
   particle_mover_t     * ALIGNED(16)  pm;
@@ -49,39 +50,20 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
 
   DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
 
-  // Determine which quads of particles quads this pipeline processes.
+  // Determine which quads of particles quads this chunk holds.
 
-  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, itmp, n );
+  DISTRIBUTE( args->np, 16, chunk, n_chunk, itmp, n );
 
   p = args->p0 + itmp;
 
-  // Determine which movers are reserved for this pipeline.
-  // Movers (16 bytes) should be reserved for pipelines in at least
-  // multiples of 8 such that the set of particle movers reserved for
-  // a pipeline is 128-byte aligned and a multiple of 128-byte in
-  // size.  The host is guaranteed to get enough movers to process its
-  // particles with this allocation.
-
-  max_nm = args->max_nm - ( args->np&15 );
-
-  if ( max_nm < 0 ) max_nm = 0;
-
-  DISTRIBUTE( max_nm, 8, pipeline_rank, n_pipeline, itmp, max_nm );
-
-  if ( pipeline_rank == n_pipeline ) max_nm = args->max_nm - itmp;
+  // Determine which movers are reserved for this chunk (see
+  // chunk_movers).
 
-  pm   = args->pm + itmp;
+  pm   = chunk_movers( args, chunk, n_chunk, &max_nm );
   nm   = 0;
   itmp = 0;
 
-  // Determine which accumulator array to use
-  // The host gets the first accumulator array.
-
-  if ( pipeline_rank != n_pipeline )
-    a0 += ( 1 + pipeline_rank ) *
-          POW2_CEIL( (args->nx+2)*(args->ny+2)*(args->nz+2), 2 );
-
-  // Process particles for this pipeline.
+  // Process particles for this chunk.
 
   for( ; n; n--, p++ )
   {
@@ -90,7 +72,7 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
     dz   = p->dz;
     ii   = p->i;
 
-    f    = f0 + ii;                           // Interpolate E
+    f    = f0 + sfc[ii];                      // Interpolate E
 
     hax  = qdt_2mc*(    ( f->ex    + dy*f->dexdy    ) +
                      dz*( f->dexdz + dy*f->d2exdydz ) );
@@ -178,7 +160,7 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
 
       v5 = q*ux*uy*uz*one_third;              // Compute correction
 
-      a  = (float *)( a0 + ii );              // Get accumulator
+      a  = (float *)( a0 + sfc[ii] );         // Get accumulator
 
 #     define ACCUMULATE_J(X,Y,Z,offset)                                 \
       v4  = q*u##X;   /* v2 = q ux                            */        \
@@ -222,18 +204,74 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
           pm[nm++] = local_pm[0];
         }
 
-        else
+        else if ( !spill_mover( args, local_pm ) ) // Unlikely
         {
-          itmp++;                               // Unlikely
+          itmp++;
         }
       }
     }
   }
 
-  args->seg[pipeline_rank].pm        = pm;
-  args->seg[pipeline_rank].max_nm    = max_nm;
-  args->seg[pipeline_rank].nm        = nm;
-  args->seg[pipeline_rank].n_ignored = itmp;
+  args->seg[chunk].pm        = pm;
+  args->seg[chunk].max_nm    = max_nm;
+  args->seg[chunk].nm        = nm;
+  args->seg[chunk].n_ignored = itmp;
+}
+
+void
+advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
+                           int pipeline_rank,
+                           int n_pipeline )
+{
+  accumulator_t * ALIGNED(128) a0 = args->a0;
+
+  int chunk;
+
+  // Determine which accumulator array to use
+  // The host gets the first accumulator array.
+
+  if ( pipeline_rank != n_pipeline )
+    a0 = args->ap[ pipeline_rank ];
+
+  // Process the chunks of particles handed to this pipeline (see
+  // pipeline_work_t).  Without dynamic scheduling, that is chunk
+  // pipeline_rank of n_pipeline chunks.
+
+  while( ( chunk = next_pipeline_chunk( args->work, pipeline_rank ) ) >= 0 )
+    advance_p_chunk_scalar( args, a0, chunk, args->work->n_chunk );
+}
+
+static int
+compare_mover_i( const void * a,
+                 const void * b )
+{
+  const int i = ( ( const particle_mover_t * ) a )->i;
+  const int j = ( ( const particle_mover_t * ) b )->i;
+
+  return ( i > j ) - ( i < j );
+}
+
+void
+append_spilled_movers( species_t * RESTRICT sp,
+                       const advance_p_pipeline_args_t * args,
+                       int nm )
+{
+  int n = args->n_spill;
+
+  if ( n > args->max_spill ) n = args->max_spill;
+
+  if ( !n ) return;
+
+  MOVE( sp->pm + sp->nm, args->pm + args->max_nm - args->max_spill, n );
+
+  sp->nm += n;
+
+  // Movers are processed in reverse order to backfill the particle list
+  // (see boundary_p), so they must be in particle order.  Spilling is
+  // rare, so just sort.
+
+  qsort( sp->pm + nm, sp->nm - nm, sizeof( particle_mover_t ),
+         compare_mover_i );
 }
 
 //----------------------------------------------------------------------------//
@@ -244,24 +282,32 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
 void
 advance_p_pipeline( species_t * RESTRICT sp,
                     accumulator_array_t * RESTRICT aa,
-                    const interpolator_array_t * RESTRICT ia )
+                    const interpolator_array_t * RESTRICT ia,
+                    int n0,
+                    int n1 )
 {
   DECLARE_ALIGNED_ARRAY( advance_p_pipeline_args_t, 128, args, 1 );
 
-  DECLARE_ALIGNED_ARRAY( particle_mover_seg_t, 128, seg, MAX_PIPELINE + 1 );
+  DECLARE_ALIGNED_ARRAY( particle_mover_seg_t, 128, seg, MAX_PIPELINE_CHUNK + 1 );
+
+  DECLARE_ALIGNED_ARRAY( pipeline_work_t, 128, work, 1 );
 
-  int rank;
+  accumulator_t * ap[ MAX_PIPELINE ];
+
+  int rank, nm, n, n_chunk;
 
   if ( !sp || !aa || !ia || sp->g != aa->g || sp->g != ia->g )
   {
     ERROR( ( "Bad args" ) );
   }
 
-  args->p0      = sp->p;
-  args->pm      = sp->pm;
+  args->p0      = sp->p + n0;
+  args->pm      = sp->pm + sp->nm;
   args->a0      = aa->a;
+  args->ap      = ap;
   args->f0      = ia->i;
   args->seg     = seg;
+  args->work    = work;
   args->g       = sp->g;
 
   args->qdt_2mc = (sp->q*sp->g->dt)/(2*sp->m*sp->g->cvac);
@@ -270,12 +316,43 @@ advance_p_pipeline( species_t * RESTRICT sp,
   args->cdt_dz  = sp->g->cvac*sp->g->dt*sp->g->rdz;
   args->qsp     = sp->q;
 
-  args->np      = sp->np;
-  args->max_nm  = sp->max_nm;
+  args->np      = n1 - n0;
+  args->max_nm  = sp->max_nm - sp->nm;
+  args->n_spill = 0;
   args->nx      = sp->g->nx;
   args->ny      = sp->g->ny;
   args->nz      = sp->g->nz;
 
+  // Set up the accumulators of the pipelines (see accumulator_array_t).
+  // Particles not sorted this step are partitioned by pipeline first such
+  // that the tiles stay about the slices of the local domain.
+
+  if ( aa->tiled )
+  {
+    if ( sp->last_sorted != sp->g->step )
+      partition_tile_p_pipeline( sp, n0, n1 );
+
+    tile_p_pipeline( aa, args->p0, NULL, args->np );
+  }
+
+  begin_pipeline_accumulators( aa, ap, N_PIPELINE );
+
+  // Split the particles into chunks of at least 16 particle blocks with at
+  // least 64 movers each for the pipelines to share (see pipeline_work_t).
+  // The tiles of tiled accumulators only cover the particles of a static
+  // schedule.  Half the movers are shared by the chunks (see
+  // chunk_movers), so the number of movers a chunk can take does not
+  // shrink with the number of chunks.
+
+  args->max_spill = ( ( args->max_nm - ( args->np&15 ) ) / 2 ) & ~7;
+  if ( args->max_spill < 0 ) args->max_spill = 0;
+
+  n = args->np >> 8;
+  if ( n > ( ( args->max_nm - args->max_spill ) >> 6 ) )
+    n = ( args->max_nm - args->max_spill ) >> 6;
+
+  n_chunk = init_pipeline_work( work, aa->tiled ? 0 : n, N_PIPELINE );
+
   // Have the host processor do the last incomplete bundle if necessary.
   // Note: This is overlapped with the pipelined processing.  As such,
   // it uses an entire accumulator.  Reserving an entire accumulator
@@ -291,12 +368,14 @@ advance_p_pipeline( species_t * RESTRICT sp,
 
   WAIT_PIPELINES();
 
+  end_pipeline_accumulators( aa, N_PIPELINE );
+
   // FIXME: HIDEOUS HACK UNTIL BETTER PARTICLE MOVER SEMANTICS
   // INSTALLED FOR DEALING WITH PIPELINES.  COMPACT THE PARTICLE
   // MOVERS TO ELIMINATE HOLES FROM THE PIPELINING.
 
-  sp->nm = 0;
-  for( rank = 0; rank <= N_PIPELINE; rank++ )
+  nm = sp->nm;
+  for( rank = 0; rank <= n_chunk; rank++ )
   {
     if ( args->seg[rank].n_ignored )
     {
@@ -311,4 +390,16 @@ advance_p_pipeline( species_t * RESTRICT sp,
 
     sp->nm += args->seg[rank].nm;
   }
+
+  append_spilled_movers( sp, args, nm );
+
+  // The pipelines index the particles they moved from n0.
+
+  if ( n0 )
+  {
+    for( n = nm; n < sp->nm; n++ )
+    {
+      sp->pm[n].i += n0;
+    }
+  }
 }
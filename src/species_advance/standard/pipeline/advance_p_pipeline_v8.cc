@@ -6,15 +6,16 @@
 
 using namespace v8;
 
-void
-advance_p_pipeline_v8( advance_p_pipeline_args_t * args,
-                       int pipeline_rank,
-                       int n_pipeline )
+static void
+advance_p_chunk_v8( advance_p_pipeline_args_t * args,
+                    accumulator_t * ALIGNED(128) a0,
+                    int chunk,
+                    int n_chunk )
 {
   particle_t           * ALIGNED(128) p0 = args->p0;
-  accumulator_t        * ALIGNED(128) a0 = args->a0;
   const interpolator_t * ALIGNED(128) f0 = args->f0;
   const grid_t         *              g  = args->g;
+  const int            * ALIGNED(128) sfc = g->sfc;
 
   particle_t           * ALIGNED(128) p;
   particle_mover_t     * ALIGNED(16)  pm;
@@ -50,40 +51,22 @@ advance_p_pipeline_v8( advance_p_pipeline_args_t * args,
 
   DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
 
-  // Determine which quads of particle quads this pipeline processes.
+  // Determine which quads of particle quads this chunk holds.
 
-  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, itmp, nq );
+  DISTRIBUTE( args->np, 16, chunk, n_chunk, itmp, nq );
 
   p = args->p0 + itmp;
 
   nq >>= 3;
 
-  // Determine which movers are reserved for this pipeline.
-  // Movers (16 bytes) should be reserved for pipelines in at least
-  // multiples of 8 such that the set of particle movers reserved for
-  // a pipeline is 128-byte aligned and a multiple of 128-byte in
-  // size.  The host is guaranteed to get enough movers to process its
-  // particles with this allocation.
-
-  max_nm = args->max_nm - ( args->np&15 );
-
-  if ( max_nm < 0 ) max_nm = 0;
-
-  DISTRIBUTE( max_nm, 8, pipeline_rank, n_pipeline, itmp, max_nm );
+  // Determine which movers are reserved for this chunk (see
+  // chunk_movers).
 
-  if ( pipeline_rank == n_pipeline ) max_nm = args->max_nm - itmp;
-
-  pm   = args->pm + itmp;
+  pm   = chunk_movers( args, chunk, n_chunk, &max_nm );
   nm   = 0;
   itmp = 0;
 
-  // Determine which accumulator array to use.
-  // The host gets the first accumulator array.
-
-  a0 += ( 1 + pipeline_rank ) *
-        POW2_CEIL( (args->nx+2)*(args->ny+2)*(args->nz+2), 2 );
-
-  // Process the particle blocks for this pipeline.
+  // Process the particle blocks for this chunk.
 
   for( ; nq; nq--, p+=8 )
   {
@@ -97,14 +80,14 @@ advance_p_pipeline_v8( advance_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
     //--------------------------------------------------------------------------
-    vp00 = ( float * ALIGNED(32) ) ( f0 + ii( 0) );
-    vp01 = ( float * ALIGNED(32) ) ( f0 + ii( 1) );
-    vp02 = ( float * ALIGNED(32) ) ( f0 + ii( 2) );
-    vp03 = ( float * ALIGNED(32) ) ( f0 + ii( 3) );
-    vp04 = ( float * ALIGNED(32) ) ( f0 + ii( 4) );
-    vp05 = ( float * ALIGNED(32) ) ( f0 + ii( 5) );
-    vp06 = ( float * ALIGNED(32) ) ( f0 + ii( 6) );
-    vp07 = ( float * ALIGNED(32) ) ( f0 + ii( 7) );
+    vp00 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 0) ] );
+    vp01 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 1) ] );
+    vp02 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 2) ] );
+    vp03 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 3) ] );
+    vp04 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 4) ] );
+    vp05 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 5) ] );
+    vp06 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 6) ] );
+    vp07 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 7) ] );
 
     //--------------------------------------------------------------------------
     // Load interpolation data for particles.
@@ -229,14 +212,14 @@ advance_p_pipeline_v8( advance_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Set current density accumulation pointers.
     //--------------------------------------------------------------------------
-    vp00 = ( float * ALIGNED(32) ) ( a0 + ii( 0) );
-    vp01 = ( float * ALIGNED(32) ) ( a0 + ii( 1) );
-    vp02 = ( float * ALIGNED(32) ) ( a0 + ii( 2) );
-    vp03 = ( float * ALIGNED(32) ) ( a0 + ii( 3) );
-    vp04 = ( float * ALIGNED(32) ) ( a0 + ii( 4) );
-    vp05 = ( float * ALIGNED(32) ) ( a0 + ii( 5) );
-    vp06 = ( float * ALIGNED(32) ) ( a0 + ii( 6) );
-    vp07 = ( float * ALIGNED(32) ) ( a0 + ii( 7) );
+    vp00 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 0) ] );
+    vp01 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 1) ] );
+    vp02 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 2) ] );
+    vp03 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 3) ] );
+    vp04 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 4) ] );
+    vp05 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 5) ] );
+    vp06 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 6) ] );
+    vp07 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 7) ] );
 
     //--------------------------------------------------------------------------
     // Accumulate current density.
@@ -356,7 +339,7 @@ advance_p_pipeline_v8( advance_p_pipeline_args_t * args,
         {                                                               \
           v4::copy_4x1( &pm[nm++], local_pm );                          \
         }                                                               \
-        else                                        /* Unlikely */      \
+        else if ( !spill_mover( args, local_pm ) )  /* Unlikely */      \
         {                                                               \
           itmp++;                                                       \
         }                                                               \
@@ -375,10 +358,32 @@ advance_p_pipeline_v8( advance_p_pipeline_args_t * args,
 #   undef MOVE_OUTBND
   }
 
-  args->seg[pipeline_rank].pm        = pm;
-  args->seg[pipeline_rank].max_nm    = max_nm;
-  args->seg[pipeline_rank].nm        = nm;
-  args->seg[pipeline_rank].n_ignored = itmp;
+  args->seg[chunk].pm        = pm;
+  args->seg[chunk].max_nm    = max_nm;
+  args->seg[chunk].nm        = nm;
+  args->seg[chunk].n_ignored = itmp;
+}
+
+void
+advance_p_pipeline_v8( advance_p_pipeline_args_t * args,
+                       int pipeline_rank,
+                       int /* n_pipeline */ )
+{
+  accumulator_t * ALIGNED(128) a0;
+
+  int chunk;
+
+  // Determine which accumulator array to use.
+  // The host gets the first accumulator array.
+
+  a0 = args->ap[ pipeline_rank ];
+
+  // Process the chunks of particles handed to this pipeline (see
+  // pipeline_work_t).  Without dynamic scheduling, that is chunk
+  // pipeline_rank of n_pipeline chunks.
+
+  while( ( chunk = next_pipeline_chunk( args->work, pipeline_rank ) ) >= 0 )
+    advance_p_chunk_v8( args, a0, chunk, args->work->n_chunk );
 }
 
 #else
@@ -0,0 +1,365 @@
+#define IN_spa
+
+#define HAS_V4_PIPELINE
+#define HAS_V8_PIPELINE
+#define HAS_V16_PIPELINE
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Reference implementation for an advance_p pipeline function for particles
+// in the AoSoA layout which does not make use of explicit calls to vector
+// intrinsic functions.  This is the advance_p_pipeline_scalar with each
+// particle loaded from and stored to its lane of its particle block.
+//----------------------------------------------------------------------------//
+
+static void
+advance_pb_chunk_scalar( advance_p_pipeline_args_t * args,
+                         accumulator_t * ALIGNED(128) a0,
+                         int chunk,
+                         int n_chunk )
+{
+  particle_block_t     * ALIGNED(128) pb0 = (particle_block_t *)args->p0;
+  const interpolator_t * ALIGNED(128) f0 = args->f0;
+  const grid_t *                      g  = args->g;
+  const int            * ALIGNED(128) sfc = g->sfc;
+
+  particle_block_t     * ALIGNED(128) pb;
+  particle_mover_t     * ALIGNED(16)  pm;
+  const interpolator_t * ALIGNED(16)  f;
+  float                * ALIGNED(16)  a;
+
+  const float qdt_2mc        = args->qdt_2mc;
+  const float cdt_dx         = args->cdt_dx;
+  const float cdt_dy         = args->cdt_dy;
+  const float cdt_dz         = args->cdt_dz;
+  const float qsp            = args->qsp;
+  const float one            = 1.0;
+  const float one_third      = 1.0/3.0;
+  const float two_fifteenths = 2.0/15.0;
+
+  float dx, dy, dz, ux, uy, uz, q;
+  float hax, hay, haz, cbx, cby, cbz;
+  float v0, v1, v2, v3, v4, v5;
+  int   ii, j;
+
+  int itmp, k, n, nm, max_nm;
+
+  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
+
+  // Determine which quads of particles quads this chunk holds.
+
+  DISTRIBUTE( args->np, 16, chunk, n_chunk, k, n );
+
+  // Determine which movers are reserved for this chunk (see
+  // chunk_movers).
+
+  pm   = chunk_movers( args, chunk, n_chunk, &max_nm );
+  nm   = 0;
+  itmp = 0;
+
+  // Process particles for this chunk.
+
+  for( ; n; n--, k++ )
+  {
+    pb   = pb0 + k / PARTICLE_BLOCK_SIZE;     // Find particle lane
+    j    = k % PARTICLE_BLOCK_SIZE;
+
+    dx   = pb->dx[j];                         // Load position
+    dy   = pb->dy[j];
+    dz   = pb->dz[j];
+    ii   = pb->i[j];
+
+    f    = f0 + sfc[ii];                      // Interpolate E
+
+    hax  = qdt_2mc*(    ( f->ex    + dy*f->dexdy    ) +
+                     dz*( f->dexdz + dy*f->d2exdydz ) );
+
+    hay  = qdt_2mc*(    ( f->ey    + dz*f->deydz    ) +
+                     dx*( f->deydx + dz*f->d2eydzdx ) );
+
+    haz  = qdt_2mc*(    ( f->ez    + dx*f->dezdx    ) +
+                     dy*( f->dezdy + dx*f->d2ezdxdy ) );
+
+    cbx  = f->cbx + dx*f->dcbxdx;             // Interpolate B
+    cby  = f->cby + dy*f->dcbydy;
+    cbz  = f->cbz + dz*f->dcbzdz;
+
+    ux   = pb->ux[j];                         // Load momentum
+    uy   = pb->uy[j];
+    uz   = pb->uz[j];
+    q    = pb->w[j];
+
+    ux  += hax;                               // Half advance E
+    uy  += hay;
+    uz  += haz;
+
+    v0   = qdt_2mc / sqrtf( one + ( ux*ux + ( uy*uy + uz*uz ) ) );
+
+                                              // Boris - scalars
+    v1   = cbx*cbx + ( cby*cby + cbz*cbz );
+    v2   = ( v0*v0 ) * v1;
+    v3   = v0 * ( one + v2 * ( one_third + v2 * two_fifteenths ) );
+    v4   = v3 / ( one + v1 * ( v3 * v3 ) );
+    v4  += v4;
+
+    v0   = ux + v3*( uy*cbz - uz*cby );       // Boris - uprime
+    v1   = uy + v3*( uz*cbx - ux*cbz );
+    v2   = uz + v3*( ux*cby - uy*cbx );
+
+    ux  += v4*( v1*cbz - v2*cby );            // Boris - rotation
+    uy  += v4*( v2*cbx - v0*cbz );
+    uz  += v4*( v0*cby - v1*cbx );
+
+    ux  += hax;                               // Half advance E
+    uy  += hay;
+    uz  += haz;
+
+    pb->ux[j] = ux;                           // Store momentum
+    pb->uy[j] = uy;
+    pb->uz[j] = uz;
+
+    v0   = one / sqrtf( one + ( ux*ux+ ( uy*uy + uz*uz ) ) );
+                                              // Get norm displacement
+
+    ux  *= cdt_dx;
+    uy  *= cdt_dy;
+    uz  *= cdt_dz;
+
+    ux  *= v0;
+    uy  *= v0;
+    uz  *= v0;
+
+    v0   = dx + ux;                           // Streak midpoint (inbnds)
+    v1   = dy + uy;
+    v2   = dz + uz;
+
+    v3   = v0 + ux;                           // New position
+    v4   = v1 + uy;
+    v5   = v2 + uz;
+
+    // FIXME-KJB: COULD SHORT CIRCUIT ACCUMULATION IN THE CASE WHERE QSP==0!
+    if (  v3 <= one &&  v4 <= one &&  v5 <= one &&   // Check if inbnds
+         -v3 <= one && -v4 <= one && -v5 <= one )
+    {
+      // Common case (inbnds).  Note: accumulator values are 4 times
+      // the total physical charge that passed through the appropriate
+      // current quadrant in a time-step.
+
+      q *= qsp;
+
+      pb->dx[j] = v3;                         // Store new position
+      pb->dy[j] = v4;
+      pb->dz[j] = v5;
+
+      dx = v0;                                // Streak midpoint
+      dy = v1;
+      dz = v2;
+
+      v5 = q*ux*uy*uz*one_third;              // Compute correction
+
+      a  = (float *)( a0 + sfc[ii] );         // Get accumulator
+
+#     define ACCUMULATE_J(X,Y,Z,offset)                                 \
+      v4  = q*u##X;   /* v2 = q ux                            */        \
+      v1  = v4*d##Y;  /* v1 = q ux dy                         */        \
+      v0  = v4-v1;    /* v0 = q ux (1-dy)                     */        \
+      v1 += v4;       /* v1 = q ux (1+dy)                     */        \
+      v4  = one+d##Z; /* v4 = 1+dz                            */        \
+      v2  = v0*v4;    /* v2 = q ux (1-dy)(1+dz)               */        \
+      v3  = v1*v4;    /* v3 = q ux (1+dy)(1+dz)               */        \
+      v4  = one-d##Z; /* v4 = 1-dz                            */        \
+      v0 *= v4;       /* v0 = q ux (1-dy)(1-dz)               */        \
+      v1 *= v4;       /* v1 = q ux (1+dy)(1-dz)               */        \
+      v0 += v5;       /* v0 = q ux [ (1-dy)(1-dz) + uy*uz/3 ] */        \
+      v1 -= v5;       /* v1 = q ux [ (1+dy)(1-dz) - uy*uz/3 ] */        \
+      v2 -= v5;       /* v2 = q ux [ (1-dy)(1+dz) - uy*uz/3 ] */        \
+      v3 += v5;       /* v3 = q ux [ (1+dy)(1+dz) + uy*uz/3 ] */        \
+      a[offset+0] += v0;                                                \
+      a[offset+1] += v1;                                                \
+      a[offset+2] += v2;                                                \
+      a[offset+3] += v3
+
+      ACCUMULATE_J( x, y, z, 0 );
+      ACCUMULATE_J( y, z, x, 4 );
+      ACCUMULATE_J( z, x, y, 8 );
+
+#     undef ACCUMULATE_J
+    }
+
+    else                                        // Unlikely
+    {
+      local_pm->dispx = ux;
+      local_pm->dispy = uy;
+      local_pm->dispz = uz;
+
+      local_pm->i     = k;
+
+      if ( move_pb( pb0, local_pm, a0, g, qsp ) ) // Unlikely
+      {
+        if ( nm < max_nm )
+        {
+          pm[nm++] = local_pm[0];
+        }
+
+        else if ( !spill_mover( args, local_pm ) ) // Unlikely
+        {
+          itmp++;
+        }
+      }
+    }
+  }
+
+  args->seg[chunk].pm        = pm;
+  args->seg[chunk].max_nm    = max_nm;
+  args->seg[chunk].nm        = nm;
+  args->seg[chunk].n_ignored = itmp;
+}
+
+void
+advance_pb_pipeline_scalar( advance_p_pipeline_args_t * args,
+                            int pipeline_rank,
+                            int n_pipeline )
+{
+  accumulator_t * ALIGNED(128) a0 = args->a0;
+
+  int chunk;
+
+  // Determine which accumulator array to use
+  // The host gets the first accumulator array.
+
+  if ( pipeline_rank != n_pipeline )
+    a0 = args->ap[ pipeline_rank ];
+
+  // Process the chunks of particles handed to this pipeline (see
+  // pipeline_work_t).  Without dynamic scheduling, that is chunk
+  // pipeline_rank of n_pipeline chunks.
+
+  while( ( chunk = next_pipeline_chunk( args->work, pipeline_rank ) ) >= 0 )
+    advance_pb_chunk_scalar( args, a0, chunk, args->work->n_chunk );
+}
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper advance_pb pipeline
+// function.  The particles must be in the AoSoA layout.
+//----------------------------------------------------------------------------//
+
+void
+advance_pb_pipeline( species_t * RESTRICT sp,
+                     accumulator_array_t * RESTRICT aa,
+                     const interpolator_array_t * RESTRICT ia,
+                     int n0,
+                     int n1 )
+{
+  DECLARE_ALIGNED_ARRAY( advance_p_pipeline_args_t, 128, args, 1 );
+
+  DECLARE_ALIGNED_ARRAY( particle_mover_seg_t, 128, seg, MAX_PIPELINE_CHUNK + 1 );
+
+  DECLARE_ALIGNED_ARRAY( pipeline_work_t, 128, work, 1 );
+
+  accumulator_t * ap[ MAX_PIPELINE ];
+
+  int rank, nm, n, n_chunk;
+
+  if ( !sp || !aa || !ia || sp->g != aa->g || sp->g != ia->g ||
+       sp->p_layout != particle_layout_aosoa )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  args->p0      = sp->p + n0; // n0 is a multiple of the block size
+  args->pm      = sp->pm + sp->nm;
+  args->a0      = aa->a;
+  args->ap      = ap;
+  args->f0      = ia->i;
+  args->seg     = seg;
+  args->work    = work;
+  args->g       = sp->g;
+
+  args->qdt_2mc = (sp->q*sp->g->dt)/(2*sp->m*sp->g->cvac);
+  args->cdt_dx  = sp->g->cvac*sp->g->dt*sp->g->rdx;
+  args->cdt_dy  = sp->g->cvac*sp->g->dt*sp->g->rdy;
+  args->cdt_dz  = sp->g->cvac*sp->g->dt*sp->g->rdz;
+  args->qsp     = sp->q;
+
+  args->np      = n1 - n0;
+  args->max_nm  = sp->max_nm - sp->nm;
+  args->n_spill = 0;
+  args->nx      = sp->g->nx;
+  args->ny      = sp->g->ny;
+  args->nz      = sp->g->nz;
+
+  // Set up the accumulators of the pipelines (see accumulator_array_t).
+  // Particles not sorted this step are partitioned by pipeline first such
+  // that the tiles stay about the slices of the local domain.
+
+  if ( aa->tiled )
+  {
+    if ( sp->last_sorted != sp->g->step )
+      partition_tile_p_pipeline( sp, n0, n1 );
+
+    tile_p_pipeline( aa, NULL, (const particle_block_t *)args->p0, args->np );
+  }
+
+  begin_pipeline_accumulators( aa, ap, N_PIPELINE );
+
+  // Split the particles into chunks of at least 16 particle blocks with at
+  // least 64 movers each for the pipelines to share (see pipeline_work_t).
+  // The tiles of tiled accumulators only cover the particles of a static
+  // schedule.  Half the movers are shared by the chunks (see
+  // chunk_movers), so the number of movers a chunk can take does not
+  // shrink with the number of chunks.
+
+  args->max_spill = ( ( args->max_nm - ( args->np&15 ) ) / 2 ) & ~7;
+  if ( args->max_spill < 0 ) args->max_spill = 0;
+
+  n = args->np >> 8;
+  if ( n > ( ( args->max_nm - args->max_spill ) >> 6 ) )
+    n = ( args->max_nm - args->max_spill ) >> 6;
+
+  n_chunk = init_pipeline_work( work, aa->tiled ? 0 : n, N_PIPELINE );
+
+  // Pipelines get whole particle blocks and the host processor does the
+  // last incomplete block (see advance_p_pipeline).
+
+  EXEC_PIPELINES( advance_pb, args, 0 );
+
+  WAIT_PIPELINES();
+
+  end_pipeline_accumulators( aa, N_PIPELINE );
+
+  // FIXME: HIDEOUS HACK UNTIL BETTER PARTICLE MOVER SEMANTICS
+  // INSTALLED FOR DEALING WITH PIPELINES.  COMPACT THE PARTICLE
+  // MOVERS TO ELIMINATE HOLES FROM THE PIPELINING.
+
+  nm = sp->nm;
+  for( rank = 0; rank <= n_chunk; rank++ )
+  {
+    if ( args->seg[rank].n_ignored )
+    {
+      WARNING( ( "Pipeline %i ran out of storage for %i movers",
+                 rank, args->seg[rank].n_ignored ) );
+    }
+
+    if ( sp->pm + sp->nm != args->seg[rank].pm )
+    {
+      MOVE( sp->pm + sp->nm, args->seg[rank].pm, args->seg[rank].nm );
+    }
+
+    sp->nm += args->seg[rank].nm;
+  }
+
+  append_spilled_movers( sp, args, nm );
+
+  // The pipelines index the particles they moved from n0.
+
+  if ( n0 )
+  {
+    for( n = nm; n < sp->nm; n++ )
+    {
+      sp->pm[n].i += n0;
+    }
+  }
+}
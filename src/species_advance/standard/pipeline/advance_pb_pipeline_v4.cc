@@ -0,0 +1,342 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V4_ACCELERATION)
+
+using namespace v4;
+
+//----------------------------------------------------------------------------//
+// This is advance_p_pipeline_v4 for particles in the AoSoA layout.  Each
+// particle block is processed as four quarters of 4 particles that are
+// loaded and stored with aligned vector loads and stores of their fields
+// instead of the load_4x4_tr and store_4x4_tr transposes.  Particles are
+// processed in the same order as the reference implementation.
+//----------------------------------------------------------------------------//
+
+static void
+advance_pb_chunk_v4( advance_p_pipeline_args_t * args,
+                     accumulator_t * ALIGNED(128) a0,
+                     int chunk,
+                     int n_chunk )
+{
+  particle_block_t     * ALIGNED(128) pb0 = (particle_block_t *)args->p0;
+  const interpolator_t * ALIGNED(128) f0 = args->f0;
+  const grid_t         *              g  = args->g;
+  const int            * ALIGNED(128) sfc = g->sfc;
+
+  particle_block_t     * ALIGNED(128) pb;
+  particle_mover_t     * ALIGNED(16)  pm;
+
+  float                * ALIGNED(16)  vp00;
+  float                * ALIGNED(16)  vp01;
+  float                * ALIGNED(16)  vp02;
+  float                * ALIGNED(16)  vp03;
+
+  // Basic constants.
+  const v4float qdt_2mc(args->qdt_2mc);
+  const v4float cdt_dx(args->cdt_dx);
+  const v4float cdt_dy(args->cdt_dy);
+  const v4float cdt_dz(args->cdt_dz);
+  const v4float qsp(args->qsp);
+  const v4float one(1.0);
+  const v4float one_third(1.0/3.0);
+  const v4float two_fifteenths(2.0/15.0);
+  const v4float neg_one(-1.0);
+
+  const float _qsp = args->qsp;
+
+  v4float dx, dy, dz, ux, uy, uz, q;
+  v4float hax, hay, haz, cbx, cby, cbz;
+  v4float v00, v01, v02, v03, v04, v05;
+  v4int   ii, outbnd;
+
+  int itmp, nq, nm, max_nm, h;
+
+  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
+
+  // Determine which quads of particle quads this chunk holds.
+
+  DISTRIBUTE( args->np, 16, chunk, n_chunk, itmp, nq );
+
+  pb = pb0 + itmp / PARTICLE_BLOCK_SIZE;
+
+  nq >>= 2;
+
+  // Determine which movers are reserved for this chunk (see
+  // chunk_movers).
+
+  pm   = chunk_movers( args, chunk, n_chunk, &max_nm );
+  nm   = 0;
+  itmp = 0;
+
+  // Process the particle blocks for this chunk, the h=0, 4, 8 and 12
+  // quarters of each block in turn.
+
+  for( h = 0; nq; nq--, h = ( h + 4 ) & 15, pb += ( h == 0 ) )
+  {
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+    load_4x1( pb->dx + h, dx );
+    load_4x1( pb->dy + h, dy );
+    load_4x1( pb->dz + h, dz );
+    load_4x1( pb->i  + h, ii );
+
+    //--------------------------------------------------------------------------
+    // Set field interpolation pointers.
+    //--------------------------------------------------------------------------
+    vp00 = ( float * ALIGNED(16) ) ( f0 + sfc[ ii( 0) ] );
+    vp01 = ( float * ALIGNED(16) ) ( f0 + sfc[ ii( 1) ] );
+    vp02 = ( float * ALIGNED(16) ) ( f0 + sfc[ ii( 2) ] );
+    vp03 = ( float * ALIGNED(16) ) ( f0 + sfc[ ii( 3) ] );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles.
+    //--------------------------------------------------------------------------
+    load_4x4_tr( vp00, vp01, vp02, vp03,
+                 hax, v00, v01, v02 );
+
+    hax = qdt_2mc*fma( fma( v02, dy, v01 ), dz, fma( v00, dy, hax ) );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles.
+    //--------------------------------------------------------------------------
+    load_4x4_tr( vp00+4, vp01+4, vp02+4, vp03+4,
+                 hay, v03, v04, v05 );
+
+    hay = qdt_2mc*fma( fma( v05, dz, v04 ), dx, fma( v03, dz, hay ) );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles.
+    //--------------------------------------------------------------------------
+    load_4x4_tr( vp00+8, vp01+8, vp02+8, vp03+8,
+                 haz, v00, v01, v02 );
+
+    haz = qdt_2mc*fma( fma( v02, dx, v01 ), dy, fma( v00, dx, haz ) );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles.
+    //--------------------------------------------------------------------------
+    load_4x4_tr( vp00+12, vp01+12, vp02+12, vp03+12,
+                 cbx, v03, cby, v04 );
+
+    cbx = fma( v03, dx, cbx );
+
+    cby = fma( v04, dy, cby );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles, final.
+    //--------------------------------------------------------------------------
+    load_4x2_tr( vp00+16, vp01+16, vp02+16, vp03+16,
+                 cbz, v05 );
+
+    cbz = fma( v05, dz, cbz );
+
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+    load_4x1( pb->ux + h, ux );
+    load_4x1( pb->uy + h, uy );
+    load_4x1( pb->uz + h, uz );
+    load_4x1( pb->w  + h, q  );
+
+    //--------------------------------------------------------------------------
+    // Update momentum.
+    //--------------------------------------------------------------------------
+    // For a 5-10% performance hit, v00 = qdt_2mc/sqrt(blah) is a few ulps more
+    // accurate (but still quite in the noise numerically) for cyclotron
+    // frequencies approaching the nyquist frequency.
+    //--------------------------------------------------------------------------
+
+    ux  += hax;
+    uy  += hay;
+    uz  += haz;
+
+    v00  = qdt_2mc*rsqrt( one + fma( ux, ux, fma( uy, uy, uz*uz ) ) );
+    v01  = fma( cbx, cbx, fma( cby, cby, cbz*cbz ) );
+    v02  = (v00*v00)*v01;
+    v03  = v00*fma( fma( two_fifteenths, v02, one_third ), v02, one );
+    v04  = v03*rcp( fma( v03*v03, v01, one ) );
+    v04 += v04;
+
+    v00  = fma( fms(  uy, cbz,  uz*cby ), v03, ux );
+    v01  = fma( fms(  uz, cbx,  ux*cbz ), v03, uy );
+    v02  = fma( fms(  ux, cby,  uy*cbx ), v03, uz );
+
+    ux   = fma( fms( v01, cbz, v02*cby ), v04, ux );
+    uy   = fma( fms( v02, cbx, v00*cbz ), v04, uy );
+    uz   = fma( fms( v00, cby, v01*cbx ), v04, uz );
+
+    ux  += hax;
+    uy  += hay;
+    uz  += haz;
+
+    //--------------------------------------------------------------------------
+    // Store particle data.
+    //--------------------------------------------------------------------------
+    store_4x1( ux, pb->ux + h );
+    store_4x1( uy, pb->uy + h );
+    store_4x1( uz, pb->uz + h );
+
+    //--------------------------------------------------------------------------
+    // Update the position of in bound particles.
+    //--------------------------------------------------------------------------
+    v00 = rsqrt( one + fma( ux, ux, fma( uy, uy, uz*uz ) ) );
+
+    ux *= cdt_dx;
+    uy *= cdt_dy;
+    uz *= cdt_dz;
+
+    ux *= v00;
+    uy *= v00;
+    uz *= v00;      // ux,uy,uz are normalized displ (relative to cell size)
+
+    v00 =  dx + ux;
+    v01 =  dy + uy;
+    v02 =  dz + uz; // New particle midpoint
+
+    v03 = v00 + ux;
+    v04 = v01 + uy;
+    v05 = v02 + uz; // New particle position
+
+    //--------------------------------------------------------------------------
+    // Determine which particles are out of bounds.
+    //--------------------------------------------------------------------------
+    outbnd = ( v03 > one ) | ( v03 < neg_one ) |
+             ( v04 > one ) | ( v04 < neg_one ) |
+             ( v05 > one ) | ( v05 < neg_one );
+
+    v03 = merge( outbnd, dx, v03 ); // Do not update outbnd particles
+    v04 = merge( outbnd, dy, v04 );
+    v05 = merge( outbnd, dz, v05 );
+
+    //--------------------------------------------------------------------------
+    // Store particle data, final.
+    //--------------------------------------------------------------------------
+    store_4x1( v03, pb->dx + h );
+    store_4x1( v04, pb->dy + h );
+    store_4x1( v05, pb->dz + h );
+
+    // Accumulate current of inbnd particles.
+    // Note: accumulator values are 4 times the total physical charge that
+    // passed through the appropriate current quadrant in a time-step.
+    q  = czero( outbnd, q*qsp );   // Do not accumulate outbnd particles
+
+    dx = v00;                      // Streak midpoint (valid for inbnd only)
+    dy = v01;
+    dz = v02;
+
+    v05 = q*ux*uy*uz*one_third;    // Charge conservation correction
+
+    //--------------------------------------------------------------------------
+    // Set current density accumulation pointers.
+    //--------------------------------------------------------------------------
+    vp00 = ( float * ALIGNED(16) ) ( a0 + sfc[ ii( 0) ] );
+    vp01 = ( float * ALIGNED(16) ) ( a0 + sfc[ ii( 1) ] );
+    vp02 = ( float * ALIGNED(16) ) ( a0 + sfc[ ii( 2) ] );
+    vp03 = ( float * ALIGNED(16) ) ( a0 + sfc[ ii( 3) ] );
+
+    //--------------------------------------------------------------------------
+    // Accumulate current density.
+    //--------------------------------------------------------------------------
+#   define ACCUMULATE_J(X,Y,Z,offset)                                  \
+    v04  = q*u##X;    /* v04 = q ux                            */      \
+    v01  = v04*d##Y;  /* v01 = q ux dy                         */      \
+    v00  = v04-v01;   /* v00 = q ux (1-dy)                     */      \
+    v01 += v04;       /* v01 = q ux (1+dy)                     */      \
+    v04  = one+d##Z;  /* v04 = 1+dz                            */      \
+    v02  = v00*v04;   /* v02 = q ux (1-dy)(1+dz)               */      \
+    v03  = v01*v04;   /* v03 = q ux (1+dy)(1+dz)               */      \
+    v04  = one-d##Z;  /* v04 = 1-dz                            */      \
+    v00 *= v04;       /* v00 = q ux (1-dy)(1-dz)               */      \
+    v01 *= v04;       /* v01 = q ux (1+dy)(1-dz)               */      \
+    v00 += v05;       /* v00 = q ux [ (1-dy)(1-dz) + uy*uz/3 ] */      \
+    v01 -= v05;       /* v01 = q ux [ (1+dy)(1-dz) - uy*uz/3 ] */      \
+    v02 -= v05;       /* v02 = q ux [ (1-dy)(1+dz) - uy*uz/3 ] */      \
+    v03 += v05;       /* v03 = q ux [ (1+dy)(1+dz) + uy*uz/3 ] */      \
+    transpose( v00, v01, v02, v03 );                                   \
+    increment_4x1( vp00+offset, v00 );                                 \
+    increment_4x1( vp01+offset, v01 );                                 \
+    increment_4x1( vp02+offset, v02 );                                 \
+    increment_4x1( vp03+offset, v03 )
+
+    ACCUMULATE_J( x, y, z, 0 );
+    ACCUMULATE_J( y, z, x, 4 );
+    ACCUMULATE_J( z, x, y, 8 );
+
+#   undef ACCUMULATE_J
+
+    //--------------------------------------------------------------------------
+    // Update position and accumulate current density for out of bounds
+    // particles.
+    //--------------------------------------------------------------------------
+
+#   define MOVE_OUTBND(N)                                               \
+    if ( outbnd(N) )                                /* Unlikely */      \
+    {                                                                   \
+      local_pm->dispx = ux(N);                                          \
+      local_pm->dispy = uy(N);                                          \
+      local_pm->dispz = uz(N);                                          \
+      local_pm->i     = ( pb - pb0 )*PARTICLE_BLOCK_SIZE + h + N;       \
+      if ( move_pb( pb0, local_pm, a0, g, _qsp ) )  /* Unlikely */      \
+      {                                                                 \
+        if ( nm < max_nm )                                              \
+        {                                                               \
+          copy_4x1( &pm[nm++], local_pm );                              \
+        }                                                               \
+        else if ( !spill_mover( args, local_pm ) )  /* Unlikely */      \
+        {                                                               \
+          itmp++;                                                       \
+        }                                                               \
+      }                                                                 \
+    }
+
+    MOVE_OUTBND( 0);
+    MOVE_OUTBND( 1);
+    MOVE_OUTBND( 2);
+    MOVE_OUTBND( 3);
+
+#   undef MOVE_OUTBND
+  }
+
+  args->seg[chunk].pm        = pm;
+  args->seg[chunk].max_nm    = max_nm;
+  args->seg[chunk].nm        = nm;
+  args->seg[chunk].n_ignored = itmp;
+}
+
+void
+advance_pb_pipeline_v4( advance_p_pipeline_args_t * args,
+                        int pipeline_rank,
+                        int /* n_pipeline */ )
+{
+  accumulator_t * ALIGNED(128) a0;
+
+  int chunk;
+
+  // Determine which accumulator array to use.
+  // The host gets the first accumulator array.
+
+  a0 = args->ap[ pipeline_rank ];
+
+  // Process the chunks of particles handed to this pipeline (see
+  // pipeline_work_t).  Without dynamic scheduling, that is chunk
+  // pipeline_rank of n_pipeline chunks.
+
+  while( ( chunk = next_pipeline_chunk( args->work, pipeline_rank ) ) >= 0 )
+    advance_pb_chunk_v4( args, a0, chunk, args->work->n_chunk );
+}
+
+#else
+
+void
+advance_pb_pipeline_v4( advance_p_pipeline_args_t * args,
+                        int pipeline_rank,
+                        int n_pipeline )
+{
+  // No v4 implementation.
+  ERROR( ( "No advance_pb_pipeline_v4 implementation." ) );
+}
+
+#endif
@@ -0,0 +1,417 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V8_ACCELERATION)
+
+using namespace v8;
+
+//----------------------------------------------------------------------------//
+// This is advance_p_pipeline_v8 for particles in the AoSoA layout.  Each
+// particle block is processed as two halves of 8 particles that are loaded
+// and stored with aligned vector loads and stores of their fields instead
+// of the load_8x8_tr and store_8x8_tr transposes.  Particles are processed
+// in the same order as the reference implementation.
+//----------------------------------------------------------------------------//
+
+static void
+advance_pb_chunk_v8( advance_p_pipeline_args_t * args,
+                    accumulator_t * ALIGNED(128) a0,
+                    int chunk,
+                    int n_chunk )
+{
+  particle_block_t     * ALIGNED(128) pb0 = (particle_block_t *)args->p0;
+  const interpolator_t * ALIGNED(128) f0 = args->f0;
+  const grid_t         *              g  = args->g;
+  const int            * ALIGNED(128) sfc = g->sfc;
+
+  particle_block_t     * ALIGNED(128) pb;
+  particle_mover_t     * ALIGNED(16)  pm;
+
+  float                * ALIGNED(32)  vp00;
+  float                * ALIGNED(32)  vp01;
+  float                * ALIGNED(32)  vp02;
+  float                * ALIGNED(32)  vp03;
+  float                * ALIGNED(32)  vp04;
+  float                * ALIGNED(32)  vp05;
+  float                * ALIGNED(32)  vp06;
+  float                * ALIGNED(32)  vp07;
+
+  // Basic constants.
+  const v8float qdt_2mc(args->qdt_2mc);
+  const v8float cdt_dx(args->cdt_dx);
+  const v8float cdt_dy(args->cdt_dy);
+  const v8float cdt_dz(args->cdt_dz);
+  const v8float qsp(args->qsp);
+  const v8float one(1.0);
+  const v8float one_third(1.0/3.0);
+  const v8float two_fifteenths(2.0/15.0);
+  const v8float neg_one(-1.0);
+
+  const float _qsp = args->qsp;
+
+  v8float dx, dy, dz, ux, uy, uz, q;
+  v8float hax, hay, haz, cbx, cby, cbz;
+  v8float v00, v01, v02, v03, v04, v05, v06, v07, v08, v09;
+  v8int   ii, outbnd;
+
+  int itmp, nq, nm, max_nm, h;
+
+  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
+
+  // Determine which blocks of particle quads this chunk holds.
+
+  DISTRIBUTE( args->np, 16, chunk, n_chunk, itmp, nq );
+
+  pb = pb0 + itmp / PARTICLE_BLOCK_SIZE;
+
+  nq >>= 3;
+
+  // Determine which movers are reserved for this chunk (see
+  // chunk_movers).
+
+  pm   = chunk_movers( args, chunk, n_chunk, &max_nm );
+  nm   = 0;
+  itmp = 0;
+
+  // Process the particle blocks for this chunk, the h=0 and h=8 halves of
+  // each block in turn.
+
+  for( h = 0; nq; nq--, h ^= 8, pb += ( h == 0 ) )
+  {
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+    load_8x1( pb->dx + h, dx );
+    load_8x1( pb->dy + h, dy );
+    load_8x1( pb->dz + h, dz );
+    load_8x1( pb->i  + h, ii );
+    load_8x1( pb->ux + h, ux );
+    load_8x1( pb->uy + h, uy );
+    load_8x1( pb->uz + h, uz );
+    load_8x1( pb->w  + h, q  );
+
+    //--------------------------------------------------------------------------
+    // Set field interpolation pointers.
+    //--------------------------------------------------------------------------
+    vp00 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 0) ] );
+    vp01 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 1) ] );
+    vp02 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 2) ] );
+    vp03 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 3) ] );
+    vp04 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 4) ] );
+    vp05 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 5) ] );
+    vp06 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 6) ] );
+    vp07 = ( float * ALIGNED(32) ) ( f0 + sfc[ ii( 7) ] );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles.
+    //--------------------------------------------------------------------------
+    load_8x8_tr( vp00, vp01, vp02, vp03,
+                 vp04, vp05, vp06, vp07,
+                 hax, v00, v01, v02, hay, v03, v04, v05 );
+
+    hax = qdt_2mc*fma( fma( v02, dy, v01 ), dz, fma( v00, dy, hax ) );
+
+    hay = qdt_2mc*fma( fma( v05, dz, v04 ), dx, fma( v03, dz, hay ) );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles.
+    //--------------------------------------------------------------------------
+    load_8x8_tr( vp00+8, vp01+8, vp02+8, vp03+8,
+                 vp04+8, vp05+8, vp06+8, vp07+8,
+                 haz, v00, v01, v02, cbx, v03, cby, v04 );
+
+    haz = qdt_2mc*fma( fma( v02, dx, v01 ), dy, fma( v00, dx, haz ) );
+
+    cbx = fma( v03, dx, cbx );
+
+    cby = fma( v04, dy, cby );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles, final.
+    //--------------------------------------------------------------------------
+    load_8x2_tr( vp00+16, vp01+16, vp02+16, vp03+16,
+                 vp04+16, vp05+16, vp06+16, vp07+16,
+                 cbz, v05 );
+
+    cbz = fma( v05, dz, cbz );
+
+    //--------------------------------------------------------------------------
+    // Update momentum.
+    //--------------------------------------------------------------------------
+    // For a 5-10% performance hit, v00 = qdt_2mc/sqrt(blah) is a few ulps more
+    // accurate (but still quite in the noise numerically) for cyclotron
+    // frequencies approaching the nyquist frequency.
+    //--------------------------------------------------------------------------
+
+    ux  += hax;
+    uy  += hay;
+    uz  += haz;
+
+    v00  = qdt_2mc*rsqrt( one + fma( ux, ux, fma( uy, uy, uz*uz ) ) );
+    v01  = fma( cbx, cbx, fma( cby, cby, cbz*cbz ) );
+    v02  = (v00*v00)*v01;
+    v03  = v00*fma( fma( two_fifteenths, v02, one_third ), v02, one );
+    v04  = v03*rcp( fma( v03*v03, v01, one ) );
+    v04 += v04;
+
+    v00  = fma( fms(  uy, cbz,  uz*cby ), v03, ux );
+    v01  = fma( fms(  uz, cbx,  ux*cbz ), v03, uy );
+    v02  = fma( fms(  ux, cby,  uy*cbx ), v03, uz );
+
+    ux   = fma( fms( v01, cbz, v02*cby ), v04, ux );
+    uy   = fma( fms( v02, cbx, v00*cbz ), v04, uy );
+    uz   = fma( fms( v00, cby, v01*cbx ), v04, uz );
+
+    ux  += hax;
+    uy  += hay;
+    uz  += haz;
+
+    // Store ux, uy, uz in v06, v07, v08 so particle velocity store can be done
+    // later with the particle positions.
+    v06  = ux;
+    v07  = uy;
+    v08  = uz;
+
+    //--------------------------------------------------------------------------
+    // Update the position of in bound particles.
+    //--------------------------------------------------------------------------
+    v00 = rsqrt( one + fma( ux, ux, fma( uy, uy, uz*uz ) ) );
+
+    ux *= cdt_dx;
+    uy *= cdt_dy;
+    uz *= cdt_dz;
+
+    ux *= v00;
+    uy *= v00;
+    uz *= v00;      // ux,uy,uz are normalized displ (relative to cell size)
+
+    v00 =  dx + ux;
+    v01 =  dy + uy;
+    v02 =  dz + uz; // New particle midpoint
+
+    v03 = v00 + ux;
+    v04 = v01 + uy;
+    v05 = v02 + uz; // New particle position
+
+    //--------------------------------------------------------------------------
+    // Determine which particles are out of bounds.
+    //--------------------------------------------------------------------------
+    outbnd = ( v03 > one ) | ( v03 < neg_one ) |
+             ( v04 > one ) | ( v04 < neg_one ) |
+             ( v05 > one ) | ( v05 < neg_one );
+
+    v03 = merge( outbnd, dx, v03 ); // Do not update outbnd particles
+    v04 = merge( outbnd, dy, v04 );
+    v05 = merge( outbnd, dz, v05 );
+
+    //--------------------------------------------------------------------------
+    // Store particle data, final.
+    //--------------------------------------------------------------------------
+    store_8x1( v03, pb->dx + h );
+    store_8x1( v04, pb->dy + h );
+    store_8x1( v05, pb->dz + h );
+    store_8x1( v06, pb->ux + h );
+    store_8x1( v07, pb->uy + h );
+    store_8x1( v08, pb->uz + h );
+
+    // Accumulate current of inbnd particles.
+    // Note: accumulator values are 4 times the total physical charge that
+    // passed through the appropriate current quadrant in a time-step.
+    q  = czero( outbnd, q*qsp );   // Do not accumulate outbnd particles
+
+    dx = v00;                      // Streak midpoint (valid for inbnd only)
+    dy = v01;
+    dz = v02;
+
+    v09 = q*ux*uy*uz*one_third;    // Charge conservation correction
+
+    //--------------------------------------------------------------------------
+    // Set current density accumulation pointers.
+    //--------------------------------------------------------------------------
+    vp00 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 0) ] );
+    vp01 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 1) ] );
+    vp02 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 2) ] );
+    vp03 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 3) ] );
+    vp04 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 4) ] );
+    vp05 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 5) ] );
+    vp06 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 6) ] );
+    vp07 = ( float * ALIGNED(32) ) ( a0 + sfc[ ii( 7) ] );
+
+    //--------------------------------------------------------------------------
+    // Accumulate current density.
+    //--------------------------------------------------------------------------
+#   define ACCUMULATE_JX(X,Y,Z)                                        \
+    v08  = q*u##X;    /* v08 = q ux                            */      \
+    v01  = v08*d##Y;  /* v01 = q ux dy                         */      \
+    v00  = v08-v01;   /* v00 = q ux (1-dy)                     */      \
+    v01 += v08;       /* v01 = q ux (1+dy)                     */      \
+    v08  = one+d##Z;  /* v08 = 1+dz                            */      \
+    v02  = v00*v08;   /* v02 = q ux (1-dy)(1+dz)               */      \
+    v03  = v01*v08;   /* v03 = q ux (1+dy)(1+dz)               */      \
+    v08  = one-d##Z;  /* v08 = 1-dz                            */      \
+    v00 *= v08;       /* v00 = q ux (1-dy)(1-dz)               */      \
+    v01 *= v08;       /* v01 = q ux (1+dy)(1-dz)               */      \
+    v00 += v09;       /* v00 = q ux [ (1-dy)(1-dz) + uy*uz/3 ] */      \
+    v01 -= v09;       /* v01 = q ux [ (1+dy)(1-dz) - uy*uz/3 ] */      \
+    v02 -= v09;       /* v02 = q ux [ (1-dy)(1+dz) - uy*uz/3 ] */      \
+    v03 += v09;       /* v03 = q ux [ (1+dy)(1+dz) + uy*uz/3 ] */
+
+#   define ACCUMULATE_JY(X,Y,Z)                                        \
+    v08  = q*u##X;    /* v08 = q ux                            */      \
+    v05  = v08*d##Y;  /* v05 = q ux dy                         */      \
+    v04  = v08-v05;   /* v04 = q ux (1-dy)                     */      \
+    v05 += v08;       /* v05 = q ux (1+dy)                     */      \
+    v08  = one+d##Z;  /* v08 = 1+dz                            */      \
+    v06  = v04*v08;   /* v06 = q ux (1-dy)(1+dz)               */      \
+    v07  = v05*v08;   /* v07 = q ux (1+dy)(1+dz)               */      \
+    v08  = one-d##Z;  /* v08 = 1-dz                            */      \
+    v04 *= v08;       /* v04 = q ux (1-dy)(1-dz)               */      \
+    v05 *= v08;       /* v05 = q ux (1+dy)(1-dz)               */      \
+    v04 += v09;       /* v04 = q ux [ (1-dy)(1-dz) + uy*uz/3 ] */      \
+    v05 -= v09;       /* v05 = q ux [ (1+dy)(1-dz) - uy*uz/3 ] */      \
+    v06 -= v09;       /* v06 = q ux [ (1-dy)(1+dz) - uy*uz/3 ] */      \
+    v07 += v09;       /* v07 = q ux [ (1+dy)(1+dz) + uy*uz/3 ] */
+
+#   define ACCUMULATE_JZ(X,Y,Z)                                        \
+    v08  = q*u##X;    /* v08 = q ux                            */      \
+    v01  = v08*d##Y;  /* v01 = q ux dy                         */      \
+    v00  = v08-v01;   /* v00 = q ux (1-dy)                     */      \
+    v01 += v08;       /* v01 = q ux (1+dy)                     */      \
+    v08  = one+d##Z;  /* v08 = 1+dz                            */      \
+    v02  = v00*v08;   /* v02 = q ux (1-dy)(1+dz)               */      \
+    v03  = v01*v08;   /* v03 = q ux (1+dy)(1+dz)               */      \
+    v08  = one-d##Z;  /* v08 = 1-dz                            */      \
+    v00 *= v08;       /* v00 = q ux (1-dy)(1-dz)               */      \
+    v01 *= v08;       /* v01 = q ux (1+dy)(1-dz)               */      \
+    v00 += v09;       /* v00 = q ux [ (1-dy)(1-dz) + uy*uz/3 ] */      \
+    v01 -= v09;       /* v01 = q ux [ (1+dy)(1-dz) - uy*uz/3 ] */      \
+    v02 -= v09;       /* v02 = q ux [ (1-dy)(1+dz) - uy*uz/3 ] */      \
+    v03 += v09;       /* v03 = q ux [ (1+dy)(1+dz) + uy*uz/3 ] */
+
+    // Accumulate Jx for 8 particles into the v00-v03 vectors.
+    ACCUMULATE_JX( x, y, z );
+
+    // Accumulate Jy for 8 particles into the v04-v07 vectors.
+    ACCUMULATE_JY( y, z, x );
+
+    // Transpose the data in vectors v00-v07 so it can be added into the
+    // accumulator arrays using vector operations.
+    transpose( v00, v01, v02, v03, v04, v05, v06, v07 );
+
+    // Add the contributions to Jx and Jy from 8 particles into the
+    // accumulator arrays for Jx and Jy.
+    increment_8x1( vp00, v00 );
+    increment_8x1( vp01, v01 );
+    increment_8x1( vp02, v02 );
+    increment_8x1( vp03, v03 );
+    increment_8x1( vp04, v04 );
+    increment_8x1( vp05, v05 );
+    increment_8x1( vp06, v06 );
+    increment_8x1( vp07, v07 );
+
+    // Accumulate Jz for 8 particles into the v00-v03 vectors.
+    ACCUMULATE_JZ( z, x, y );
+
+    // Zero the v04-v07 vectors prior to transposing the data.
+    v04 = 0.0;
+    v05 = 0.0;
+    v06 = 0.0;
+    v07 = 0.0;
+
+    // Transpose the data in vectors v00-v07 so it can be added into the
+    // accumulator arrays using vector operations.
+    transpose( v00, v01, v02, v03, v04, v05, v06, v07 );
+
+    // Add the contributions to Jz from 8 particles into the accumulator
+    // arrays for Jz.
+    increment_8x1( vp00 + 8, v00 );
+    increment_8x1( vp01 + 8, v01 );
+    increment_8x1( vp02 + 8, v02 );
+    increment_8x1( vp03 + 8, v03 );
+    increment_8x1( vp04 + 8, v04 );
+    increment_8x1( vp05 + 8, v05 );
+    increment_8x1( vp06 + 8, v06 );
+    increment_8x1( vp07 + 8, v07 );
+
+#   undef ACCUMULATE_JX
+#   undef ACCUMULATE_JY
+#   undef ACCUMULATE_JZ
+
+    //--------------------------------------------------------------------------
+    // Update position and accumulate current density for out of bounds
+    // particles.
+    //--------------------------------------------------------------------------
+
+#   define MOVE_OUTBND(N)                                               \
+    if ( outbnd(N) )                                /* Unlikely */      \
+    {                                                                   \
+      local_pm->dispx = ux(N);                                          \
+      local_pm->dispy = uy(N);                                          \
+      local_pm->dispz = uz(N);                                          \
+      local_pm->i     = ( pb - pb0 )*PARTICLE_BLOCK_SIZE + h + N;       \
+      if ( move_pb( pb0, local_pm, a0, g, _qsp ) )  /* Unlikely */      \
+      {                                                                 \
+        if ( nm < max_nm )                                              \
+        {                                                               \
+          v4::copy_4x1( &pm[nm++], local_pm );                          \
+        }                                                               \
+        else if ( !spill_mover( args, local_pm ) )  /* Unlikely */      \
+        {                                                               \
+          itmp++;                                                       \
+        }                                                               \
+      }                                                                 \
+    }
+
+    MOVE_OUTBND( 0);
+    MOVE_OUTBND( 1);
+    MOVE_OUTBND( 2);
+    MOVE_OUTBND( 3);
+    MOVE_OUTBND( 4);
+    MOVE_OUTBND( 5);
+    MOVE_OUTBND( 6);
+    MOVE_OUTBND( 7);
+
+#   undef MOVE_OUTBND
+  }
+
+  args->seg[chunk].pm        = pm;
+  args->seg[chunk].max_nm    = max_nm;
+  args->seg[chunk].nm        = nm;
+  args->seg[chunk].n_ignored = itmp;
+}
+
+void
+advance_pb_pipeline_v8( advance_p_pipeline_args_t * args,
+                       int pipeline_rank,
+                       int /* n_pipeline */ )
+{
+  accumulator_t * ALIGNED(128) a0;
+
+  int chunk;
+
+  // Determine which accumulator array to use.
+  // The host gets the first accumulator array.
+
+  a0 = args->ap[ pipeline_rank ];
+
+  // Process the chunks of particles handed to this pipeline (see
+  // pipeline_work_t).  Without dynamic scheduling, that is chunk
+  // pipeline_rank of n_pipeline chunks.
+
+  while( ( chunk = next_pipeline_chunk( args->work, pipeline_rank ) ) >= 0 )
+    advance_pb_chunk_v8( args, a0, chunk, args->work->n_chunk );
+}
+
+#else
+
+void
+advance_pb_pipeline_v8( advance_p_pipeline_args_t * args,
+                       int pipeline_rank,
+                       int n_pipeline )
+{
+  // No v8 implementation.
+  ERROR( ( "No advance_pb_pipeline_v8 implementation." ) );
+}
+
+#endif
@@ -19,6 +19,7 @@ center_p_pipeline_scalar( center_p_pipeline_args_t * args,
                           int n_pipeline )
 {
   const interpolator_t * ALIGNED(128) f0 = args->f0;
+  const int            * ALIGNED(128) sfc = args->sfc;
 
   particle_t           * ALIGNED(32)  p;
 
@@ -52,7 +53,7 @@ center_p_pipeline_scalar( center_p_pipeline_args_t * args,
     dz   = p->dz;
     ii   = p->i;
 
-    f    = f0 + ii;                          // Interpolate E
+    f    = f0 + sfc[ii];                     // Interpolate E
 
     hax  = qdt_2mc*(    ( f->ex    + dy*f->dexdy    ) +
                      dz*( f->dexdz + dy*f->d2exdydz ) );
@@ -120,6 +121,7 @@ center_p_pipeline( species_t * RESTRICT sp,
 
   args->p0      = sp->p;
   args->f0      = ia->i;
+  args->sfc     = ia->g->sfc;
   args->qdt_2mc = (sp->q*sp->g->dt)/(2*sp->m*sp->g->cvac);
   args->np      = sp->np;
 
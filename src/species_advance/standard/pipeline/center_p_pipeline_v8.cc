@@ -12,6 +12,7 @@ center_p_pipeline_v8( center_p_pipeline_args_t * args,
                       int n_pipeline )
 {
   const interpolator_t * ALIGNED(128) f0 = args->f0;
+  const int            * ALIGNED(128) sfc = args->sfc;
 
   particle_t           * ALIGNED(128) p;
 
@@ -59,14 +60,14 @@ center_p_pipeline_v8( center_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
     //--------------------------------------------------------------------------
-    vp00 = ( const float * ALIGNED(32) ) ( f0 + ii(0) );
-    vp01 = ( const float * ALIGNED(32) ) ( f0 + ii(1) );
-    vp02 = ( const float * ALIGNED(32) ) ( f0 + ii(2) );
-    vp03 = ( const float * ALIGNED(32) ) ( f0 + ii(3) );
-    vp04 = ( const float * ALIGNED(32) ) ( f0 + ii(4) );
-    vp05 = ( const float * ALIGNED(32) ) ( f0 + ii(5) );
-    vp06 = ( const float * ALIGNED(32) ) ( f0 + ii(6) );
-    vp07 = ( const float * ALIGNED(32) ) ( f0 + ii(7) );
+    vp00 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(0) ] );
+    vp01 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(1) ] );
+    vp02 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(2) ] );
+    vp03 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(3) ] );
+    vp04 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(4) ] );
+    vp05 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(5) ] );
+    vp06 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(6) ] );
+    vp07 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(7) ] );
 
     //--------------------------------------------------------------------------
     // Load interpolation data for particles.
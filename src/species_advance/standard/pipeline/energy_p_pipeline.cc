@@ -20,6 +20,7 @@ energy_p_pipeline_scalar( energy_p_pipeline_args_t * RESTRICT args,
                           int n_pipeline )
 {
   const interpolator_t * RESTRICT ALIGNED(128) f = args->f;
+  const int            * RESTRICT ALIGNED(128) sfc = args->sfc;
   const particle_t     * RESTRICT ALIGNED(32)  p = args->p;
 
   const float qdt_2mc = args->qdt_2mc;
@@ -46,7 +47,7 @@ energy_p_pipeline_scalar( energy_p_pipeline_args_t * RESTRICT args,
     dx  = p[n].dx;
     dy  = p[n].dy;
     dz  = p[n].dz;
-    i   = p[n].i;
+    i   = sfc[ p[n].i ];
 
     v0  = p[n].ux + qdt_2mc*(    ( f[i].ex    + dy*f[i].dexdy    ) +
                               dz*( f[i].dexdz + dy*f[i].d2exdydz ) );
@@ -93,6 +94,7 @@ energy_p_pipeline( const species_t * RESTRICT sp,
 
   args->p       = sp->p;
   args->f       = ia->i;
+  args->sfc     = ia->g->sfc;
   args->en      = en;
   args->qdt_2mc = (sp->q*sp->g->dt)/(2*sp->m*sp->g->cvac);
   args->msp     = sp->m;
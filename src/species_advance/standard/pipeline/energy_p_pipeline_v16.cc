@@ -12,6 +12,7 @@ energy_p_pipeline_v16( energy_p_pipeline_args_t * args,
                        int n_pipeline )
 {
   const interpolator_t * RESTRICT ALIGNED(128) f = args->f;
+  const int            * RESTRICT ALIGNED(128) sfc = args->sfc;
   const particle_t     * RESTRICT ALIGNED(128) p = args->p;
 
   const float          * RESTRICT ALIGNED(64)  vp00;
@@ -71,22 +72,22 @@ energy_p_pipeline_v16( energy_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
     //--------------------------------------------------------------------------
-    vp00 = ( float * ) ( f + i( 0) );
-    vp01 = ( float * ) ( f + i( 1) );
-    vp02 = ( float * ) ( f + i( 2) );
-    vp03 = ( float * ) ( f + i( 3) );
-    vp04 = ( float * ) ( f + i( 4) );
-    vp05 = ( float * ) ( f + i( 5) );
-    vp06 = ( float * ) ( f + i( 6) );
-    vp07 = ( float * ) ( f + i( 7) );
-    vp08 = ( float * ) ( f + i( 8) );
-    vp09 = ( float * ) ( f + i( 9) );
-    vp10 = ( float * ) ( f + i(10) );
-    vp11 = ( float * ) ( f + i(11) );
-    vp12 = ( float * ) ( f + i(12) );
-    vp13 = ( float * ) ( f + i(13) );
-    vp14 = ( float * ) ( f + i(14) );
-    vp15 = ( float * ) ( f + i(15) );
+    vp00 = ( float * ) ( f + sfc[ i( 0) ] );
+    vp01 = ( float * ) ( f + sfc[ i( 1) ] );
+    vp02 = ( float * ) ( f + sfc[ i( 2) ] );
+    vp03 = ( float * ) ( f + sfc[ i( 3) ] );
+    vp04 = ( float * ) ( f + sfc[ i( 4) ] );
+    vp05 = ( float * ) ( f + sfc[ i( 5) ] );
+    vp06 = ( float * ) ( f + sfc[ i( 6) ] );
+    vp07 = ( float * ) ( f + sfc[ i( 7) ] );
+    vp08 = ( float * ) ( f + sfc[ i( 8) ] );
+    vp09 = ( float * ) ( f + sfc[ i( 9) ] );
+    vp10 = ( float * ) ( f + sfc[ i(10) ] );
+    vp11 = ( float * ) ( f + sfc[ i(11) ] );
+    vp12 = ( float * ) ( f + sfc[ i(12) ] );
+    vp13 = ( float * ) ( f + sfc[ i(13) ] );
+    vp14 = ( float * ) ( f + sfc[ i(14) ] );
+    vp15 = ( float * ) ( f + sfc[ i(15) ] );
 
     //--------------------------------------------------------------------------
     // Load interpolation data for particles.
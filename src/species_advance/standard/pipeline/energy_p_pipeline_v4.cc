@@ -12,6 +12,7 @@ energy_p_pipeline_v4( energy_p_pipeline_args_t * args,
                       int n_pipeline )
 {
   const interpolator_t * RESTRICT ALIGNED(128) f = args->f;
+  const int            * RESTRICT ALIGNED(128) sfc = args->sfc;
   const particle_t     * RESTRICT ALIGNED(128) p = args->p;
 
   const float          * RESTRICT ALIGNED(16)  vp00;
@@ -53,10 +54,10 @@ energy_p_pipeline_v4( energy_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
     //--------------------------------------------------------------------------
-    vp00 = ( float * ) ( f + i(0) );
-    vp01 = ( float * ) ( f + i(1) );
-    vp02 = ( float * ) ( f + i(2) );
-    vp03 = ( float * ) ( f + i(3) );
+    vp00 = ( float * ) ( f + sfc[ i(0) ] );
+    vp01 = ( float * ) ( f + sfc[ i(1) ] );
+    vp02 = ( float * ) ( f + sfc[ i(2) ] );
+    vp03 = ( float * ) ( f + sfc[ i(3) ] );
 
     //--------------------------------------------------------------------------
     // Load interpolation data for particles.
@@ -0,0 +1,122 @@
+#define IN_spa
+
+#define HAS_V16_PIPELINE
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Reference implementation for an energy_p pipeline function for particles
+// in the AoSoA layout which does not make use of explicit calls to vector
+// intrinsic functions.  This function calculates kinetic energy, normalized
+// by c^2.
+//----------------------------------------------------------------------------//
+
+void
+energy_pb_pipeline_scalar( energy_p_pipeline_args_t * RESTRICT args,
+                           int pipeline_rank,
+                           int n_pipeline )
+{
+  const interpolator_t * RESTRICT ALIGNED(128) f = args->f;
+  const int            * RESTRICT ALIGNED(128) sfc = args->sfc;
+  const particle_block_t * RESTRICT ALIGNED(128) pb0 =
+    (const particle_block_t *)args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) pb;
+
+  const float qdt_2mc = args->qdt_2mc;
+  const float msp     = args->msp;
+  const float one     = 1.0;
+
+  float dx, dy, dz;
+  float v0, v1, v2;
+
+  double en = 0.0;
+
+  int i, j, n, n0, n1;
+
+  // Determine which particles this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n0, n1 );
+
+  n1 += n0;
+
+  // Process particles quads for this pipeline.
+
+  for( n = n0; n < n1; n++ )
+  {
+    pb  = pb0 + n / PARTICLE_BLOCK_SIZE;
+    j   = n % PARTICLE_BLOCK_SIZE;
+
+    dx  = pb->dx[j];
+    dy  = pb->dy[j];
+    dz  = pb->dz[j];
+    i   = sfc[ pb->i[j] ];
+
+    v0  = pb->ux[j] + qdt_2mc*(    ( f[i].ex    + dy*f[i].dexdy    ) +
+                                dz*( f[i].dexdz + dy*f[i].d2exdydz ) );
+
+    v1  = pb->uy[j] + qdt_2mc*(    ( f[i].ey    + dz*f[i].deydz    ) +
+                                dx*( f[i].deydx + dz*f[i].d2eydzdx ) );
+
+    v2  = pb->uz[j] + qdt_2mc*(    ( f[i].ez    + dx*f[i].dezdx    ) +
+                                dy*( f[i].dezdy + dx*f[i].d2ezdxdy ) );
+
+    v0  = v0*v0 + v1*v1 + v2*v2;
+
+    v0  = (msp * pb->w[j]) * (v0 / (one + sqrtf(one + v0)));
+
+    en += ( double ) v0;
+  }
+
+  args->en[pipeline_rank] = en;
+}
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper energy_pb pipeline
+// function.  The particles must be in the AoSoA layout.
+//----------------------------------------------------------------------------//
+
+double
+energy_pb_pipeline( const species_t * RESTRICT sp,
+                    const interpolator_array_t * RESTRICT ia )
+{
+  DECLARE_ALIGNED_ARRAY( energy_p_pipeline_args_t, 128, args, 1 );
+
+  DECLARE_ALIGNED_ARRAY( double, 128, en, MAX_PIPELINE+1 );
+
+  double local, global;
+  int rank;
+
+  if ( !sp || !ia || sp->g != ia->g ||
+       sp->p_layout != particle_layout_aosoa )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  // Have the pipelines do the bulk of particles in blocks and have the
+  // host do the final incomplete block.
+
+  args->p       = sp->p;
+  args->f       = ia->i;
+  args->sfc     = ia->g->sfc;
+  args->en      = en;
+  args->qdt_2mc = (sp->q*sp->g->dt)/(2*sp->m*sp->g->cvac);
+  args->msp     = sp->m;
+  args->np      = sp->np;
+
+  EXEC_PIPELINES( energy_pb, args, 0 );
+
+  WAIT_PIPELINES();
+
+  local = 0.0;
+  for( rank = 0; rank <= N_PIPELINE; rank++ )
+  {
+    local += en[rank];
+  }
+
+  mp_allsum_d( &local, &global, 1 );
+
+  return global * ( ( double ) sp->g->cvac *
+		    ( double ) sp->g->cvac );
+}
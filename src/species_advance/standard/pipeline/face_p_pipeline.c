@@ -0,0 +1,188 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Move the particles in face voxels to the front of the particle array
+// without sorting.  With n_face face particles, each interior particle in
+// [0,n_face) (a hole) is swapped with a face particle in [n_face,np) (a
+// stray): the k-th hole from the front with the k-th stray from the back.
+// Each pipeline fills the holes in its share of the particles.  The shares
+// before a share holding holes lie in [0,n_face), so the number of holes
+// before it follows from the face particle counts of the shares.  The
+// strays a pipeline fills its holes with are found from the back by
+// skipping whole shares in [n_face,np) and then scanning.  That is a pass
+// of its own, find_stray_p, as the scan would otherwise run over strays
+// another pipeline may already have swapped.  After it, a pipeline only
+// visits its own holes and strays and the interior particles between its
+// strays, none of which another pipeline writes.
+//----------------------------------------------------------------------------//
+
+#define FACE_P(n) \
+  face[ p ? p[n].i : pb[(n)/PARTICLE_BLOCK_SIZE].i[(n)%PARTICLE_BLOCK_SIZE] ]
+
+void
+count_face_p_pipeline_scalar( face_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  const particle_t       * RESTRICT ALIGNED(128) p    = args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) pb   = args->pb;
+  const char             * RESTRICT ALIGNED(128) face = args->face;
+
+  int n, n1, c = 0;
+
+  DISTRIBUTE( args->np, PARTICLE_BLOCK_SIZE, pipeline_rank, n_pipeline,
+              n, n1 );
+
+  for( n1 += n; n < n1; n++ ) c += FACE_P(n);
+
+  args->count[pipeline_rank] = c;
+}
+
+void
+find_stray_p_pipeline_scalar( face_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  const particle_t       * RESTRICT ALIGNED(128) p     = args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) pb    = args->pb;
+  const char             * RESTRICT ALIGNED(128) face  = args->face;
+  const int              * RESTRICT ALIGNED(128) count = args->count;
+
+  const int np     = args->np;
+  const int n_face = args->n_face;
+
+  int n, n1, s, k;
+
+  DISTRIBUTE( np, PARTICLE_BLOCK_SIZE, pipeline_rank, n_pipeline, n, n1 );
+
+  if ( n >= n_face ) return; // No holes in this share
+
+  // Count the holes in the shares before this one.
+
+  for( k = 0, s = 0; s < pipeline_rank; s++ )
+  {
+    DISTRIBUTE( np, PARTICLE_BLOCK_SIZE, s, n_pipeline, n, n1 );
+
+    k += n1 - count[s];
+  }
+
+  // Skip as many strays from the back.
+
+  for( s = n_pipeline; ; s-- )
+  {
+    DISTRIBUTE( np, PARTICLE_BLOCK_SIZE, s, n_pipeline, n, n1 );
+
+    if ( n < n_face || k < count[s] ) break;
+
+    k -= count[s];
+  }
+
+  for( n += n1; k; k-- ) do n--; while( !FACE_P(n) );
+
+  args->stray[pipeline_rank] = n;
+}
+
+void
+partition_face_p_pipeline_scalar( face_p_pipeline_args_t * args,
+                                  int pipeline_rank,
+                                  int n_pipeline )
+{
+  particle_t       * RESTRICT ALIGNED(128) p    = args->p;
+  particle_block_t * RESTRICT ALIGNED(128) pb   = args->pb;
+  const char       * RESTRICT ALIGNED(128) face = args->face;
+
+  particle_t t;
+  int n, n1, j;
+
+  DISTRIBUTE( args->np, PARTICLE_BLOCK_SIZE, pipeline_rank, n_pipeline,
+              n, n1 );
+
+  n1 += n;
+  if ( n1 > args->n_face ) n1 = args->n_face;
+  if ( n >= n1 ) return;
+
+  j = args->stray[pipeline_rank];
+
+  for( ; n < n1; n++ )
+  {
+    if ( FACE_P(n) ) continue;
+
+    do j--; while( !FACE_P(j) );
+
+    if ( p )
+    {
+      t = p[n], p[n] = p[j], p[j] = t;
+    }
+
+    else
+    {
+      load_particle_pb( &t, pb, n );
+      copy_particle_pb( pb, n, pb, j );
+      store_particle_pb( pb, j, &t );
+    }
+  }
+}
+
+#if defined(V4_ACCELERATION) && defined(HAS_V4_PIPELINE)
+
+#error "V4 version not hooked up yet!"
+
+#endif
+
+int
+partition_face_p_pipeline( species_t * RESTRICT sp,
+                           const char * RESTRICT face )
+{
+  DECLARE_ALIGNED_ARRAY( face_p_pipeline_args_t, 128, args, 1 );
+
+  DECLARE_ALIGNED_ARRAY( int, 128, count, MAX_PIPELINE+1 );
+  DECLARE_ALIGNED_ARRAY( int, 128, stray, MAX_PIPELINE+1 );
+
+  int rank;
+
+  if ( !sp || !face )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  if ( sp->p_layout == particle_layout_aosoa )
+  {
+    args->p  = NULL;
+    args->pb = ( particle_block_t * ) sp->p;
+  }
+
+  else
+  {
+    args->p  = sp->p;
+    args->pb = NULL;
+  }
+
+  args->face   = face;
+  args->count  = count;
+  args->stray  = stray;
+  args->np     = sp->np;
+  args->n_face = 0;
+
+  EXEC_PIPELINES( count_face_p, args, 0 );
+
+  WAIT_PIPELINES();
+
+  for( rank = 0; rank <= N_PIPELINE; rank++ )
+  {
+    args->n_face += count[rank];
+  }
+
+  EXEC_PIPELINES( find_stray_p, args, 0 );
+
+  WAIT_PIPELINES();
+
+  EXEC_PIPELINES( partition_face_p, args, 0 );
+
+  WAIT_PIPELINES();
+
+  return args->n_face;
+}
@@ -0,0 +1,260 @@
+#define IN_spa
+
+#define HAS_V4_PIPELINE
+#define HAS_V8_PIPELINE
+#define HAS_V16_PIPELINE
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Reference implementation for an accumulate_hydro_p pipeline function which
+// does not make use of explicit calls to vector intrinsic functions.  The
+// momentum is half advanced in E and half rotated in B to bring it to the
+// same time as the particle positions before the moments are deposited.
+//----------------------------------------------------------------------------//
+
+void
+accumulate_hydro_p_pipeline_scalar( accumulate_hydro_p_pipeline_args_t * args,
+                                    int pipeline_rank,
+                                    int n_pipeline )
+{
+  const particle_t       * RESTRICT ALIGNED(32)  p   = args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) pb  = args->pb;
+  /**/  hydro_t          * RESTRICT ALIGNED(128) h   = args->h;
+  const interpolator_t   * RESTRICT ALIGNED(128) f   = args->f;
+  const int              * RESTRICT ALIGNED(128) sfc = args->sfc;
+
+  const float c        = args->c;
+  const float qsp      = args->qsp;
+  const float mspc     = args->mspc;
+  const float qdt_2mc  = args->qdt_2mc;
+  const float qdt_4mc2 = args->qdt_4mc2;
+  const float r8V      = args->r8V;
+
+  const int stride_10 = args->s10;
+  const int stride_21 = args->s21;
+  const int stride_43 = args->s43;
+  const int i0        = args->i0;
+
+  particle_t pn;
+  float dx, dy, dz, ux, uy, uz, w, vx, vy, vz, ke_mc;
+  float w0, w1, w2, w3, w4, w5, w6, w7, t;
+  int i, j, n, n0, n1;
+
+  // Determine which particles this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n0, n1 );
+
+  n1 += n0;
+
+  // Determine which slab to use and clear it.
+
+  h += pipeline_rank * args->stride;
+
+  CLEAR( h, args->nh );
+
+  for( n = n0; n < n1; n++ )
+  {
+    // Load the particle
+    if( pb ) load_particle_pb( &pn, pb, n );
+    else     pn = p[n];
+    dx = pn.dx;
+    dy = pn.dy;
+    dz = pn.dz;
+    i  = pn.i;
+    j  = sfc[i];
+    i -= i0;
+    ux = pn.ux;
+    uy = pn.uy;
+    uz = pn.uz;
+    w  = pn.w;
+
+    // Half advance E
+    ux += qdt_2mc*((f[j].ex+dy*f[j].dexdy) + dz*(f[j].dexdz+dy*f[j].d2exdydz));
+    uy += qdt_2mc*((f[j].ey+dz*f[j].deydz) + dx*(f[j].deydx+dz*f[j].d2eydzdx));
+    uz += qdt_2mc*((f[j].ez+dx*f[j].dezdx) + dy*(f[j].dezdy+dx*f[j].d2ezdxdy));
+
+    // Boris rotation - Interpolate B field
+    w5 = f[j].cbx + dx*f[j].dcbxdx;
+    w6 = f[j].cby + dy*f[j].dcbydy;
+    w7 = f[j].cbz + dz*f[j].dcbzdz;
+
+    // Boris rotation - curl scalars (0.5 in v0 for half rotate) and
+    // kinetic energy computation. Note: gamma-1 = |u|^2 / (gamma+1)
+    // is the numerically accurate way to compute gamma-1
+    ke_mc = ux*ux + uy*uy + uz*uz; // ke_mc = |u|^2 (invariant)
+    vz = sqrt(1+ke_mc);            // vz = gamma    (invariant)
+    ke_mc *= c/(vz+1);             // ke_mc = c|u|^2/(gamma+1) = c*(gamma-1)
+    vz = c/vz;                     // vz = c/gamma
+    w0 = qdt_4mc2*vz;
+    w1 = w5*w5 + w6*w6 + w7*w7;    // |cB|^2
+    w2 = w0*w0*w1;
+    w3 = w0*(1+(1./3.)*w2*(1+0.4*w2));
+    w4 = w3/(1 + w1*w3*w3); w4 += w4;
+
+    // Boris rotation - uprime
+    w0 = ux + w3*( uy*w7 - uz*w6 );
+    w1 = uy + w3*( uz*w5 - ux*w7 );
+    w2 = uz + w3*( ux*w6 - uy*w5 );
+
+    // Boris rotation - u
+    ux += w4*( w1*w7 - w2*w6 );
+    uy += w4*( w2*w5 - w0*w7 );
+    uz += w4*( w0*w6 - w1*w5 );
+
+    // Compute physical velocities
+    vx  = ux*vz;
+    vy  = uy*vz;
+    vz *= uz;
+
+    // Compute the trilinear coefficients
+    w0  = r8V*w;    // w0 = (1/8)(w/V)
+    dx *= w0;       // dx = (1/8)(w/V) x
+    w1  = w0+dx;    // w1 = (1/8)(w/V) + (1/8)(w/V)x = (1/8)(w/V)(1+x)
+    w0 -= dx;       // w0 = (1/8)(w/V) - (1/8)(w/V)x = (1/8)(w/V)(1-x)
+    w3  = 1+dy;     // w3 = 1+y
+    w2  = w0*w3;    // w2 = (1/8)(w/V)(1-x)(1+y)
+    w3 *= w1;       // w3 = (1/8)(w/V)(1+x)(1+y)
+    dy  = 1-dy;     // dy = 1-y
+    w0 *= dy;       // w0 = (1/8)(w/V)(1-x)(1-y)
+    w1 *= dy;       // w1 = (1/8)(w/V)(1+x)(1-y)
+    w7  = 1+dz;     // w7 = 1+z
+    w4  = w0*w7;    // w4 = (1/8)(w/V)(1-x)(1-y)(1+z) = (w/V) trilin_0 *Done
+    w5  = w1*w7;    // w5 = (1/8)(w/V)(1+x)(1-y)(1+z) = (w/V) trilin_1 *Done
+    w6  = w2*w7;    // w6 = (1/8)(w/V)(1-x)(1+y)(1+z) = (w/V) trilin_2 *Done
+    w7 *= w3;       // w7 = (1/8)(w/V)(1+x)(1+y)(1+z) = (w/V) trilin_3 *Done
+    dz  = 1-dz;     // dz = 1-z
+    w0 *= dz;       // w0 = (1/8)(w/V)(1-x)(1-y)(1-z) = (w/V) trilin_4 *Done
+    w1 *= dz;       // w1 = (1/8)(w/V)(1+x)(1-y)(1-z) = (w/V) trilin_5 *Done
+    w2 *= dz;       // w2 = (1/8)(w/V)(1-x)(1+y)(1-z) = (w/V) trilin_6 *Done
+    w3 *= dz;       // w3 = (1/8)(w/V)(1+x)(1+y)(1-z) = (w/V) trilin_7 *Done
+
+    // Accumulate the hydro fields
+#   define ACCUM_HYDRO( wn)                             \
+    t  = qsp*wn;        /* t  = (qsp w/V) trilin_n */   \
+    h[i].jx  += t*vx;                                   \
+    h[i].jy  += t*vy;                                   \
+    h[i].jz  += t*vz;                                   \
+    h[i].rho += t;                                      \
+    t  = mspc*wn;       /* t = (msp c w/V) trilin_n */  \
+    dx = t*ux;          /* dx = (px w/V) trilin_n */    \
+    dy = t*uy;                                          \
+    dz = t*uz;                                          \
+    h[i].px  += dx;                                     \
+    h[i].py  += dy;                                     \
+    h[i].pz  += dz;                                     \
+    h[i].ke  += t*ke_mc;                                \
+    h[i].txx += dx*vx;                                  \
+    h[i].tyy += dy*vy;                                  \
+    h[i].tzz += dz*vz;                                  \
+    h[i].tyz += dy*vz;                                  \
+    h[i].tzx += dz*vx;                                  \
+    h[i].txy += dx*vy
+
+    /**/            ACCUM_HYDRO(w0); // Cell i,j,k
+    i += stride_10; ACCUM_HYDRO(w1); // Cell i+1,j,k
+    i += stride_21; ACCUM_HYDRO(w2); // Cell i,j+1,k
+    i += stride_10; ACCUM_HYDRO(w3); // Cell i+1,j+1,k
+    i += stride_43; ACCUM_HYDRO(w4); // Cell i,j,k+1
+    i += stride_10; ACCUM_HYDRO(w5); // Cell i+1,j,k+1
+    i += stride_21; ACCUM_HYDRO(w6); // Cell i,j+1,k+1
+    i += stride_10; ACCUM_HYDRO(w7); // Cell i+1,j+1,k+1
+
+#   undef ACCUM_HYDRO
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper accumulate_hydro_p
+// pipeline function.
+//----------------------------------------------------------------------------//
+
+void
+accumulate_hydro_p_pipeline( hydro_array_t * RESTRICT ha,
+                             const species_t * RESTRICT sp,
+                             const interpolator_array_t * RESTRICT ia )
+{
+  DECLARE_ALIGNED_ARRAY( accumulate_hydro_p_pipeline_args_t, 128, args, 1 );
+
+  static hydro_t * ALIGNED(128) scratch = NULL;
+  static size_t             max_scratch = 0;
+
+  size_t sz_scratch;
+
+  const grid_t * g;
+  int nx, ny, nz;
+
+  if ( !ha || !sp || !ia || ha->g != sp->g || ha->g != ia->g )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  g  = sp->g;
+  nx = g->nx;
+  ny = g->ny;
+  nz = g->nz;
+
+  if ( sp->p_layout == particle_layout_aosoa )
+  {
+    args->p  = NULL;
+    args->pb = ( const particle_block_t * ) sp->p;
+  }
+
+  else
+  {
+    args->p  = sp->p;
+    args->pb = NULL;
+  }
+
+  // Particles only deposit to the hydros of the nodes of the local
+  // domain, (1:nx+1,1:ny+1,1:nz+1).  Slabs are padded to a multiple of
+  // 128 bytes so that each one is aligned.
+
+  args->h0       = ha->h;
+  args->f        = ia->i;
+  args->sfc      = g->sfc;
+  args->c        = g->cvac;
+  args->qsp      = sp->q;
+  args->mspc     = sp->m*g->cvac;
+  args->qdt_2mc  = ( sp->q*g->dt ) / ( 2*args->mspc );
+  args->qdt_4mc2 = args->qdt_2mc / ( 2*g->cvac );
+  args->r8V      = g->r8V;
+  args->np       = sp->np;
+  args->i0       = VOXEL( 1,    1,    1,    nx, ny, nz );
+  args->nh       = VOXEL( nx+1, ny+1, nz+1, nx, ny, nz ) - args->i0 + 1;
+  args->stride   = POW2_CEIL( args->nh, 2 );
+  args->n_slab   = N_PIPELINE + 1;
+
+  args->s10 = VOXEL( 1, 0, 0, nx, ny, nz ) - VOXEL( 0, 0, 0, nx, ny, nz );
+  args->s21 = VOXEL( 0, 1, 0, nx, ny, nz ) - VOXEL( 1, 0, 0, nx, ny, nz );
+  args->s43 = VOXEL( 0, 0, 1, nx, ny, nz ) - VOXEL( 1, 1, 0, nx, ny, nz );
+
+  // Ensure enough scratch space is allocated for the slabs.  Like the
+  // rho slabs, it is only allocated once hydro is first accumulated.
+
+  sz_scratch = ( size_t ) args->stride * ( size_t ) args->n_slab;
+
+  if ( sz_scratch > max_scratch )
+  {
+    FREE_ALIGNED( scratch );
+
+    MALLOC_ALIGNED( scratch, sz_scratch, 128 );
+
+    max_scratch = sz_scratch;
+  }
+
+  args->h = scratch;
+
+  // Have the pipelines do the bulk of particles in blocks and have the
+  // host do the final incomplete block.
+
+  EXEC_PIPELINES( accumulate_hydro_p, args, 0 );
+
+  WAIT_PIPELINES();
+
+  // Reduce the slabs into the hydro array.
+
+  reduce_hydro_p_pipeline( args );
+}
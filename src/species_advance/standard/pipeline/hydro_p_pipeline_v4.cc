@@ -0,0 +1,289 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V4_ACCELERATION)
+
+using namespace v4;
+
+void
+accumulate_hydro_p_pipeline_v4( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+  const particle_t       * ALIGNED(128) p   = args->p;
+  const particle_block_t * ALIGNED(128) pb  = args->pb;
+  /**/  hydro_t          * ALIGNED(128) h   = args->h;
+  const interpolator_t   * ALIGNED(128) f0  = args->f;
+  const int              * ALIGNED(128) sfc = args->sfc;
+
+  const float            * ALIGNED(16)  vp00;
+  const float            * ALIGNED(16)  vp01;
+  const float            * ALIGNED(16)  vp02;
+  const float            * ALIGNED(16)  vp03;
+
+  float                  * ALIGNED(16)  hp;
+
+  // Basic constants.
+  const v4float qdt_2mc(args->qdt_2mc);
+  const v4float qdt_4mc2(args->qdt_4mc2);
+  const v4float c(args->c);
+  const v4float qsp(args->qsp);
+  const v4float mspc(args->mspc);
+  const v4float r8V(args->r8V);
+  const v4float one(1.0);
+  const v4float one_third(1.0/3.0);
+  const v4float two_fifths(0.4);
+  const v4float zero(0.0);
+
+  v4float dx, dy, dz, ux, uy, uz, w, ke_mc, vg;
+  v4float hax, hay, haz, cbx, cby, cbz;
+  v4float w0, w1, w2, w3, w4, w5, w6, w7;
+  v4float v00, v01, v02, v03, v04, v05, v06, v07;
+  v4float v08, v09, v10, v11, v12, v13;
+  v4int   ii;
+
+  // Per particle hydro moments and per corner trilinear weights of the
+  // particles being deposited.
+
+  DECLARE_ALIGNED_ARRAY( float, 16, m,  4*16 );
+  DECLARE_ALIGNED_ARRAY( float, 16, wt, 8*4  );
+
+  int off[8];
+
+  int n, nq, k, j;
+
+  // Determine which particle quads this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n, nq );
+
+  nq >>= 2;
+
+  // Determine which slab to use and clear it.
+
+  h += pipeline_rank * args->stride;
+
+  CLEAR( h, args->nh );
+
+  // Offsets in the slab of the hydros of the 8 nodes of a voxel.
+
+  off[0] = -args->i0;
+  off[1] = off[0] + args->s10;
+  off[2] = off[1] + args->s21;
+  off[3] = off[2] + args->s10;
+  off[4] = off[3] + args->s43;
+  off[5] = off[4] + args->s10;
+  off[6] = off[5] + args->s21;
+  off[7] = off[6] + args->s10;
+
+  // Process the particle quads for this pipeline.
+
+  for( ; nq; nq--, n+=4 )
+  {
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+    if ( pb )
+    {
+      const particle_block_t * ALIGNED(128) b = pb + n / PARTICLE_BLOCK_SIZE;
+
+      j = n % PARTICLE_BLOCK_SIZE;
+
+      load_4x1( &b->dx[j], dx );
+      load_4x1( &b->dy[j], dy );
+      load_4x1( &b->dz[j], dz );
+      load_4x1( &b->i[j],  ii );
+      load_4x1( &b->ux[j], ux );
+      load_4x1( &b->uy[j], uy );
+      load_4x1( &b->uz[j], uz );
+      load_4x1( &b->w[j],  w  );
+    }
+
+    else
+    {
+      load_4x4_tr( &p[n  ].dx, &p[n+1].dx, &p[n+2].dx, &p[n+3].dx,
+                   dx, dy, dz, ii );
+
+      load_4x4_tr( &p[n  ].ux, &p[n+1].ux, &p[n+2].ux, &p[n+3].ux,
+                   ux, uy, uz, w );
+    }
+
+    //--------------------------------------------------------------------------
+    // Set field interpolation pointers.
+    //--------------------------------------------------------------------------
+    vp00 = ( const float * ALIGNED(16) ) ( f0 + sfc[ ii(0) ] );
+    vp01 = ( const float * ALIGNED(16) ) ( f0 + sfc[ ii(1) ] );
+    vp02 = ( const float * ALIGNED(16) ) ( f0 + sfc[ ii(2) ] );
+    vp03 = ( const float * ALIGNED(16) ) ( f0 + sfc[ ii(3) ] );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles.
+    //--------------------------------------------------------------------------
+    load_4x4_tr( vp00, vp01, vp02, vp03,
+                 hax, v00, v01, v02 );
+
+    hax = qdt_2mc*fma( fma( v02, dy, v01 ), dz, fma( v00, dy, hax ) );
+
+    load_4x4_tr( vp00+4, vp01+4, vp02+4, vp03+4,
+                 hay, v03, v04, v05 );
+
+    hay = qdt_2mc*fma( fma( v05, dz, v04 ), dx, fma( v03, dz, hay ) );
+
+    load_4x4_tr( vp00+8, vp01+8, vp02+8, vp03+8,
+                 haz, v00, v01, v02 );
+
+    haz = qdt_2mc*fma( fma( v02, dx, v01 ), dy, fma( v00, dx, haz ) );
+
+    load_4x4_tr( vp00+12, vp01+12, vp02+12, vp03+12,
+                 cbx, v03, cby, v04 );
+
+    cbx = fma( v03, dx, cbx );
+
+    cby = fma( v04, dy, cby );
+
+    load_4x2_tr( vp00+16, vp01+16, vp02+16, vp03+16,
+                 cbz, v05 );
+
+    cbz = fma( v05, dz, cbz );
+
+    //--------------------------------------------------------------------------
+    // Half advance E and half rotate B.  Also compute the kinetic energy.
+    // Note: gamma-1 = |u|^2 / (gamma+1) is the numerically accurate way to
+    // compute gamma-1.
+    //--------------------------------------------------------------------------
+    ux   += hax;
+    uy   += hay;
+    uz   += haz;
+
+    ke_mc = fma( ux, ux, fma( uy, uy, uz*uz ) );  // |u|^2 (invariant)
+    vg    = sqrt( one + ke_mc );                   // gamma (invariant)
+    ke_mc = ke_mc * ( c / ( vg + one ) );          // c*(gamma-1)
+    vg    = c / vg;                                // c/gamma
+
+    v00   = qdt_4mc2*vg;
+    v01   = fma( cbx, cbx, fma( cby, cby, cbz*cbz ) );
+    v02   = (v00*v00)*v01;
+    v03   = v00*fma( one_third*v02, fma( two_fifths, v02, one ), one );
+    v04   = v03 / fma( v03*v03, v01, one );
+    v04  += v04;
+
+    v00   = fma( fms(  uy, cbz,  uz*cby ), v03, ux );
+    v01   = fma( fms(  uz, cbx,  ux*cbz ), v03, uy );
+    v02   = fma( fms(  ux, cby,  uy*cbx ), v03, uz );
+
+    ux    = fma( fms( v01, cbz, v02*cby ), v04, ux );
+    uy    = fma( fms( v02, cbx, v00*cbz ), v04, uy );
+    uz    = fma( fms( v00, cby, v01*cbx ), v04, uz );
+
+    //--------------------------------------------------------------------------
+    // Compute the trilinear coefficients.
+    //--------------------------------------------------------------------------
+    w0  = r8V*w;    // w0 = (1/8)(w/V)
+    dx *= w0;       // dx = (1/8)(w/V) x
+    w1  = w0+dx;    // w1 = (1/8)(w/V)(1+x)
+    w0 -= dx;       // w0 = (1/8)(w/V)(1-x)
+    w3  = one+dy;   // w3 = 1+y
+    w2  = w0*w3;    // w2 = (1/8)(w/V)(1-x)(1+y)
+    w3 *= w1;       // w3 = (1/8)(w/V)(1+x)(1+y)
+    dy  = one-dy;   // dy = 1-y
+    w0 *= dy;       // w0 = (1/8)(w/V)(1-x)(1-y)
+    w1 *= dy;       // w1 = (1/8)(w/V)(1+x)(1-y)
+    w7  = one+dz;   // w7 = 1+z
+    w4  = w0*w7;    // w4 = (w/V) trilin_4
+    w5  = w1*w7;    // w5 = (w/V) trilin_5
+    w6  = w2*w7;    // w6 = (w/V) trilin_6
+    w7 *= w3;       // w7 = (w/V) trilin_7
+    dz  = one-dz;   // dz = 1-z
+    w0 *= dz;       // w0 = (w/V) trilin_0
+    w1 *= dz;       // w1 = (w/V) trilin_1
+    w2 *= dz;       // w2 = (w/V) trilin_2
+    w3 *= dz;       // w3 = (w/V) trilin_3
+
+    store_4x1( w0, &wt[ 0] );
+    store_4x1( w1, &wt[ 4] );
+    store_4x1( w2, &wt[ 8] );
+    store_4x1( w3, &wt[12] );
+    store_4x1( w4, &wt[16] );
+    store_4x1( w5, &wt[20] );
+    store_4x1( w6, &wt[24] );
+    store_4x1( w7, &wt[28] );
+
+    //--------------------------------------------------------------------------
+    // Compute the hydro moments of the particles, in hydro_t order, and
+    // transpose them so each particle's moments are contiguous.
+    //--------------------------------------------------------------------------
+    v00 = ux*vg;    // vx
+    v01 = uy*vg;    // vy
+    v02 = uz*vg;    // vz
+
+    v04 = mspc*ux;  // px
+    v05 = mspc*uy;  // py
+    v06 = mspc*uz;  // pz
+    v07 = mspc*ke_mc;
+
+    v08 = v04*v00;  // txx
+    v09 = v05*v01;  // tyy
+    v10 = v06*v02;  // tzz
+    v11 = v05*v02;  // tyz
+    v12 = v06*v00;  // tzx
+    v13 = v04*v01;  // txy
+
+    v00 *= qsp;     // jx
+    v01 *= qsp;     // jy
+    v02 *= qsp;     // jz
+
+    store_4x4_tr( v00, v01, v02, qsp,
+                  &m[ 0], &m[16], &m[32], &m[48] );
+
+    store_4x4_tr( v04, v05, v06, v07,
+                  &m[ 4], &m[20], &m[36], &m[52] );
+
+    store_4x4_tr( v08, v09, v10, v11,
+                  &m[ 8], &m[24], &m[40], &m[56] );
+
+    store_4x4_tr( v12, v13, zero, zero,
+                  &m[12], &m[28], &m[44], &m[60] );
+
+    //--------------------------------------------------------------------------
+    // Accumulate the weighted moments of each particle to the hydros of
+    // the nodes of its voxel.
+    //--------------------------------------------------------------------------
+    for( k = 0; k < 4; k++ )
+    {
+      load_4x1( &m[16*k   ], v00 );
+      load_4x1( &m[16*k+ 4], v01 );
+      load_4x1( &m[16*k+ 8], v02 );
+      load_4x1( &m[16*k+12], v03 );
+
+      for( j = 0; j < 8; j++ )
+      {
+        hp  = ( float * ALIGNED(16) ) ( h + ii(k) + off[j] );
+
+        v04 = v4float( wt[4*j+k] );
+
+        load_4x1( hp,    v05 );
+        load_4x1( hp+ 4, v06 );
+        load_4x1( hp+ 8, v07 );
+        load_4x1( hp+12, v08 );
+
+        store_4x1( fma( v04, v00, v05 ), hp    );
+        store_4x1( fma( v04, v01, v06 ), hp+ 4 );
+        store_4x1( fma( v04, v02, v07 ), hp+ 8 );
+        store_4x1( fma( v04, v03, v08 ), hp+12 );
+      }
+    }
+  }
+}
+
+#else
+
+void
+accumulate_hydro_p_pipeline_v4( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+  // No v4 implementation.
+  ERROR( ( "No accumulate_hydro_p_pipeline_v4 implementation." ) );
+}
+
+#endif
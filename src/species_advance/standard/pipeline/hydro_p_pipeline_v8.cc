@@ -0,0 +1,282 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V8_ACCELERATION)
+
+using namespace v8;
+
+void
+accumulate_hydro_p_pipeline_v8( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+  const particle_t       * ALIGNED(128) p   = args->p;
+  const particle_block_t * ALIGNED(128) pb  = args->pb;
+  /**/  hydro_t          * ALIGNED(128) h   = args->h;
+  const interpolator_t   * ALIGNED(128) f0  = args->f;
+  const int              * ALIGNED(128) sfc = args->sfc;
+
+  const float            * ALIGNED(32)  vp00;
+  const float            * ALIGNED(32)  vp01;
+  const float            * ALIGNED(32)  vp02;
+  const float            * ALIGNED(32)  vp03;
+  const float            * ALIGNED(32)  vp04;
+  const float            * ALIGNED(32)  vp05;
+  const float            * ALIGNED(32)  vp06;
+  const float            * ALIGNED(32)  vp07;
+
+  float                  * ALIGNED(32)  hp;
+
+  // Basic constants.
+  const v8float qdt_2mc(args->qdt_2mc);
+  const v8float qdt_4mc2(args->qdt_4mc2);
+  const v8float c(args->c);
+  const v8float qsp(args->qsp);
+  const v8float mspc(args->mspc);
+  const v8float r8V(args->r8V);
+  const v8float one(1.0);
+  const v8float one_third(1.0/3.0);
+  const v8float two_fifths(0.4);
+  const v8float zero(0.0);
+
+  v8float dx, dy, dz, ux, uy, uz, w, ke_mc, vg;
+  v8float hax, hay, haz, cbx, cby, cbz;
+  v8float w0, w1, w2, w3, w4, w5, w6, w7;
+  v8float v00, v01, v02, v03, v04, v05, v06, v07;
+  v8float v08, v09, v10, v11, v12, v13;
+  v8int   ii;
+
+  // Per particle hydro moments and per corner trilinear weights of the
+  // particles being deposited.
+
+  DECLARE_ALIGNED_ARRAY( float, 32, m,  8*16 );
+  DECLARE_ALIGNED_ARRAY( float, 32, wt, 8*8  );
+
+  int off[8];
+
+  int n, nq, k, j;
+
+  // Determine which particle blocks this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n, nq );
+
+  nq >>= 3;
+
+  // Determine which slab to use and clear it.
+
+  h += pipeline_rank * args->stride;
+
+  CLEAR( h, args->nh );
+
+  // Offsets in the slab of the hydros of the 8 nodes of a voxel.
+
+  off[0] = -args->i0;
+  off[1] = off[0] + args->s10;
+  off[2] = off[1] + args->s21;
+  off[3] = off[2] + args->s10;
+  off[4] = off[3] + args->s43;
+  off[5] = off[4] + args->s10;
+  off[6] = off[5] + args->s21;
+  off[7] = off[6] + args->s10;
+
+  // Process the particle blocks for this pipeline.
+
+  for( ; nq; nq--, n+=8 )
+  {
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+    if ( pb )
+    {
+      const particle_block_t * ALIGNED(128) b = pb + n / PARTICLE_BLOCK_SIZE;
+
+      j = n % PARTICLE_BLOCK_SIZE;
+
+      load_8x1( &b->dx[j], dx );
+      load_8x1( &b->dy[j], dy );
+      load_8x1( &b->dz[j], dz );
+      load_8x1( &b->i[j],  ii );
+      load_8x1( &b->ux[j], ux );
+      load_8x1( &b->uy[j], uy );
+      load_8x1( &b->uz[j], uz );
+      load_8x1( &b->w[j],  w  );
+    }
+
+    else
+    {
+      load_8x8_tr( &p[n  ].dx, &p[n+1].dx, &p[n+2].dx, &p[n+3].dx,
+                   &p[n+4].dx, &p[n+5].dx, &p[n+6].dx, &p[n+7].dx,
+                   dx, dy, dz, ii, ux, uy, uz, w );
+    }
+
+    //--------------------------------------------------------------------------
+    // Set field interpolation pointers.
+    //--------------------------------------------------------------------------
+    vp00 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(0) ] );
+    vp01 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(1) ] );
+    vp02 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(2) ] );
+    vp03 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(3) ] );
+    vp04 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(4) ] );
+    vp05 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(5) ] );
+    vp06 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(6) ] );
+    vp07 = ( const float * ALIGNED(32) ) ( f0 + sfc[ ii(7) ] );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles.
+    //--------------------------------------------------------------------------
+    load_8x8_tr( vp00, vp01, vp02, vp03,
+                 vp04, vp05, vp06, vp07,
+                 hax, v00, v01, v02, hay, v03, v04, v05 );
+
+    hax = qdt_2mc*fma( fma( v02, dy, v01 ), dz, fma( v00, dy, hax ) );
+
+    hay = qdt_2mc*fma( fma( v05, dz, v04 ), dx, fma( v03, dz, hay ) );
+
+    load_8x8_tr( vp00+8, vp01+8, vp02+8, vp03+8,
+                 vp04+8, vp05+8, vp06+8, vp07+8,
+                 haz, v00, v01, v02, cbx, v03, cby, v04 );
+
+    haz = qdt_2mc*fma( fma( v02, dx, v01 ), dy, fma( v00, dx, haz ) );
+
+    cbx = fma( v03, dx, cbx );
+
+    cby = fma( v04, dy, cby );
+
+    load_8x2_tr( vp00+16, vp01+16, vp02+16, vp03+16,
+                 vp04+16, vp05+16, vp06+16, vp07+16,
+                 cbz, v05 );
+
+    cbz = fma( v05, dz, cbz );
+
+    //--------------------------------------------------------------------------
+    // Half advance E and half rotate B.  Also compute the kinetic energy.
+    // Note: gamma-1 = |u|^2 / (gamma+1) is the numerically accurate way to
+    // compute gamma-1.
+    //--------------------------------------------------------------------------
+    ux   += hax;
+    uy   += hay;
+    uz   += haz;
+
+    ke_mc = fma( ux, ux, fma( uy, uy, uz*uz ) );  // |u|^2 (invariant)
+    vg    = sqrt( one + ke_mc );                   // gamma (invariant)
+    ke_mc = ke_mc * ( c / ( vg + one ) );          // c*(gamma-1)
+    vg    = c / vg;                                // c/gamma
+
+    v00   = qdt_4mc2*vg;
+    v01   = fma( cbx, cbx, fma( cby, cby, cbz*cbz ) );
+    v02   = (v00*v00)*v01;
+    v03   = v00*fma( one_third*v02, fma( two_fifths, v02, one ), one );
+    v04   = v03 / fma( v03*v03, v01, one );
+    v04  += v04;
+
+    v00   = fma( fms(  uy, cbz,  uz*cby ), v03, ux );
+    v01   = fma( fms(  uz, cbx,  ux*cbz ), v03, uy );
+    v02   = fma( fms(  ux, cby,  uy*cbx ), v03, uz );
+
+    ux    = fma( fms( v01, cbz, v02*cby ), v04, ux );
+    uy    = fma( fms( v02, cbx, v00*cbz ), v04, uy );
+    uz    = fma( fms( v00, cby, v01*cbx ), v04, uz );
+
+    //--------------------------------------------------------------------------
+    // Compute the trilinear coefficients.
+    //--------------------------------------------------------------------------
+    w0  = r8V*w;    // w0 = (1/8)(w/V)
+    dx *= w0;       // dx = (1/8)(w/V) x
+    w1  = w0+dx;    // w1 = (1/8)(w/V)(1+x)
+    w0 -= dx;       // w0 = (1/8)(w/V)(1-x)
+    w3  = one+dy;   // w3 = 1+y
+    w2  = w0*w3;    // w2 = (1/8)(w/V)(1-x)(1+y)
+    w3 *= w1;       // w3 = (1/8)(w/V)(1+x)(1+y)
+    dy  = one-dy;   // dy = 1-y
+    w0 *= dy;       // w0 = (1/8)(w/V)(1-x)(1-y)
+    w1 *= dy;       // w1 = (1/8)(w/V)(1+x)(1-y)
+    w7  = one+dz;   // w7 = 1+z
+    w4  = w0*w7;    // w4 = (w/V) trilin_4
+    w5  = w1*w7;    // w5 = (w/V) trilin_5
+    w6  = w2*w7;    // w6 = (w/V) trilin_6
+    w7 *= w3;       // w7 = (w/V) trilin_7
+    dz  = one-dz;   // dz = 1-z
+    w0 *= dz;       // w0 = (w/V) trilin_0
+    w1 *= dz;       // w1 = (w/V) trilin_1
+    w2 *= dz;       // w2 = (w/V) trilin_2
+    w3 *= dz;       // w3 = (w/V) trilin_3
+
+    store_8x1( w0, &wt[ 0] );
+    store_8x1( w1, &wt[ 8] );
+    store_8x1( w2, &wt[16] );
+    store_8x1( w3, &wt[24] );
+    store_8x1( w4, &wt[32] );
+    store_8x1( w5, &wt[40] );
+    store_8x1( w6, &wt[48] );
+    store_8x1( w7, &wt[56] );
+
+    //--------------------------------------------------------------------------
+    // Compute the hydro moments of the particles, in hydro_t order, and
+    // transpose them so each particle's moments are contiguous.
+    //--------------------------------------------------------------------------
+    v00 = ux*vg;    // vx
+    v01 = uy*vg;    // vy
+    v02 = uz*vg;    // vz
+
+    v04 = mspc*ux;  // px
+    v05 = mspc*uy;  // py
+    v06 = mspc*uz;  // pz
+    v07 = mspc*ke_mc;
+
+    v08 = v04*v00;  // txx
+    v09 = v05*v01;  // tyy
+    v10 = v06*v02;  // tzz
+    v11 = v05*v02;  // tyz
+    v12 = v06*v00;  // tzx
+    v13 = v04*v01;  // txy
+
+    v00 *= qsp;     // jx
+    v01 *= qsp;     // jy
+    v02 *= qsp;     // jz
+
+    store_8x8_tr( v00, v01, v02, qsp, v04, v05, v06, v07,
+                  &m[  0], &m[ 16], &m[ 32], &m[ 48],
+                  &m[ 64], &m[ 80], &m[ 96], &m[112] );
+
+    store_8x8_tr( v08, v09, v10, v11, v12, v13, zero, zero,
+                  &m[  8], &m[ 24], &m[ 40], &m[ 56],
+                  &m[ 72], &m[ 88], &m[104], &m[120] );
+
+    //--------------------------------------------------------------------------
+    // Accumulate the weighted moments of each particle to the hydros of
+    // the nodes of its voxel.
+    //--------------------------------------------------------------------------
+    for( k = 0; k < 8; k++ )
+    {
+      load_8x1( &m[16*k  ], v00 );
+      load_8x1( &m[16*k+8], v01 );
+
+      for( j = 0; j < 8; j++ )
+      {
+        hp  = ( float * ALIGNED(32) ) ( h + ii(k) + off[j] );
+
+        v04 = v8float( wt[8*j+k] );
+
+        load_8x1( hp,   v05 );
+        load_8x1( hp+8, v06 );
+
+        store_8x1( fma( v04, v00, v05 ), hp   );
+        store_8x1( fma( v04, v01, v06 ), hp+8 );
+      }
+    }
+  }
+}
+
+#else
+
+void
+accumulate_hydro_p_pipeline_v8( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+  // No v8 implementation.
+  ERROR( ( "No accumulate_hydro_p_pipeline_v8 implementation." ) );
+}
+
+#endif
@@ -0,0 +1,56 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Sum the slabs into the hydro array.  The slabs are always summed in the
+// same order such that the result does not depend on how the nodes are
+// distributed.
+//----------------------------------------------------------------------------//
+
+void
+reduce_hydro_p_pipeline_scalar( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+  const int sh = sizeof(hydro_t) / sizeof(float);
+  const int sr = sh * args->stride;
+
+  const int n_slab = args->n_slab;
+
+  int i, n, j, k;
+
+  DISTRIBUTE( args->nh, 16, pipeline_rank, n_pipeline, i, n );
+
+  // a is broken into restricted rw and ro parts to allow the compiler
+  // to do more aggresive optimizations
+
+  /**/  float * RESTRICT ALIGNED(16) a = &args->h0[ args->i0 + i ].jx;
+  const float * RESTRICT ALIGNED(16) b = &args->h[ i ].jx;
+
+  n *= sh;
+
+  for( k = 0; k < n_slab; k++, b += sr )
+  {
+    for( j = 0; j < n; j++ )
+    {
+      a[j] += b[j];
+    }
+  }
+}
+
+#if defined(V4_ACCELERATION) && defined(HAS_V4_PIPELINE)
+
+#error "V4 version not hooked up yet!"
+
+#endif
+
+void
+reduce_hydro_p_pipeline( accumulate_hydro_p_pipeline_args_t * args )
+{
+  EXEC_PIPELINES( reduce_hydro_p, args, 0 );
+
+  WAIT_PIPELINES();
+}
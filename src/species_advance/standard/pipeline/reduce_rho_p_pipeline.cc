@@ -0,0 +1,72 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Sum the slabs into the rhof of the block of nodes (x0:x1,y0:y1,z0:z1).
+// The slabs are always summed in the same order such that the result does
+// not depend on how the nodes are distributed.
+//----------------------------------------------------------------------------//
+
+void
+reduce_rho_p_pipeline_scalar( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  /**/  field_t * RESTRICT ALIGNED(128) f = args->f;
+  const float   * RESTRICT ALIGNED(128) r = args->rho;
+
+  const int stride = args->stride;
+  const int n_slab = args->n_slab;
+  const int sy     = args->sy;
+  const int sz     = args->sz;
+
+  float s;
+  int x, y, z, v, i, k, n_node;
+
+  DISTRIBUTE_VOXELS( args->x0, args->x1, args->y0, args->y1,
+                     args->z0, args->z1, 16,
+                     pipeline_rank, n_pipeline, x, y, z, n_node );
+
+  v = x + sy*y + sz*z;
+
+  for( ; n_node; n_node-- )
+  {
+    i = v - args->i0;
+
+    s = r[i];
+
+    for( k = 1; k < n_slab; k++ )
+    {
+      s += r[i + k*stride];
+    }
+
+    f[v].rhof += s;
+
+    v++;
+
+    x++;
+    if ( x > args->x1 )
+    {
+      x = args->x0, y++;
+      if ( y > args->y1 ) y = args->y0, z++;
+      v = x + sy*y + sz*z;
+    }
+  }
+}
+
+#if defined(V4_ACCELERATION) && defined(HAS_V4_PIPELINE)
+
+#error "V4 version not hooked up yet!"
+
+#endif
+
+void
+reduce_rho_p_pipeline( accumulate_rho_p_pipeline_args_t * args )
+{
+  EXEC_PIPELINES( reduce_rho_p, args, 0 );
+
+  WAIT_PIPELINES();
+}
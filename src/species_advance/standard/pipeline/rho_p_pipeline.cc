@@ -0,0 +1,282 @@
+#define IN_spa
+
+#define HAS_V4_PIPELINE
+#define HAS_V8_PIPELINE
+#define HAS_V16_PIPELINE
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Reference implementation for an accumulate_rho_p pipeline function which
+// does not make use of explicit calls to vector intrinsic functions.
+//----------------------------------------------------------------------------//
+
+void
+accumulate_rho_p_pipeline_scalar( accumulate_rho_p_pipeline_args_t * args,
+                                  int pipeline_rank,
+                                  int n_pipeline )
+{
+  const particle_t       * RESTRICT ALIGNED(32)  p  = args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) pb = args->pb;
+  /**/  float            * RESTRICT ALIGNED(128) r  = args->rho;
+
+  const float q_8V = args->q_8V;
+  const int   sy   = args->sy;
+  const int   sz   = args->sz;
+  const int   i0   = args->i0;
+
+  float w0, w1, w2, w3, w4, w5, w6, w7, dz;
+
+  int n, n1, v;
+
+  // Determine which particles this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n, n1 );
+
+  n1 += n;
+
+  // Determine which slab to use and clear it if this is the first
+  // species deposited.
+
+  r += pipeline_rank * args->stride;
+
+  if ( args->clear ) CLEAR( r, args->n );
+
+  for( ; n < n1; n++ )
+  {
+    // After detailed experiments and studying of assembly dumps, it was
+    // determined that if the platform does not support efficient 4-vector
+    // SIMD memory gather/scatter operations, the savings from using
+    // "trilinear" are slightly outweighed by the overhead of the
+    // gather/scatters.
+
+    // Load the particle data
+
+    if( pb ) {
+      const particle_block_t * RESTRICT ALIGNED(128) b =
+        pb + n/PARTICLE_BLOCK_SIZE;
+      const int j = n%PARTICLE_BLOCK_SIZE;
+      w0 = b->dx[j];
+      w1 = b->dy[j];
+      dz = b->dz[j];
+      v  = b->i[j];
+      w7 = b->w[j]*q_8V;
+    } else {
+      w0 = p[n].dx;
+      w1 = p[n].dy;
+      dz = p[n].dz;
+      v  = p[n].i;
+      w7 = p[n].w*q_8V;
+    }
+
+    // Compute the trilinear weights
+    // Though the PPE should have hardware fma/fmaf support, it was
+    // measured to be more efficient _not_ to use it here.  (Maybe the
+    // compiler isn't actually generating the assembly for it.
+
+#   define FMA( x,y,z) ((z)+(x)*(y))
+#   define FNMS(x,y,z) ((z)-(x)*(y))
+    w6=FNMS(w0,w7,w7);                    // q(1-dx)
+    w7=FMA( w0,w7,w7);                    // q(1+dx)
+    w4=FNMS(w1,w6,w6); w5=FNMS(w1,w7,w7); // q(1-dx)(1-dy), q(1+dx)(1-dy)
+    w6=FMA( w1,w6,w6); w7=FMA( w1,w7,w7); // q(1-dx)(1+dy), q(1+dx)(1+dy)
+    w0=FNMS(dz,w4,w4); w1=FNMS(dz,w5,w5); w2=FNMS(dz,w6,w6); w3=FNMS(dz,w7,w7);
+    w4=FMA( dz,w4,w4); w5=FMA( dz,w5,w5); w6=FMA( dz,w6,w6); w7=FMA( dz,w7,w7);
+#   undef FNMS
+#   undef FMA
+
+    // Reduce the particle charge to the slab
+
+    v -= i0;
+
+    r[v      ] += w0; r[v      +1] += w1;
+    r[v   +sy] += w2; r[v   +sy+1] += w3;
+    r[v+sz   ] += w4; r[v+sz   +1] += w5;
+    r[v+sz+sy] += w6; r[v+sz+sy+1] += w7;
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Deposit the charge of a species into the pipeline slabs.  The slabs are
+// kept between calls such that the charge of a species list can be summed
+// in the slabs and reduced into rhof once (see accumulate_rho_p_list_faces).
+//----------------------------------------------------------------------------//
+
+static float * ALIGNED(128) scratch = NULL;
+static size_t           max_scratch = 0;
+
+static void
+deposit_rho_p( accumulate_rho_p_pipeline_args_t * args,
+               field_array_t * RESTRICT fa,
+               const species_t * RESTRICT sp,
+               int clear )
+{
+  size_t sz_scratch;
+
+  const grid_t * g;
+  int nx, ny, nz;
+
+  if ( !fa || !sp || fa->g != sp->g )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  g  = sp->g;
+  nx = g->nx;
+  ny = g->ny;
+  nz = g->nz;
+
+  if ( sp->p_layout == particle_layout_aosoa )
+  {
+    args->p  = NULL;
+    args->pb = ( const particle_block_t * ) sp->p;
+  }
+
+  else
+  {
+    args->p  = sp->p;
+    args->pb = NULL;
+  }
+
+  // Particles only deposit to the nodes of the local domain,
+  // (1:nx+1,1:ny+1,1:nz+1).  Slabs are padded to a multiple of 128
+  // bytes so that each one is aligned.
+
+  args->f      = fa->f;
+  args->q_8V   = sp->q*g->r8V;
+  args->np     = sp->np;
+  args->sy     = g->sy;
+  args->sz     = g->sz;
+  args->i0     = VOXEL( 1,    1,    1,    nx, ny, nz );
+  args->n      = VOXEL( nx+1, ny+1, nz+1, nx, ny, nz ) - args->i0 + 1;
+  args->stride = POW2_CEIL( args->n, 32 );
+  args->n_slab = N_PIPELINE + 1;
+  args->clear  = clear;
+
+  // Ensure enough scratch space is allocated for the slabs.  The slabs
+  // hold the charge of earlier species unless they are cleared.
+
+  sz_scratch = ( size_t ) args->stride * ( size_t ) args->n_slab;
+
+  if ( sz_scratch > max_scratch )
+  {
+    if ( !clear ) ERROR( ( "Slabs resized during a species list" ) );
+
+    FREE_ALIGNED( scratch );
+
+    MALLOC_ALIGNED( scratch, sz_scratch, 128 );
+
+    max_scratch = sz_scratch;
+  }
+
+  args->rho = scratch;
+
+  // Have the pipelines do the bulk of particles in blocks and have the
+  // host do the final incomplete block.
+
+  EXEC_PIPELINES( accumulate_rho_p, args, 0 );
+
+  WAIT_PIPELINES();
+}
+
+//----------------------------------------------------------------------------//
+// Reduce the slabs into the rhof of the block of nodes (x0:x1,y0:y1,z0:z1).
+//----------------------------------------------------------------------------//
+
+static void
+reduce_rho_p_block( accumulate_rho_p_pipeline_args_t * args,
+                    int x0, int x1,
+                    int y0, int y1,
+                    int z0, int z1 )
+{
+  if ( x0 > x1 || y0 > y1 || z0 > z1 )
+  {
+    return;
+  }
+
+  args->x0 = x0; args->x1 = x1;
+  args->y0 = y0; args->y1 = y1;
+  args->z0 = z0; args->z1 = z1;
+
+  reduce_rho_p_pipeline( args );
+}
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper accumulate_rho_p pipeline
+// function.
+//----------------------------------------------------------------------------//
+
+void
+accumulate_rho_p_pipeline( field_array_t * RESTRICT fa,
+                           const species_t * RESTRICT sp )
+{
+  DECLARE_ALIGNED_ARRAY( accumulate_rho_p_pipeline_args_t, 128, args, 1 );
+
+  deposit_rho_p( args, fa, sp, 1 );
+
+  // Reduce the slabs into rhof.
+
+  reduce_rho_p_block( args, 1, fa->g->nx + 1,
+                            1, fa->g->ny + 1,
+                            1, fa->g->nz + 1 );
+}
+
+//----------------------------------------------------------------------------//
+// Deposit the charge of a species list and reduce it into the nodes on the
+// faces of the local domain.  Each face is reduced as a slab such that no
+// node is reduced twice.  The slabs and their layout are kept for
+// accumulate_rho_p_list_interior_pipeline.
+//----------------------------------------------------------------------------//
+
+static accumulate_rho_p_pipeline_args_t list_args[1];
+
+void
+accumulate_rho_p_list_faces_pipeline( field_array_t * RESTRICT fa,
+                                      const species_t * RESTRICT sp_list )
+{
+  const species_t * sp;
+  int nx, ny, nz;
+
+  if ( !fa || !sp_list )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  LIST_FOR_EACH( sp, sp_list )
+  {
+    deposit_rho_p( list_args, fa, sp, sp == sp_list );
+  }
+
+  nx = fa->g->nx;
+  ny = fa->g->ny;
+  nz = fa->g->nz;
+
+  reduce_rho_p_block( list_args, 1,    1,    1,    ny+1, 1,    nz+1 );
+  reduce_rho_p_block( list_args, nx+1, nx+1, 1,    ny+1, 1,    nz+1 );
+  reduce_rho_p_block( list_args, 2,    nx,   1,    1,    1,    nz+1 );
+  reduce_rho_p_block( list_args, 2,    nx,   ny+1, ny+1, 1,    nz+1 );
+  reduce_rho_p_block( list_args, 2,    nx,   2,    ny,   1,    1    );
+  reduce_rho_p_block( list_args, 2,    nx,   2,    ny,   nz+1, nz+1 );
+}
+
+//----------------------------------------------------------------------------//
+// Reduce the charge deposited by accumulate_rho_p_list_faces_pipeline into
+// the nodes not on the faces of the local domain.
+//----------------------------------------------------------------------------//
+
+void
+accumulate_rho_p_list_interior_pipeline( field_array_t * RESTRICT fa )
+{
+  if ( !fa || list_args->f != fa->f || list_args->rho != scratch )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  reduce_rho_p_block( list_args, 2, fa->g->nx,
+                                 2, fa->g->ny,
+                                 2, fa->g->nz );
+
+  list_args->f = NULL;
+}
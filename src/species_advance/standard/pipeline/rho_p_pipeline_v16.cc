@@ -0,0 +1,120 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V16_ACCELERATION)
+
+using namespace v16;
+
+void
+accumulate_rho_p_pipeline_v16( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  const particle_t       * ALIGNED(128) p  = args->p;
+  const particle_block_t * ALIGNED(128) pb = args->pb;
+  /**/  float            * ALIGNED(128) r  = args->rho;
+
+  const v16float q_8V(args->q_8V);
+
+  const int sy = args->sy;
+  const int sz = args->sz;
+  const int i0 = args->i0;
+
+  v16float dx, dy, dz, w;
+  v16float w0, w1, w2, w3, w4, w5, w6, w7;
+  v16int   ii;
+
+  // Per node trilinear weights of the particles being deposited.
+
+  DECLARE_ALIGNED_ARRAY( float, 64, wt, 8*16 );
+
+  int n, nq, k, v;
+
+  // Determine which particle blocks this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n, nq );
+
+  nq >>= 4;
+
+  // Determine which slab to use and clear it if this is the first
+  // species deposited.
+
+  r += pipeline_rank * args->stride;
+
+  if ( args->clear ) CLEAR( r, args->n );
+
+  // Process the particle blocks for this pipeline.
+
+  for( ; nq; nq--, n+=16 )
+  {
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+    if ( pb )
+    {
+      const particle_block_t * ALIGNED(128) b = pb + n / PARTICLE_BLOCK_SIZE;
+
+      load_16x1( b->dx, dx );
+      load_16x1( b->dy, dy );
+      load_16x1( b->dz, dz );
+      load_16x1( b->i,  ii );
+      load_16x1( b->w,  w  );
+    }
+
+    else
+    {
+      load_16x8_tr_p( &p[n   ].dx, &p[n+ 2].dx, &p[n+ 4].dx, &p[n+ 6].dx,
+                      &p[n+ 8].dx, &p[n+10].dx, &p[n+12].dx, &p[n+14].dx,
+                      dx, dy, dz, ii, w0, w1, w2, w );
+    }
+
+    //--------------------------------------------------------------------------
+    // Compute the trilinear weights.
+    //--------------------------------------------------------------------------
+    w7 = q_8V*w;
+    w6 = fnms( dx, w7, w7 );                        // q(1-dx)
+    w7 = fma(  dx, w7, w7 );                        // q(1+dx)
+    w4 = fnms( dy, w6, w6 ); w5 = fnms( dy, w7, w7 ); // q(1-dx)(1-dy), ...
+    w6 = fma(  dy, w6, w6 ); w7 = fma(  dy, w7, w7 ); // q(1-dx)(1+dy), ...
+    w0 = fnms( dz, w4, w4 ); w1 = fnms( dz, w5, w5 );
+    w2 = fnms( dz, w6, w6 ); w3 = fnms( dz, w7, w7 );
+    w4 = fma(  dz, w4, w4 ); w5 = fma(  dz, w5, w5 );
+    w6 = fma(  dz, w6, w6 ); w7 = fma(  dz, w7, w7 );
+
+    store_16x1( w0, &wt[  0] );
+    store_16x1( w1, &wt[ 16] );
+    store_16x1( w2, &wt[ 32] );
+    store_16x1( w3, &wt[ 48] );
+    store_16x1( w4, &wt[ 64] );
+    store_16x1( w5, &wt[ 80] );
+    store_16x1( w6, &wt[ 96] );
+    store_16x1( w7, &wt[112] );
+
+    //--------------------------------------------------------------------------
+    // Reduce the particle charge to the slab.
+    //--------------------------------------------------------------------------
+    for( k = 0; k < 16; k++ )
+    {
+      v = ii(k) - i0;
+
+      r[v      ] += wt[  0+k]; r[v      +1] += wt[ 16+k];
+      r[v   +sy] += wt[ 32+k]; r[v   +sy+1] += wt[ 48+k];
+      r[v+sz   ] += wt[ 64+k]; r[v+sz   +1] += wt[ 80+k];
+      r[v+sz+sy] += wt[ 96+k]; r[v+sz+sy+1] += wt[112+k];
+    }
+  }
+}
+
+#else
+
+void
+accumulate_rho_p_pipeline_v16( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  // No v16 implementation.
+  ERROR( ( "No accumulate_rho_p_pipeline_v16 implementation." ) );
+}
+
+#endif
@@ -0,0 +1,122 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V8_ACCELERATION)
+
+using namespace v8;
+
+void
+accumulate_rho_p_pipeline_v8( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  const particle_t       * ALIGNED(128) p  = args->p;
+  const particle_block_t * ALIGNED(128) pb = args->pb;
+  /**/  float            * ALIGNED(128) r  = args->rho;
+
+  const v8float q_8V(args->q_8V);
+
+  const int sy = args->sy;
+  const int sz = args->sz;
+  const int i0 = args->i0;
+
+  v8float dx, dy, dz, w;
+  v8float w0, w1, w2, w3, w4, w5, w6, w7;
+  v8int   ii;
+
+  // Per node trilinear weights of the particles being deposited.
+
+  DECLARE_ALIGNED_ARRAY( float, 32, wt, 8*8 );
+
+  int n, nq, k, v;
+
+  // Determine which particle blocks this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n, nq );
+
+  nq >>= 3;
+
+  // Determine which slab to use and clear it if this is the first
+  // species deposited.
+
+  r += pipeline_rank * args->stride;
+
+  if ( args->clear ) CLEAR( r, args->n );
+
+  // Process the particle blocks for this pipeline.
+
+  for( ; nq; nq--, n+=8 )
+  {
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+    if ( pb )
+    {
+      const particle_block_t * ALIGNED(128) b = pb + n / PARTICLE_BLOCK_SIZE;
+
+      k = n % PARTICLE_BLOCK_SIZE;
+
+      load_8x1( &b->dx[k], dx );
+      load_8x1( &b->dy[k], dy );
+      load_8x1( &b->dz[k], dz );
+      load_8x1( &b->i[k],  ii );
+      load_8x1( &b->w[k],  w  );
+    }
+
+    else
+    {
+      load_8x8_tr( &p[n  ].dx, &p[n+1].dx, &p[n+2].dx, &p[n+3].dx,
+                   &p[n+4].dx, &p[n+5].dx, &p[n+6].dx, &p[n+7].dx,
+                   dx, dy, dz, ii, w0, w1, w2, w );
+    }
+
+    //--------------------------------------------------------------------------
+    // Compute the trilinear weights.
+    //--------------------------------------------------------------------------
+    w7 = q_8V*w;
+    w6 = fnms( dx, w7, w7 );                        // q(1-dx)
+    w7 = fma(  dx, w7, w7 );                        // q(1+dx)
+    w4 = fnms( dy, w6, w6 ); w5 = fnms( dy, w7, w7 ); // q(1-dx)(1-dy), ...
+    w6 = fma(  dy, w6, w6 ); w7 = fma(  dy, w7, w7 ); // q(1-dx)(1+dy), ...
+    w0 = fnms( dz, w4, w4 ); w1 = fnms( dz, w5, w5 );
+    w2 = fnms( dz, w6, w6 ); w3 = fnms( dz, w7, w7 );
+    w4 = fma(  dz, w4, w4 ); w5 = fma(  dz, w5, w5 );
+    w6 = fma(  dz, w6, w6 ); w7 = fma(  dz, w7, w7 );
+
+    store_8x1( w0, &wt[  0] );
+    store_8x1( w1, &wt[  8] );
+    store_8x1( w2, &wt[ 16] );
+    store_8x1( w3, &wt[ 24] );
+    store_8x1( w4, &wt[ 32] );
+    store_8x1( w5, &wt[ 40] );
+    store_8x1( w6, &wt[ 48] );
+    store_8x1( w7, &wt[ 56] );
+
+    //--------------------------------------------------------------------------
+    // Reduce the particle charge to the slab.
+    //--------------------------------------------------------------------------
+    for( k = 0; k < 8; k++ )
+    {
+      v = ii(k) - i0;
+
+      r[v      ] += wt[  0+k]; r[v      +1] += wt[  8+k];
+      r[v   +sy] += wt[ 16+k]; r[v   +sy+1] += wt[ 24+k];
+      r[v+sz   ] += wt[ 32+k]; r[v+sz   +1] += wt[ 40+k];
+      r[v+sz+sy] += wt[ 48+k]; r[v+sz+sy+1] += wt[ 56+k];
+    }
+  }
+}
+
+#else
+
+void
+accumulate_rho_p_pipeline_v8( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  // No v8 implementation.
+  ERROR( ( "No accumulate_rho_p_pipeline_v8 implementation." ) );
+}
+
+#endif
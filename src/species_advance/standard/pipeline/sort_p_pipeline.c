@@ -33,6 +33,7 @@ coarse_count_pipeline_scalar( sort_p_pipeline_args_t * args,
                               int n_pipeline )
 {
   const particle_t * RESTRICT ALIGNED(128) p_src = args->p;
+  const int        * RESTRICT ALIGNED(128) sfc   = args->sfc;
 
   int i, i1;
 
@@ -65,7 +66,7 @@ coarse_count_pipeline_scalar( sort_p_pipeline_args_t * args,
   // Local coarse count the input particles.
   for( ; i < i1; i++ )
   {
-    count[ V2P( p_src[i].i, n_subsort, vl, vh ) ]++;
+    count[ V2P( sfc[ p_src[i].i ], n_subsort, vl, vh ) ]++;
   }
 
   // Copy local coarse count to output.
@@ -85,6 +86,7 @@ coarse_sort_pipeline_scalar( sort_p_pipeline_args_t * args,
 {
   const particle_t * RESTRICT ALIGNED(128) p_src = args->p;
   /**/  particle_t * RESTRICT ALIGNED(128) p_dst = args->aux_p;
+  const int        * RESTRICT ALIGNED(128) sfc   = args->sfc;
 
   int i, i1;
   int n_subsort = args->n_subsort;
@@ -120,7 +122,7 @@ coarse_sort_pipeline_scalar( sort_p_pipeline_args_t * args,
   // Copy particles into aux array in coarse sorted order.
   for( ; i < i1; i++ )
   {
-    j = next[ V2P( p_src[i].i, n_subsort, vl, vh ) ]++;
+    j = next[ V2P( sfc[ p_src[i].i ], n_subsort, vl, vh ) ]++;
 
 #   if defined( __SSE__ )
 
@@ -146,6 +148,7 @@ subsort_pipeline_scalar( sort_p_pipeline_args_t * args,
 {
   const particle_t * RESTRICT ALIGNED(128) p_src = args->aux_p;
   /**/  particle_t * RESTRICT ALIGNED(128) p_dst = args->p;
+  const int        * RESTRICT ALIGNED(128) sfc   = args->sfc;
 
   int i0, i1, v0, v1, i, j, v, sum, count;
 
@@ -178,7 +181,7 @@ subsort_pipeline_scalar( sort_p_pipeline_args_t * args,
     // Fine grained count.
     for( i = i0; i < i1; i++ )
     {
-      next[ p_src[i].i ]++;
+      next[ sfc[ p_src[i].i ] ]++;
     }
 
     // Compute the partitioning.
@@ -196,7 +199,7 @@ subsort_pipeline_scalar( sort_p_pipeline_args_t * args,
     // Local fine grained sort.
     for( i = i0; i < i1; i++ )
     {
-      v = p_src[i].i;
+      v = sfc[ p_src[i].i ];
       j = next[v]++;
 
 #     if defined( __SSE__ )
@@ -240,19 +243,10 @@ sort_p_pipeline( species_t * sp )
   int * RESTRICT ALIGNED(128) partition = sp->partition;
   int * RESTRICT ALIGNED(128) next;
 
-  int vl = VOXEL( 1,
-		  1,
-		  1,
-		  sp->g->nx,
-		  sp->g->ny,
-		  sp->g->nz );
-
-  int vh = VOXEL( sp->g->nx,
-		  sp->g->ny,
-		  sp->g->nz,
-		  sp->g->nx,
-		  sp->g->ny,
-		  sp->g->nz );
+  // Particles are sorted by the storage index of their voxel.  Thus,
+  // the particles are laid out along the grid's space filling curve.
+  int vl = sp->g->sfc_lo;
+  int vh = sp->g->sfc_hi;
 
   int n_voxel = sp->g->nv;
 
@@ -293,6 +287,7 @@ sort_p_pipeline( species_t * sp )
   args->coarse_partition = coarse_partition;
   args->next             = next;
   args->partition        = partition;
+  args->sfc              = sp->g->sfc;
   args->n                = n_particle;
   args->n_subsort        = n_subsort;
   args->vl               = vl;
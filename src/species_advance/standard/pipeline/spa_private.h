@@ -25,9 +25,11 @@ typedef struct advance_p_pipeline_args
 {
   MEM_PTR( particle_t,           128 ) p0;       // Particle array
   MEM_PTR( particle_mover_t,     128 ) pm;       // Particle mover array
-  MEM_PTR( accumulator_t,        128 ) a0;       // Accumulator arrays
+  MEM_PTR( accumulator_t,        128 ) a0;       // Host accumulator array
+  MEM_PTR( accumulator_t * const, 1  ) ap;       // Pipeline accumulators
   MEM_PTR( const interpolator_t, 128 ) f0;       // Interpolator array
   MEM_PTR( particle_mover_seg_t, 128 ) seg;      // Dest for return values
+  MEM_PTR( pipeline_work_t,      128 ) work;     // Chunks of particles
   MEM_PTR( const grid_t,         1   ) g;        // Local domain grid params
 
   float                                qdt_2mc;  // Particle/field coupling
@@ -38,14 +40,71 @@ typedef struct advance_p_pipeline_args
 
   int                                  np;       // Number of particles
   int                                  max_nm;   // Number of movers
+  int                                  max_spill; // Movers shared by the
+                                                  // chunks (the last ones)
+  volatile int                         n_spill;  // Shared movers claimed
   int                                  nx;       // x-mesh resolution
   int                                  ny;       // y-mesh resolution
   int                                  nz;       // z-mesh resolution
  
-  PAD_STRUCT( 6*SIZEOF_MEM_PTR + 5*sizeof(float) + 5*sizeof(int) )
+  PAD_STRUCT( 8*SIZEOF_MEM_PTR + 5*sizeof(float) + 7*sizeof(int) )
 
 } advance_p_pipeline_args_t;
 
+// The movers are split between the chunks of particles, except for the
+// last max_spill movers, which are shared.  A chunk gets its movers in
+// multiples of 8 such that the movers of a chunk are 128-byte aligned
+// and a multiple of 128 bytes in size.  The host chunk (chunk==n_chunk)
+// is guaranteed to get enough movers to process its particles.
+
+STATIC_INLINE particle_mover_t *
+chunk_movers( const advance_p_pipeline_args_t * args,
+              int chunk,
+              int n_chunk,
+              int * max_nm )
+{
+  int n = args->max_nm - args->max_spill - ( args->np&15 ), i;
+
+  if ( n < 0 ) n = 0;
+
+  DISTRIBUTE( n, 8, chunk, n_chunk, i, n );
+
+  if ( chunk == n_chunk ) n = args->max_nm - args->max_spill - i;
+
+  *max_nm = n;
+
+  return args->pm + i;
+}
+
+// A chunk that has used up its own movers stores a mover in the shared
+// movers.  Returns 0 if these are used up too.  Chunks with more movers
+// than they were given in proportion to their particles (e.g. after
+// sort_p put the particles of the faces of the local domain together)
+// then do not lose any.  Shared movers are claimed in no particular
+// order (see append_spilled_movers).
+
+STATIC_INLINE int
+spill_mover( advance_p_pipeline_args_t * args,
+             const particle_mover_t * pm )
+{
+  int n = __sync_fetch_and_add( &args->n_spill, 1 );
+
+  if ( n >= args->max_spill ) return 0;
+
+  args->pm[ args->max_nm - args->max_spill + n ] = *pm;
+
+  return 1;
+}
+
+// Append the shared movers the pipelines claimed to the movers of sp,
+// of which the first nm were there before the advance, and keep those
+// ordered by particle index.
+
+void
+append_spilled_movers( species_t * RESTRICT sp,
+                       const advance_p_pipeline_args_t * args,
+                       int nm );
+
 // PROTOTYPE_PIPELINE( advance_p, advance_p_pipeline_args_t );
 
 void
@@ -68,6 +127,73 @@ advance_p_pipeline_v16( advance_p_pipeline_args_t * args,
                         int pipeline_rank,
                         int n_pipeline );
 
+// The advance_pb pipelines take the same arguments as advance_p but p0
+// points to particle blocks (AoSoA layout).
+
+void
+advance_pb_pipeline_scalar( advance_p_pipeline_args_t * args,
+                            int pipeline_rank,
+                            int n_pipeline );
+
+void
+advance_pb_pipeline_v4( advance_p_pipeline_args_t * args,
+                        int pipeline_rank,
+                        int n_pipeline );
+
+void
+advance_pb_pipeline_v8( advance_p_pipeline_args_t * args,
+                        int pipeline_rank,
+                        int n_pipeline );
+
+void
+advance_pb_pipeline_v16( advance_p_pipeline_args_t * args,
+                         int pipeline_rank,
+                         int n_pipeline );
+
+///////////////////////////////////////////////////////////////////////////////
+// tile_p_pipeline interface
+
+typedef struct tile_p_pipeline_args
+{
+  MEM_PTR( const particle_t,       128 ) p0;   // Particle array
+  MEM_PTR( const particle_block_t, 128 ) pb0;  // Particle blocks (AoSoA)
+  MEM_PTR( const int,              128 ) nbr;  // Voxel accumulator ranges
+  MEM_PTR( accumulator_tile_t,     16  ) tile; // Dest for pipeline tiles
+  int                                    np;   // Number of particles
+
+  PAD_STRUCT( 4*SIZEOF_MEM_PTR + sizeof(int) )
+
+} tile_p_pipeline_args_t;
+
+void
+tile_p_pipeline_scalar( tile_p_pipeline_args_t * args,
+                        int pipeline_rank,
+                        int n_pipeline );
+
+// Sets the accumulator tiles of the pipelines of a particle advance of
+// the np particles at p0 (or, in the AoSoA layout, pb0).  The tile of a
+// pipeline spans the storage indices of the voxels of its particles plus
+// a halo no wider than the aa->nbr ranges.  It is the slice of the local
+// domain of the pipeline plus the halo when the particles are sorted (see
+// sort_p) or partitioned by partition_tile_p_pipeline.
+
+void
+tile_p_pipeline( accumulator_array_t * RESTRICT aa,
+                 const particle_t * p0,
+                 const particle_block_t * pb0,
+                 int np );
+
+// Partitions particles n0:n1-1 of sp in place such that the particles of
+// each pipeline's share of an advance of them come from the pipeline's
+// slice of the storage indices (the coarse partition of sort_p).  Inside
+// a slice, the particles are in no particular voxel order.  In the AoSoA
+// layout, n0 must be a multiple of PARTICLE_BLOCK_SIZE.
+
+void
+partition_tile_p_pipeline( species_t * RESTRICT sp,
+                           int n0,
+                           int n1 );
+
 ///////////////////////////////////////////////////////////////////////////////
 // center_p_pipeline and uncenter_p_pipeline interface
 
@@ -75,10 +201,11 @@ typedef struct center_p_pipeline_args
 {
   MEM_PTR( particle_t,           128 ) p0;      // Particle array
   MEM_PTR( const interpolator_t, 128 ) f0;      // Interpolator array
+  MEM_PTR( const int,            128 ) sfc;     // Voxel storage indices
   float                                qdt_2mc; // Particle/field coupling
   int                                  np;      // Number of particles
 
-  PAD_STRUCT( 2*SIZEOF_MEM_PTR + sizeof(float) + sizeof(int) )
+  PAD_STRUCT( 3*SIZEOF_MEM_PTR + sizeof(float) + sizeof(int) )
 
 } center_p_pipeline_args_t;
 
@@ -125,6 +252,28 @@ uncenter_p_pipeline_v16( center_p_pipeline_args_t * args,
                          int pipeline_rank,
                          int n_pipeline );
 
+// AoSoA layout variants (p0 points to particle blocks)
+
+void
+center_pb_pipeline_scalar( center_p_pipeline_args_t * args,
+                           int pipeline_rank,
+                           int n_pipeline );
+
+void
+center_pb_pipeline_v16( center_p_pipeline_args_t * args,
+                        int pipeline_rank,
+                        int n_pipeline );
+
+void
+uncenter_pb_pipeline_scalar( center_p_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline );
+
+void
+uncenter_pb_pipeline_v16( center_p_pipeline_args_t * args,
+                          int pipeline_rank,
+                          int n_pipeline );
+
 ///////////////////////////////////////////////////////////////////////////////
 // energy_p_pipeline interface
 
@@ -132,12 +281,13 @@ typedef struct energy_p_pipeline_args
 {
   MEM_PTR( const particle_t,     128 ) p;       // Particle array
   MEM_PTR( const interpolator_t, 128 ) f;       // Interpolator array
+  MEM_PTR( const int,            128 ) sfc;     // Voxel storage indices
   MEM_PTR( double,               128 ) en;      // Return values
   float                                qdt_2mc; // Particle/field coupling
   float                                msp;     // Species particle rest mass
   int                                  np;      // Number of particles
 
-  PAD_STRUCT( 3*SIZEOF_MEM_PTR + 2*sizeof(float) + sizeof(int) )
+  PAD_STRUCT( 4*SIZEOF_MEM_PTR + 2*sizeof(float) + sizeof(int) )
 
 } energy_p_pipeline_args_t;
 
@@ -163,6 +313,152 @@ energy_p_pipeline_v16( energy_p_pipeline_args_t * args,
                        int pipeline_rank,
                        int n_pipeline );
 
+// AoSoA layout variants (p points to particle blocks)
+
+void
+energy_pb_pipeline_scalar( energy_p_pipeline_args_t * RESTRICT args,
+                           int pipeline_rank,
+                           int n_pipeline );
+
+void
+energy_pb_pipeline_v16( energy_p_pipeline_args_t * args,
+                        int pipeline_rank,
+                        int n_pipeline );
+
+///////////////////////////////////////////////////////////////////////////////
+// accumulate_hydro_p_pipeline interface
+
+typedef struct accumulate_hydro_p_pipeline_args
+{
+  MEM_PTR( const particle_t,       128 ) p;        // Particle array
+  MEM_PTR( const particle_block_t, 128 ) pb;       // Or particle blocks
+  MEM_PTR( hydro_t,                128 ) h0;       // Hydro array
+  MEM_PTR( hydro_t,                128 ) h;        // Pipeline hydro slabs
+  MEM_PTR( const interpolator_t,   128 ) f;        // Interpolator array
+  MEM_PTR( const int,              128 ) sfc;      // Voxel storage indices
+  float                                  qdt_2mc;  // Particle/field coupling
+  float                                  qdt_4mc2; // qdt_2mc/(2c)
+  float                                  c;        // Speed of light
+  float                                  qsp;      // Species particle charge
+  float                                  mspc;     // Species particle m c
+  float                                  r8V;      // 1/(8 cell volume)
+  int                                    np;       // Number of particles
+  int                                    i0;       // First node in a slab
+  int                                    nh;       // Number of nodes in a slab
+  int                                    stride;   // Stride between slabs
+  int                                    n_slab;   // Number of slabs
+  int                                    s10;      // Voxel (1,0,0)-(0,0,0)
+  int                                    s21;      // Voxel (0,1,0)-(1,0,0)
+  int                                    s43;      // Voxel (0,0,1)-(1,1,0)
+
+  PAD_STRUCT( 6*SIZEOF_MEM_PTR + 6*sizeof(float) + 8*sizeof(int) )
+
+} accumulate_hydro_p_pipeline_args_t;
+
+// Exactly one of p and pb is non-NULL depending on the particle
+// layout.  Each pipeline, the host included, deposits into its own
+// slab, h + pipeline_rank*stride, where slab element k holds the hydro
+// of node i0+k.  The slabs are then summed into h0 in a fixed order by
+// reduce_hydro_p, so the result is deterministic for a given number of
+// pipelines.  The slabs are scratch that only covers the local nodes; it
+// is allocated on the first accumulate_hydro_p and only ever grown.
+
+// PROTOTYPE_PIPELINE( accumulate_hydro_p, accumulate_hydro_p_pipeline_args_t );
+// PROTOTYPE_PIPELINE( reduce_hydro_p,     accumulate_hydro_p_pipeline_args_t );
+
+void
+accumulate_hydro_p_pipeline_scalar( accumulate_hydro_p_pipeline_args_t * args,
+                                    int pipeline_rank,
+                                    int n_pipeline );
+
+void
+accumulate_hydro_p_pipeline_v4( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline );
+
+void
+accumulate_hydro_p_pipeline_v8( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline );
+
+void
+accumulate_hydro_p_pipeline_v16( accumulate_hydro_p_pipeline_args_t * args,
+                                 int pipeline_rank,
+                                 int n_pipeline );
+
+void
+reduce_hydro_p_pipeline_scalar( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline );
+
+void
+reduce_hydro_p_pipeline( accumulate_hydro_p_pipeline_args_t * args );
+
+///////////////////////////////////////////////////////////////////////////////
+// accumulate_rho_p_pipeline interface
+
+typedef struct accumulate_rho_p_pipeline_args
+{
+  MEM_PTR( const particle_t,       128 ) p;      // Particle array
+  MEM_PTR( const particle_block_t, 128 ) pb;     // Or particle blocks
+  MEM_PTR( field_t,                128 ) f;      // Field array
+  MEM_PTR( float,                  128 ) rho;    // Pipeline rhof slabs
+  float                                  q_8V;   // Species q/(8 cell volume)
+  int                                    np;     // Number of particles
+  int                                    sy;     // Voxel y-stride
+  int                                    sz;     // Voxel z-stride
+  int                                    i0;     // First node in a slab
+  int                                    n;      // Number of nodes in a slab
+  int                                    stride; // Stride between slabs
+  int                                    n_slab; // Number of slabs
+  int                                    clear;  // Clear the slabs first
+  int                                    x0, x1; // Block of nodes reduced
+  int                                    y0, y1; // by reduce_rho_p
+  int                                    z0, z1;
+
+  PAD_STRUCT( 4*SIZEOF_MEM_PTR + sizeof(float) + 14*sizeof(int) )
+
+} accumulate_rho_p_pipeline_args_t;
+
+// Exactly one of p and pb is non-NULL depending on the particle
+// layout.  Each pipeline, the host included, deposits into its own
+// slab, rho + pipeline_rank*stride, where slab element k holds the
+// rhof of node i0+k.  The slabs are cleared first if clear is set,
+// otherwise the charge adds to what an earlier species deposited.  The
+// slabs are then summed into the block of nodes (x0:x1,y0:y1,z0:z1) of
+// f in a fixed order by reduce_rho_p.
+
+// PROTOTYPE_PIPELINE( accumulate_rho_p, accumulate_rho_p_pipeline_args_t );
+// PROTOTYPE_PIPELINE( reduce_rho_p,     accumulate_rho_p_pipeline_args_t );
+
+void
+accumulate_rho_p_pipeline_scalar( accumulate_rho_p_pipeline_args_t * args,
+                                  int pipeline_rank,
+                                  int n_pipeline );
+
+void
+accumulate_rho_p_pipeline_v4( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+void
+accumulate_rho_p_pipeline_v8( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+void
+accumulate_rho_p_pipeline_v16( accumulate_rho_p_pipeline_args_t * args,
+                               int pipeline_rank,
+                               int n_pipeline );
+
+void
+reduce_rho_p_pipeline_scalar( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+void
+reduce_rho_p_pipeline( accumulate_rho_p_pipeline_args_t * args );
+
 ///////////////////////////////////////////////////////////////////////////////
 // sort_p_pipeline interface
 
@@ -200,12 +496,13 @@ typedef struct sort_p_pipeline_args
   /**/ // (0:max_subsort-1,0:MAX_PIPELINE-1)
   MEM_PTR( int,        128 ) partition;        // Partitioning (0:n_voxel)
   MEM_PTR( int,        128 ) next;             // Aux partitioning (0:n_voxel)
+  MEM_PTR( const int,  128 ) sfc;              // Voxel storage indices
   int n;         // Number of particles
   int n_subsort; // Number of pipelines to be used for subsorts
-  int vl, vh;    // Particles may be contained in voxels [vl,vh].
+  int vl, vh;    // Particles may be contained in storage indices [vl,vh].
   int n_voxel;   // Number of voxels total (including ghosts)
 
-  PAD_STRUCT( 5*SIZEOF_MEM_PTR + 5*sizeof(int) )
+  PAD_STRUCT( 6*SIZEOF_MEM_PTR + 5*sizeof(int) )
 
 } sort_p_pipeline_args_t;
 
@@ -213,6 +510,10 @@ typedef struct sort_p_pipeline_args
 // PROTOTYPE_PIPELINE( coarse_sort,  sort_p_pipeline_args_t );
 // PROTOTYPE_PIPELINE( subsort,      sort_p_pipeline_args_t );
 
+// The sort stages are C (partition_tile_p_pipeline uses them from C++)
+
+BEGIN_C_DECLS
+
 void
 coarse_count_pipeline_scalar( sort_p_pipeline_args_t * args,
                               int pipeline_rank,
@@ -228,4 +529,79 @@ subsort_pipeline_scalar( sort_p_pipeline_args_t * args,
                          int pipeline_rank,
                          int n_pipeline );
 
+// AoSoA layout variants (p and aux_p point to particle blocks)
+
+void
+coarse_count_pb_pipeline_scalar( sort_p_pipeline_args_t * args,
+                                 int pipeline_rank,
+                                 int n_pipeline );
+
+void
+coarse_sort_pb_pipeline_scalar( sort_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline );
+
+void
+subsort_pb_pipeline_scalar( sort_p_pipeline_args_t * args,
+                            int pipeline_rank,
+                            int n_pipeline );
+
+END_C_DECLS
+
+// Copies each pipeline's share of an advance of the n particles at aux_p
+// to p (see partition_tile_p_pipeline)
+
+void
+copy_tile_p_pipeline_scalar( sort_p_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline );
+
+void
+copy_tile_pb_pipeline_scalar( sort_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+///////////////////////////////////////////////////////////////////////////////
+// partition_face_p_pipeline interface
+
+typedef struct face_p_pipeline_args
+{
+  MEM_PTR( particle_t,       128 ) p;      // Particle array
+  MEM_PTR( particle_block_t, 128 ) pb;     // Or particle blocks
+  MEM_PTR( const char,       128 ) face;   // Face voxel flags (0:nv-1)
+  MEM_PTR( int,              128 ) count;  // Face particles per pipeline
+  MEM_PTR( int,              128 ) stray;  // Where the strays of a
+  /**/                                     // pipeline are looked for
+  int                              np;     // Number of particles
+  int                              n_face; // Number of face particles
+
+  PAD_STRUCT( 5*SIZEOF_MEM_PTR + 2*sizeof(int) )
+
+} face_p_pipeline_args_t;
+
+// Exactly one of p and pb is non-NULL depending on the particle
+// layout.  count_face_p gives the number of face particles in the share
+// of each pipeline.  With n_face set to their sum, find_stray_p and then
+// partition_face_p swap the interior particles in [0,n_face) with the
+// face particles in [n_face,np) (the strays).
+
+// PROTOTYPE_PIPELINE( count_face_p,     face_p_pipeline_args_t );
+// PROTOTYPE_PIPELINE( find_stray_p,     face_p_pipeline_args_t );
+// PROTOTYPE_PIPELINE( partition_face_p, face_p_pipeline_args_t );
+
+void
+count_face_p_pipeline_scalar( face_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+void
+find_stray_p_pipeline_scalar( face_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+void
+partition_face_p_pipeline_scalar( face_p_pipeline_args_t * args,
+                                  int pipeline_rank,
+                                  int n_pipeline );
+
 #endif // _spa_private_h_
@@ -0,0 +1,235 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+#include <limits.h>
+
+//----------------------------------------------------------------------------//
+// Each pipeline finds the range of accumulators the particles it will
+// advance can touch.  The particles are distributed among the pipelines as
+// in advance_p.  The host accumulates directly to the host accumulator so
+// it has no tile.  The particles of a pipeline can be in any order; the
+// tile is bounded by the storage indices they span plus a halo.
+//----------------------------------------------------------------------------//
+
+void
+tile_p_pipeline_scalar( tile_p_pipeline_args_t * args,
+                        int pipeline_rank,
+                        int n_pipeline )
+{
+  const particle_t       * ALIGNED(32)  p   = args->p0;
+  const particle_block_t * ALIGNED(128) pb  = args->pb0;
+  const int              * ALIGNED(128) nbr = args->nbr;
+
+  int n, n1, v, lo, hi;
+
+  if ( pipeline_rank == n_pipeline ) return;
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n, n1 );
+
+  n1 += n;
+
+  lo = INT_MAX;
+  hi = INT_MIN;
+
+  for( ; n < n1; n++ )
+  {
+    v = pb ? pb[ n / PARTICLE_BLOCK_SIZE ].i[ n % PARTICLE_BLOCK_SIZE ]
+           : p[n].i;
+
+    if ( lo > nbr[2*v  ] ) lo = nbr[2*v  ];
+    if ( hi < nbr[2*v+1] ) hi = nbr[2*v+1];
+  }
+
+  args->tile[pipeline_rank].lo = lo;
+  args->tile[pipeline_rank].hi = hi;
+}
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper tile_p pipeline
+// function.
+//----------------------------------------------------------------------------//
+
+void
+tile_p_pipeline( accumulator_array_t * RESTRICT aa,
+                 const particle_t * p0,
+                 const particle_block_t * pb0,
+                 int np )
+{
+  DECLARE_ALIGNED_ARRAY( tile_p_pipeline_args_t, 128, args, 1 );
+
+  if ( !aa || !aa->tiled || ( !p0 && !pb0 ) || np < 0 )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  args->p0       = pb0 ? NULL : p0;
+  args->pb0      = pb0;
+  args->nbr      = tile_accumulator_ranges( aa );
+  args->tile     = aa->tile;
+  args->np       = np;
+
+  EXEC_PIPELINES( tile_p, args, 0 );
+
+  WAIT_PIPELINES();
+}
+
+//----------------------------------------------------------------------------//
+// Partition the particles to advance by slices of the storage indices of
+// their voxels with the coarse count and coarse sort stages of sort_p.  The particles land in the scratch in partitioned order and each
+// pipeline copies its share of the advance back such that the pages of
+// the particles stay with the pipelines that advance them.  The particles
+// within a slice keep no voxel order.
+//----------------------------------------------------------------------------//
+
+void
+copy_tile_p_pipeline_scalar( sort_p_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline )
+{
+  int n, n1;
+
+  DISTRIBUTE( args->n, 16, pipeline_rank, n_pipeline, n, n1 );
+
+  COPY( args->p + n, args->aux_p + n, n1 );
+}
+
+void
+copy_tile_pb_pipeline_scalar( sort_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  particle_block_t       * RESTRICT ALIGNED(128) pb_dst =
+    (particle_block_t *)args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) pb_src =
+    (const particle_block_t *)args->aux_p;
+
+  int n, n1;
+
+  DISTRIBUTE( args->n, 16, pipeline_rank, n_pipeline, n, n1 );
+
+  n1 += n;
+
+  // Whole blocks, then the particles of the trailing partial block of the
+  // host (the particles of the block past the advance are not ours)
+
+  COPY( pb_dst + n / PARTICLE_BLOCK_SIZE, pb_src + n / PARTICLE_BLOCK_SIZE,
+        ( n1 - n ) / PARTICLE_BLOCK_SIZE );
+
+  for( n += ( ( n1 - n ) / PARTICLE_BLOCK_SIZE )*PARTICLE_BLOCK_SIZE;
+       n < n1; n++ )
+    copy_particle_pb( pb_dst, n, pb_src, n );
+}
+
+void
+partition_tile_p_pipeline( species_t * RESTRICT sp,
+                           int n0,
+                           int n1 )
+{
+  DECLARE_ALIGNED_ARRAY( sort_p_pipeline_args_t, 128, args, 1 );
+
+  static char * ALIGNED(128) scratch = NULL;
+  static size_t          max_scratch = 0;
+
+  // Many more buckets than pipelines such that the shares of the advance,
+  // which split the particles evenly, cut into few voxels of the buckets
+  // next to them
+
+  int n_subsort = 256;
+  int cp_stride = POW2_CEIL( n_subsort, 4 );
+  int pb        = sp && sp->p_layout == particle_layout_aosoa;
+
+  int * RESTRICT ALIGNED(128) coarse_partition;
+
+  size_t sz_scratch;
+  int i, pipeline_rank, subsort, count, sum;
+
+  if ( !sp || n0 < 0 || n0 > n1 || n1 > sp->np ||
+       ( pb && ( n0 % PARTICLE_BLOCK_SIZE ) ) )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  // A single pipeline advances all the particles anyway
+
+  if ( N_PIPELINE == 1 || n0 == n1 ) return;
+
+  // Whole blocks of scratch so the AoSoA kernels can index it as blocks
+
+  sz_scratch = ( sizeof( particle_t ) *
+                 POW2_CEIL( n1 - n0, PARTICLE_BLOCK_SIZE ) +
+                 128                                       +
+                 sizeof( *coarse_partition ) * ( cp_stride * N_PIPELINE + 1 ) );
+
+  if ( sz_scratch > max_scratch )
+  {
+    FREE_ALIGNED( scratch );
+
+    MALLOC_ALIGNED( scratch, sz_scratch, 128 );
+
+    max_scratch = sz_scratch;
+  }
+
+  args->p                = sp->p + n0;
+  args->aux_p            = ALIGN_PTR( particle_t, scratch, 128 );
+  args->coarse_partition = coarse_partition =
+    ALIGN_PTR( int, args->aux_p + POW2_CEIL( n1 - n0, PARTICLE_BLOCK_SIZE ),
+               128 );
+  args->next             = NULL;
+  args->partition        = NULL;
+  args->sfc              = sp->g->sfc;
+  args->n                = n1 - n0;
+  args->n_subsort        = n_subsort;
+  args->vl               = sp->g->sfc_lo;
+  args->vh               = sp->g->sfc_hi;
+  args->n_voxel          = sp->g->nv;
+
+  if ( pb )
+  {
+    EXEC_PIPELINES( coarse_count_pb, args, 0 );
+  }
+  else
+  {
+    EXEC_PIPELINES( coarse_count, args, 0 );
+  }
+
+  WAIT_PIPELINES();
+
+  // Convert the coarse count into a coarse partitioning (see sort_p).
+
+  sum = 0;
+  for( subsort = 0; subsort < n_subsort; subsort++ )
+  {
+    for( pipeline_rank = 0; pipeline_rank < N_PIPELINE; pipeline_rank++ )
+    {
+      i                   = subsort + cp_stride * pipeline_rank;
+      count               = coarse_partition[i];
+      coarse_partition[i] = sum;
+      sum                += count;
+    }
+  }
+
+  if ( pb )
+  {
+    EXEC_PIPELINES( coarse_sort_pb, args, 0 );
+  }
+  else
+  {
+    EXEC_PIPELINES( coarse_sort, args, 0 );
+  }
+
+  WAIT_PIPELINES();
+
+  if ( pb )
+  {
+    EXEC_PIPELINES( copy_tile_pb, args, 0 );
+  }
+  else
+  {
+    EXEC_PIPELINES( copy_tile_p, args, 0 );
+  }
+
+  WAIT_PIPELINES();
+}
@@ -12,6 +12,7 @@ uncenter_p_pipeline_v16( center_p_pipeline_args_t * args,
                          int n_pipeline )
 {
   const interpolator_t * ALIGNED(128) f0 = args->f0;
+  const int            * ALIGNED(128) sfc = args->sfc;
 
   particle_t           * ALIGNED(128) p;
 
@@ -67,22 +68,22 @@ uncenter_p_pipeline_v16( center_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
     //--------------------------------------------------------------------------
-    vp00 = ( const float * ALIGNED(64) ) ( f0 + ii( 0) );
-    vp01 = ( const float * ALIGNED(64) ) ( f0 + ii( 1) );
-    vp02 = ( const float * ALIGNED(64) ) ( f0 + ii( 2) );
-    vp03 = ( const float * ALIGNED(64) ) ( f0 + ii( 3) );
-    vp04 = ( const float * ALIGNED(64) ) ( f0 + ii( 4) );
-    vp05 = ( const float * ALIGNED(64) ) ( f0 + ii( 5) );
-    vp06 = ( const float * ALIGNED(64) ) ( f0 + ii( 6) );
-    vp07 = ( const float * ALIGNED(64) ) ( f0 + ii( 7) );
-    vp08 = ( const float * ALIGNED(64) ) ( f0 + ii( 8) );
-    vp09 = ( const float * ALIGNED(64) ) ( f0 + ii( 9) );
-    vp10 = ( const float * ALIGNED(64) ) ( f0 + ii(10) );
-    vp11 = ( const float * ALIGNED(64) ) ( f0 + ii(11) );
-    vp12 = ( const float * ALIGNED(64) ) ( f0 + ii(12) );
-    vp13 = ( const float * ALIGNED(64) ) ( f0 + ii(13) );
-    vp14 = ( const float * ALIGNED(64) ) ( f0 + ii(14) );
-    vp15 = ( const float * ALIGNED(64) ) ( f0 + ii(15) );
+    vp00 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii( 0) ] );
+    vp01 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii( 1) ] );
+    vp02 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii( 2) ] );
+    vp03 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii( 3) ] );
+    vp04 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii( 4) ] );
+    vp05 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii( 5) ] );
+    vp06 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii( 6) ] );
+    vp07 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii( 7) ] );
+    vp08 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii( 8) ] );
+    vp09 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii( 9) ] );
+    vp10 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii(10) ] );
+    vp11 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii(11) ] );
+    vp12 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii(12) ] );
+    vp13 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii(13) ] );
+    vp14 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii(14) ] );
+    vp15 = ( const float * ALIGNED(64) ) ( f0 + sfc[ ii(15) ] );
 
     //--------------------------------------------------------------------------
     // Load interpolation data for particles.
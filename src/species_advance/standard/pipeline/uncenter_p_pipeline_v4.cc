@@ -12,6 +12,7 @@ uncenter_p_pipeline_v4( center_p_pipeline_args_t * args,
                         int n_pipeline )
 {
   const interpolator_t * ALIGNED(128) f0 = args->f0;
+  const int            * ALIGNED(128) sfc = args->sfc;
 
   particle_t           * ALIGNED(128) p;
 
@@ -54,10 +55,10 @@ uncenter_p_pipeline_v4( center_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
     //--------------------------------------------------------------------------
-    vp00 = ( const float * ALIGNED(16) ) ( f0 + ii(0) );
-    vp01 = ( const float * ALIGNED(16) ) ( f0 + ii(1) );
-    vp02 = ( const float * ALIGNED(16) ) ( f0 + ii(2) );
-    vp03 = ( const float * ALIGNED(16) ) ( f0 + ii(3) );
+    vp00 = ( const float * ALIGNED(16) ) ( f0 + sfc[ ii(0) ] );
+    vp01 = ( const float * ALIGNED(16) ) ( f0 + sfc[ ii(1) ] );
+    vp02 = ( const float * ALIGNED(16) ) ( f0 + sfc[ ii(2) ] );
+    vp03 = ( const float * ALIGNED(16) ) ( f0 + sfc[ ii(3) ] );
 
     //--------------------------------------------------------------------------
     // Load interpolation data for particles.
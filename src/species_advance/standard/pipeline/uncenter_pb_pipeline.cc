@@ -0,0 +1,133 @@
+#define IN_spa
+
+#define HAS_V16_PIPELINE
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Reference implementation for an uncenter_p pipeline function for particles
+// in the AoSoA layout which does not make use of explicit calls to vector
+// intrinsic functions.
+//----------------------------------------------------------------------------//
+
+void
+uncenter_pb_pipeline_scalar( center_p_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline )
+{
+  const interpolator_t * ALIGNED(128) f0 = args->f0;
+  const int            * ALIGNED(128) sfc = args->sfc;
+
+  particle_block_t     * ALIGNED(128) pb0 = (particle_block_t *)args->p0;
+  particle_block_t     * ALIGNED(128) pb;
+
+  const interpolator_t * ALIGNED(16)  f;
+
+  const float qdt_2mc        =     -args->qdt_2mc; // For backward half advance
+  const float qdt_4mc        = -0.5*args->qdt_2mc; // For backward half rotate
+  const float one            = 1.0;
+  const float one_third      = 1.0/3.0;
+  const float two_fifteenths = 2.0/15.0;
+
+  float dx, dy, dz, ux, uy, uz;
+  float hax, hay, haz, cbx, cby, cbz;
+  float v0, v1, v2, v3, v4;
+  int   ii, j;
+
+  int k, n;
+
+  // Determine which particles this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, k, n );
+
+  // Process particles for this pipeline.
+
+  for( ; n; n--, k++ )
+  {
+    pb   = pb0 + k / PARTICLE_BLOCK_SIZE;    // Find particle lane
+    j    = k % PARTICLE_BLOCK_SIZE;
+
+    dx   = pb->dx[j];                        // Load position
+    dy   = pb->dy[j];
+    dz   = pb->dz[j];
+    ii   = pb->i[j];
+
+    f    = f0 + sfc[ii];                     // Interpolate E
+
+    hax  = qdt_2mc*(    ( f->ex    + dy*f->dexdy    ) +
+                     dz*( f->dexdz + dy*f->d2exdydz ) );
+
+    hay  = qdt_2mc*(    ( f->ey    + dz*f->deydz    ) +
+                     dx*( f->deydx + dz*f->d2eydzdx ) );
+
+    haz  = qdt_2mc*(    ( f->ez    + dx*f->dezdx    ) +
+                     dy*( f->dezdy + dx*f->d2ezdxdy ) );
+
+    cbx  = f->cbx + dx*f->dcbxdx;            // Interpolate B
+    cby  = f->cby + dy*f->dcbydy;
+    cbz  = f->cbz + dz*f->dcbzdz;
+
+    ux   = pb->ux[j];                        // Load momentum
+    uy   = pb->uy[j];
+    uz   = pb->uz[j];
+
+    v0   = qdt_4mc/(float)sqrt(one + (ux*ux + (uy*uy + uz*uz)));
+    /**/                                     // Boris - scalars
+    v1   = cbx*cbx + (cby*cby + cbz*cbz);
+    v2   = (v0*v0)*v1;
+    v3   = v0*(one+v2*(one_third+v2*two_fifteenths));
+    v4   = v3/(one+v1*(v3*v3));
+    v4  += v4;
+
+    v0   = ux + v3*( uy*cbz - uz*cby );      // Boris - uprime
+    v1   = uy + v3*( uz*cbx - ux*cbz );
+    v2   = uz + v3*( ux*cby - uy*cbx );
+
+    ux  += v4*( v1*cbz - v2*cby );           // Boris - rotation
+    uy  += v4*( v2*cbx - v0*cbz );
+    uz  += v4*( v0*cby - v1*cbx );
+
+    ux  += hax;                              // Half advance E
+    uy  += hay;
+    uz  += haz;
+
+    pb->ux[j] = ux;                          // Store momentum
+    pb->uy[j] = uy;
+    pb->uz[j] = uz;
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper uncenter_pb pipeline
+// function.  The particles must be in the AoSoA layout.
+//----------------------------------------------------------------------------//
+
+void
+uncenter_pb_pipeline( species_t * RESTRICT sp,
+                      const interpolator_array_t * RESTRICT ia )
+{
+  DECLARE_ALIGNED_ARRAY( center_p_pipeline_args_t, 128, args, 1 );
+
+  if ( !sp ||
+       !ia ||
+       sp->g != ia->g ||
+       sp->p_layout != particle_layout_aosoa )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  // Have the pipelines do the bulk of particles in blocks and have the
+  // host do the final incomplete block.
+
+  args->p0      = sp->p;
+  args->f0      = ia->i;
+  args->sfc     = ia->g->sfc;
+  args->qdt_2mc = (sp->q*sp->g->dt)/(2*sp->m*sp->g->cvac);
+  args->np      = sp->np;
+
+  EXEC_PIPELINES( uncenter_pb, args, 0 );
+
+  WAIT_PIPELINES();
+}
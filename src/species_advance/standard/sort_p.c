@@ -27,6 +27,10 @@ sort_p( species_t * sp )
   if ( !sp )
     ERROR( ( "Bad args" ) );
 
+  // The legacy sort only handles AoS particles.  The next advance_p
+  // converts them back to the preferred layout.
+  convert_p( sp, particle_layout_aos );
+
   sp->last_sorted = sp->g->step;
 
   particle_t * ALIGNED(128) p = sp->p;
@@ -37,6 +41,8 @@ sort_p( species_t * sp )
 
   int * RESTRICT ALIGNED(128) partition = sp->partition;
 
+  const int * RESTRICT ALIGNED(128) sfc = sp->g->sfc;
+
   static int * RESTRICT ALIGNED(128) next = NULL;
 
   static int max_nc1 = 0;
@@ -68,7 +74,7 @@ sort_p( species_t * sp )
 
   for( i = 0; i < np; i++ )
   {
-    next[ p[i].i ]++;
+    next[ sfc[ p[i].i ] ]++;
   }
 
   // Convert the count to a partitioning and save a copy in next.
@@ -90,14 +96,21 @@ sort_p( species_t * sp )
 
     MALLOC_ALIGNED( new_p, sp->max_np, 128 );
 
+    // Keep the pages where the pipelines that advance them are (see
+    // pipeline_affinity).  The pushers split the np particles, not max_np.
+
+    if ( pipeline_affinity )
+      clear_pipelines( new_p, sizeof(particle_t), np, 16 );
+
     in_p  = sp->p;
     out_p = new_p;
 
     for( i = 0; i < np; i++ )
     {
-      out_p[ next[ in_p[i].i ]++ ] = in_p[i];
+      out_p[ next[ sfc[ in_p[i].i ] ]++ ] = in_p[i];
     }
 
+    unplace_pipelines( sp->p );
     FREE_ALIGNED( sp->p );
 
     sp->p = new_p;
@@ -125,7 +138,7 @@ sort_p( species_t * sp )
 
         for( ; ; )
         {
-          dest = &p[ next[ src->i ]++ ];
+          dest = &p[ next[ sfc[ src->i ] ]++ ];
 
           if ( src == dest ) break;
 
@@ -135,6 +148,12 @@ sort_p( species_t * sp )
         }
       }
     }
+
+    // The pages of the particles stay with the pipelines that advance
+    // them; this only moves pages if the particles were placed for another
+    // number of particles (see place_pipelines).
+
+    place_pipelines( p, sizeof(particle_t), np, 16 );
   }
 }
 
@@ -159,7 +178,22 @@ sort_p( species_t * sp )
   }
 
   // Conditionally execute this when more abstractions are available.
-  sort_p_pipeline( sp );
+  if ( sp->layout == particle_layout_aosoa )
+  {
+    convert_p( sp, particle_layout_aosoa );
+
+    sort_pb_pipeline( sp );
+  }
+
+  else
+  {
+    sort_p_pipeline( sp );
+  }
+
+  // The number of particles may have changed since they were placed; only
+  // the pages whose pipeline changed move (see place_pipelines)
+
+  place_pipelines( sp->p, sizeof(particle_t), sp->np, 16 );
 }
 
 #endif
@@ -13,6 +13,15 @@ uncenter_p( species_t * RESTRICT sp,
             const interpolator_array_t * RESTRICT ia )
 {
   // Once more options are available, this should be conditionally executed
-  // based on user choice.
-  uncenter_p_pipeline( sp, ia );
+  // based on user choice.  The particles are uncentered in whatever layout
+  // they are currently in.
+  if ( sp->p_layout == particle_layout_aosoa )
+  {
+    uncenter_pb_pipeline( sp, ia );
+  }
+
+  else
+  {
+    uncenter_p_pipeline( sp, ia );
+  }
 }
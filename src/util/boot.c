@@ -21,8 +21,8 @@ boot_services( int * pargc,
   // cores if threads are booted _after_ MPI is initialized.  So we
   // start up the pipeline dispatchers _before_ starting up MPI.
 
-  // FIXME: The thread utilities should take responsibility for
-  // thread-core affinity instead of leaving this to chance.
+  // Use --affinity to bind the pipelines to cores instead of leaving
+  // this to chance (see boot_pipeline_affinity).
 
   // Boot up the communications layer
 
@@ -43,6 +43,23 @@ boot_services( int * pargc,
 
 #endif
 
+  // Select the simd pipelines to run.  This is done after the
+  // communications layer is up so it can be reported once.
+
+  boot_simd( pargc, pargv );
+
+  // Set the number of chunks per pipeline for dynamic scheduling
+
+  boot_pipeline_work( pargc, pargv );
+
+  // Report where the pipelines run (if bound)
+
+  log_pipeline_affinity();
+
+  // Start up the profile timeline (if requested)
+
+  boot_profile( pargc, pargv );
+
   // Set the boot_timestamp
 
   mp_barrier();
@@ -57,6 +74,8 @@ halt_services( void )
 {
   _boot_timestamp = 0;
 
+  halt_profile();
+
 #if defined(VPIC_USE_PTHREADS)
   #if defined(VPIC_SWAP_MPI_PTHREAD_INIT)
     thread.halt();
@@ -23,6 +23,11 @@ static int booted = 0;
 static checkpt_t * checkpt = NULL;
 static checkpt_t * restore = NULL;
 
+/* Nonzero while restoring from a stream written by another rank (see
+   restore_remapped). */
+
+static int remapped = 0;
+
 /* The registry is a list of objects that need to checkpointed (in the
    order they should be checkpointed).  The registry gives each object
    a unique identifier that is invariant across a checkpt/restore and
@@ -44,6 +49,64 @@ static registry_t * registry = NULL;
 
 static size_t next_id = 1;
 
+/* Symbols given a name with register_symbol.  These are registered
+   before main runs, so this list is not touched by boot_checkpt and
+   halt_checkpt. */
+
+typedef struct symbol {
+  const char * name;
+  const void * saddr;
+  struct symbol * next;
+} symbol_t;
+
+static symbol_t * symbol = NULL;
+
+/* The sizes of the types whose arrays are checkpointed raw (see
+   register_layout) */
+
+typedef struct layout {
+  const char * name;
+  size_t size;
+  struct layout * next;
+} layout_t;
+
+static layout_t * layout = NULL;
+
+/* A checkpt stream starts with the format magic, the format version,
+   next_id and the name and size of each registered layout.  Each
+   object follows in its own section.  A section
+   starts with the section magic, the object's id and the name of its
+   checkpt function, followed by the object header, the object's
+   registry entry and whatever the object's checkpt function writes.
+   The sections are followed by the end marker, a table of contents
+   giving the id, offset and size of each section, and a trailer giving
+   the offset of the table of contents.  Streams without the format
+   magic are read as legacy streams (next_id followed by object headers
+   and entries). */
+
+#define FORMAT_MAGIC   ((size_t)0xF0F3A7C2)
+#define FORMAT_VERSION ((size_t)4)
+#define SECTION_MAGIC  ((size_t)0x5EC7104)
+#define TOC_MAGIC      ((size_t)0x70C70C)
+
+static const char *
+symbol_name( const void * saddr ) {
+  symbol_t * node;
+  if( !saddr ) return NULL;
+  for( node=symbol; node; node=node->next )
+    if( node->saddr==saddr ) return node->name;
+  return NULL;
+}
+
+static void *
+symbol_addr( const char * name ) {
+  symbol_t * node;
+  if( !name ) return NULL;
+  for( node=symbol; node; node=node->next )
+    if( !strcmp( node->name, name ) ) return (void *)node->saddr;
+  return NULL;
+}
+
 #ifdef VERBOSE_CHECKPOINTING
 
 static void
@@ -106,6 +169,16 @@ boot_checkpt( int * pargc,
   restore  = NULL;
   next_id  = 1;
 
+  /* Set up how checkpts are written */
+
+  if( pargc && pargv )
+    set_checkpt_striping( strip_cmdline_int( pargc, pargv,
+                                              "--checkpt-files", 0 ),
+                          strip_cmdline_int( pargc, pargv,
+                                             "--checkpt-chunk", 8<<20 ) );
+  if( pargc && pargv )
+    set_checkpt_async( strip_cmdline( pargc, pargv, "--checkpt-async" ) );
+
   /* Mark the service as booted */
 
   booted = 1;
@@ -117,6 +190,11 @@ halt_checkpt( void ) {
   /* Check input args */
 
   if( !booted  ) ERROR(( "checkpt service not booted." ));
+
+  /* Finish writing the last snapshot */
+
+  halt_checkpt_io();
+
   if( registry ) {
     dump_registry();
     ERROR(( "halt called with some objects still registered" ));
@@ -237,45 +315,139 @@ unregister_object( void * obj ) {
 }
 
 void
-checkpt_objects( const char * name ) {
-  registry_t * node;
+register_symbol( const char * name,
+                 const void * saddr ) {
+  symbol_t * node;
+
+  if( !name || !saddr ) ERROR(( "Bad args" ));
+
+  for( node=symbol; node; node=node->next )
+    if( !strcmp( node->name, name ) ) break;
+  if( node ) {
+    if( node->saddr!=saddr )
+      ERROR(( "Symbol \"%s\" already registered for a different address",
+              name ));
+    return;
+  }
 
-  /* Check input args */
+  MALLOC( node, 1 );
+  node->name  = name;
+  node->saddr = saddr;
+  node->next  = symbol;
+  symbol = node;
+}
 
-  if( !booted ) ERROR(( "checkpt not booted" ));
-  if( checkpt ) ERROR(( "currently writing a checkpt" ));
-  if( restore ) ERROR(( "currently reading a checkpt" ));
+void
+register_layout( const char * name,
+                 size_t size ) {
+  layout_t * node;
+
+  if( !name || !size ) ERROR(( "Bad args" ));
+
+  for( node=layout; node; node=node->next )
+    if( !strcmp( node->name, name ) ) break;
+  if( node ) {
+    if( node->size!=size )
+      ERROR(( "Layout \"%s\" already registered with a different size",
+              name ));
+    return;
+  }
 
-  /* Open the checkpt serialization stream */
+  MALLOC( node, 1 );
+  node->name = name;
+  node->size = size;
+  node->next = layout;
+  layout = node;
+}
 
-  checkpt = checkpt_open_wronly( name );
-  CHECKPT_VAL( size_t, next_id );
+static void
+checkpt_registry( void ) {
+  registry_t * node;
+  layout_t * lnode;
+  size_t * toc, n, off;
+
+  CHECKPT_VAL( size_t, FORMAT_MAGIC   );
+  CHECKPT_VAL( size_t, FORMAT_VERSION );
+  CHECKPT_VAL( size_t, next_id        );
+
+  n = 0;
+  for( lnode=layout; lnode; lnode=lnode->next ) n++;
+  CHECKPT_VAL( size_t, n );
+  for( lnode=layout; lnode; lnode=lnode->next ) {
+    checkpt_str( lnode->name );
+    CHECKPT_VAL( size_t, lnode->size );
+  }
+
+  n = 0;
+  for( node=registry; node; node=node->next ) n++;
+  MALLOC( toc, 3*n+1 );
 
   /* Checkpoint the objects */
 
+  n = 0;
   for( node=registry; node; node=node->next ) {
     dump_node( node );
+    off = checkpt_tell( checkpt );
+    CHECKPT_VAL( size_t, SECTION_MAGIC );
+    CHECKPT_VAL( size_t, node->id );
+    checkpt_str( symbol_name( (void *)(size_t)node->checkpt_func ) );
     CHECKPT_VAL( size_t, 0x600DF00D );
     checkpt_raw( node, sizeof(*node) );
     checkpt_sym( (void *)(size_t)node->checkpt_func   );
     checkpt_sym( (void *)(size_t)node->restore_func   );
     checkpt_sym( (void *)(size_t)node->reanimate_func );
     if( node->checkpt_func ) node->checkpt_func( node->obj );
+    toc[3*n  ] = node->id;
+    toc[3*n+1] = off;
+    toc[3*n+2] = checkpt_tell( checkpt ) - off;
+    n++;
   }
 
-  /* Mark that there are no more objects in the stream, close the
-     serialization stream and indicate that we are no longer writing a
-     checkpt */
-  
+  /* Mark that there are no more objects in the stream */
+
   CHECKPT_VAL( size_t, 0xBADF00D );
-  checkpt_close( checkpt );
-  checkpt = NULL;
+
+  /* Write the table of contents and the trailer */
+
+  off = checkpt_tell( checkpt );
+  CHECKPT_VAL( size_t, n );
+  checkpt_raw( toc, 3*n*sizeof(size_t) );
+  CHECKPT_VAL( size_t, off );
+  CHECKPT_VAL( size_t, TOC_MAGIC );
+
+  FREE( toc );
+}
+
+/* Read the registry entry of the object whose header is next in the
+   stream */
+
+static void
+restore_entry( registry_t * node ) {
+  restore_raw( node, sizeof(*node) );
+  node->checkpt_func   = (checkpt_func_t)  (size_t)restore_sym();
+  node->restore_func   = (restore_func_t)  (size_t)restore_sym();
+  node->reanimate_func = (reanimate_func_t)(size_t)restore_sym();
+  node->next = NULL;
+}
+
+/* Restore the object whose header is next in the stream and append it
+   to the registry. */
+
+static registry_t *
+restore_node( registry_t * prev ) {
+  registry_t * node;
+  MALLOC( node, 1 );
+  restore_entry( node );
+  if( !registry ) registry = node;
+  if( prev ) prev->next = node;
+  dump_node( node );
+  if( node->restore_func ) node->obj = node->restore_func();
+  return node;
 }
 
 void
-restore_objects( const char * name ) {
-  registry_t * node, * prev;
-  size_t prefix;
+checkpt_objects( const char * name ) {
+  size_t sz = 0;
 
   /* Check input args */
 
@@ -283,6 +455,129 @@ restore_objects( const char * name ) {
   if( checkpt ) ERROR(( "currently writing a checkpt" ));
   if( restore ) ERROR(( "currently reading a checkpt" ));
 
+  /* The last snapshot of any rank might still be going to a file this
+     checkpt overwrites */
+
+  wait_checkpt();
+
+  /* Snapshots are sized by serializing them */
+
+  if( checkpt_async() ) {
+    checkpt = checkpt_open_snapshot();
+    checkpt_registry();
+    checkpt_drain( checkpt, name );
+    checkpt = NULL;
+    return;
+  }
+
+  /* When ranks share a file, where a rank's stream goes depends on the
+     size of the streams of the ranks before it.  Size the stream with a
+     dry run that does no I/O. */
+
+  if( checkpt_aggregated() ) {
+    checkpt = checkpt_open_count();
+    checkpt_registry();
+    sz = checkpt_tell( checkpt );
+    checkpt_close( checkpt );
+    checkpt = NULL;
+  }
+
+  /* Open the checkpt serialization stream, checkpoint the objects, close
+     the serialization stream and indicate that we are no longer writing
+     a checkpt */
+
+  checkpt = checkpt_open_wronly( name, sz );
+  checkpt_registry();
+  checkpt_close( checkpt );
+  checkpt = NULL;
+}
+
+/* Read the table of contents of a stream (n gets the number of
+   sections) */
+
+static size_t *
+restore_toc( size_t * _n ) {
+  size_t * toc, n, off, magic;
+  n = checkpt_size( restore );
+  if( n<2*sizeof(size_t) ) ERROR(( "Malformed checkpt (truncated)" ));
+  checkpt_seek( restore, n-2*sizeof(size_t) );
+  RESTORE_VAL( size_t, off   );
+  RESTORE_VAL( size_t, magic );
+  if( magic!=TOC_MAGIC || off>n )
+    ERROR(( "Malformed checkpt (expected a trailer)" ));
+  checkpt_seek( restore, off );
+  RESTORE_VAL( size_t, n );
+  MALLOC( toc, 3*n+1 );
+  restore_raw( toc, 3*n*sizeof(size_t) );
+  *_n = n;
+  return toc;
+}
+
+/* Read the header of the section of object id and the object header
+   that starts it.  Returns the type of the section (the caller frees
+   it). */
+
+static char *
+restore_section( size_t id ) {
+  size_t prefix;
+  char * type;
+  RESTORE_VAL( size_t, prefix );
+  if( prefix!=SECTION_MAGIC )
+    ERROR(( "Malformed checkpt (expected a section header)" ));
+  RESTORE_VAL( size_t, prefix );
+  if( prefix!=id )
+    ERROR(( "Malformed checkpt (section of object %lu holds object %lu)",
+            (unsigned long)id, (unsigned long)prefix ));
+  type = restore_str();
+  RESTORE_VAL( size_t, prefix );
+  if( prefix!=0x600DF00D )
+    ERROR(( "Malformed checkpt (expected an object header)" ));
+  return type;
+}
+
+/* Check the stream starts with the format header, read next_id and
+   check the layouts the stream was written with match this build.  The
+   objects restore their arrays raw, so a type whose size differs (e.g.
+   particle_t with and without particle tags) can not be restored.
+   Types whose padding depends on the build (e.g. on the SIMD width) are
+   checkpointed and registered without it (see restore_data_strided). */
+
+static size_t
+restore_format( size_t prefix ) {
+  layout_t * node;
+  size_t id, n, size;
+  char * name;
+  if( prefix!=FORMAT_MAGIC )
+    ERROR(( "Checkpt predates the sectioned checkpt format" ));
+  RESTORE_VAL( size_t, prefix );
+  if( prefix!=FORMAT_VERSION )
+    ERROR(( "Checkpt has format version %lu (expected %lu)",
+            (unsigned long)prefix, (unsigned long)FORMAT_VERSION ));
+  RESTORE_VAL( size_t, id );
+  RESTORE_VAL( size_t, n );
+  for( ; n; n-- ) {
+    name = restore_str();
+    RESTORE_VAL( size_t, size );
+    if( !name ) ERROR(( "Malformed checkpt (expected a layout name)" ));
+    for( node=layout; node; node=node->next )
+      if( !strcmp( node->name, name ) ) break;
+    if( node && node->size!=size )
+      ERROR(( "Checkpt was written with a %lu byte %s but this build has "
+              "a %lu byte %s", (unsigned long)size, name,
+              (unsigned long)node->size, name ));
+    FREE( name );
+  }
+  return id;
+}
+
+/* Replace the registered objects with the objects in a stream */
+
+static void
+restore_stream( checkpt_t * stream ) {
+  registry_t * node, * prev;
+  size_t prefix, * toc, n, i;
+  char * type;
+
   /* Delete all objects in the in favor of the checkpointed objects */
 
   node = registry;
@@ -294,30 +589,45 @@ restore_objects( const char * name ) {
   registry = NULL;
   next_id = 0;
 
-  /* Open the checkpt deserialization stream */
+  /* Read the objects from the stream */
 
-  restore = checkpt_open_rdonly( name );
-  RESTORE_VAL( size_t, next_id );
+  restore = stream;
+  RESTORE_VAL( size_t, prefix );
+  prev = NULL;
 
-  /* Restore the objects */
+  if( prefix!=FORMAT_MAGIC ) {
 
-  prev = NULL;
-  for(;;) {
-    RESTORE_VAL( size_t, prefix );
-    if( prefix== 0xBADF00D ) break;
-    if( prefix!=0x600DF00D )
-      ERROR(( "Malformed checkpt (expected an object header)" ));
-    MALLOC( node, 1 );
-    restore_raw( node, sizeof(*node) );
-    node->checkpt_func   = (checkpt_func_t)  (size_t)restore_sym();
-    node->restore_func   = (restore_func_t)  (size_t)restore_sym();
-    node->reanimate_func = (reanimate_func_t)(size_t)restore_sym();
-    node->next = NULL;
-    if( !registry ) registry = node;
-    if( prev ) prev->next = node;
-    prev = node;
-    dump_node( node );
-    if( node->restore_func ) node->obj = node->restore_func();
+    /* Legacy stream: restore the objects in order */
+
+    next_id = prefix;
+    for(;;) {
+      RESTORE_VAL( size_t, prefix );
+      if( prefix== 0xBADF00D ) break;
+      if( prefix!=0x600DF00D )
+        ERROR(( "Malformed checkpt (expected an object header)" ));
+      prev = restore_node( prev );
+    }
+
+  } else {
+
+    next_id = restore_format( prefix );
+
+    /* Restore the objects section by section */
+
+    toc = restore_toc( &n );
+    for( i=0; i<n; i++ ) {
+      checkpt_seek( restore, toc[3*i+1] );
+      type = restore_section( toc[3*i] );
+      prev = restore_node( prev );
+      if( checkpt_tell( restore )-toc[3*i+1]!=toc[3*i+2] )
+        ERROR(( "Object %lu (%s) restored %lu bytes of its %lu byte section",
+                (unsigned long)toc[3*i], type ? type : "untyped",
+                (unsigned long)( checkpt_tell( restore )-toc[3*i+1] ),
+                (unsigned long)toc[3*i+2] ));
+      FREE( type );
+    }
+
+    FREE( toc );
   }
 
   /* Close the checkpt deserialization stream and indicate that we are
@@ -327,6 +637,92 @@ restore_objects( const char * name ) {
   restore = NULL;
 }
 
+void
+restore_objects( const char * name ) {
+
+  /* Check input args */
+
+  if( !booted ) ERROR(( "checkpt not booted" ));
+  if( checkpt ) ERROR(( "currently writing a checkpt" ));
+  if( restore ) ERROR(( "currently reading a checkpt" ));
+
+  /* The checkpt might be a snapshot some rank is still writing */
+
+  wait_checkpt();
+
+  restore_stream( checkpt_open_rdonly( name ) );
+}
+
+void
+restore_remapped_objects( const char * name,
+                          int rank ) {
+
+  /* Check input args */
+
+  if( !booted ) ERROR(( "checkpt not booted" ));
+  if( checkpt ) ERROR(( "currently writing a checkpt" ));
+  if( restore ) ERROR(( "currently reading a checkpt" ));
+
+  checkpt_wait_drain();
+
+  remapped = 1;
+  restore_stream( checkpt_open_rank( name, rank ) );
+  remapped = 0;
+}
+
+void *
+restore_object( const char * name,
+                int rank,
+                const void * obj ) {
+  registry_t node[1];
+  size_t id, prefix, * toc, n, i;
+  char * type;
+  void * copy;
+
+  /* Check input args */
+
+  if( !booted ) ERROR(( "checkpt not booted" ));
+  if( checkpt ) ERROR(( "currently writing a checkpt" ));
+  if( restore ) ERROR(( "currently reading a checkpt" ));
+
+  id = object_id( obj );
+  if( !id ) ERROR(( "object is not registered" ));
+
+  checkpt_wait_drain();
+
+  /* Find the section of the object */
+
+  remapped = 1;
+  restore  = checkpt_open_rank( name, rank );
+  RESTORE_VAL( size_t, prefix );
+  restore_format( prefix );
+  toc = restore_toc( &n );
+  for( i=0; i<n; i++ ) if( toc[3*i]==id ) break;
+  if( i==n )
+    ERROR(( "Checkpt \"%s\" has no object %lu for rank %i", name,
+            (unsigned long)id, rank ));
+
+  /* And restore it */
+
+  checkpt_seek( restore, toc[3*i+1] );
+  type = restore_section( id );
+  restore_entry( node );
+  copy = node->restore_func ? node->restore_func() : NULL;
+
+  FREE( type );
+  FREE( toc );
+  checkpt_close( restore );
+  restore  = NULL;
+  remapped = 0;
+  return copy;
+}
+
+int
+restore_remapped( void ) {
+  return remapped;
+}
+
+
 void
 reanimate_objects( void ) {
   registry_t * node;
@@ -399,9 +795,11 @@ checkpt_data( const void * _data,
   CHECKPT_VAL( size_t, n_ele  ); CHECKPT_VAL( size_t, max_ele );
   CHECKPT_VAL( size_t, align  );
 
-  /* Write out the individual elements */
+  /* Write out the individual elements (in one piece if they are
+     contiguous) */
 
-  for( n=0; n<n_ele; n++ ) checkpt_raw( data+n*str_ele, sz_ele );
+  if( sz_ele==str_ele ) checkpt_raw( data, n_ele*sz_ele );
+  else for( n=0; n<n_ele; n++ ) checkpt_raw( data+n*str_ele, sz_ele );
 }
 
 void *
@@ -426,7 +824,38 @@ restore_data( void ) {
 
   /* And read in the checkpointed elements */
 
-  for( n=0; n<n_ele; n++ ) restore_raw( data+n*str_ele, sz_ele );
+  if( sz_ele==str_ele ) restore_raw( data, n_ele*sz_ele );
+  else for( n=0; n<n_ele; n++ ) restore_raw( data+n*str_ele, sz_ele );
+  return data;
+}
+
+void *
+restore_data_strided( size_t str ) {
+  char * data;
+  size_t n, sz_ele, str_ele, n_ele, max_ele, align;
+
+  /* Read the data header */
+
+  RESTORE_VAL( size_t, n );
+  if( n!=0xDA7A ) ERROR(( "malformed checkpt (expected a data header)" ));
+  RESTORE_VAL( size_t, sz_ele ); RESTORE_VAL( size_t, str_ele );
+  RESTORE_VAL( size_t, n_ele  ); RESTORE_VAL( size_t, max_ele );
+  RESTORE_VAL( size_t, align  );
+  if( n_ele>max_ele || sz_ele>str_ele )
+    ERROR(( "malformed checkpt (invalid data layout)" ));
+  if( sz_ele>str )
+    ERROR(( "Checkpt has %lu byte elements which do not fit in %lu bytes",
+            (unsigned long)sz_ele, (unsigned long)str ));
+
+  /* Allocate the data with this build's stride and read in the
+     checkpointed elements */
+
+  if( align==0 ) MALLOC(         data, max_ele*str        );
+  else           MALLOC_ALIGNED( data, max_ele*str, align );
+  if( sz_ele<str ) CLEAR( data, n_ele*str );
+
+  if( sz_ele==str ) restore_raw( data, n_ele*sz_ele );
+  else for( n=0; n<n_ele; n++ ) restore_raw( data+n*str, sz_ele );
   return data;
 }
 
@@ -537,11 +966,24 @@ restore_ptr( void ) {
   return reanimate_fptr( restore_fptr() );
 }
 
+/* Named symbols are written as a named symbol header and the name */
+
+static int
+checkpt_named_sym( const void * saddr ) {
+  const char * name = symbol_name( saddr );
+  if( !name ) return 0;
+  CHECKPT_VAL( size_t, 0x4E4D513B );
+  checkpt_str( name );
+  return 1;
+}
+
 #ifdef NO_REVERSE_SYMBOL_TABLE_LOOKUP_SUPPORT
 
 void
 checkpt_sym( const void * saddr ) {
 
+  if( checkpt_named_sym( saddr ) ) return;
+
   /* If symbol address is NULL, checkpoint a NULL symbol header.
      Otherwise, write a address symbol header and the symbol
      address. */
@@ -570,11 +1012,21 @@ restore_sym( void ) {
   static int first_time = 1;
   size_t type;
   void * saddr;
+  char * sname;
 
   /* Read the symbol header and determine the symbol type. */
 
   RESTORE_VAL( size_t, type );
   if( type==0x2C11513B ) return NULL; /* NULL symbol header */
+  if( type==0x4E4D513B ) {            /* Named symbol header */
+    sname = restore_str();
+    saddr = symbol_addr( sname );
+    if( !saddr )
+      ERROR(( "Unable to resolve the symbol \"%s\".  Make sure it is "
+              "registered with REGISTER_SYMBOL.", sname ));
+    FREE( sname );
+    return saddr;
+  }
   if( type!=0xADD7513B ) 
     ERROR(( "Malformed checkpt (expected symbol header)" ));
 
@@ -656,6 +1108,10 @@ checkpt_sym( const void * saddr ) {
     return;
   }
 
+  /* Write named symbols by name */
+
+  if( checkpt_named_sym( saddr ) ) return;
+
   /* Do a reverse symbol lookup */
 
   dlerror();
@@ -723,6 +1179,20 @@ restore_sym( void ) {
     saddr = NULL;
     break;
 
+  case 0x4E4D513B: /* named symbol */
+
+    /* Look the name up among the registered symbols and, failing
+       that, in the symbol table */
+
+    sname = restore_str();
+    saddr = symbol_addr( sname );
+    if( !saddr ) saddr = find_saddr( sname, NULL );
+    if( !saddr )
+      ERROR(( "Unable to resolve the symbol \"%s\".  Make sure it is "
+              "registered with REGISTER_SYMBOL.", sname ));
+    FREE( sname );
+    break;
+
   case  0x577513B: /* string symbol */
 
     /* Restore the symbol strings */
@@ -88,7 +88,10 @@ void *
 object_ptr( size_t id );
 
 /* Checkpt(restore) all objects to(from) the checkpt with the given
-   name (a '\0'-terminated string).  If restore_objects is called
+   name (a '\0'-terminated string).  These are collective.  Each rank's
+   objects are serialized to a stream in the file name.r, where r is
+   the rank (see set_checkpt_striping for the file layout when the
+   checkpt is aggregated into fewer files).  If restore_objects is called
    with any objects already registered, already objects already
    registered will be silently unregistered.  Except for objects
    registered during boot_services, this is not an issue
@@ -103,6 +106,66 @@ checkpt_objects( const char * name );
 void
 restore_objects( const char * name );
 
+/* Restarting on a different number of ranks.  checkpt_ranks gives the
+   number of ranks that wrote the checkpt name (collective).
+   restore_remapped_objects restores the objects rank wrote instead of
+   this rank's objects.  restore_object restores one object from the
+   stream rank wrote: the object checkpointed in place of the
+   registered object obj (objects get the same identifiers on every
+   rank when the ranks create them in the same order).  Pointers it
+   holds to other objects are restored to the corresponding registered
+   objects.  The object is not registered.  Neither is collective, so
+   to read the stream of another rank from a checkpt written earlier in
+   the same run, call wait_checkpt first.  restore_remapped is nonzero
+   while either reads from the stream of another rank (restore
+   functions that check they are reading their own rank's stream should
+   accept this). */
+
+int
+checkpt_ranks( const char * name );
+
+void
+restore_remapped_objects( const char * name,
+                          int rank );
+
+void *
+restore_object( const char * name,
+                int rank,
+                const void * obj );
+
+int
+restore_remapped( void );
+
+/* Set how checkpts are written.  The streams of the ranks are
+   aggregated into n_file files, each shared by a consecutive block
+   of ranks and named after the first rank of the block (0 or at least
+   world_size gives one file per rank, the default).  Only the first
+   rank of a block opens its file; the other ranks send it their
+   streams (and receive them from it on restore).  Payloads of at
+   least sz_chunk bytes (8 MiB by default) are split into chunks of
+   that size which the pipelines write (read) in parallel.  Restoring
+   detects how a checkpt was aggregated.  These can also be set with
+   the --checkpt-files and --checkpt-chunk command line options. */
+
+void
+set_checkpt_striping( int n_file,
+                      size_t sz_chunk );
+
+/* In async mode (async nonzero), checkpt_objects takes a snapshot:
+   the objects are serialized into memory and checkpt_objects returns
+   while a background thread writes the snapshot to the checkpt.  A
+   checkpt (or restore) waits until the previous snapshot is written,
+   as does halt_checkpt.  wait_checkpt waits explicitly until every
+   rank has written its snapshot (collective).  The snapshot holds a
+   copy of all checkpointed data.  Async mode can also be set
+   with the --checkpt-async command line option. */
+
+void
+set_checkpt_async( int async );
+
+void
+wait_checkpt( void );
+
 /* Call the reanimate functions on all objects.  This is typically
    done after the restore process. */
 
@@ -150,6 +213,17 @@ checkpt_data( const void * data,
 void *
 restore_data( void );
 
+/* Restore data checkpointed by checkpt_data into elements str_ele bytes
+   apart, whatever stride they were written with.  This lets a type
+   whose padding depends on the build (e.g. on the SIMD width) be
+   written without its padding (sz_ele smaller than str_ele) and
+   restored by a build that pads it differently.  The checkpointed
+   elements must fit in str_ele bytes; the rest of each element is
+   cleared. */
+
+void *
+restore_data_strided( size_t str_ele );
+
 /* Checkpt(restore) a '\0'-terminated string.  The returned pointer of
    restore_str heap_allocated as:
      MALLOC( (char *)string, strlen_string+1 )
@@ -248,7 +322,15 @@ restore_ptr( void );
    edge cases above.
    
    It is okay to checkpoint a NULL symbol (it will be restored as a
-   NULL). */
+   NULL).
+
+   None of the above applies to symbols given a name with
+   register_symbol.  These are checkpointed by name and restored by
+   looking the name up among the registered symbols, which works with
+   static functions, without an exported symbol table and after the
+   application is rebuilt.  Kernels, the checkpt, restore and reanimate
+   functions of objects and the callbacks of boundary conditions,
+   emitters and collision operators are registered this way. */
 
 void
 checkpt_sym( const void * sym );
@@ -256,6 +338,24 @@ checkpt_sym( const void * sym );
 void *
 restore_sym( void );
 
+/* Give the symbol at saddr a name for checkpt_sym / restore_sym.
+   Registering the same name and symbol again is okay.  Symbols must
+   be registered before a restore; REGISTER_SYMBOL below does it at
+   program start.  This can be called before boot_checkpt. */
+
+void
+register_symbol( const char * name,
+                 const void * saddr );
+
+/* Record the size of a type whose arrays objects checkpt raw.  The
+   sizes are written at the start of every checkpt and restoring a
+   checkpt written with a different size for a registered type is an
+   error.  REGISTER_LAYOUT below does it at program start. */
+
+void
+register_layout( const char * name,
+                 size_t size );
+
 /****************************************************************************/
 
 /* This robust macros are provided for  convenience.  They provide a
@@ -287,6 +387,30 @@ restore_sym( void );
 
 #define UNREGISTER_OBJECT(p)     unregister_object( (p) )
 
+/* REGISTER_SYMBOL(f) registers the function f under its name when the
+   program starts.  Use it at file scope after f is declared, in the
+   file that defines f (input decks included). */
+
+#define REGISTER_SYMBOL(f)                                      \
+  static void __attribute__((constructor))                      \
+  _register_symbol_##f( void ) {                                \
+    register_symbol( #f, (const void *)(size_t)(f) );           \
+  }
+
+/* REGISTER_LAYOUT(T) registers the size of type T when the program
+   starts.  Use it at file scope in the file that checkpoints arrays of
+   T.  REGISTER_LAYOUT_SIZE(T,sz) registers the sz bytes of each T that
+   are checkpointed instead, for a type checkpointed without its
+   padding (see restore_data_strided). */
+
+#define REGISTER_LAYOUT_SIZE(T,sz)                              \
+  static void __attribute__((constructor))                      \
+  _register_layout_##T( void ) {                                \
+    register_layout( #T, (sz) );                                \
+  }
+
+#define REGISTER_LAYOUT(T) REGISTER_LAYOUT_SIZE( T, sizeof(T) )
+
 #define CHECKPT_ALIGNED(p,n,a) do {           \
     size_t _sz = (n)*sizeof(*(p));            \
     checkpt_data( (p), _sz, _sz, 1, 1, (a) ); \
@@ -312,6 +436,8 @@ restore_sym( void );
 
 #define RESTORE_ALIGNED(p) CXX_ILLEGAL_PTR_COPY( (p), restore_data() )
 #define RESTORE(p)         RESTORE_ALIGNED((p))
+#define RESTORE_STRIDED(p) CXX_ILLEGAL_PTR_COPY( (p),                        \
+                             restore_data_strided( sizeof(*(p)) ) )
 #define RESTORE_STR(p)     CXX_ILLEGAL_PTR_COPY( (p), restore_str()  )
 #define RESTORE_FPTR(p)    CXX_ILLEGAL_PTR_COPY( (p), restore_fptr() )
 #define RESTORE_PTR(p)     CXX_ILLEGAL_PTR_COPY( (p), restore_ptr()  )
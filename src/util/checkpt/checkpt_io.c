@@ -0,0 +1,1025 @@
+#define IN_checkpt
+#include "checkpt_private.h"
+#include "../mp/mp.h"
+#include "../pipelines/pipelines_exec.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* A checkpt stream is a contiguous range of bytes in a file.  Small
+   writes(reads) are staged in a buffer of sz_chunk bytes.  Payloads at
+   least that large bypass the buffer and are split into chunks of
+   sz_chunk bytes that the pipelines transfer in parallel with pwrite
+   (pread).
+
+   By default, each rank writes its stream to its own file,
+   name.rank, which holds nothing else.  When the checkpt is
+   aggregated into n_file < world_size files, consecutive blocks of
+   ranks share a file.  The file of a block is name.r0, where r0 is
+   the first rank of the block, and r0 is the only rank of the block
+   that opens it.  The other ranks send their streams to r0 in chunks
+   of sz_chunk bytes, which r0 writes after its own stream.  On
+   restore, r0 reads the streams of the other ranks of its block and
+   sends each one to its rank, which reads it from memory.  So only
+   n_file ranks open (create) files and hit the file system metadata
+   servers.  The file starts with a header giving the location of the
+   stream of each rank of the block:
+
+     size_t magic, n_file, n_rank, r0, n
+     size_t off[0], sz[0], ..., off[n-1], sz[n-1]
+
+   where n_rank is the number of ranks that wrote the checkpt and n is
+   the number of ranks in the block.  Streams start on STREAM_ALIGN
+   byte boundaries.  A per rank file starts with the stream itself (the
+   first value in a stream is never the magic number).
+
+   In async mode, a checkpt is a snapshot: the stream is serialized
+   into memory and a background thread writes it to the file while the
+   simulation continues.  The snapshot memory is reused, so a snapshot
+   waits until the previous one is written.  MPI is not used from the
+   background thread, so when an async checkpt is aggregated, the
+   other ranks of a block send their snapshots to r0 before
+   checkpt_objects returns.  r0 then holds the snapshots of its whole
+   block and writes them as one. */
+
+#define AGGREGATE_MAGIC ((size_t)0xA66C4EC7)
+#define STREAM_ALIGN    ((int64_t)4096)
+
+#define CHECKPT_SIZE_TAG 40
+#define CHECKPT_DATA_TAG 41
+
+static int    n_file   = 0;
+static size_t sz_chunk = ((size_t)8)<<20;
+static int    async    = 0;
+
+struct checkpt {
+  int fd;          /* File descriptor (-1 if in memory or sent) */
+  int wr;          /* Nonzero if writing */
+  int mem;         /* Nonzero if a snapshot or, if reading, a stream
+                      received from r0 (else only counts bytes if fd
+                      is -1 and dst is -1) */
+  int dst;         /* Rank the stream is sent to (-1 if none) */
+  int64_t base;    /* File offset of the start of the stream */
+  int64_t pos;     /* Stream offset of buf[0] */
+  size_t n_buf;    /* Bytes staged in buf */
+  size_t at;       /* Next unread byte in buf (if reading) */
+  size_t max_buf;  /* Snapshot capacity */
+  int64_t sz;      /* Size of the stream (if reading) */
+  char * buf;      /* Staging buffer (sz_chunk bytes) or snapshot */
+  char * name;     /* Name of the file (for error messages) */
+  mp_t * mp;       /* Ports staging and sending chunks (if dst>=0) */
+  int port;        /* Port staging the next chunk */
+  int sent[2];     /* Nonzero if the chunk of a port is being sent */
+  int n_blk;       /* Ranks of the block, if r0 of an aggregated file */
+  int64_t * blk;   /* Offset and size of the streams of the block */
+};
+
+/* The snapshot memory and the state of the thread writing the last
+   snapshot.  busy is set while the snapshot is being written. */
+
+static char * snapshot     = NULL;
+static size_t max_snapshot = 0;
+
+static struct {
+  int booted, busy, halt;
+  pthread_t handle;
+  pthread_mutex_t mutex;
+  pthread_cond_t wake;
+  int fd;
+  int64_t base;
+  size_t n;
+  char * name;
+} drain;
+
+/* Private helpers ***********************************************************/
+
+/* The number of files a checkpt is actually written to and the block of
+   ranks that share a file. */
+
+static int
+files_used( int nf ) {
+  return ( nf<1 || nf>world_size ) ? world_size : nf;
+}
+
+static int
+file_of( int rank,
+         int nf,
+         int nr ) {
+  return (int)( ((int64_t)rank*(int64_t)nf) / (int64_t)nr );
+}
+
+static int
+first_rank( int file,
+            int nf,
+            int nr ) {
+  return (int)( ((int64_t)file*(int64_t)nr + (int64_t)(nf-1)) / (int64_t)nf );
+}
+
+/* Transfer n bytes between data and the file at offset off.  Returns 0
+   on success and an errno otherwise (EIO if the file ended early). */
+
+static int
+transfer( int fd,
+          char * data,
+          size_t n,
+          int64_t off,
+          int wr ) {
+  ssize_t m;
+  while( n ) {
+    m = wr ? pwrite( fd, data, n, (off_t)off ) : pread( fd, data, n, (off_t)off );
+    if( m<0 && errno==EINTR ) continue;
+    if( m<=0 ) return m<0 ? errno : EIO;
+    data += m, n -= m, off += m;
+  }
+  return 0;
+}
+
+/* Point to point transfer of streams between the ranks of an aggregated
+   block.  Streams go in chunks of at most sz_chunk bytes, double
+   buffered in two ports of mp, so the sender stages (reads) a chunk
+   while the previous one is in flight and the receiver writes
+   (copies) a chunk while the next one arrives. */
+
+static mp_t *
+new_stream_mp( void ) {
+  mp_t * mp = new_private_mp( 2 );
+  mp_size_send_buffer( mp, 0, (int)sz_chunk );
+  mp_size_send_buffer( mp, 1, (int)sz_chunk );
+  mp_size_recv_buffer( mp, 0, (int)sz_chunk );
+  mp_size_recv_buffer( mp, 1, (int)sz_chunk );
+  return mp;
+}
+
+/* Send the n bytes at offset off of mem (of the file fd if mem is NULL)
+   to dst */
+
+static void
+send_stream( mp_t * mp,
+             int dst,
+             const char * mem,
+             int fd,
+             int64_t off,
+             int64_t n,
+             const char * name ) {
+  int64_t o;
+  int port = 0, sent[2] = { 0, 0 }, len;
+  char * buf;
+
+  for( o=0; o<n; o+=len, port ^= 1 ) {
+    len = ( n-o < (int64_t)sz_chunk ) ? (int)( n-o ) : (int)sz_chunk;
+    if( sent[port] ) mp_end_send( mp, port );
+    buf = (char *)mp_send_buffer( mp, port );
+    if( mem ) memcpy( buf, mem + off + o, len );
+    else if( transfer( fd, buf, len, off + o, 0 ) )
+      ERROR(( "Unable to read checkpt \"%s\"", name ));
+    mp_begin_send( mp, port, len, dst, CHECKPT_DATA_TAG );
+    sent[port] = 1;
+  }
+  if( sent[0] ) mp_end_send( mp, 0 );
+  if( sent[1] ) mp_end_send( mp, 1 );
+}
+
+/* Receive the n bytes src sends with send_stream (or a checkpt stream
+   opened for dst) into mem at offset off (into the file fd if mem is
+   NULL) */
+
+static void
+recv_stream( mp_t * mp,
+             int src,
+             char * mem,
+             int fd,
+             int64_t off,
+             int64_t n,
+             const char * name ) {
+  int64_t o, o1;
+  int port = 0, len, len1;
+  char * buf;
+
+  if( n<1 ) return;
+  len = ( n < (int64_t)sz_chunk ) ? (int)n : (int)sz_chunk;
+  mp_begin_recv( mp, 0, len, src, CHECKPT_DATA_TAG );
+  for( o=0; o<n; o=o1, len=len1, port ^= 1 ) {
+    o1   = o + len;
+    len1 = ( n-o1 < (int64_t)sz_chunk ) ? (int)( n-o1 ) : (int)sz_chunk;
+    mp_end_recv( mp, port );
+    if( len1 ) mp_begin_recv( mp, port^1, len1, src, CHECKPT_DATA_TAG );
+    buf = (char *)mp_recv_buffer( mp, port );
+    if( mem ) memcpy( mem + off + o, buf, len );
+    else if( transfer( fd, buf, len, off + o, 1 ) )
+      ERROR(( "Unable to write checkpt \"%s\"", name ));
+  }
+}
+
+typedef struct checkpt_io_pipeline_args {
+  char * data;     /* Payload */
+  char * mem;      /* Snapshot to copy to (NULL if transferring) */
+  int * err;       /* Error of each pipeline (0:n_pipeline) */
+  int64_t off;     /* File offset of data[0] */
+  size_t n;        /* Payload bytes */
+  size_t sz_chunk; /* Bytes per chunk */
+  int fd;          /* File descriptor */
+  int wr;          /* Nonzero if writing */
+} checkpt_io_pipeline_args_t;
+
+static void
+checkpt_io_pipeline_scalar( checkpt_io_pipeline_args_t * args,
+                            int pipeline_rank,
+                            int n_pipeline ) {
+  size_t sz = args->sz_chunk, o, len;
+  int c, nc, err;
+
+  DISTRIBUTE( (int)( (args->n + sz - 1)/sz ), 1, pipeline_rank, n_pipeline,
+              c, nc );
+
+  for( ; nc; c++, nc-- ) {
+    o   = (size_t)c*sz;
+    len = args->n - o;
+    if( len>sz ) len = sz;
+    if( args->mem ) {
+      memcpy( args->mem + args->off + o, args->data + o, len );
+      continue;
+    }
+    err = transfer( args->fd, args->data + o, len, args->off + (int64_t)o,
+                    args->wr );
+    if( err ) args->err[pipeline_rank] = err;
+  }
+}
+
+/* Transfer a payload between data and the stream at stream offset pos.
+   Payloads that span several chunks are transferred (copied into the
+   snapshot) by the pipelines. */
+
+static void
+transfer_payload( checkpt_t * c,
+                  char * data,
+                  size_t n,
+                  int64_t pos ) {
+  DECLARE_ALIGNED_ARRAY( checkpt_io_pipeline_args_t, 128, args, 1 );
+  int err[ MAX_PIPELINE+1 ], rank, e = 0;
+
+  if( n<=sz_chunk || N_PIPELINE<2 ) {
+    if( c->mem ) memcpy( c->buf + pos, data, n );
+    else         e = transfer( c->fd, data, n, c->base + pos, c->wr );
+  } else {
+    CLEAR( err, N_PIPELINE+1 );
+    args->data     = data;
+    args->mem      = c->mem ? c->buf : NULL;
+    args->err      = err;
+    args->off      = c->mem ? pos : c->base + pos;
+    args->n        = n;
+    args->sz_chunk = sz_chunk;
+    args->fd       = c->fd;
+    args->wr       = c->wr;
+    EXEC_PIPELINES( checkpt_io, args, 0 );
+    WAIT_PIPELINES();
+    for( rank=0; rank<=N_PIPELINE; rank++ ) if( err[rank] ) e = err[rank];
+  }
+
+  if( e ) ERROR(( "Unable to %s %lu bytes of checkpt \"%s\" (%s)",
+                  c->wr ? "write" : "read", (unsigned long)n, c->name,
+                  strerror( e ) ));
+}
+
+static void
+flush( checkpt_t * c ) {
+  if( !c->n_buf ) return;
+  transfer_payload( c, c->buf, c->n_buf, c->pos );
+  c->pos  += c->n_buf;
+  c->n_buf = 0;
+}
+
+/* Refill the staging buffer from the file at the current stream
+   position.  The buffer may end up short if the file ends. */
+
+static void
+fill( checkpt_t * c ) {
+  ssize_t m;
+  c->pos  += c->n_buf;
+  c->n_buf = 0;
+  c->at    = 0;
+  while( c->n_buf<sz_chunk ) {
+    m = pread( c->fd, c->buf + c->n_buf, sz_chunk - c->n_buf,
+               (off_t)( c->base + c->pos + (int64_t)c->n_buf ) );
+    if( m<0 && errno==EINTR ) continue;
+    if( m<0 ) ERROR(( "Unable to read checkpt \"%s\" (%s)",
+                      c->name, strerror( errno ) ));
+    if( m==0 ) break;
+    c->n_buf += m;
+  }
+}
+
+static checkpt_t *
+new_checkpt( const char * name,
+             int fd,
+             int wr,
+             int64_t base ) {
+  checkpt_t * c;
+  MALLOC( c, 1 );
+  c->fd    = fd;
+  c->wr    = wr;
+  c->mem   = 0;
+  c->dst   = -1;
+  c->base  = base;
+  c->pos   = 0;
+  c->n_buf = 0;
+  c->at    = 0;
+  c->max_buf = 0;
+  c->sz    = 0;
+  c->buf   = NULL;
+  c->name  = NULL;
+  c->mp    = NULL;
+  c->port  = 0;
+  c->sent[0] = 0;
+  c->sent[1] = 0;
+  c->n_blk = 0;
+  c->blk   = NULL;
+  if( fd>=0 ) {
+    MALLOC_ALIGNED( c->buf, sz_chunk, 128 );
+    MALLOC( c->name, strlen(name)+1 );
+    strcpy( c->name, name );
+  }
+  return c;
+}
+
+static int
+open_file( const char * name,
+           int flags ) {
+  int fd = open( name, flags, 0644 );
+  if( fd<0 ) ERROR(( "Unable to open \"%s\" for checkpt %s (%s)", name,
+                     (flags & O_WRONLY) ? "write" : "read",
+                     strerror( errno ) ));
+  return fd;
+}
+
+static void *
+drain_writer( void * arg ) {
+  int e;
+
+  (void)arg;
+
+  pthread_mutex_lock( &drain.mutex );
+  for(;;) {
+    while( !drain.busy && !drain.halt )
+      pthread_cond_wait( &drain.wake, &drain.mutex );
+    if( !drain.busy ) break; /* Halted and drained */
+    pthread_mutex_unlock( &drain.mutex );
+
+    e = transfer( drain.fd, snapshot, drain.n, drain.base, 1 );
+    if( e ) ERROR(( "Unable to write snapshot \"%s\" (%s)", drain.name,
+                    strerror( e ) ));
+    if( close( drain.fd ) )
+      ERROR(( "Error closing snapshot \"%s\" (%s)", drain.name,
+              strerror( errno ) ));
+
+    pthread_mutex_lock( &drain.mutex );
+    FREE( drain.name );
+    drain.busy = 0;
+    pthread_cond_broadcast( &drain.wake );
+  }
+  pthread_mutex_unlock( &drain.mutex );
+
+  return NULL;
+}
+
+/* Lay out this rank's stream of sz bytes in the checkpt with the given
+   name.  Returns the name of the file it goes to.  If this rank writes
+   the file, fd gets the open file and base the offset of the stream in
+   it (dst gets -1).  Otherwise, fd gets -1 and dst the first rank of
+   the block, which writes the stream.  The first rank of an aggregated
+   block also gets the offset and size of the stream of each rank of
+   its block in blk (n_blk entries). */
+
+static char *
+open_stream( const char * name,
+             size_t sz,
+             int * _fd,
+             int64_t * _base,
+             int * _dst,
+             int * _n_blk,
+             int64_t ** _blk ) {
+  char * fname;
+  size_t * hdr;
+  int64_t * sz_rank, * blk = NULL, base, off;
+  int nf, nr, r0, r1, n = 0, r, fd, dst = -1;
+
+  if( !name ) ERROR(( "NULL name" ));
+
+  nf = files_used( n_file );
+  nr = world_size;
+  MALLOC( fname, strlen(name)+32 );
+
+  if( nf==nr ) {
+    sprintf( fname, "%s.%i", name, world_rank );
+    fd   = open_file( fname, O_WRONLY | O_CREAT | O_TRUNC );
+    base = 0;
+  } else {
+
+    /* Lay out the streams of the block of ranks that share this
+       rank's file */
+
+    MALLOC( sz_rank, nr );
+    off = (int64_t)sz;
+    mp_allgather_i64( &off, sz_rank, 1 );
+
+    r0 = first_rank( file_of( world_rank, nf, nr ),   nf, nr );
+    r1 = first_rank( file_of( world_rank, nf, nr )+1, nf, nr );
+    n  = r1 - r0;
+
+    MALLOC( hdr, 5+2*n );
+    hdr[0] = AGGREGATE_MAGIC;
+    hdr[1] = nf;
+    hdr[2] = nr;
+    hdr[3] = r0;
+    hdr[4] = n;
+    off = (int64_t)( (5+2*n)*sizeof(size_t) );
+    for( r=0; r<n; r++ ) {
+      off = ( ( off + STREAM_ALIGN - 1 ) / STREAM_ALIGN ) * STREAM_ALIGN;
+      hdr[5+2*r  ] = off;
+      hdr[5+2*r+1] = sz_rank[r0+r];
+      off += sz_rank[r0+r];
+    }
+    base = hdr[5+2*(world_rank-r0)];
+
+    /* Only the first rank of the block opens the file */
+
+    sprintf( fname, "%s.%i", name, r0 );
+    fd = -1;
+    if( world_rank==r0 ) {
+      fd = open_file( fname, O_WRONLY | O_CREAT | O_TRUNC );
+      if( transfer( fd, (char *)hdr, (5+2*n)*sizeof(size_t), 0, 1 ) )
+        ERROR(( "Unable to write the header of checkpt \"%s\"", fname ));
+      MALLOC( blk, 2*n );
+      for( r=0; r<2*n; r++ ) blk[r] = (int64_t)hdr[5+r];
+    } else {
+      dst = r0;
+      n   = 0;
+    }
+
+    FREE( hdr );
+    FREE( sz_rank );
+  }
+
+  *_fd    = fd;
+  *_base  = base;
+  *_dst   = dst;
+  *_n_blk = n;
+  *_blk   = blk;
+  return fname;
+}
+
+/* Receive the streams of the other ranks of the block of an aggregated
+   checkpt r0 writes, into the file fd (or mem, holding the block from
+   the start of the first stream on, if fd is -1) */
+
+static void
+gather_block( int fd,
+              char * mem,
+              int n_blk,
+              const int64_t * blk,
+              const char * name ) {
+  mp_t * mp;
+  int r;
+  if( n_blk<2 ) return;
+  mp = new_stream_mp();
+  for( r=1; r<n_blk; r++ )
+    recv_stream( mp, world_rank+r, mem, fd,
+                 mem ? blk[2*r]-blk[0] : blk[2*r], blk[2*r+1], name );
+  delete_private_mp( mp );
+}
+
+/* Send the chunk staged in the current port of a stream sent to r0 */
+
+static void
+send_chunk( checkpt_t * c ) {
+  mp_begin_send( c->mp, c->port, (int)c->n_buf, c->dst, CHECKPT_DATA_TAG );
+  c->sent[c->port] = 1;
+  c->pos  += c->n_buf;
+  c->n_buf = 0;
+  c->port ^= 1;
+  if( c->sent[c->port] ) mp_end_send( c->mp, c->port ), c->sent[c->port] = 0;
+  c->buf = (char *)mp_send_buffer( c->mp, c->port );
+}
+
+/* Public interface **********************************************************/
+
+void
+set_checkpt_async( int _async ) {
+  async = _async;
+}
+
+void
+wait_checkpt( void ) {
+  checkpt_wait_drain();
+  mp_barrier();
+}
+
+void
+set_checkpt_striping( int _n_file,
+                      size_t _sz_chunk ) {
+  if( _n_file<0 || _sz_chunk<1 || _sz_chunk>(size_t)INT_MAX )
+    ERROR(( "Bad args" ));
+  n_file   = _n_file;
+  sz_chunk = _sz_chunk;
+}
+
+/* Private interface *********************************************************/
+
+int
+checkpt_aggregated( void ) {
+  return files_used( n_file )<world_size;
+}
+
+checkpt_t *
+checkpt_open_count( void ) {
+  return new_checkpt( NULL, -1, 1, 0 );
+}
+
+checkpt_t *
+checkpt_open_wronly( const char * name,
+                     size_t sz ) {
+  checkpt_t * c;
+  char * fname;
+  int64_t base, * blk;
+  int fd, dst, n_blk;
+
+  fname = open_stream( name, sz, &fd, &base, &dst, &n_blk, &blk );
+  c = new_checkpt( fname, fd, 1, base );
+  c->n_blk = n_blk;
+  c->blk   = blk;
+  if( dst>=0 ) {
+    MALLOC( c->name, strlen(fname)+1 );
+    strcpy( c->name, fname );
+    c->dst = dst;
+    c->mp  = new_stream_mp();
+    c->buf = (char *)mp_send_buffer( c->mp, 0 );
+  }
+  FREE( fname );
+  return c;
+}
+
+void
+checkpt_wait_drain( void ) {
+  if( !drain.booted ) return;
+  pthread_mutex_lock( &drain.mutex );
+  while( drain.busy ) pthread_cond_wait( &drain.wake, &drain.mutex );
+  pthread_mutex_unlock( &drain.mutex );
+}
+
+checkpt_t *
+checkpt_open_snapshot( void ) {
+  checkpt_t * c;
+  checkpt_wait_drain();
+  c = new_checkpt( NULL, -1, 1, 0 );
+  c->mem     = 1;
+  c->buf     = snapshot;
+  c->max_buf = max_snapshot;
+  snapshot     = NULL;
+  max_snapshot = 0;
+  return c;
+}
+
+void
+checkpt_drain( checkpt_t * checkpt,
+               const char * name ) {
+  char * fname, * buf;
+  int64_t base, * blk;
+  size_t n;
+  mp_t * mp;
+  int fd, dst, n_blk;
+
+  if( !checkpt || !checkpt->mem ) ERROR(( "Bad args" ));
+
+  if( !drain.booted ) {
+    drain.busy = 0;
+    drain.halt = 0;
+    if( pthread_mutex_init( &drain.mutex, NULL ) )
+      ERROR(( "pthread_mutex_init failed" ));
+    if( pthread_cond_init( &drain.wake, NULL ) )
+      ERROR(( "pthread_cond_init failed" ));
+    if( pthread_create( &drain.handle, NULL, drain_writer, NULL ) )
+      ERROR(( "pthread_create failed" ));
+    drain.booted = 1;
+  }
+
+  fname = open_stream( name, checkpt->n_buf, &fd, &base, &dst, &n_blk, &blk );
+  buf = checkpt->buf;
+  n   = checkpt->n_buf;
+
+  /* Hand the snapshot to r0 if aggregated.  r0 puts the snapshots of
+     its block together in a new snapshot laid out like the file from
+     the start of its own stream on. */
+
+  if( dst>=0 ) {
+    mp = new_stream_mp();
+    send_stream( mp, dst, buf, -1, 0, (int64_t)n, fname );
+    delete_private_mp( mp );
+    snapshot     = buf;
+    max_snapshot = checkpt->max_buf;
+    FREE( fname );
+    FREE( checkpt );
+    return;
+  }
+
+  if( n_blk>1 ) {
+    n = (size_t)( blk[2*(n_blk-1)] + blk[2*(n_blk-1)+1] - blk[0] );
+    MALLOC_ALIGNED( buf, n, 128 );
+    CLEAR( buf, n );
+    COPY( buf, checkpt->buf, checkpt->n_buf );
+    FREE_ALIGNED( checkpt->buf );
+    gather_block( -1, buf, n_blk, blk, fname );
+    checkpt->buf     = buf;
+    checkpt->max_buf = n;
+  }
+  FREE( blk );
+
+  /* Hand the snapshot to the writer */
+
+  snapshot     = checkpt->buf;
+  max_snapshot = checkpt->max_buf;
+
+  pthread_mutex_lock( &drain.mutex );
+  drain.name = fname;
+  drain.fd   = fd;
+  drain.base = base;
+  drain.n    = n;
+  drain.busy = 1;
+  pthread_cond_broadcast( &drain.wake );
+  pthread_mutex_unlock( &drain.mutex );
+
+  FREE( checkpt );
+}
+
+void
+halt_checkpt_io( void ) {
+  if( !drain.booted ) return;
+  pthread_mutex_lock( &drain.mutex );
+  drain.halt = 1;
+  pthread_cond_broadcast( &drain.wake );
+  pthread_mutex_unlock( &drain.mutex );
+  pthread_join( drain.handle, NULL );
+  pthread_cond_destroy( &drain.wake );
+  pthread_mutex_destroy( &drain.mutex );
+  drain.booted = 0;
+  FREE_ALIGNED( snapshot );
+  max_snapshot = 0;
+}
+
+int
+checkpt_async( void ) {
+  return async;
+}
+
+/* Find out from the first file of the checkpt how it was written.
+   peek gets whether the checkpt is aggregated and, if so, the number of
+   files and ranks it was written with. */
+
+static void
+peek_checkpt( const char * name,
+              int64_t * peek ) {
+  char * fname;
+  size_t hdr[5];
+  int fd;
+
+  MALLOC( fname, strlen(name)+32 );
+  sprintf( fname, "%s.0", name );
+  CLEAR( peek, 3 );
+  fd = open_file( fname, O_RDONLY );
+  if( !transfer( fd, (char *)hdr, sizeof(hdr), 0, 0 ) &&
+      hdr[0]==AGGREGATE_MAGIC ) {
+    peek[0] = 1;
+    peek[1] = hdr[1];
+    peek[2] = hdr[2];
+  }
+  close( fd );
+  FREE( fname );
+}
+
+/* Open the stream rank wrote in a checkpt written as given by peek */
+
+static checkpt_t *
+open_rank( const char * name,
+           int rank,
+           const int64_t * peek ) {
+  checkpt_t * c;
+  char * fname;
+  size_t hdr[5], ent[2];
+  struct stat st[1];
+  int nf = (int)peek[1], nr = (int)peek[2], r0, fd;
+  int64_t base, sz;
+
+  MALLOC( fname, strlen(name)+32 );
+
+  if( !peek[0] ) {
+    sprintf( fname, "%s.%i", name, rank );
+    fd   = open_file( fname, O_RDONLY );
+    if( fstat( fd, st ) )
+      ERROR(( "Unable to stat checkpt \"%s\" (%s)", fname, strerror( errno ) ));
+    base = 0;
+    sz   = (int64_t)st->st_size;
+  } else {
+    if( rank<0 || rank>=nr )
+      ERROR(( "Checkpt \"%s\" was written by %i ranks (no rank %i)",
+              name, nr, rank ));
+    r0 = first_rank( file_of( rank, nf, nr ), nf, nr );
+    sprintf( fname, "%s.%i", name, r0 );
+    fd = open_file( fname, O_RDONLY );
+    if( transfer( fd, (char *)hdr, sizeof(hdr), 0, 0 ) ||
+        hdr[0]!=AGGREGATE_MAGIC || hdr[3]!=(size_t)r0 ||
+        rank-r0>=(int)hdr[4] ||
+        transfer( fd, (char *)ent, 2*sizeof(size_t),
+                  (int64_t)( (5+2*(rank-r0))*sizeof(size_t) ), 0 ) )
+      ERROR(( "Malformed checkpt \"%s\" (bad header)", fname ));
+    base = (int64_t)ent[0];
+    sz   = (int64_t)ent[1];
+  }
+
+  c = new_checkpt( fname, fd, 0, base );
+  c->sz = sz;
+  FREE( fname );
+  return c;
+}
+
+/* Open this rank's stream in an aggregated checkpt written by as many
+   ranks as there are now (as given by peek).  r0 of each block reads
+   the streams of the other ranks of the block and sends them to their
+   ranks, which then read them from memory. */
+
+static checkpt_t *
+scatter_block( const char * name,
+               const int64_t * peek ) {
+  checkpt_t * c;
+  char * fname;
+  size_t * hdr;
+  int64_t sz;
+  mp_t * mp;
+  int nf = (int)peek[1], nr = (int)peek[2], r0, n, r;
+
+  r0 = first_rank( file_of( world_rank, nf, nr ),   nf, nr );
+  n  = first_rank( file_of( world_rank, nf, nr )+1, nf, nr ) - r0;
+  mp = new_stream_mp();
+  mp_size_send_buffer( mp, 0, sizeof(int64_t) );
+  mp_size_recv_buffer( mp, 0, sizeof(int64_t) );
+
+  if( world_rank==r0 ) {
+    c = open_rank( name, r0, peek );
+    MALLOC( hdr, 5+2*n );
+    if( transfer( c->fd, (char *)hdr, (5+2*n)*sizeof(size_t), 0, 0 ) ||
+        hdr[4]!=(size_t)n )
+      ERROR(( "Malformed checkpt \"%s\" (bad header)", c->name ));
+    for( r=1; r<n; r++ ) {
+      *(int64_t *)mp_send_buffer( mp, 0 ) = (int64_t)hdr[5+2*r+1];
+      mp_begin_send( mp, 0, sizeof(int64_t), r0+r, CHECKPT_SIZE_TAG );
+      mp_end_send( mp, 0 );
+      send_stream( mp, r0+r, NULL, c->fd, (int64_t)hdr[5+2*r],
+                   (int64_t)hdr[5+2*r+1], c->name );
+    }
+    FREE( hdr );
+  } else {
+    MALLOC( fname, strlen(name)+32 );
+    sprintf( fname, "%s.%i", name, r0 );
+    mp_begin_recv( mp, 0, sizeof(int64_t), r0, CHECKPT_SIZE_TAG );
+    mp_end_recv( mp, 0 );
+    sz = *(int64_t *)mp_recv_buffer( mp, 0 );
+    c = new_checkpt( NULL, -1, 0, 0 );
+    c->mem     = 1;
+    c->sz      = sz;
+    c->n_buf   = (size_t)sz;
+    c->max_buf = (size_t)sz;
+    c->name    = fname;
+    MALLOC_ALIGNED( c->buf, sz>0 ? sz : 1, 128 );
+    recv_stream( mp, r0, c->buf, -1, 0, sz, fname );
+  }
+
+  delete_private_mp( mp );
+  return c;
+}
+
+checkpt_t *
+checkpt_open_rdonly( const char * name ) {
+  int64_t peek[3], * all;
+  checkpt_t * c;
+
+  if( !name ) ERROR(( "NULL name" ));
+
+  /* Only the first rank looks at the first file */
+
+  if( world_rank==0 ) peek_checkpt( name, peek );
+  else                CLEAR( peek, 3 );
+  MALLOC( all, 3*world_size );
+  mp_allgather_i64( peek, all, 3 );
+  if( all[0] && all[2]==world_size ) c = scatter_block( name, all );
+  else                               c = open_rank( name, world_rank, all );
+  FREE( all );
+  return c;
+}
+
+checkpt_t *
+checkpt_open_rank( const char * name,
+                   int rank ) {
+  int64_t peek[3];
+  if( !name ) ERROR(( "NULL name" ));
+  peek_checkpt( name, peek );
+  return open_rank( name, rank, peek );
+}
+
+int
+checkpt_ranks( const char * name ) {
+  char * fname;
+  int64_t peek[3];
+  int n = 0, n_rank;
+
+  if( !name ) ERROR(( "NULL name" ));
+
+  /* A checkpt written one file per rank has the files name.0, name.1,
+     ... up to the number of ranks that wrote it */
+
+  if( world_rank==0 ) {
+    peek_checkpt( name, peek );
+    if( peek[0] ) n = (int)peek[2];
+    else {
+      MALLOC( fname, strlen(name)+32 );
+      do sprintf( fname, "%s.%i", name, ++n );
+      while( !access( fname, F_OK ) );
+      FREE( fname );
+    }
+  }
+  mp_allsum_i( &n, &n_rank, 1 );
+  return n_rank;
+}
+
+size_t
+checkpt_tell( checkpt_t * checkpt ) {
+  if( !checkpt ) ERROR(( "NULL checkpt" ));
+  return (size_t)checkpt->pos + ( checkpt->wr ? checkpt->n_buf : checkpt->at );
+}
+
+size_t
+checkpt_size( checkpt_t * checkpt ) {
+  if( !checkpt || checkpt->wr ) ERROR(( "Invalid checkpt_size request" ));
+  return (size_t)checkpt->sz;
+}
+
+void
+checkpt_seek( checkpt_t * checkpt,
+              size_t pos ) {
+  if( !checkpt || checkpt->wr || ( checkpt->fd<0 && !checkpt->mem ) )
+    ERROR(( "Invalid checkpt_seek request" ));
+  if( (int64_t)pos>checkpt->sz )
+    ERROR(( "Malformed checkpt \"%s\" (seek past the end of the stream)",
+            checkpt->name ));
+
+  /* Stay in the staging buffer if pos is in it */
+
+  if( (int64_t)pos>=checkpt->pos &&
+      (int64_t)pos<=checkpt->pos + (int64_t)checkpt->n_buf ) {
+    checkpt->at = pos - (size_t)checkpt->pos;
+    return;
+  }
+
+  checkpt->pos   = (int64_t)pos;
+  checkpt->n_buf = 0;
+  checkpt->at    = 0;
+}
+
+void
+checkpt_close( checkpt_t * checkpt ) {
+  if( !checkpt ) ERROR(( "NULL checkpt" ));
+  if( checkpt->mem && checkpt->wr ) {
+    snapshot     = checkpt->buf;
+    max_snapshot = checkpt->max_buf;
+    FREE( checkpt );
+    return;
+  }
+  if( checkpt->dst>=0 ) {
+    if( checkpt->n_buf ) send_chunk( checkpt );
+    if( checkpt->sent[0] ) mp_end_send( checkpt->mp, 0 );
+    if( checkpt->sent[1] ) mp_end_send( checkpt->mp, 1 );
+    delete_private_mp( checkpt->mp );
+    checkpt->buf = NULL; /* Owned by mp */
+  }
+  if( checkpt->fd>=0 ) {
+    if( checkpt->wr ) {
+      flush( checkpt );
+      gather_block( checkpt->fd, NULL, checkpt->n_blk, checkpt->blk,
+                    checkpt->name );
+    }
+    if( close( checkpt->fd ) )
+      ERROR(( "Error closing checkpt \"%s\" (%s)", checkpt->name,
+              strerror( errno ) ));
+  }
+  FREE( checkpt->blk );
+  FREE_ALIGNED( checkpt->buf );
+  FREE( checkpt->name );
+  FREE( checkpt );
+}
+
+void
+checkpt_read( checkpt_t * checkpt,
+              void * _data,
+              size_t sz ) {
+  char * data = (char *)_data;
+  size_t n;
+
+  if( !sz ) return;
+  if( !checkpt || checkpt->wr || !data ) ERROR(( "Invalid checkpt_read request" ));
+
+  /* A stream received from r0 is all in the buffer */
+
+  if( checkpt->mem ) {
+    if( checkpt->at + sz > checkpt->n_buf )
+      ERROR(( "Malformed checkpt \"%s\" (unexpected end of stream)",
+              checkpt->name ));
+    memcpy( data, checkpt->buf + checkpt->at, sz );
+    checkpt->at += sz;
+    return;
+  }
+
+  /* Drain what is staged, then read big payloads directly and small
+     ones through the staging buffer */
+
+  n = checkpt->n_buf - checkpt->at;
+  if( n>sz ) n = sz;
+  memcpy( data, checkpt->buf + checkpt->at, n );
+  checkpt->at += n, data += n, sz -= n;
+  if( !sz ) return;
+
+  if( sz>=sz_chunk ) {
+    checkpt->pos  += checkpt->n_buf;
+    checkpt->n_buf = checkpt->at = 0;
+    transfer_payload( checkpt, data, sz, checkpt->pos );
+    checkpt->pos  += sz;
+    return;
+  }
+
+  fill( checkpt );
+  if( checkpt->n_buf<sz )
+    ERROR(( "Malformed checkpt \"%s\" (unexpected end of file)",
+            checkpt->name ));
+  memcpy( data, checkpt->buf, sz );
+  checkpt->at = sz;
+}
+
+void
+checkpt_write( checkpt_t * checkpt,
+               const void * data,
+               size_t sz ) {
+
+  if( !sz ) return;
+  if( !checkpt || !checkpt->wr || !data ) ERROR(( "Invalid checkpt_write request" ));
+
+  if( checkpt->mem ) {
+    if( checkpt->n_buf+sz>checkpt->max_buf ) {
+      size_t max_buf = 2*checkpt->max_buf;
+      char * buf;
+      if( max_buf<checkpt->n_buf+sz ) max_buf = checkpt->n_buf+sz;
+      if( max_buf<sz_chunk          ) max_buf = sz_chunk;
+      MALLOC_ALIGNED( buf, max_buf, 128 );
+      COPY( buf, checkpt->buf, checkpt->n_buf );
+      FREE_ALIGNED( checkpt->buf );
+      checkpt->buf     = buf;
+      checkpt->max_buf = max_buf;
+    }
+    transfer_payload( checkpt, (char *)data, sz, checkpt->n_buf );
+    checkpt->n_buf += sz;
+    return;
+  }
+
+  if( checkpt->dst>=0 ) {
+    const char * d = (const char *)data;
+    size_t n;
+    while( sz ) {
+      n = sz_chunk - checkpt->n_buf;
+      if( n>sz ) n = sz;
+      memcpy( checkpt->buf + checkpt->n_buf, d, n );
+      checkpt->n_buf += n, d += n, sz -= n;
+      if( checkpt->n_buf==sz_chunk ) send_chunk( checkpt );
+    }
+    return;
+  }
+
+  if( checkpt->fd<0 ) {
+    checkpt->pos += sz;
+    return;
+  }
+
+  if( checkpt->n_buf+sz<=sz_chunk ) {
+    memcpy( checkpt->buf + checkpt->n_buf, data, sz );
+    checkpt->n_buf += sz;
+    return;
+  }
+
+  flush( checkpt );
+
+  if( sz>=sz_chunk ) {
+    transfer_payload( checkpt, (char *)data, sz, checkpt->pos );
+    checkpt->pos += sz;
+  } else {
+    memcpy( checkpt->buf, data, sz );
+    checkpt->n_buf = sz;
+  }
+}
@@ -12,11 +12,81 @@ typedef struct checkpt checkpt_t;
 
 BEGIN_C_DECLS
 
+/* Nonzero if a checkpt is aggregated into fewer files than there are
+   ranks (see set_checkpt_striping).  Such a checkpt needs the size of
+   each rank's stream before it can be written. */
+
+int
+checkpt_aggregated( void );
+
+/* Open a stream that only counts the bytes written to it. */
+
+checkpt_t *
+checkpt_open_count( void );
+
+/* Open the stream of this rank in the checkpt with the given name.
+   These are collective.  When writing an aggregated checkpt, sz is the
+   number of bytes this rank will write (it is ignored otherwise). */
+
 checkpt_t *
 checkpt_open_rdonly( const char * name );
 
 checkpt_t *
-checkpt_open_wronly( const char * name );
+checkpt_open_wronly( const char * name,
+                     size_t sz );
+
+/* Open the stream rank wrote in the checkpt with the given name for
+   reading.  Not collective. */
+
+checkpt_t *
+checkpt_open_rank( const char * name,
+                   int rank );
+
+/* Nonzero if checkpts are written as snapshots (see set_checkpt_async). */
+
+int
+checkpt_async( void );
+
+/* Open a stream that serializes into the snapshot memory.  Waits until
+   the previous snapshot has been written.  checkpt_drain hands the
+   snapshot to the background writer, which writes it as this rank's
+   stream in the checkpt with the given name, and closes the stream.
+   checkpt_drain is collective. */
+
+checkpt_t *
+checkpt_open_snapshot( void );
+
+void
+checkpt_drain( checkpt_t * checkpt,
+               const char * name );
+
+/* Wait until this rank's last snapshot has been written.  Not
+   collective (wait_checkpt also waits for the other ranks). */
+
+void
+checkpt_wait_drain( void );
+
+/* Wait for the last snapshot to be written and stop the background
+   writer. */
+
+void
+halt_checkpt_io( void );
+
+/* Number of bytes written to (read from) the stream so far. */
+
+size_t
+checkpt_tell( checkpt_t * checkpt );
+
+/* Size in bytes of a stream opened with checkpt_open_rdonly and move
+   its read position to pos (an offset returned by checkpt_tell when the
+   stream was written). */
+
+size_t
+checkpt_size( checkpt_t * checkpt );
+
+void
+checkpt_seek( checkpt_t * checkpt,
+              size_t pos );
 
 void
 checkpt_close( checkpt_t * checkpt );
@@ -47,6 +47,7 @@ restore_collective( void ) {
   int rank, size;
   RESTORE_VAL( int, rank );
   RESTORE_VAL( int, size );
+  if( restore_remapped() ) return world; // Restarting on other ranks
   if( size!=world_size )
     ERROR(( "The number of nodes that made this checkpt (%i) is different "
             "from the number of nodes currently (%i)",
@@ -142,6 +143,16 @@ struct DMPPolicy {
     TRAP( MPI_Allreduce( local, global, n, MPI_DOUBLE, MPI_SUM, world->comm ) );
   }
   
+  inline void
+  mp_allmax_d( double * local,
+               double * global,
+               int n ) {
+    if( !local || !global || n<1 || std::abs(local-global)<n ) {
+	 	ERROR(( "Bad args" ));
+	 } // if
+    TRAP( MPI_Allreduce( local, global, n, MPI_DOUBLE, MPI_MAX, world->comm ) );
+  }
+  
   inline void
   mp_allsum_i( int * local,
                int * global,
@@ -194,6 +205,13 @@ struct DMPPolicy {
   
   inline mp_t *
   new_mp( int n_port ) {
+    mp_t * mp = new_private_mp( n_port );
+    REGISTER_OBJECT( mp, checkpt_mp, restore_mp, NULL );
+    return mp;
+  }
+  
+  inline mp_t *
+  new_private_mp( int n_port ) {
     mp_t * mp;
     if( n_port<1 ) ERROR(( "Bad args" ));
     MALLOC( mp, 1 );
@@ -206,15 +224,20 @@ struct DMPPolicy {
     CLEAR(  mp->rbuf_sz, n_port ); CLEAR(  mp->sbuf_sz, n_port ); 
     CLEAR(  mp->rreq_sz, n_port ); CLEAR(  mp->sreq_sz, n_port ); 
     CLEAR(  mp->rreq,    n_port ); CLEAR(  mp->sreq,    n_port ); 
-    REGISTER_OBJECT( mp, checkpt_mp, restore_mp, NULL );
     return mp;
   }
   
   inline void
   delete_mp( mp_t * mp ) {
-    int port;
     if( !mp ) return;
     UNREGISTER_OBJECT( mp );
+    delete_private_mp( mp );
+  }
+  
+  inline void
+  delete_private_mp( mp_t * mp ) {
+    int port;
+    if( !mp ) return;
     for( port=0; port<mp->n_port; port++ ) {
       FREE_ALIGNED( mp->rbuf[port] ); FREE_ALIGNED( mp->sbuf[port] ); 
     }
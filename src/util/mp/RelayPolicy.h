@@ -46,6 +46,7 @@ restore_collective( void ) {
   int rank, size;
   RESTORE_VAL( int, rank );
   RESTORE_VAL( int, size );
+  if( restore_remapped() ) return world; // Restarting on other ranks
   if( size!=world_size )
     ERROR(( "The number of processes that made this checkpt (%i) is different "
             "from the number of processes currently (%i)", size, world_size ));
@@ -145,6 +146,18 @@ struct RelayPolicy {
     p2p.recv( global, request.count, request.tag, request.id );
   }
 
+  inline void
+  mp_allmax_d( double * local,
+               double * global,
+               int n ) {
+    if( !local || !global || n<1 || abs(local-global)<n ) ERROR(( "Bad args" ));
+    P2PConnection & p2p = P2PConnection::instance();
+    MPRequest request( P2PTag::allreduce_max_double, P2PTag::data, n, 0 );
+    p2p.post( request );
+    p2p.send( local,  request.count, request.tag );
+    p2p.recv( global, request.count, request.tag, request.id );
+  }
+
   inline void
   mp_allsum_i( int * local,
                int * global,
@@ -222,6 +235,13 @@ struct RelayPolicy {
 
   inline mp_t *
   new_mp( int n_port ) {
+    mp_t * mp = new_private_mp( n_port );
+    REGISTER_OBJECT( mp, checkpt_mp, restore_mp, NULL );
+    return mp;
+  }
+  
+  inline mp_t *
+  new_private_mp( int n_port ) {
     mp_t * mp;
     if( n_port<1 ) ERROR(( "Bad args" ));
     MALLOC( mp, 1 );
@@ -234,15 +254,20 @@ struct RelayPolicy {
     CLEAR(  mp->rbuf_sz, n_port ); CLEAR(  mp->sbuf_sz, n_port ); 
     CLEAR(  mp->rreq_sz, n_port ); CLEAR(  mp->sreq_sz, n_port ); 
     CLEAR(  mp->rreq,    n_port ); CLEAR(  mp->sreq,    n_port ); 
-    REGISTER_OBJECT( mp, checkpt_mp, restore_mp, NULL );
     return mp;
   }
   
   inline void
   delete_mp( mp_t * mp ) {
-    int port;
     if( !mp ) return;
     UNREGISTER_OBJECT( mp );
+    delete_private_mp( mp );
+  }
+  
+  inline void
+  delete_private_mp( mp_t * mp ) {
+    int port;
+    if( !mp ) return;
     for( port=0; port<mp->n_port; port++ ) {
       FREE_ALIGNED( mp->rbuf[port] ); FREE_ALIGNED( mp->sbuf[port] ); 
     }
@@ -25,6 +25,10 @@ void mp_allsum_d( double *local, double *global, int n ) {
   return MPWrapper::instance().mp_allsum_d( local, global, n );
 }
 
+void mp_allmax_d( double *local, double *global, int n ) {
+  return MPWrapper::instance().mp_allmax_d( local, global, n );
+}
+
 void mp_allsum_i( int *local, int *global, int n ) {
   return MPWrapper::instance().mp_allsum_i( local, global, n );
 }
@@ -53,6 +57,14 @@ mp_t * new_mp( int n_port ) { return MPWrapper::instance().new_mp( n_port ); }
 
 void delete_mp( mp_t * mp ) { MPWrapper::instance().delete_mp( mp ); }
 
+mp_t * new_private_mp( int n_port ) {
+  return MPWrapper::instance().new_private_mp( n_port );
+}
+
+void delete_private_mp( mp_t * mp ) {
+  MPWrapper::instance().delete_private_mp( mp );
+}
+
 void * ALIGNED(16) mp_recv_buffer( mp_t * mp, int tag ) {
   return MPWrapper::instance().mp_recv_buffer( mp, tag );
 }
@@ -85,3 +97,9 @@ void mp_end_send( mp_t * mp, int sbuf ) {
   MPWrapper::instance().mp_end_send( mp, sbuf );
 }
 
+// Named for checkpt_sym (see REGISTER_SYMBOL)
+
+REGISTER_SYMBOL( checkpt_collective )
+REGISTER_SYMBOL( restore_collective )
+REGISTER_SYMBOL( checkpt_mp )
+REGISTER_SYMBOL( restore_mp )
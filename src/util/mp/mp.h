@@ -67,6 +67,11 @@ mp_allsum_d( double * local,
              double * global,
              int n );
 
+void
+mp_allmax_d( double * local,
+             double * global,
+             int n );
+
 void
 mp_allsum_i( int * local,
              int * global,
@@ -109,6 +114,17 @@ new_mp( int n_port );
 void
 delete_mp( mp_t * mp );
 
+/* Ports that are not registered with the checkpt service (e.g. the ports
+   the checkpt service itself uses while a checkpt is being written or
+   read).  They are not in checkpts and must be deleted with
+   delete_private_mp. */
+
+mp_t *
+new_private_mp( int n_port );
+
+void
+delete_private_mp( mp_t * mp );
+
 void * ALIGNED(128)
 mp_recv_buffer( mp_t * mp,
                 int port );
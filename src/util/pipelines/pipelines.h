@@ -47,6 +47,138 @@ enum { MAX_PIPELINE = 272 };
 
 #endif
 
+//----------------------------------------------------------------------------//
+// simd_width is the widest vector pipeline EXEC_PIPELINES may dispatch,
+// 0 (scalar), 4, 8 or 16.  It is set by boot_simd from the pipelines that
+// were compiled in and, when built with USE_SIMD_DISPATCH, from what the
+// processor supports.  The VPIC_SIMD environment variable (scalar, v4, v8,
+// v16 or auto) can lower it in a USE_SIMD_DISPATCH build and VPIC_SIMD_CPU
+// caps what the processor is taken to support there.
+//----------------------------------------------------------------------------//
+
+BEGIN_C_DECLS
+
+extern int simd_width;
+
+void
+boot_simd( int * pargc,
+           char *** pargv );
+
+END_C_DECLS
+
+//----------------------------------------------------------------------------//
+// Dynamic scheduling of pipeline work.  A kernel that opts in splits its
+// items into n_chunk chunks, chunk c being the items pipeline c of n_chunk
+// pipelines would get from DISTRIBUTE, and each pipeline processes the
+// chunks next_pipeline_chunk hands it until it returns -1.  The host
+// straggler (pipeline_rank==n_pipeline) gets chunk n_chunk.
+//
+// Each pipeline starts on a contiguous range of chunks of its own.  Once
+// that is exhausted, it steals the back half of what is left of the range
+// of another pipeline.  A range is packed in one 64-bit word per pipeline
+// that is only updated with compare and swap, so no locks are taken.
+//
+// pipeline_chunks is the number of chunks per pipeline requested with
+// --pipeline-chunks (1, the static schedule, by default).  init_pipeline_work
+// uses at most n_chunk_max chunks, so a kernel that can not be split more
+// finely than a static schedule passes 0.  With n_pipeline chunks, pipeline
+// r gets exactly chunk r.  Otherwise which pipeline processes a chunk, and
+// so the order in which floating point results are summed, varies from
+// run to run.
+//----------------------------------------------------------------------------//
+
+enum { MAX_PIPELINE_CHUNK = 8*MAX_PIPELINE };
+
+typedef struct pipeline_work_queue
+{
+  volatile int64_t range; // Chunks [lo,hi) left as lo | hi<<32
+  char pad[ 64 - sizeof(int64_t) ];
+} pipeline_work_queue_t;
+
+typedef struct pipeline_work
+{
+  pipeline_work_queue_t q[ MAX_PIPELINE + 1 ];
+  int n_chunk;
+  int n_pipeline;
+} pipeline_work_t;
+
+BEGIN_C_DECLS
+
+extern int pipeline_chunks;
+
+void
+boot_pipeline_work( int * pargc,
+                    char *** pargv );
+
+int
+init_pipeline_work( pipeline_work_t * w,
+                    int n_chunk_max,
+                    int n_pipeline );
+
+int
+next_pipeline_chunk( pipeline_work_t * w,
+                     int pipeline_rank );
+
+END_C_DECLS
+
+//----------------------------------------------------------------------------//
+// Pipeline affinity and NUMA placement (see pipelines_affinity.c).  When
+// --affinity binds the pipelines to cores, pipeline_affinity is set and
+// the large arrays are first touched with clear_pipelines by the
+// pipelines that use them so their pages land on the NUMA node of those
+// pipelines.  place_pipelines moves pages already touched to the NUMA
+// node of the pipelines that use them; only the pages whose pipeline
+// changed since the last placement of the array move, and
+// unplace_pipelines forgets that placement.  copy_pipelines copies an array
+// the same way so a pipelined pass over the copy finds it in cache.
+// log_numa_usage reports the NUMA nodes of the pages of an array and is
+// collective.
+//----------------------------------------------------------------------------//
+
+BEGIN_C_DECLS
+
+extern int pipeline_affinity;
+
+void
+boot_pipeline_affinity( int * pargc,
+                        char *** pargv,
+                        int n_slot );
+
+void
+bind_pipeline( int slot );
+
+void
+log_pipeline_affinity( void );
+
+void
+log_numa_usage( const char * name,
+                const void * p,
+                size_t sz );
+
+void
+clear_pipelines( void * p,
+                 size_t sz,
+                 int n,
+                 int block );
+
+void
+place_pipelines( void * p,
+                 size_t sz,
+                 int n,
+                 int block );
+
+void
+unplace_pipelines( const void * p );
+
+void
+copy_pipelines( void * p,
+                const void * src,
+                size_t sz,
+                int n,
+                int block );
+
+END_C_DECLS
+
 //----------------------------------------------------------------------------//
 // Make sure that pipelines_pthreads.h and pipelines_openmp.h can only be
 // included via this header file.
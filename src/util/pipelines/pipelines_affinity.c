@@ -0,0 +1,625 @@
+#define _GNU_SOURCE // For sched_setaffinity
+
+#include "pipelines_exec.h" // For util_base.h, datatypes and prototypes
+#include "../mp/mp.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#define HAS_AFFINITY
+#ifndef MPOL_MF_MOVE
+#define MPOL_MF_MOVE (1<<1) // From linux/mempolicy.h
+#endif
+#endif
+
+int pipeline_affinity = 0;
+
+enum { MAX_NUMA_NODE = 64 };
+
+// Cpu[slot] is the core of pipeline slot (see boot_pipeline_affinity).
+
+static int Cpu[ MAX_PIPELINE+1 ];
+static int N_slot = 0;
+
+// Placed holds the last placement of the most recently placed arrays (see
+// place_pipelines).
+
+enum { MAX_PLACED = 16 };
+
+static struct
+{
+  const void * p;
+  size_t sz;
+  int n;
+  int block;
+  int n_pipeline;
+} Placed[ MAX_PLACED ];
+
+static int Next_placed = 0;
+
+#if defined(HAS_AFFINITY)
+static cpu_set_t Boot_set; // Cores of the host before it was bound
+#endif
+
+#if defined(HAS_AFFINITY)
+
+//----------------------------------------------------------------------------//
+// NUMA node of a core from sysfs (0 if it can not be determined).
+//----------------------------------------------------------------------------//
+
+static int
+cpu_node( int cpu )
+{
+  char path[ 64 ];
+  struct dirent * e;
+  DIR * d;
+  int node = 0;
+
+  sprintf( path, "/sys/devices/system/cpu/cpu%i", cpu );
+  d = opendir( path );
+  if ( !d ) return 0;
+  while( ( e = readdir( d ) ) )
+    if ( strncmp( e->d_name, "node", 4 )==0 &&
+         sscanf( e->d_name + 4, "%i", &node )==1 ) break;
+  closedir( d );
+  return node < 0 || node >= MAX_NUMA_NODE ? 0 : node;
+}
+
+//----------------------------------------------------------------------------//
+// Parse a core list like "0-7,16,18" into cpu.  Returns the number of cores.
+//----------------------------------------------------------------------------//
+
+static int
+parse_cpu_list( const char * request,
+                int * cpu )
+{
+  const char * s = request;
+  char * end;
+  int n = 0, lo, hi;
+
+  while( *s )
+  {
+    lo = hi = (int)strtol( s, &end, 10 );
+    if ( end==s || lo < 0 ) ERROR(( "Invalid affinity \"%s\"", request ));
+    s = end;
+    if ( *s=='-' )
+    {
+      hi = (int)strtol( s+1, &end, 10 );
+      if ( end==s+1 || hi < lo ) ERROR(( "Invalid affinity \"%s\"", request ));
+      s = end;
+    }
+    for( ; lo<=hi; lo++ )
+    {
+      if ( n==MAX_PIPELINE+1 ) break;
+      cpu[n++] = lo;
+    }
+    if ( *s==',' ) s++;
+    else if ( *s ) ERROR(( "Invalid affinity \"%s\"", request ));
+  }
+
+  return n;
+}
+
+//----------------------------------------------------------------------------//
+// Rank of this process among the processes of its node from the variables
+// the common launchers set (-1 if none is set).  The pipelines boot before
+// the communication layer, so this can not be asked of it.
+//----------------------------------------------------------------------------//
+
+static int
+node_local_rank( void )
+{
+  static const char * var[] = { "OMPI_COMM_WORLD_LOCAL_RANK",
+                                "MPI_LOCALRANKID",
+                                "MV2_COMM_WORLD_LOCAL_RANK",
+                                "PMI_LOCAL_RANK",
+                                "SLURM_LOCALID",
+                                "ALPS_APP_PE_LOCAL",
+                                NULL };
+  const char * value;
+  int k;
+
+  for( k=0; var[k]; k++ )
+  {
+    value = getenv( var[k] );
+    if ( value && *value ) return atoi( value );
+  }
+
+  return -1;
+}
+
+#endif
+
+//----------------------------------------------------------------------------//
+// boot_pipeline_affinity picks the cores of n_slot pipeline slots from
+// --affinity or the VPIC_AFFINITY environment variable.  This is none (the
+// default, threads are left to the operating system), compact (fill the
+// cores this process may run on in order), scatter (round robin over the
+// NUMA nodes of those cores) or an explicit core list like "0-7,16".  Slots
+// wrap around the cores if there are more slots than cores.  When the
+// launcher did not restrict the cores of this process, compact and scatter
+// start at the slots of the node local rank of this process so the ranks
+// of a node do not share cores.  The thread dispatchers call this when
+// they boot and each of their threads binds itself with bind_pipeline.
+//----------------------------------------------------------------------------//
+
+void
+boot_pipeline_affinity( int * pargc,
+                        char *** pargv,
+                        int n_slot )
+{
+  const char * request;
+  int k;
+
+  request = strip_cmdline_string( pargc, pargv, "--affinity",
+                                  getenv( "VPIC_AFFINITY" ) );
+
+#if defined(HAS_AFFINITY)
+  // Undo the binding of the host from a previous boot.
+
+  if ( pipeline_affinity ) sched_setaffinity( 0, sizeof(Boot_set), &Boot_set );
+  else                     sched_getaffinity( 0, sizeof(Boot_set), &Boot_set );
+#endif
+
+  pipeline_affinity = 0;
+  N_slot            = 0;
+
+  for( k=0; k<MAX_PLACED; k++ ) Placed[k].p = NULL;
+
+  if ( !request || strcmp( request, "none" )==0 ) return;
+
+  if ( n_slot < 1 || n_slot > MAX_PIPELINE+1 ) ERROR(( "Bad args" ));
+
+#if defined(HAS_AFFINITY)
+  {
+    int cpu[ CPU_SETSIZE ], n_cpu = 0, c, k, node, n_left, first = 0;
+    int next[ MAX_NUMA_NODE ];
+
+    if ( strcmp( request, "compact" )==0 || strcmp( request, "scatter" )==0 )
+    {
+      for( c=0; c<CPU_SETSIZE; c++ )
+        if ( CPU_ISSET( c, &Boot_set ) ) cpu[n_cpu++] = c;
+
+      // A process that may run on every core of the node is not bound by
+      // its launcher and the other ranks of the node see the same cores.
+
+      if ( n_cpu >= sysconf( _SC_NPROCESSORS_ONLN ) )
+      {
+        int local_rank = node_local_rank();
+        if ( local_rank >= 0 ) first = local_rank*n_slot;
+        else WARNING(( "The node local rank is unknown; the ranks of a node "
+                       "bind their pipelines to the same cores unless the "
+                       "launcher binds each rank to its own cores" ));
+        if ( first && first + n_slot > n_cpu )
+          WARNING(( "Node local rank %i shares cores with other ranks",
+                    local_rank ));
+      }
+
+      // Scatter takes the next core of each NUMA node in turn.
+
+      if ( request[0]=='s' )
+      {
+        int order[ CPU_SETSIZE ], node_of[ CPU_SETSIZE ];
+
+        for( k=0; k<n_cpu; k++ ) node_of[k] = cpu_node( cpu[k] );
+        for( node=0; node<MAX_NUMA_NODE; node++ ) next[node] = 0;
+
+        for( n_left=0; n_left<n_cpu; )
+          for( node=0; node<MAX_NUMA_NODE; node++ )
+          {
+            for( k=next[node]; k<n_cpu && node_of[k]!=node; k++ ) ;
+            next[node] = k+1;
+            if ( k<n_cpu ) order[n_left++] = cpu[k];
+          }
+
+        for( k=0; k<n_cpu; k++ ) cpu[k] = order[k];
+      }
+    }
+
+    else n_cpu = parse_cpu_list( request, cpu );
+
+    if ( n_cpu < 1 ) ERROR(( "No cores for affinity \"%s\"", request ));
+
+    if ( n_cpu < n_slot )
+      WARNING(( "%i pipeline threads share %i cores", n_slot, n_cpu ));
+
+    for( k=0; k<n_slot; k++ ) Cpu[k] = cpu[ ( first + k ) % n_cpu ];
+
+    pipeline_affinity = 1;
+    N_slot            = n_slot;
+  }
+#else
+  WARNING(( "Pipeline affinity is not supported on this platform" ));
+#endif
+}
+
+//----------------------------------------------------------------------------//
+// Bind the calling thread to the core of a pipeline slot.
+//----------------------------------------------------------------------------//
+
+void
+bind_pipeline( int slot )
+{
+#if defined(HAS_AFFINITY)
+  cpu_set_t set;
+
+  if ( !pipeline_affinity || slot < 0 || slot >= N_slot ) return;
+
+  CPU_ZERO( &set );
+  CPU_SET( Cpu[slot], &set );
+  if ( sched_setaffinity( 0, sizeof(set), &set ) )
+    WARNING(( "Unable to bind pipeline %i to core %i (%s)",
+              slot, Cpu[slot], strerror( errno ) ));
+#endif
+}
+
+//----------------------------------------------------------------------------//
+// Report the cores of the pipelines and the memory of the NUMA nodes of
+// this node.  This is called after the communication layer is up so it is
+// reported once.
+//----------------------------------------------------------------------------//
+
+void
+log_pipeline_affinity( void )
+{
+#if defined(HAS_AFFINITY)
+  char path[ 64 ], line[ 256 ];
+  FILE * f;
+  double total, avail;
+  int k, node;
+
+  if ( !pipeline_affinity || world_rank ) return;
+
+  log_printf( "*** Pipeline cores:" );
+  for( k=0; k<N_slot; k++ ) log_printf( " %i", Cpu[k] );
+  log_printf( "\n" );
+
+  for( node=0; node<MAX_NUMA_NODE; node++ )
+  {
+    sprintf( path, "/sys/devices/system/node/node%i/meminfo", node );
+    f = fopen( path, "r" );
+    if ( !f ) continue;
+    total = avail = 0;
+    while( fgets( line, sizeof(line), f ) )
+    {
+      char * s = strstr( line, "MemTotal:" );
+      if ( s ) total = atof( s + 9 );
+      s = strstr( line, "MemFree:" );
+      if ( s ) avail = atof( s + 8 );
+    }
+    fclose( f );
+    log_printf( "*** NUMA node %i: %.0f MiB free of %.0f MiB\n",
+                node, avail/1024, total/1024 );
+  }
+#endif
+}
+
+//----------------------------------------------------------------------------//
+// Report on which NUMA nodes the pages of an array are, summed over ranks.
+// Pages not touched yet are reported as untouched.  This is collective.
+//----------------------------------------------------------------------------//
+
+void
+log_numa_usage( const char * name,
+                const void * p,
+                size_t sz )
+{
+  double local[ MAX_NUMA_NODE+1 ], global[ MAX_NUMA_NODE+1 ];
+  int node;
+
+  for( node=0; node<=MAX_NUMA_NODE; node++ ) local[node] = 0;
+
+#if defined(HAS_AFFINITY) && defined(SYS_move_pages)
+  if ( p && sz )
+  {
+    enum { N_BATCH = 1024 };
+    void * page[ N_BATCH ];
+    int status[ N_BATCH ];
+    size_t pg = (size_t)sysconf( _SC_PAGESIZE );
+    char * p0 = (char *)( (size_t)p & ~( pg-1 ) );
+    char * p1 = (char *)p + sz;
+    int n, k;
+
+    while( p0 < p1 )
+    {
+      for( n=0; n<N_BATCH && p0<p1; n++, p0+=pg ) page[n] = p0;
+      if ( syscall( SYS_move_pages, 0, (unsigned long)n, page, NULL,
+                    status, 0 ) ) for( k=0; k<n; k++ ) status[k] = -1;
+      for( k=0; k<n; k++ )
+        local[ status[k]>=0 && status[k]<MAX_NUMA_NODE ? status[k] :
+               MAX_NUMA_NODE ] += (double)pg;
+    }
+  }
+#else
+  local[MAX_NUMA_NODE] = (double)sz;
+#endif
+
+  mp_allsum_d( local, global, MAX_NUMA_NODE+1 );
+
+  if ( world_rank ) return;
+
+  log_printf( "*** %s:", name );
+  for( node=0; node<MAX_NUMA_NODE; node++ )
+    if ( global[node] ) log_printf( " node %i %.1f MiB,", node,
+                                    global[node]/1048576. );
+  log_printf( " untouched %.1f MiB\n", global[MAX_NUMA_NODE]/1048576. );
+}
+
+//----------------------------------------------------------------------------//
+// Zero n items of sz bytes at p with the pipelines, each pipeline clearing
+// the items DISTRIBUTE with the block size block gives it.  On freshly
+// allocated memory, this places the pages on the NUMA node of the pipeline
+// that will use them (first touch).
+//----------------------------------------------------------------------------//
+
+typedef struct clear_pipelines_args
+{
+  MEM_PTR( char, 128 ) p;
+  size_t sz;
+  int n;
+  int block;
+
+  PAD_STRUCT( SIZEOF_MEM_PTR + sizeof(size_t) + 2*sizeof(int) )
+
+} clear_pipelines_args_t;
+
+void
+clear_pipelines_pipeline_scalar( clear_pipelines_args_t * args,
+                                 int pipeline_rank,
+                                 int n_pipeline )
+{
+  int i, n;
+
+  DISTRIBUTE( args->n, args->block, pipeline_rank, n_pipeline, i, n );
+
+  if ( n ) memset( args->p + (size_t)i*args->sz, 0, (size_t)n*args->sz );
+}
+
+void
+clear_pipelines( void * p,
+                 size_t sz,
+                 int n,
+                 int block )
+{
+  DECLARE_ALIGNED_ARRAY( clear_pipelines_args_t, 128, args, 1 );
+
+  if ( ( !p && n ) || n < 0 || block < 1 ) ERROR(( "Bad args" ));
+
+  args->p     = (char *)p;
+  args->sz    = sz;
+  args->n     = n;
+  args->block = block;
+
+  EXEC_PIPELINES( clear_pipelines, args, 0 );
+
+  WAIT_PIPELINES();
+}
+
+//----------------------------------------------------------------------------//
+// Copy n items of sz bytes from src to p with the pipelines, each pipeline
+// copying the items DISTRIBUTE with the block size block gives it.  A
+// pipelined pass over the copy with the same block size then finds its
+// items in the cache of its core.
+//----------------------------------------------------------------------------//
+
+typedef struct copy_pipelines_args
+{
+  MEM_PTR( char,       128 ) p;
+  MEM_PTR( const char, 128 ) src;
+  size_t sz;
+  int n;
+  int block;
+
+  PAD_STRUCT( 2*SIZEOF_MEM_PTR + sizeof(size_t) + 2*sizeof(int) )
+
+} copy_pipelines_args_t;
+
+void
+copy_pipelines_pipeline_scalar( copy_pipelines_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+  int i, n;
+
+  DISTRIBUTE( args->n, args->block, pipeline_rank, n_pipeline, i, n );
+
+  if ( n ) memcpy( args->p   + (size_t)i*args->sz,
+                   args->src + (size_t)i*args->sz, (size_t)n*args->sz );
+}
+
+void
+copy_pipelines( void * p,
+                const void * src,
+                size_t sz,
+                int n,
+                int block )
+{
+  DECLARE_ALIGNED_ARRAY( copy_pipelines_args_t, 128, args, 1 );
+
+  if ( ( ( !p || !src ) && n ) || n < 0 || block < 1 ) ERROR(( "Bad args" ));
+
+  args->p     = (char *)p;
+  args->src   = (const char *)src;
+  args->sz    = sz;
+  args->n     = n;
+  args->block = block;
+
+  EXEC_PIPELINES( copy_pipelines, args, 0 );
+
+  WAIT_PIPELINES();
+}
+
+//----------------------------------------------------------------------------//
+// Move the pages of n items of sz bytes at p to the NUMA node of the
+// pipeline DISTRIBUTE with the block size block gives the items to.  Each
+// page goes with the pipeline its first byte belongs to.  This keeps the
+// placement of an array whose used part changed (like the particles after
+// they were loaded or sorted) in line with the pipelines that process it.
+// The last placement of the most recently placed arrays is remembered;
+// only the pages whose pipeline changed since then move, so placing an
+// array again after it was reordered in place (as sort_p does) is free.
+// unplace_pipelines forgets the placement of an array whose pages were
+// touched otherwise (like restored particles).  It does nothing unless the
+// pipelines are bound to cores.
+//----------------------------------------------------------------------------//
+
+typedef struct place_pipelines_args
+{
+  MEM_PTR( char, 128 ) p;
+  size_t sz;
+  int n;     // Number of items to place
+  int n_old; // Number of items placed before (0 if none)
+  int block;
+
+  PAD_STRUCT( SIZEOF_MEM_PTR + sizeof(size_t) + 3*sizeof(int) )
+
+} place_pipelines_args_t;
+
+static void
+record_placement( const void * p,
+                  size_t sz,
+                  int n,
+                  int block )
+{
+  int k;
+
+  for( k=0; k<MAX_PLACED && Placed[k].p!=p; k++ ) ;
+
+  if ( k==MAX_PLACED )
+  {
+    k           = Next_placed;
+    Next_placed = ( Next_placed + 1 ) % MAX_PLACED;
+  }
+
+  Placed[k].p          = p;
+  Placed[k].sz         = sz;
+  Placed[k].n          = n;
+  Placed[k].block      = block;
+  Placed[k].n_pipeline = N_PIPELINE;
+}
+
+void
+unplace_pipelines( const void * p )
+{
+  int k;
+
+  if ( !p ) return;
+
+  for( k=0; k<MAX_PLACED; k++ )
+    if ( Placed[k].p==p ) Placed[k].p = NULL;
+}
+
+#if defined(HAS_AFFINITY) && defined(SYS_move_pages)
+
+// Pages [*pg0,*pg1) whose first byte the pipeline gets of n items
+
+static void
+place_pipelines_pages( const place_pipelines_args_t * args,
+                       int n,
+                       int pipeline_rank,
+                       int n_pipeline,
+                       size_t pg,
+                       char ** pg0,
+                       char ** pg1 )
+{
+  int i;
+
+  DISTRIBUTE( n, args->block, pipeline_rank, n_pipeline, i, n );
+
+  *pg0 = args->p + (size_t)i*args->sz;
+  *pg1 = *pg0 + (size_t)n*args->sz;
+  *pg0 = (char *)( i ? ( (size_t)*pg0 + pg-1 ) & ~( pg-1 )
+                     : (size_t)*pg0 & ~( pg-1 ) );
+  if ( *pg1 < *pg0 ) *pg1 = *pg0;
+}
+
+static void
+move_pipeline_pages( char * p0,
+                     char * p1,
+                     size_t pg,
+                     int cpu )
+{
+  enum { N_BATCH = 1024 };
+  void * page[ N_BATCH ];
+  int node[ N_BATCH ], status[ N_BATCH ];
+  int k;
+
+  for( k=0; k<N_BATCH; k++ ) node[k] = cpu_node( cpu );
+
+  while( p0 < p1 )
+  {
+    for( k=0; k<N_BATCH && p0<p1; k++, p0+=pg ) page[k] = p0;
+    syscall( SYS_move_pages, 0, (unsigned long)k, page, node, status,
+             MPOL_MF_MOVE );
+  }
+}
+
+#endif
+
+void
+place_pipelines_pipeline_scalar( place_pipelines_args_t * args,
+                                 int pipeline_rank,
+                                 int n_pipeline )
+{
+#if defined(HAS_AFFINITY) && defined(SYS_move_pages)
+  size_t pg = (size_t)sysconf( _SC_PAGESIZE );
+  char * p0, * p1, * q0, * q1;
+  int cpu;
+
+  cpu = sched_getcpu();
+  if ( cpu < 0 ) return;
+
+  place_pipelines_pages( args, args->n,     pipeline_rank, n_pipeline, pg,
+                         &p0, &p1 );
+  place_pipelines_pages( args, args->n_old, pipeline_rank, n_pipeline, pg,
+                         &q0, &q1 );
+
+  // Only the pages outside the pages the pipeline had before move
+
+  if ( q0 >= q1 ) q0 = q1 = p1;
+
+  move_pipeline_pages( p0, q0 < p1 ? q0 : p1, pg, cpu );
+  move_pipeline_pages( q1 > p0 ? q1 : p0, p1, pg, cpu );
+#else
+  (void)args; (void)pipeline_rank; (void)n_pipeline;
+#endif
+}
+
+void
+place_pipelines( void * p,
+                 size_t sz,
+                 int n,
+                 int block )
+{
+  DECLARE_ALIGNED_ARRAY( place_pipelines_args_t, 128, args, 1 );
+
+  int k;
+
+  if ( ( !p && n ) || n < 0 || block < 1 ) ERROR(( "Bad args" ));
+
+  if ( !pipeline_affinity || !n ) return;
+
+  args->p     = (char *)p;
+  args->sz    = sz;
+  args->n     = n;
+  args->n_old = 0;
+  args->block = block;
+
+  for( k=0; k<MAX_PLACED; k++ )
+    if ( Placed[k].p==p && Placed[k].sz==sz && Placed[k].block==block &&
+         Placed[k].n_pipeline==N_PIPELINE ) args->n_old = Placed[k].n;
+
+  if ( args->n_old==n ) return;
+
+  EXEC_PIPELINES( place_pipelines, args, 0 );
+
+  WAIT_PIPELINES();
+
+  record_placement( p, sz, n, block );
+}
@@ -11,6 +11,54 @@
 #include "../v8/v8.h"
 #include "../v16/v16.h"
 
+//----------------------------------------------------------------------------//
+// With run time simd dispatch, SELECT_PIPELINE(name) picks the widest
+// name##_pipeline_vN the including file provides that was compiled into
+// this build and that does not exceed simd_width.  The v4 pipelines are
+// built with the baseline ISA; the v8 and v16 pipelines are only referenced
+// when they were built for AVX2 and AVX-512.
+//----------------------------------------------------------------------------//
+
+#if defined(VPIC_SIMD_DISPATCH)
+
+#if defined(V4_ACCELERATION) && defined(HAS_V4_PIPELINE)
+# define PIPELINE_V4(name) ( (pipeline_func_t) name##_pipeline_v4 )
+#else
+# define PIPELINE_V4(name) NULL
+#endif
+
+#if defined(VPIC_SIMD_DISPATCH_V8) && defined(HAS_V8_PIPELINE)
+# define PIPELINE_V8(name) ( (pipeline_func_t) name##_pipeline_v8 )
+#else
+# define PIPELINE_V8(name) NULL
+#endif
+
+#if defined(VPIC_SIMD_DISPATCH_V16) && defined(HAS_V16_PIPELINE)
+# define PIPELINE_V16(name) ( (pipeline_func_t) name##_pipeline_v16 )
+#else
+# define PIPELINE_V16(name) NULL
+#endif
+
+STATIC_INLINE pipeline_func_t
+select_pipeline( pipeline_func_t scalar,
+                 pipeline_func_t v4,
+                 pipeline_func_t v8,
+                 pipeline_func_t v16 )
+{
+  if ( v16 && simd_width >= 16 ) return v16;
+  if ( v8  && simd_width >=  8 ) return v8;
+  if ( v4  && simd_width >=  4 ) return v4;
+  return scalar;
+}
+
+# define SELECT_PIPELINE(name)                                   \
+  select_pipeline( (pipeline_func_t) name##_pipeline_scalar,     \
+                   PIPELINE_V4(name),                            \
+                   PIPELINE_V8(name),                            \
+                   PIPELINE_V16(name) )
+
+#endif
+
 //----------------------------------------------------------------------------//
 // Make sure that pipelines_exec_pth.h and pipelines_exec_omp.h can only be
 // included via this header file.
@@ -16,13 +16,35 @@
 
 #define WAIT_PIPELINES() _Pragma( TOSTRING( omp barrier ) )
 
+//----------------------------------------------------------------------------//
+// Macro defines to support run time simd dispatch.  Uses thread dispatcher
+// on the pipeline chosen by SELECT_PIPELINE and the caller does straggler
+// cleanup with the scalar pipeline.
+//----------------------------------------------------------------------------//
+
+#if defined(VPIC_SIMD_DISPATCH)
+
+# define EXEC_PIPELINES(name, args, str)                                   \
+  {                                                                        \
+    pipeline_func_t pipeline = SELECT_PIPELINE(name);                      \
+    _Pragma( TOSTRING( omp parallel num_threads(N_PIPELINE) shared(args) ) ) \
+    {                                                                      \
+      _Pragma( TOSTRING( omp for ) )                                       \
+      for( int id = 0; id < N_PIPELINE; id++ )                             \
+      {                                                                    \
+        pipeline( args+id*sizeof(*args)*str, id, N_PIPELINE );             \
+      }                                                                    \
+    }                                                                      \
+  }                                                                        \
+  name##_pipeline_scalar( args+str*N_PIPELINE, N_PIPELINE, N_PIPELINE );
+
 //----------------------------------------------------------------------------//
 // Macro defines to support v16 simd vector acceleration.  Uses thread
 // dispatcher on the v16 pipeline and the caller does straggler cleanup with
 // the scalar pipeline.
 //----------------------------------------------------------------------------//
 
-#if defined(V16_ACCELERATION) && defined(HAS_V16_PIPELINE)
+#elif defined(V16_ACCELERATION) && defined(HAS_V16_PIPELINE)
 
 # define EXEC_PIPELINES(name, args, str)                                   \
   _Pragma( TOSTRING( omp parallel num_threads(N_PIPELINE) shared(args) ) ) \
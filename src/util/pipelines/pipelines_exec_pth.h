@@ -12,13 +12,26 @@
 
 # define WAIT_PIPELINES() thread.wait()
 
+//----------------------------------------------------------------------------//
+// Macro defines to support run time simd dispatch.  Uses thread dispatcher
+// on the pipeline chosen by SELECT_PIPELINE and the caller does straggler
+// cleanup with the scalar pipeline.
+//----------------------------------------------------------------------------//
+
+#if defined(VPIC_SIMD_DISPATCH)
+
+# define EXEC_PIPELINES(name,args,str)                           \
+  thread.dispatch( SELECT_PIPELINE(name),                        \
+                   args, sizeof(*args), str );                   \
+  name##_pipeline_scalar( args+str*N_PIPELINE, N_PIPELINE, N_PIPELINE )
+
 //----------------------------------------------------------------------------//
 // Macro defines to support v16 simd vector acceleration.  Uses thread
 // dispatcher on the v16 pipeline and the caller does straggler cleanup with
 // the scalar pipeline.
 //----------------------------------------------------------------------------//
 
-#if defined(V16_ACCELERATION) && defined(HAS_V16_PIPELINE)
+#elif defined(V16_ACCELERATION) && defined(HAS_V16_PIPELINE)
 
 # define EXEC_PIPELINES(name,args,str)                           \
   thread.dispatch( (pipeline_func_t)name##_pipeline_v16,         \
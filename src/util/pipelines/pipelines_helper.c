@@ -27,6 +27,15 @@ omp_boot( int * pargc,
   //assign our helper values
   omp_helper.n_pipeline       = n_pipeline;
   omp_helper.dispatch_to_host = dispatch_to_host;
+
+  // Bind the threads of the team the pipelines run on (the host is
+  // thread 0)
+  boot_pipeline_affinity( pargc, pargv, n_pipeline );
+  if ( pipeline_affinity )
+  {
+    #pragma omp parallel num_threads(n_pipeline)
+    bind_pipeline( omp_get_thread_num() );
+  }
 }
 
 /*
@@ -9,6 +9,17 @@
 
 #include <omp.h>
 
+//----------------------------------------------------------------------------//
+// A pipeline function takes a pointer to arguments for the pipeline and an
+// integer which gives the rank of the pipeline and the total number of
+// pipelines dispatched.
+//----------------------------------------------------------------------------//
+
+typedef void
+(*pipeline_func_t)( void * args,
+                    int pipeline_rank,
+                    int n_pipeline );
+
 //----------------------------------------------------------------------------//
 // Generic macros that are used for all cases of vector acceleration as well
 // as the standard case that does not use vector acceleration.
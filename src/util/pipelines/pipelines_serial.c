@@ -73,4 +73,9 @@ pipeline_dispatcher_t serial = {
   serial_wait      // wait
 };
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( checkpt_serial )
+REGISTER_SYMBOL( restore_serial )
+
 #endif
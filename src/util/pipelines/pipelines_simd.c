@@ -0,0 +1,137 @@
+#include "pipelines.h" // For util_base.h, datatypes and prototypes
+
+#include <string.h>
+
+int simd_width = 0;
+
+//----------------------------------------------------------------------------//
+// Widest simd pipeline width that was compiled into this build.
+//----------------------------------------------------------------------------//
+
+static int
+simd_compiled_width( void )
+{
+#if defined(VPIC_SIMD_DISPATCH_V16) || \
+    defined(USE_V16_PORTABLE)       || \
+    defined(USE_V16_AVX512)
+  return 16;
+#elif defined(VPIC_SIMD_DISPATCH_V8) || \
+      defined(USE_V8_PORTABLE)       || \
+      defined(USE_V8_AVX)            || \
+      defined(USE_V8_AVX2)
+  return 8;
+#elif defined(USE_V4_PORTABLE) || \
+      defined(USE_V4_SSE)      || \
+      defined(USE_V4_AVX)      || \
+      defined(USE_V4_AVX2)     || \
+      defined(USE_V4_ALTIVEC)
+  return 4;
+#else
+  return 0;
+#endif
+}
+
+//----------------------------------------------------------------------------//
+// Width named by a simd request: scalar, v4, v8 or v16 (auto is the widest).
+//----------------------------------------------------------------------------//
+
+static int
+simd_request_width( const char * request )
+{
+  if ( strcmp( request, "auto"   )==0 ) return 16;
+  if ( strcmp( request, "scalar" )==0 ) return 0;
+  if ( strcmp( request, "v4"     )==0 ) return 4;
+  if ( strcmp( request, "v8"     )==0 ) return 8;
+  if ( strcmp( request, "v16"    )==0 ) return 16;
+
+  ERROR(( "Invalid simd width requested (%s)", request ));
+  return 0;
+}
+
+//----------------------------------------------------------------------------//
+// Widest simd pipeline width this processor can run.  Only the v8 and v16
+// pipelines of a USE_SIMD_DISPATCH build need a run time check; everything
+// else was built for the baseline ISA the binary already requires.  The
+// VPIC_SIMD_CPU environment variable (same values as VPIC_SIMD) caps what
+// the processor is taken to support, such that the fallback on processors
+// without AVX-512 or AVX2 can be tested on any processor.
+//----------------------------------------------------------------------------//
+
+static int
+simd_supported_width( void )
+{
+  int width = simd_compiled_width();
+
+#if defined(VPIC_SIMD_DISPATCH)
+  if ( width > 4 ) width = 4;
+
+  __builtin_cpu_init();
+
+# if defined(VPIC_SIMD_DISPATCH_V8)
+  if ( __builtin_cpu_supports( "avx2" ) &&
+       __builtin_cpu_supports( "fma"  ) )
+    width = 8;
+# endif
+
+# if defined(VPIC_SIMD_DISPATCH_V16)
+  if ( __builtin_cpu_supports( "avx512f"  ) &&
+       __builtin_cpu_supports( "avx512dq" ) )
+    width = 16;
+# endif
+
+  {
+    const char * cpu = getenv( "VPIC_SIMD_CPU" );
+    if ( cpu && width > simd_request_width( cpu ) )
+      width = simd_request_width( cpu );
+  }
+#endif
+
+  return width;
+}
+
+//----------------------------------------------------------------------------//
+// boot_simd selects the simd width.  The width can be lowered with --simd or
+// the VPIC_SIMD environment variable, which take one of scalar, v4, v8, v16
+// or auto.  This only has an effect when built with USE_SIMD_DISPATCH as the
+// width is otherwise fixed at compile time.
+//----------------------------------------------------------------------------//
+
+void
+boot_simd( int * pargc,
+           char *** pargv )
+{
+  const char * request;
+  int width, supported;
+
+  request = strip_cmdline_string( pargc, pargv, "--simd",
+                                  getenv( "VPIC_SIMD" ) );
+
+  supported = simd_supported_width();
+  width     = supported;
+
+  if ( request && strcmp( request, "auto" ) )
+  {
+    width = simd_request_width( request );
+  }
+
+#if defined(VPIC_SIMD_DISPATCH)
+  if ( width > supported )
+  {
+    WARNING(( "Requested simd width %s is not supported by this processor "
+              "or build; using %i", request, supported ));
+    width = supported;
+  }
+
+  if ( world_rank==0 )
+    log_printf( "*** Using simd width %i (%s)\n", width,
+                request ? request : "auto" );
+#else
+  if ( width != supported )
+    WARNING(( "Requested simd width %s ignored; build with USE_SIMD_DISPATCH "
+              "to select it at run time", request ));
+
+  width = supported;
+#endif
+
+  simd_width = width;
+}
@@ -38,6 +38,7 @@
 // (?) Timeouts in thread_halt, thread_boot (spin wait)
 
 #include "pipelines.h"
+#include "../profile/profile.h"
 
 #if defined(VPIC_USE_PTHREADS)
 
@@ -68,7 +69,8 @@ typedef struct pipeline_state {
 static pthread_t Host;
 static pipeline_state_t Pipeline[ MAX_PIPELINE ];
 static volatile int Done[ MAX_PIPELINE ];
-static int Id = 0;
+static double T0[ MAX_PIPELINE ], T1[ MAX_PIPELINE ]; // Busy time of job
+static int64_t Count[ MAX_PIPELINE ][ PROFILE_MAX_COUNTER ]; // Hardware counts
 static int Busy = 0;
 static int Dispatch_To_Host = 0;
 
@@ -85,9 +87,9 @@ pipeline_dispatcher_t *
 restore_thread( void ) {
   int n_pipeline;
   RESTORE_VAL( int, n_pipeline );
-  if( thread.n_pipeline!=n_pipeline )
-    ERROR(( "--tpp changed between checkpt (%i) and restore (%i)",
-            n_pipeline, thread.n_pipeline ));
+  if( thread.n_pipeline!=n_pipeline && !world_rank )
+    MESSAGE(( "--tpp changed between checkpt (%i) and restore (%i)",
+              n_pipeline, thread.n_pipeline ));
   return &thread;
 }
 
@@ -154,7 +156,7 @@ restore_thread( void ) {
  * Dependencies: pthread_self, pthread_cond_init, pthread_mutex_init
  *               pthread_create
  *
- * Globals read/altered: thread.n_pipeline (rw), Host (rw), Id (rw),
+ * Globals read/altered: thread.n_pipeline (rw), Host (rw),
  *                       Pipeline (rw), Busy (rw), Dispatch_To_Host (rw)
  *
  * Notes:
@@ -183,9 +185,14 @@ thread_boot( int * pargc,
   if( n_pipeline<1 || n_pipeline>MAX_PIPELINE )
     ERROR(( "Invalid number of pipelines requested (%i)", n_pipeline ));
 
+  // Pick the cores of the pipeline threads and the host (the last slot).
+  // Each pipeline thread binds itself when it starts.
+
+  boot_pipeline_affinity( pargc, pargv, n_pipeline+1-Dispatch_To_Host );
+  bind_pipeline( n_pipeline-Dispatch_To_Host );
+
   // Initialize some global variables. Note: thread.n_pipeline = 0 here
 
-  Id   = 0;
   Busy = 0;
   Host = pthread_self();
 
@@ -304,7 +311,7 @@ thread_halt( void ) {
   // Free resources associated with Threader as all pipelines are now
   // dead.  Note: This must be done in a separate loop because
   // non-terminated pipelines calling parallel_execute may try to
-  // access mutexes for destroyed pipelines and Id and with unknown
+  // access mutexes for destroyed pipelines with unknown
   // results if the mutexes were destroyed before all the pipelines
   // were terminated.
 
@@ -343,7 +350,7 @@ thread_halt( void ) {
  * Dependencies: pthread_mutex_unlock, pthread_self, pthread_mutex_trylock,
  *               pthread_equal, pthread_mutex_lock, pthread_cond_signal
  *
- * Globals read/altered: thread.n_pipeline (r), Id, Dispatch_To_Host,
+ * Globals read/altered: thread.n_pipeline (r), Dispatch_To_Host,
  *                       Pipeline (rw)
  *
  * Notes:
@@ -386,9 +393,10 @@ parallel_execute( pipeline_func_t func,
 
   for(;;) {
 
-    // Get an id of a pipeline to query.
+    // Jobs always go to the pipeline of the same id such that a job
+    // always runs on the same core (see boot_pipeline_affinity).
 
-    id = Id; if( (++Id) >= thread.n_pipeline-Dispatch_To_Host ) Id = 0;
+    id = job % ( thread.n_pipeline-Dispatch_To_Host );
 
     if( !pthread_mutex_trylock( &Pipeline[id].mutex ) ) {
 
@@ -462,6 +470,10 @@ static void*
 pipeline_mgr(void *_pipeline) {
 
   pipeline_state_t* pipeline = (pipeline_state_t*)_pipeline;
+  int64_t count[ PROFILE_MAX_COUNTER ];
+  int k;
+
+  bind_pipeline( pipeline-Pipeline );
 
   // Pipeline state is PIPELINE_ACK and the pipeline mutex is unlocked
   // when entering.  Since pthread_cond_wait unlockes the pipeline
@@ -490,8 +502,16 @@ pipeline_mgr(void *_pipeline) {
       // necessary.  Note: the pipeline mutex is locked while the
       // pipeline is executing a task.
 
+      if( profile_n_counter ) profile_count( pipeline-Pipeline, count );
+      T0[ pipeline->job ] = wallclock();
       if( pipeline->func )
         pipeline->func( pipeline->args, pipeline->job, pipeline->n_job );
+      T1[ pipeline->job ] = wallclock();
+      if( profile_n_counter ) {
+        profile_count( pipeline-Pipeline, Count[ pipeline->job ] );
+        for( k=0; k<profile_n_counter; k++ )
+          Count[ pipeline->job ][k] -= count[k];
+      }
       if( pipeline->flag ) *pipeline->flag = 1;
 
       // Pass through into the next case
@@ -541,8 +561,17 @@ thread_dispatch( pipeline_func_t func,
   }
 
   if( Dispatch_To_Host ) {
+    int64_t count[ PROFILE_MAX_COUNTER ];
+    int k;
     Done[id] = 0;
+    if( profile_n_counter ) profile_count( MAX_PIPELINE, count );
+    T0[id] = wallclock();
     if( func ) func( ((char *)args) + id*sz*str, id, thread.n_pipeline );
+    T1[id] = wallclock();
+    if( profile_n_counter ) {
+      profile_count( MAX_PIPELINE, Count[id] );
+      for( k=0; k<profile_n_counter; k++ ) Count[id][k] -= count[k];
+    }
     Done[id] = 1;
   }
 }
@@ -564,6 +593,9 @@ thread_wait( void ) {
     else           nanodelay(5);
   }
 
+  profile_pipelines( thread.n_pipeline, T0, T1,
+                     profile_n_counter ? Count[0] : NULL );
+
   Busy = 0;
 }
 
@@ -575,4 +607,9 @@ pipeline_dispatcher_t thread = {
   thread_wait      // wait
 };
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( checkpt_thread )
+REGISTER_SYMBOL( restore_thread )
+
 #endif
@@ -0,0 +1,129 @@
+#include "pipelines.h" // For util_base.h, datatypes and prototypes
+
+int pipeline_chunks = 1;
+
+#define RANGE( lo, hi ) ( (int64_t)(uint32_t)(lo) | ( (int64_t)(hi)<<32 ) )
+#define RANGE_LO( r )   ( (int)(uint32_t)(r) )
+#define RANGE_HI( r )   ( (int)( (r)>>32 ) )
+
+//----------------------------------------------------------------------------//
+// boot_pipeline_work sets the number of chunks per pipeline the kernels
+// that support dynamic scheduling split their work into.
+//----------------------------------------------------------------------------//
+
+void
+boot_pipeline_work( int * pargc,
+                    char *** pargv )
+{
+  int n = strip_cmdline_int( pargc, pargv, "--pipeline-chunks", 1 );
+
+  if ( n < 1 || n*MAX_PIPELINE > MAX_PIPELINE_CHUNK )
+    ERROR(( "Invalid number of chunks per pipeline requested (%i)", n ));
+
+  if ( n > 1 && world_rank==0 )
+    log_printf( "*** Scheduling up to %i chunks per pipeline dynamically\n",
+                n );
+
+  pipeline_chunks = n;
+}
+
+//----------------------------------------------------------------------------//
+// Give each pipeline an equal share of the chunks to start with and returns
+// the number of chunks.
+//----------------------------------------------------------------------------//
+
+int
+init_pipeline_work( pipeline_work_t * w,
+                    int n_chunk_max,
+                    int n_pipeline )
+{
+  int n_chunk, rank, lo, n;
+
+  if ( !w || n_pipeline < 1 || n_pipeline > MAX_PIPELINE )
+    ERROR(( "Bad args" ));
+
+  n_chunk = pipeline_chunks*n_pipeline;
+  if ( n_chunk > n_chunk_max ) n_chunk = n_chunk_max;
+  if ( n_chunk < n_pipeline  ) n_chunk = n_pipeline;
+
+  for( rank = 0; rank < n_pipeline; rank++ )
+  {
+    DISTRIBUTE( n_chunk, 1, rank, n_pipeline, lo, n );
+    w->q[rank].range = RANGE( lo, lo + n );
+  }
+
+  w->q[n_pipeline].range = RANGE( n_chunk, n_chunk + 1 );
+
+  w->n_chunk    = n_chunk;
+  w->n_pipeline = n_pipeline;
+
+  return n_chunk;
+}
+
+//----------------------------------------------------------------------------//
+// Returns the next chunk for a pipeline to process or -1 when all chunks
+// were handed out.  A range of chunks only ever shrinks from either end
+// until it is empty, and only its owner refills an empty range with chunks
+// it stole.  As every chunk is handed out once, a range never returns to a
+// value an outdated compare and swap could mistake it for.
+//----------------------------------------------------------------------------//
+
+int
+next_pipeline_chunk( pipeline_work_t * w,
+                     int pipeline_rank )
+{
+  pipeline_work_queue_t * q = w->q + pipeline_rank;
+  int64_t r;
+  int lo, hi, mid, k, v;
+
+  // Take the next chunk of this pipeline's range.
+
+  for(;;)
+  {
+    r  = q->range;
+    lo = RANGE_LO( r );
+    hi = RANGE_HI( r );
+    if ( lo >= hi ) break;
+    if ( __sync_bool_compare_and_swap( &q->range, r, RANGE( lo + 1, hi ) ) )
+      return lo;
+  }
+
+  // The host straggler neither steals nor is stolen from.  Nothing is
+  // stolen with the static schedule either such that each pipeline
+  // accumulates the same particles in the same order every time.
+
+  if ( pipeline_rank == w->n_pipeline || w->n_chunk == w->n_pipeline )
+    return -1;
+
+  // Steal the back half of another pipeline's range, starting with the
+  // next pipeline, and keep what is not processed right away in this
+  // pipeline's range for others to steal in turn.
+
+  for( k = 1; k < w->n_pipeline; k++ )
+  {
+    v = pipeline_rank + k;
+    if ( v >= w->n_pipeline ) v -= w->n_pipeline;
+
+    for(;;)
+    {
+      r   = w->q[v].range;
+      lo  = RANGE_LO( r );
+      hi  = RANGE_HI( r );
+      if ( lo >= hi ) break;
+      mid = lo + ( hi - lo )/2;
+      if ( __sync_bool_compare_and_swap( &w->q[v].range, r,
+                                         RANGE( lo, mid ) ) )
+      {
+        if ( mid + 1 < hi )
+          __sync_lock_test_and_set( &q->range, RANGE( mid + 1, hi ) );
+        return mid;
+      }
+    }
+  }
+
+  return -1;
+}
+
+#undef RANGE_HI
+#undef RANGE_LO
+#undef RANGE
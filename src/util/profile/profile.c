@@ -1,17 +1,225 @@
 #include "profile.h"
+#include "../mp/mp.h"
+#include "../pipelines/pipelines.h"
 #include "sys/time.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
 
 profile_internal_use_only_timer_t profile_internal_use_only[] = {
-# define PROFILE_TIMER_INIT( timer ) { #timer, 0., 0., 0, 0 },
+# define PROFILE_TIMER_INIT( timer ) { #timer, 0., 0., 0, 0, 0., 0., {0} },
   PROFILE_TIMERS( PROFILE_TIMER_INIT )
 # undef PROFILE_TIMER_INIT
-  { NULL, 0., 0., 0, 0 }
+  { NULL, 0., 0., 0, 0, 0., 0., {0} }
 };
 
+// The timeline is a ring of the most recent events.  Event k lives in
+// Event[k%Max_event].  Events [N_flushed,N_event) have not been written
+// yet.  Pipeline events get the timer of the innermost TIC/TOC block
+// around them when that block closes.
+
+typedef struct profile_event {
+  int timer;      // Timer of the event (-1 if not known yet)
+  int lane;       // 0 for the host, 1+id for pipeline id
+  double t0, t1;
+} profile_event_t;
+
+static profile_event_t * Event = NULL;
+static int64_t Max_event = 0, N_event = 0, N_flushed = 0, N_dropped = 0;
+static FILE * Trace = NULL;
+static double T_origin = 0;
+static char Named[ MAX_PIPELINE+2 ];
+
+// Pipeline busy times and hardware counts of the Pipe_n dispatches
+// since the last TOC
+
+static int Pipe_n = 0;
+static double Pipe_t0 = 0, Pipe_max = 0, Pipe_mean = 0;
+static int64_t Pipe_count[ PROFILE_MAX_COUNTER ];
+
+static void
+record_event( int timer,
+              int lane,
+              double t0,
+              double t1 ) {
+  profile_event_t * e = Event + N_event%Max_event;
+  e->timer = timer;
+  e->lane  = lane;
+  e->t0    = t0;
+  e->t1    = t1;
+  N_event++;
+}
+
+static void
+flush_trace( void ) {
+  profile_internal_use_only_timer_t * p = profile_internal_use_only;
+  const profile_event_t * e;
+  int64_t k;
+
+  if( !Trace ) return;
+
+  k = N_event - Max_event;
+  if( k > N_flushed ) N_dropped += k - N_flushed;
+  else                k  = N_flushed;
+
+  for( ; k<N_event; k++ ) {
+    e = Event + k%Max_event;
+    if( !Named[ e->lane ] ) {
+      if( e->lane ) fprintf( Trace, "{\"name\":\"thread_name\",\"ph\":\"M\","
+                             "\"pid\":%i,\"tid\":%i,"
+                             "\"args\":{\"name\":\"pipeline %i\"}},\n",
+                             world_rank, e->lane, e->lane-1 );
+      else          fprintf( Trace, "{\"name\":\"thread_name\",\"ph\":\"M\","
+                             "\"pid\":%i,\"tid\":0,"
+                             "\"args\":{\"name\":\"host\"}},\n",
+                             world_rank );
+      Named[ e->lane ] = 1;
+    }
+    fprintf( Trace, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%i,\"tid\":%i,"
+             "\"ts\":%.3f,\"dur\":%.3f},\n",
+             e->timer<0 ? "pipeline" : p[ e->timer ].name,
+             world_rank, e->lane,
+             1e6*( e->t0 - T_origin ), 1e6*( e->t1 - e->t0 ) );
+  }
+  fflush( Trace );
+
+  N_flushed = N_event;
+}
+
+void
+boot_profile( int * pargc,
+              char *** pargv ) {
+  const char * trace = NULL;
+  char name[1024];
+  double local_time;
+
+  boot_profile_counters( pargc, pargv );
+
+  Max_event = 65536;
+  if( pargc && pargv ) {
+    trace     = strip_cmdline_string( pargc, pargv, "--profile-trace", NULL );
+    Max_event = strip_cmdline_int( pargc, pargv, "--profile-events", Max_event );
+  }
+  if( !trace ) return;
+
+  if( Max_event<1 ) ERROR(( "Invalid number of profile events (%li)",
+                            (long)Max_event ));
+
+  // Put the ranks on a common time origin (see uptime)
+
+  mp_barrier();
+  local_time = wallclock();
+  mp_allsum_d( &local_time, &T_origin, 1 );
+  T_origin /= (double)world_size;
+
+  if( strlen( trace ) > sizeof(name)-32 ) ERROR(( "Trace name too long" ));
+  sprintf( name, "%s.%i", trace, world_rank );
+  Trace = fopen( name, "w" );
+  if( !Trace ) ERROR(( "Could not open \"%s\"", name ));
+
+  MALLOC( Event, Max_event );
+  N_event = N_flushed = N_dropped = 0;
+  CLEAR( Named, MAX_PIPELINE+2 );
+
+  if( world_rank==0 ) fprintf( Trace, "[\n" );
+  fprintf( Trace, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%i,"
+           "\"args\":{\"name\":\"rank %i\"}},\n", world_rank, world_rank );
+
+  if( world_rank==0 ) log_printf( "*** Writing profile timeline to %s.*\n",
+                                  trace );
+}
+
+void
+halt_profile( void ) {
+  halt_profile_counters();
+  if( !Trace ) return;
+  flush_trace();
+  if( N_dropped ) WARNING(( "%li profile events were dropped; consider a "
+                            "larger --profile-events", (long)N_dropped ));
+
+  // Every event ends with a comma, so each rank ends its file with one
+  // more metadata event that does not and the last rank closes the array.
+
+  fprintf( Trace, "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%i,"
+           "\"args\":{\"sort_index\":%i}}%s\n", world_rank, world_rank,
+           world_rank==world_size-1 ? "\n]" : "," );
+  fclose( Trace );
+  Trace = NULL;
+  FREE( Event );
+  Max_event = N_event = N_flushed = N_dropped = 0;
+}
+
+void
+profile_pipelines( int n_pipeline,
+                   const double * t0,
+                   const double * t1,
+                   const int64_t * count ) {
+  double t_max = 0, t_sum = 0, t;
+  int id, k;
+
+  if( n_pipeline<1 ) return;
+
+  if( Pipe_n++==0 ) {
+    Pipe_t0 = t0[0];
+    for( k=0; k<profile_n_counter; k++ ) Pipe_count[k] = 0;
+  }
+
+  for( id=0; id<n_pipeline; id++ ) {
+    t = t1[id] - t0[id];
+    if( t_max<t ) t_max = t;
+    t_sum += t;
+    if( Pipe_t0>t0[id] ) Pipe_t0 = t0[id];
+    if( Trace ) record_event( -1, 1+id, t0[id], t1[id] );
+    if( count )
+      for( k=0; k<profile_n_counter; k++ )
+        Pipe_count[k] += count[ PROFILE_MAX_COUNTER*id+k ];
+  }
+
+  Pipe_max  += t_max;
+  Pipe_mean += t_sum/(double)n_pipeline;
+}
+
+void
+profile_internal_use_only_toc( int timer,
+                               double tic,
+                               int n_calls ) {
+  profile_internal_use_only_timer_t * p = profile_internal_use_only + timer;
+  double toc = wallclock();
+  int64_t k;
+  int c;
+
+  p->t += toc - tic;
+  p->n += n_calls;
+
+  // Claim the pipeline dispatches inside this block.  Dispatches
+  // outside of any block are not attributed to a timer.
+
+  if( Pipe_n>0 && Pipe_t0>=tic ) {
+    p->t_pipe_max  += Pipe_max;
+    p->t_pipe_mean += Pipe_mean;
+    for( c=0; c<profile_n_counter; c++ ) p->count[c] += Pipe_count[c];
+  }
+  Pipe_n = 0;
+  Pipe_max = Pipe_mean = 0;
+
+  if( Trace ) {
+    for( k=N_event-1; k>=N_flushed && k>=N_event-Max_event; k-- ) {
+      profile_event_t * e = Event + k%Max_event;
+      if( e->t0<tic ) break;
+      if( e->timer<0 ) e->timer = timer;
+    }
+    record_event( timer, 0, tic, toc );
+  }
+}
+
 void
 update_profile( int dump ) {
+  enum { n_timer = profile_internal_use_only_n_timer };
   profile_internal_use_only_timer_t * p;
   double sum = 0, sum_total = 0;
+  double local[ PROFILE_MAX_COUNTER*n_timer ], global[ PROFILE_MAX_COUNTER*n_timer ];
+  double mean, stddev;
+  int i, k;
 
   for( p=profile_internal_use_only; p->name; p++ ) {
     p->t_total += p->t;
@@ -53,9 +261,93 @@ update_profile( int dump ) {
     log_printf( "\n" );
   }
 
+  // Reduce the load imbalance over the ranks.  Sums are t, t^2, n and
+  // the pipeline busy times; maxes are t and -t.
+
+  if( VERBOSE_MESSAGES != 0 ) {
+    for( i=0; i<n_timer; i++ ) {
+      p = profile_internal_use_only + i;
+      local[5*i  ] = p->t;
+      local[5*i+1] = p->t*p->t;
+      local[5*i+2] = (double)p->n;
+      local[5*i+3] = p->t_pipe_max;
+      local[5*i+4] = p->t_pipe_mean;
+    }
+    mp_allsum_d( local, global, 5*n_timer );
+    for( i=0; i<n_timer; i++ ) {
+      p = profile_internal_use_only + i;
+      local[2*i  ] =  p->t;
+      local[2*i+1] = -p->t;
+    }
+    mp_allmax_d( local, local+2*n_timer, 2*n_timer );
+
+    if( dump ) {
+      log_printf( "\n" // 8901234567890123456 | x.xe+xx x.xe+xx x.xe+xx x.xe+xx xx.xx | xx.xx
+                  "                           |       Load Imbalance Over %6i Ranks     | Pipelines\n"
+                  "    Operation              |  Min     Mean    Max     Stddev  Max/Mean | Max/Mean\n"
+                  "---------------------------+------------------------------------------+----------\n",
+                  world_size );
+
+      for( i=0; i<n_timer; i++ ) {
+        p = profile_internal_use_only + i;
+        if( global[5*i+2]==0 ) continue;
+        mean   = global[5*i]/(double)world_size;
+        stddev = global[5*i+1]/(double)world_size - mean*mean;
+        stddev = stddev>0 ? sqrt( stddev ) : 0;
+        log_printf( "%26.26s | %.1e %.1e %.1e %.1e %8.2f |",
+                    p->name, -local[2*n_timer+2*i+1], mean,
+                    local[2*n_timer+2*i], stddev,
+                    local[2*n_timer+2*i]/( DBL_EPSILON + mean ) );
+        if( global[5*i+4]>0 ) log_printf( " %8.2f\n",
+                                          global[5*i+3]/global[5*i+4] );
+        else                  log_printf( "        -\n" );
+      }
+
+      log_printf( "\n" );
+    }
+  }
+
+  // Sum the hardware counts over the ranks
+
+  if( VERBOSE_MESSAGES != 0 && profile_n_counter ) {
+    for( i=0; i<n_timer; i++ )
+      for( k=0; k<profile_n_counter; k++ )
+        local[ profile_n_counter*i+k ] =
+          (double)profile_internal_use_only[i].count[k];
+    mp_allsum_d( local, global, profile_n_counter*n_timer );
+
+    if( dump ) {
+      log_printf( "\n                           | Pipeline Hardware Counts Summed "
+                  "Over Ranks Since Last Update\n"
+                  "    Operation              |" );
+      for( k=0; k<profile_n_counter; k++ )
+        log_printf( " %12.12s", profile_counter_name[k] );
+      log_printf( "\n---------------------------+" );
+      for( k=0; k<profile_n_counter; k++ ) log_printf( "-------------" );
+      log_printf( "\n" );
+
+      for( i=0; i<n_timer; i++ ) {
+        for( k=0; k<profile_n_counter; k++ )
+          if( global[ profile_n_counter*i+k ]!=0 ) break;
+        if( k==profile_n_counter ) continue;
+        log_printf( "%26.26s |", profile_internal_use_only[i].name );
+        for( k=0; k<profile_n_counter; k++ )
+          log_printf( " %12.4e", global[ profile_n_counter*i+k ] );
+        log_printf( "\n" );
+      }
+
+      log_printf( "\n" );
+    }
+  }
+
+  flush_trace();
+
   for( p=profile_internal_use_only; p->name; p++ ) {
     p->t = 0;
     p->n = 0;
+    p->t_pipe_max  = 0;
+    p->t_pipe_mean = 0;
+    for( k=0; k<PROFILE_MAX_COUNTER; k++ ) p->count[k] = 0;
   }
 }
 
@@ -32,6 +32,7 @@
   _( clean_div_b       ) \
   _( synchronize_tang_e_norm_b ) \
   _( load_interpolator ) \
+  _( rebalance_domain  ) \
   _( compute_curl_b    ) \
   _( compute_rhob      ) \
   _( uncenter_p        ) \
@@ -56,12 +57,17 @@
 
 #define TOC(timer,n_calls)                                            \
     while(0);                                                         \
-    profile_internal_use_only[profile_internal_use_only_##timer].t += \
-      wallclock() - _profile_tic;                                     \
-    profile_internal_use_only[profile_internal_use_only_##timer].n += \
-      (n_calls);                                                      \
+    profile_internal_use_only_toc( profile_internal_use_only_##timer, \
+                                   _profile_tic, (n_calls) );         \
   } while(0)
 
+// PROFILE_TIME gives the total time spent in a timer since the last
+// restore (including the time since the last profile update).
+
+#define PROFILE_TIME(timer)                                           \
+  ( profile_internal_use_only[profile_internal_use_only_##timer].t_total + \
+    profile_internal_use_only[profile_internal_use_only_##timer].t )
+
 // Do not touch these
 
 enum profile_internal_use_only_timers {
@@ -72,18 +78,99 @@ enum profile_internal_use_only_timers {
   profile_internal_use_only_n_timer
 };
 
+#define PROFILE_MAX_COUNTER 8
+
 typedef struct profile_internal_use_only_timer {
   const char * name;
   double t, t_total;
   int n, n_total;
+  double t_pipe_max, t_pipe_mean; // Slowest and mean pipeline busy times
+  int64_t count[ PROFILE_MAX_COUNTER ]; // Pipeline hardware counts
 } profile_internal_use_only_timer_t;
 
 extern profile_internal_use_only_timer_t profile_internal_use_only[];
 
+// Number and names of the hardware counters read around the pipelines
+// (0 if hardware counting is off)
+
+extern int profile_n_counter;
+extern const char * profile_counter_name[ PROFILE_MAX_COUNTER ];
+
 BEGIN_C_DECLS
 
+void
+profile_internal_use_only_toc( int timer,
+                               double tic,
+                               int n_calls );
+
+void
+boot_profile_counters( int * pargc,
+                       char *** pargv );
+
+void
+halt_profile_counters( void );
+
+// Boots the profile.  The command line options are:
+//
+//   --profile-trace <base>  Writes a timeline of the TIC/TOC blocks and
+//                           the pipelines they dispatched to <base>.rank
+//                           in the Chrome trace event format.  Rank 0's
+//                           file opens the event array and the last
+//                           rank's file closes it when the profile halts,
+//                           so "cat <base>.0 <base>.1 ..." gives a single
+//                           JSON trace for chrome://tracing or Perfetto.
+//   --profile-events <n>    Size of the per-rank ring of timeline events
+//                           kept between profile updates (default 65536).
+//                           Older events are dropped when it overflows.
+//   --profile-counters <l>  Counts the comma separated hardware events in
+//                           <l> in the pipelines with perf_event_open.
+//                           Events are cycles, instructions, l1d-misses,
+//                           llc-misses, branch-misses or rXXXX for a raw
+//                           event (e.g. on Intel r10d1 for L2 load misses
+//                           and r3cc7 for packed FP ops).  "default" is
+//                           cycles,instructions,l1d-misses,llc-misses.
+//                           Events unavailable on any rank are dropped.
+//
+// This is collective and must be called after the pipelines and the
+// communications layer are booted.
+
+void
+boot_profile( int * pargc,
+              char *** pargv );
+
+// Flushes and closes the timeline (if any).
+
+void
+halt_profile( void );
+
+// Records the busy times [t0[id],t1[id]] of the pipelines id in
+// [0,n_pipeline) of the last dispatch and, if count is not NULL, their
+// hardware counts count[PROFILE_MAX_COUNTER*id+k].  They are attributed
+// to the innermost TIC/TOC block around the dispatch.  Host only.
+
+void
+profile_pipelines( int n_pipeline,
+                   const double * t0,
+                   const double * t1,
+                   const int64_t * count );
+
+// Reads the running hardware counts of the calling thread into
+// count[0:profile_n_counter-1].  Each thread that calls this must use
+// its own slot in [0,MAX_PIPELINE] (the counters of a slot are opened
+// by the first thread to read them).  Counts are zero if the counters
+// could not be opened for the thread.
+
+void
+profile_count( int slot,
+               int64_t * count );
+
 // Updates the cumulative profile, resets the local profile and, if
-// dump is true, writes the local and cumulative profiles to the log.
+// dump is true, writes the local and cumulative profiles to the log
+// followed by the load imbalance since the last update: the min, mean,
+// max and standard deviation over the ranks of the time in each timer
+// and the ratio of the slowest to the mean pipeline busy time of the
+// dispatches in each timer.  The timeline (if any) is flushed.  This is
+// collective.
 
 void
 update_profile( int dump );
@@ -0,0 +1,210 @@
+#include "profile.h"
+#include "../mp/mp.h"
+#include "../pipelines/pipelines.h"
+#include <string.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define HAS_PERF_EVENT
+#endif
+
+int profile_n_counter = 0;
+const char * profile_counter_name[ PROFILE_MAX_COUNTER ];
+
+#if defined(HAS_PERF_EVENT)
+
+typedef struct counter {
+  const char * name;
+  uint32_t type;
+  uint64_t config;
+} counter_t;
+
+#define CACHE_READ_MISS(cache)                                \
+  ( (cache) | ( PERF_COUNT_HW_CACHE_OP_READ     <<  8 ) |     \
+              ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 ) )
+
+static const counter_t Known[] = {
+  { "cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES            },
+  { "instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS          },
+  { "l1d-misses",    PERF_TYPE_HW_CACHE, CACHE_READ_MISS( PERF_COUNT_HW_CACHE_L1D ) },
+  { "llc-misses",    PERF_TYPE_HW_CACHE, CACHE_READ_MISS( PERF_COUNT_HW_CACHE_LL  ) },
+  { "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES         },
+  { NULL,            0,                  0                                   }
+};
+
+#undef CACHE_READ_MISS
+
+static counter_t Counter[ PROFILE_MAX_COUNTER ];
+static char Name[ PROFILE_MAX_COUNTER ][ 32 ];
+
+// The counters of each slot form a group led by Fd[slot][0] so they are
+// read together.  Opened[slot] is set once the counters of the slot
+// were opened (Fd[slot][0]<0 if that failed).
+
+static int Fd[ MAX_PIPELINE+1 ][ PROFILE_MAX_COUNTER ];
+static char Opened[ MAX_PIPELINE+1 ];
+
+static int
+open_counter( const counter_t * c,
+              int group ) {
+  struct perf_event_attr attr;
+  CLEAR( &attr, 1 );
+  attr.size           = sizeof(attr);
+  attr.type           = c->type;
+  attr.config         = c->config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  attr.read_format    = PERF_FORMAT_GROUP |
+                        PERF_FORMAT_TOTAL_TIME_ENABLED |
+                        PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall( SYS_perf_event_open, &attr, 0, -1, group, 0 );
+}
+
+static void
+open_group( int slot ) {
+  int k;
+  for( k=0; k<profile_n_counter; k++ ) {
+    Fd[slot][k] = open_counter( Counter+k, k ? Fd[slot][0] : -1 );
+    if( Fd[slot][k]<0 ) break;
+  }
+  if( k<profile_n_counter ) {
+    while( k-- ) close( Fd[slot][k] );
+    Fd[slot][0] = -1;
+  }
+  Opened[slot] = 1;
+}
+
+void
+profile_count( int slot,
+               int64_t * count ) {
+  uint64_t buf[ 3+PROFILE_MAX_COUNTER ];
+  double scale;
+  int k;
+
+  if( !Opened[slot] ) open_group( slot );
+
+  // The counts are scaled up for the time the group was not on the
+  // PMU when the kernel had to multiplex the counters.
+
+  if( Fd[slot][0]<0 ||
+      read( Fd[slot][0], buf, sizeof(buf) ) <
+      (ssize_t)( ( 3+profile_n_counter )*sizeof(uint64_t) ) ||
+      buf[2]==0 ) {
+    for( k=0; k<profile_n_counter; k++ ) count[k] = 0;
+    return;
+  }
+
+  scale = (double)buf[1]/(double)buf[2];
+  for( k=0; k<profile_n_counter; k++ )
+    count[k] = (int64_t)( scale*(double)buf[3+k] + 0.5 );
+}
+
+void
+boot_profile_counters( int * pargc,
+                       char *** pargv ) {
+  const char * request = NULL;
+  char list[ 256 ], * tok, * end;
+  int available[ PROFILE_MAX_COUNTER ], n_available[ PROFILE_MAX_COUNTER ];
+  int n, k, fd;
+  const counter_t * c;
+
+  if( pargc && pargv )
+    request = strip_cmdline_string( pargc, pargv, "--profile-counters", NULL );
+  if( !request ) return;
+
+  if( strlen( request )>=sizeof(list) ) ERROR(( "Counter list too long" ));
+  strcpy( list, request );
+
+  // Parse the requested counters.  "default" is the first four known
+  // counters.
+
+  n = 0;
+  for( tok=strtok( list, "," ); tok; tok=strtok( NULL, "," ) ) {
+    if( strcmp( tok, "default" )==0 ) {
+      for( k=0; k<4; k++ ) {
+        if( n==PROFILE_MAX_COUNTER ) break;
+        Counter[n++] = Known[k];
+      }
+      continue;
+    }
+    if( n==PROFILE_MAX_COUNTER )
+      ERROR(( "At most %i counters may be requested", PROFILE_MAX_COUNTER ));
+    for( c=Known; c->name; c++ ) if( strcmp( c->name, tok )==0 ) break;
+    if( c->name ) Counter[n] = *c;
+    else if( tok[0]=='r' && tok[1] ) {
+      Counter[n].type   = PERF_TYPE_RAW;
+      Counter[n].config = strtoull( tok+1, &end, 16 );
+      if( *end ) ERROR(( "Invalid raw counter \"%s\"", tok ));
+    }
+    else ERROR(( "Unknown counter \"%s\"", tok ));
+    strncpy( Name[n], tok, sizeof(Name[n])-1 );
+    Name[n][ sizeof(Name[n])-1 ] = '\0';
+    Counter[n].name = Name[n];
+    n++;
+  }
+
+  // Keep the counters every rank can open
+
+  for( k=0; k<n; k++ ) {
+    fd = open_counter( Counter+k, -1 );
+    available[k] = fd>=0;
+    if( fd>=0 ) close( fd );
+    else if( world_rank==0 )
+      WARNING(( "Hardware counter %s is unavailable (%s)",
+                Counter[k].name, strerror( errno ) ));
+  }
+  if( n ) mp_allsum_i( available, n_available, n );
+
+  profile_n_counter = 0;
+  for( k=0; k<n; k++ )
+    if( n_available[k]==world_size ) {
+      Counter[ profile_n_counter ] = Counter[k];
+      profile_counter_name[ profile_n_counter++ ] = Counter[k].name;
+    }
+
+  CLEAR( Opened, MAX_PIPELINE+1 );
+
+  if( world_rank==0 ) {
+    if( profile_n_counter ) log_printf( "*** Counting %i hardware events in "
+                                        "the pipelines\n", profile_n_counter );
+    else WARNING(( "No hardware counters available; counting disabled" ));
+  }
+}
+
+void
+halt_profile_counters( void ) {
+  int slot, k;
+  for( slot=0; slot<=MAX_PIPELINE; slot++ ) {
+    if( Opened[slot] && Fd[slot][0]>=0 )
+      for( k=0; k<profile_n_counter; k++ ) close( Fd[slot][k] );
+    Opened[slot] = 0;
+  }
+  profile_n_counter = 0;
+}
+
+#else
+
+void
+profile_count( int slot,
+               int64_t * count ) {
+  int k;
+  for( k=0; k<profile_n_counter; k++ ) count[k] = 0;
+}
+
+void
+boot_profile_counters( int * pargc,
+                       char *** pargv ) {
+  if( pargc && pargv &&
+      strip_cmdline_string( pargc, pargv, "--profile-counters", NULL ) &&
+      world_rank==0 )
+    WARNING(( "Hardware counters are not supported on this platform" ));
+}
+
+void
+halt_profile_counters( void ) {
+}
+
+#endif
@@ -70,7 +70,8 @@ seed_rng( rng_t * RESTRICT r,
   for( n=1; n<SFMT_N32; n++ )
     u(n) = ((uint32_t)1812433253) * (u(n-1)^(u(n-1)>>30)) + n;
   adjust_rng( r );
-  r->n = SFMT_NC;
+  r->n   = SFMT_NC;
+  r->lim = SFMT_NC;
   return r;
 }
 
@@ -112,6 +113,14 @@ _( int64_t, i64, u64, 1 ) _( uint64_t,       u64, u64, 0 )
 
 /* Uniform floating point generators */
 
+/* In counter mode, the single precision fills generate their blocks in
+   bulk (see rng_counter.c) */
+
+#define COUNTER_FILL_f( variant )                               \
+  if( RNG_IS_COUNTER(r) )                                       \
+    return counter_frand##variant##_fill( r, x, str_ele, n_ele )
+#define COUNTER_FILL_d( variant )
+
 #define _( type, prefix, variant, state_type, state_prefix )    \
 type                                                            \
 prefix##rand##variant( rng_t * RESTRICT r ) {                   \
@@ -129,6 +138,7 @@ prefix##rand##variant##_fill( rng_t * RESTRICT r,               \
   size_t n;                                                     \
   if( !n_ele ) return x;                                        \
   if( !r || !x ) ERROR(( "Bad args" ));                         \
+  COUNTER_FILL_##prefix( variant );                             \
   for( n=0; n<n_ele; n++ ) {                                    \
     RNG_NEXT( u, state_type, r, state_prefix, 0 );              \
     x[n*str_ele] = conv_##prefix##rand##variant( u );           \
@@ -142,6 +152,8 @@ _( float, f, _c1, uint32_t, u32 ) _( double, d, _c1, uint64_t, u64 )
 _( float, f, _c,  uint32_t, u32 ) _( double, d, _c,  uint64_t, u64 )
 
 #undef _
+#undef COUNTER_FILL_d
+#undef COUNTER_FILL_f
 
 /* Normal generators */
 
@@ -341,6 +353,7 @@ frandn_fill( rng_t * RESTRICT r,
   size_t n;
   if( !n_ele ) return x;
   if( !r || !x ) ERROR(( "Bad args" ));
+  if( RNG_IS_COUNTER(r) ) return counter_frandn_fill( r, x, str_ele, n_ele );
   for( n=0; n<n_ele; n++ ) x[ n*str_ele ] = frandn( r );
   return x;
 }
@@ -423,6 +436,7 @@ frande_fill( rng_t * RESTRICT r,
   size_t n;
   if( !n_ele ) return x;
   if( !r || !x ) ERROR(( "Bad args" ));
+  if( RNG_IS_COUNTER(r) ) return counter_frande_fill( r, x, str_ele, n_ele );
   for( n=0; n<n_ele; n++ ) x[ n*str_ele ] = frande( r );
   return x;
 }
@@ -539,3 +553,7 @@ shuffle( rng_t * RESTRICT r,
   return _x;
 }
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( checkpt_rng )
+REGISTER_SYMBOL( restore_rng )
@@ -13,6 +13,7 @@ typedef struct rng rng_t;
 typedef struct rng_pool {
   rng_t ** rng; /* Random number generators (indexed 0:n_rng-1) */
   int n_rng;    /* Number of random number generators in pool */
+  uint64_t key; /* Key for counter based streams (see seed_rng_counter) */
 } rng_pool_t;
 
 BEGIN_C_DECLS
@@ -32,7 +33,10 @@ delete_rng_pool( rng_pool_t * RESTRICT rp ); /* Pool to delete */
      sync_pool  = seed_rng_pool( rp, seed, 1 );
    gives each local_pool rng and each sync_pool rng has a unique seed
    on all calling processes and that the sync pool rngs are
-   identically initialized on all calling processes. */
+   identically initialized on all calling processes.  The pool key is
+   the seed for both, such that the counter based streams drawn from a
+   pool do not depend on the process drawing them (see
+   RNG_COUNTER_KEY). */
 
 /* FIXME: WE NEED BIGGER SEEDS.  NOTE THAT THE EFFECT SEED SPACE FOR
    POOLS IS ROUGHLY FLOOR( UINT_MAX / (n_rng*(world_size+1)) )  */
@@ -43,7 +47,7 @@ seed_rng_pool( rng_pool_t * RESTRICT rp, /* Pool to seed */
                                             seed_rng) */
                int sync );               /* True for synchronized seeding */
 
-/* In rng.c */
+/* In rng.c and rng_counter.c */
 
 rng_t *              /* New generator (already seeded via seed_rng) */
 new_rng( int seed ); /* Random number generator seed */
@@ -57,6 +61,67 @@ rng_t *                            /* Returns r */
 seed_rng( rng_t * RESTRICT r,      /* Generator to seed */
           int              seed ); /* Seed */
 
+/* seed_rng_counter puts a generator in counter mode on the stream
+   (s0,s1,s2) of key.  In counter mode, the generator draws the blocks
+   of a counter based generator (Philox4x32-10) instead of advancing
+   its SFMT state, such that what is drawn only depends on the key, the
+   stream and how much was drawn from the stream since it was
+   selected.  Selecting a stream is cheap, so a pipeline can select a
+   stream per particle or voxel named by, for example, the operator
+   and the global index of the voxel.  Results then do not depend on
+   which pipeline or process did the work or on the number of either.
+   All generators below work in counter mode; the single precision
+   _fill generators are vectorized in counter mode (but frandn_fill
+   does not then match repeated calls to frandn, see rng_counter.c).  seed_rng returns the generator to SFMT mode. */
+
+rng_t *                                /* Returns r */
+seed_rng_counter( rng_t * RESTRICT r,  /* Generator to seed */
+                  uint64_t key,        /* Key (e.g. RNG_COUNTER_KEY) */
+                  uint32_t s0,         /* Stream */
+                  uint32_t s1,
+                  uint32_t s2 );
+
+/* RNG_COUNTER_KEY gives the key of the counter based streams drawn
+   from the pool rp at the step step.  With the step in the key, all
+   three stream words are free to name the work (e.g. an operator and a
+   global voxel index or particle, see global_voxel and
+   particle_stream). */
+
+#define RNG_COUNTER_KEY(rp,step) \
+  ( (rp)->key | ( (uint64_t)(uint32_t)(step) << 32 ) )
+
+/* The _stream_fill generators draw from many streams of a key at once:
+   x[4k:4k+3] is drawn from the start of the stream (s0,s1[k],s2[k]) for
+   k on 0:n-1.  uirand_stream_fill and frand_c0_stream_fill give what
+   seed_rng_counter on that stream followed by 4 uirand or frand_c0
+   would.  frandn_stream_fill gives the Box-Muller transform of the
+   same words (see frandn_fill).  These are vectorized such that a
+   pipeline can give each particle its own stream cheaply. */
+
+uint32_t *                                  /* Returns x */
+uirand_stream_fill( uint64_t key,           /* Key */
+                    uint32_t s0,            /* Stream of all elements */
+                    const uint32_t * RESTRICT s1, /* Streams (n) */
+                    const uint32_t * RESTRICT s2,
+                    uint32_t * RESTRICT x,  /* Array to fill (4n) */
+                    size_t n );             /* Number of streams */
+
+float *                                       /* Returns x */
+frand_c0_stream_fill( uint64_t key,           /* Key */
+                      uint32_t s0,            /* Stream of all elements */
+                      const uint32_t * RESTRICT s1, /* Streams (n) */
+                      const uint32_t * RESTRICT s2,
+                      float * RESTRICT x,     /* Array to fill (4n) */
+                      size_t n );             /* Number of streams */
+
+float *                                     /* Returns x */
+frandn_stream_fill( uint64_t key,           /* Key */
+                    uint32_t s0,            /* Stream of all elements */
+                    const uint32_t * RESTRICT s1, /* Streams (n) */
+                    const uint32_t * RESTRICT s2,
+                    float * RESTRICT x,     /* Array to fill (4n) */
+                    size_t n );             /* Number of streams */
+
 /* Integer random generators make uniform rands on [0,INTTYPE_MAX] for
    signed types and on [0,UINTTYPE_MAX] for unsigned types.  There are
    singleton generators for each primitive integral type (including
@@ -0,0 +1,300 @@
+#define IN_rng
+#include "rng_private.h"
+
+/* Counter based generation
+
+   In counter mode, a generator is the Philox4x32-10 block cipher of
+   Salmon et al ("Parallel Random Numbers: As Easy as 1, 2, 3", SC11)
+   applied to a 128-bit counter under a 64-bit key.  The first three
+   counter words name a stream and the last one enumerates the 128-bit
+   blocks of the stream.  As a block is a pure function of the key and
+   the counter, the numbers drawn from a stream do not depend on which
+   thread or process draws them or on what was drawn before the stream
+   was selected.  Philox4x32-10 passes BigCrush for any key and counter
+   pattern and each stream holds 2^32 blocks. */
+
+#define PHILOX_M0 ((uint32_t)0xd2511f53)
+#define PHILOX_M1 ((uint32_t)0xcd9e8d57)
+#define PHILOX_W0 ((uint32_t)0x9e3779b9)
+#define PHILOX_W1 ((uint32_t)0xbb67ae85)
+
+enum {
+  PHILOX_LANE   = 16, /* Blocks enciphered together */
+  COUNTER_BATCH = 64  /* Blocks per bulk fill batch */
+};
+
+/* Encipher the m (at most PHILOX_LANE) counters (x0,x1,x2,x3)[0:m-1]
+   in place under the key (k0,k1).  The rounds are written as loops
+   over lanes such that the compiler can map them onto the widest
+   available vector unit (the 32x32->64-bit multiplies are the v8 and
+   v16 unsigned multiplies). */
+
+STATIC_INLINE void
+philox_lanes( uint32_t k0,
+              uint32_t k1,
+              uint32_t * RESTRICT x0,
+              uint32_t * RESTRICT x1,
+              uint32_t * RESTRICT x2,
+              uint32_t * RESTRICT x3,
+              int m ) {
+  uint32_t y0, y2;
+  uint64_t p0, p1;
+  int n, l;
+
+  for( n=0; n<10; n++ ) {
+    for( l=0; l<m; l++ ) {
+      p0 = (uint64_t)PHILOX_M0*(uint64_t)x0[l];
+      p1 = (uint64_t)PHILOX_M1*(uint64_t)x2[l];
+      y0 = ( (uint32_t)( p1>>32 ) ) ^ x1[l] ^ k0;
+      y2 = ( (uint32_t)( p0>>32 ) ) ^ x3[l] ^ k1;
+      x0[l] = y0, x1[l] = (uint32_t)p1;
+      x2[l] = y2, x3[l] = (uint32_t)p0;
+    }
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+}
+
+/* Generate the n_block blocks of the stream of r starting at block c3
+   into u (4 words per block), PHILOX_LANE blocks at a time. */
+
+static void
+philox_blocks( const rng_t * RESTRICT r,
+               uint32_t c3,
+               uint32_t * RESTRICT u,
+               int n_block ) {
+  uint32_t x0[ PHILOX_LANE ], x1[ PHILOX_LANE ];
+  uint32_t x2[ PHILOX_LANE ], x3[ PHILOX_LANE ];
+  int b, m, l;
+
+  for( b=0; b<n_block; b+=PHILOX_LANE ) {
+    m = n_block - b; if( m>PHILOX_LANE ) m = PHILOX_LANE;
+
+    for( l=0; l<m; l++ ) {
+      x0[l] = r->ctr[0];
+      x1[l] = r->ctr[1];
+      x2[l] = r->ctr[2];
+      x3[l] = c3 + (uint32_t)( b + l );
+    }
+
+    philox_lanes( r->key[0], r->key[1], x0, x1, x2, x3, m );
+
+    for( l=0; l<m; l++ ) {
+      u[4*(b+l)  ] = x0[l];
+      u[4*(b+l)+1] = x1[l];
+      u[4*(b+l)+2] = x2[l];
+      u[4*(b+l)+3] = x3[l];
+    }
+  }
+}
+
+/* Generate the first block of each of the n streams (s0,s1[k],s2[k])
+   of key into u (4 words per stream), PHILOX_LANE streams at a time. */
+
+static void
+philox_streams( uint64_t key,
+                uint32_t s0,
+                const uint32_t * RESTRICT s1,
+                const uint32_t * RESTRICT s2,
+                uint32_t * RESTRICT u,
+                size_t n ) {
+  uint32_t x0[ PHILOX_LANE ], x1[ PHILOX_LANE ];
+  uint32_t x2[ PHILOX_LANE ], x3[ PHILOX_LANE ];
+  size_t b;
+  int m, l;
+
+  for( b=0; b<n; b+=PHILOX_LANE ) {
+    m = (int)( n - b ); if( m>PHILOX_LANE ) m = PHILOX_LANE;
+
+    for( l=0; l<m; l++ ) {
+      x0[l] = s0;
+      x1[l] = s1[b+l];
+      x2[l] = s2[b+l];
+      x3[l] = 0;
+    }
+
+    philox_lanes( (uint32_t)key, (uint32_t)( key>>32 ), x0, x1, x2, x3, m );
+
+    for( l=0; l<m; l++ ) {
+      u[4*(b+l)  ] = x0[l];
+      u[4*(b+l)+1] = x1[l];
+      u[4*(b+l)+2] = x2[l];
+      u[4*(b+l)+3] = x3[l];
+    }
+  }
+}
+
+/* Private API **************************************************************/
+
+void
+rng_counter_next( rng_t * RESTRICT r ) {
+  philox_blocks( r, r->ctr[3], r->state.u32, RNG_COUNTER_BLOCK );
+  r->ctr[3] += RNG_COUNTER_BLOCK;
+}
+
+/* The bulk fills encipher the next COUNTER_BATCH blocks at a time
+   straight into a batch buffer and convert it with loops the compiler
+   can vectorize.  They start at the block after the ones buffered for
+   the singleton generators and leave the buffer empty. */
+
+STATIC_INLINE void
+counter_batch( rng_t * RESTRICT r,
+               uint32_t * RESTRICT u,
+               int n_block ) {
+  philox_blocks( r, r->ctr[3], u, n_block );
+  r->ctr[3] += (uint32_t)n_block;
+  r->n       = r->lim;
+}
+
+#define _( variant, conv )                                      \
+float *                                                         \
+counter_frand##variant##_fill( rng_t * RESTRICT r,              \
+                               float * RESTRICT x,              \
+                               size_t str_ele,                  \
+                               size_t n_ele ) {                 \
+  uint32_t u[ 4*COUNTER_BATCH ];                                \
+  float y[ 4*COUNTER_BATCH ];                                   \
+  size_t n, m, k;                                               \
+  for( n=0; n<n_ele; n+=m ) {                                   \
+    m = n_ele - n; if( m>4*COUNTER_BATCH ) m = 4*COUNTER_BATCH; \
+    counter_batch( r, u, (int)( (m+3)/4 ) );                    \
+    for( k=0; k<m; k++ ) y[k] = conv( u[k] );                   \
+    for( k=0; k<m; k++ ) x[ (n+k)*str_ele ] = y[k];             \
+  }                                                             \
+  return x;                                                     \
+}
+
+#define conv_frande(u32) (-logf( conv_frand_c1(u32) ))
+
+_(    , conv_frand    )
+_( _c0, conv_frand_c0 )
+_( _c1, conv_frand_c1 )
+_( _c,  conv_frand_c  )
+_( e,   conv_frande   )
+
+#undef conv_frande
+#undef _
+
+/* The bulk normal fill uses the Box-Muller transform instead of the
+   ziggurat method of frandn as it has no rejection step to get in the
+   way of vectorization.  Each pair of words gives a pair of normals:
+     x = sqrt( -2 log u0 ) cos( 2 pi u1 )
+     y = sqrt( -2 log u0 ) sin( 2 pi u1 )
+   for u0 on (0,1] and u1 on [0,1).  As such, frandn_fill in counter
+   mode does not produce the same normals as repeated calls to frandn
+   but both have the same distribution. */
+
+float *
+counter_frandn_fill( rng_t * RESTRICT r,
+                     float * RESTRICT x,
+                     size_t str_ele,
+                     size_t n_ele ) {
+  static const float two_pi = 6.28318530717958647692f;
+  uint32_t u[ 4*COUNTER_BATCH ];
+  float rad[ 2*COUNTER_BATCH ], ang[ 2*COUNTER_BATCH ];
+  float y[ 4*COUNTER_BATCH ];
+  size_t n, m, k;
+
+  for( n=0; n<n_ele; n+=m ) {
+    m = n_ele - n; if( m>4*COUNTER_BATCH ) m = 4*COUNTER_BATCH;
+    counter_batch( r, u, (int)( (m+3)/4 ) );
+    for( k=0; k<(m+1)/2; k++ ) {
+      rad[k] = sqrtf( -2.f*logf( conv_frand_c1( u[2*k] ) ) );
+      ang[k] = two_pi*conv_frand_c0( u[2*k+1] );
+    }
+    for( k=0; k<(m+1)/2; k++ ) {
+      y[2*k  ] = rad[k]*cosf( ang[k] );
+      y[2*k+1] = rad[k]*sinf( ang[k] );
+    }
+    for( k=0; k<m; k++ ) x[ (n+k)*str_ele ] = y[k];
+  }
+
+  return x;
+}
+
+/* Public API ***************************************************************/
+
+rng_t *
+seed_rng_counter( rng_t * RESTRICT r,
+                  uint64_t key,
+                  uint32_t s0,
+                  uint32_t s1,
+                  uint32_t s2 ) {
+  if( !r ) ERROR(( "Bad args" ));
+  r->key[0] = (uint32_t)key;
+  r->key[1] = (uint32_t)( key>>32 );
+  r->ctr[0] = s0;
+  r->ctr[1] = s1;
+  r->ctr[2] = s2;
+  r->ctr[3] = 0;
+  r->lim    = RNG_COUNTER_NC;
+  r->n      = RNG_COUNTER_NC;
+  return r;
+}
+
+uint32_t *
+uirand_stream_fill( uint64_t key,
+                    uint32_t s0,
+                    const uint32_t * RESTRICT s1,
+                    const uint32_t * RESTRICT s2,
+                    uint32_t * RESTRICT x,
+                    size_t n ) {
+  if( !n ) return x;
+  if( !s1 || !s2 || !x ) ERROR(( "Bad args" ));
+  philox_streams( key, s0, s1, s2, x, n );
+  return x;
+}
+
+float *
+frand_c0_stream_fill( uint64_t key,
+                      uint32_t s0,
+                      const uint32_t * RESTRICT s1,
+                      const uint32_t * RESTRICT s2,
+                      float * RESTRICT x,
+                      size_t n ) {
+  uint32_t u[ 4*PHILOX_LANE ];
+  size_t b, m, k;
+  if( !n ) return x;
+  if( !s1 || !s2 || !x ) ERROR(( "Bad args" ));
+  for( b=0; b<n; b+=m ) {
+    m = n - b; if( m>PHILOX_LANE ) m = PHILOX_LANE;
+    philox_streams( key, s0, s1+b, s2+b, u, m );
+    for( k=0; k<4*m; k++ ) x[4*b+k] = conv_frand_c0( u[k] );
+  }
+  return x;
+}
+
+/* Box-Muller on the first block of each stream as in frandn_fill */
+
+float *
+frandn_stream_fill( uint64_t key,
+                    uint32_t s0,
+                    const uint32_t * RESTRICT s1,
+                    const uint32_t * RESTRICT s2,
+                    float * RESTRICT x,
+                    size_t n ) {
+  static const float two_pi = 6.28318530717958647692f;
+  uint32_t u[ 4*PHILOX_LANE ];
+  float rad[ 2*PHILOX_LANE ], ang[ 2*PHILOX_LANE ];
+  size_t b, m, k;
+  if( !n ) return x;
+  if( !s1 || !s2 || !x ) ERROR(( "Bad args" ));
+  for( b=0; b<n; b+=m ) {
+    m = n - b; if( m>PHILOX_LANE ) m = PHILOX_LANE;
+    philox_streams( key, s0, s1+b, s2+b, u, m );
+    for( k=0; k<2*m; k++ ) {
+      rad[k] = sqrtf( -2.f*logf( conv_frand_c1( u[2*k] ) ) );
+      ang[k] = two_pi*conv_frand_c0( u[2*k+1] );
+    }
+    for( k=0; k<2*m; k++ ) {
+      x[4*b+2*k  ] = rad[k]*cosf( ang[k] );
+      x[4*b+2*k+1] = rad[k]*sinf( ang[k] );
+    }
+  }
+  return x;
+}
+
+#undef PHILOX_W1
+#undef PHILOX_W0
+#undef PHILOX_M1
+#undef PHILOX_M0
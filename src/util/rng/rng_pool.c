@@ -55,8 +55,13 @@ seed_rng_pool( rng_pool_t * RESTRICT rp,
                int sync ) {
   int n;
   if( !rp ) ERROR(( "Bad args" ));
+  rp->key = (uint64_t)(uint32_t)seed;
   seed = (sync ? world_size : world_rank) + (world_size+1)*rp->n_rng*seed;
   for( n=0; n<rp->n_rng; n++ ) seed_rng( rp->rng[n], seed + (world_size+1)*n );
   return rp;
 }
 
+/* Named for checkpt_sym (see REGISTER_SYMBOL) */
+
+REGISTER_SYMBOL( checkpt_rng_pool )
+REGISTER_SYMBOL( restore_rng_pool )
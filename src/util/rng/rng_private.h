@@ -187,6 +187,15 @@ enum sfmt_parameters {
   SFMT_N64 = SFMT_NC/sizeof(uint64_t)
 };
 
+/* In counter mode (see seed_rng_counter), the state holds the
+   RNG_COUNTER_BLOCK Philox blocks most recently generated instead of
+   the SFMT state. */
+
+enum rng_counter_parameters {
+  RNG_COUNTER_BLOCK = 4,                      /* Blocks per refill */
+  RNG_COUNTER_NC    = 16*RNG_COUNTER_BLOCK    /* Bytes per refill */
+};
+
 struct rng {
   union {
     sfmt_128_t sfmt[ SFMT_N ]; /* Actual randgen state */
@@ -201,9 +210,15 @@ struct rng {
     uint64_t u64[ SFMT_N64 ];
   } state;
   uint32_t n;      /* Next unextracted byte */
-  uint32_t pad[3]; /* 16-byte align */
+  uint32_t lim;    /* Bytes of state extracted before a refill (SFMT_NC
+                      for SFMT, RNG_COUNTER_NC in counter mode) */
+  uint32_t key[2]; /* Counter mode key */
+  uint32_t ctr[4]; /* Counter mode stream (ctr[0:2]) and next block
+                      (ctr[3]) */
 };
 
+#define RNG_IS_COUNTER(r) ((r)->lim!=SFMT_NC)
+
 #if defined(__SSE2__)
 
 # define DECL_SFMT                                                 \
@@ -257,12 +272,35 @@ sfmt_next( sfmt_128_t * RESTRICT sfmt ) {
 # undef SFMT
 # undef DECL_SFMT
 
-/* Note that SFMT_NC is sizeof(r->state.p[0]) aligned */
+/* In rng_counter.c */
+
+void
+rng_counter_next( rng_t * RESTRICT r );
+
+#define _( variant )                                               \
+float *                                                            \
+counter_frand##variant##_fill( rng_t * RESTRICT r,                 \
+                               float * RESTRICT x,                 \
+                               size_t str_ele,                     \
+                               size_t n_ele );
+
+_() _( _c0 ) _( _c1 ) _( _c ) _( n ) _( e )
+
+#undef _
+
+STATIC_INLINE void
+rng_next( rng_t * RESTRICT r ) {
+  if( LIKELY( r->lim==SFMT_NC ) ) sfmt_next( r->state.sfmt );
+  else                            rng_counter_next( r );
+}
+
+/* Note that SFMT_NC and RNG_COUNTER_NC are sizeof(r->state.p[0])
+   aligned */
 
 #define RNG_NEXT( a, t, r, p, rs ) do {                                   \
     uint32_t _n = ((r)->n +   ((uint32_t)sizeof((r)->state.p[0]))-1 ) &   \
       /**/                 (~(((uint32_t)sizeof((r)->state.p[0]))-1));    \
-    if( _n >= SFMT_NC ) sfmt_next( (r)->state.sfmt ), _n = 0;             \
+    if( _n >= (r)->lim ) rng_next( (r) ), _n = 0;                         \
     (a) = ((r)->state.p[ _n/(uint32_t)sizeof((r)->state.p[0]) ] >> (rs)); \
     (r)->n =             _n+(uint32_t)sizeof((r)->state.p[0]);            \
   } while(0)
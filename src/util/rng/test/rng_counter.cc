@@ -0,0 +1,57 @@
+/*~--------------------------------------------------------------------------~*
+ *~--------------------------------------------------------------------------~*/
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main()
+#include "catch.hpp"
+
+#include "../../util.h"
+#include "src/vpic/vpic_unit_deck.h"
+
+/* Known answer from the Philox4x32-10 reference implementation (zero
+   key and counter) */
+TEST_CASE("seed_rng_counter", "[rng]") {
+
+  boot_checkpt(NULL, NULL);
+
+  static const unsigned int kat[4] =
+    { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 };
+  float x[100], y[100];
+  int i;
+  rng_t * rng = new_rng( 1234 );
+  rng_t * ref = new_rng( 1234 );
+  seed_rng_counter( rng, 0, 0, 0, 0 );
+  for( i=0; i<4; i++ ) if( uirand( rng )!=kat[i] ) break;
+  REQUIRE( i==4 );
+
+  /* Bulk and singleton generation agree on a fresh stream */
+  seed_rng_counter( rng, 1234, 1, 2, 3 );
+  frand_c0_fill( rng, x, 1, 100 );
+  seed_rng_counter( rng, 1234, 1, 2, 3 );
+  for( i=0; i<100; i++ ) y[i] = frand_c0( rng );
+  for( i=0; i<100; i++ ) if( x[i]!=y[i] ) break;
+  REQUIRE( i==100 );
+
+  /* Stream fills draw the start of each stream */
+  uint32_t s1[25], s2[25], u[100];
+  for( i=0; i<25; i++ ) s1[i] = 7*i, s2[i] = i ^ 0x5a5a;
+  uirand_stream_fill( 1234, 9, s1, s2, u, 25 );
+  frand_c0_stream_fill( 1234, 9, s1, s2, x, 25 );
+  for( i=0; i<100; i++ ) {
+    if( !(i&3) ) seed_rng_counter( rng, 1234, 9, s1[i>>2], s2[i>>2] );
+    if( uirand( rng )!=u[i] ) break;
+  }
+  REQUIRE( i==100 );
+  for( i=0; i<100; i++ ) {
+    if( !(i&3) ) seed_rng_counter( rng, 1234, 9, s1[i>>2], s2[i>>2] );
+    if( frand_c0( rng )!=x[i] ) break;
+  }
+  REQUIRE( i==100 );
+
+  /* Back to SFMT */
+  seed_rng( rng, 1234 );
+  for( i=0; i<1000; i++ ) if( uirand( rng )!=uirand( ref ) ) break;
+  REQUIRE( i==1000 );
+  delete_rng(ref);
+  delete_rng(rng);
+  halt_checkpt();
+} // TEST
@@ -12,6 +12,29 @@
 
 #define FAK field_array->kernel
 
+// Largest number of runs of interior particles pushed per species while
+// the particle exchange is in flight (see interior_p_ranges).  Each run is
+// a separate advance_p_range.
+
+enum { MAX_INTERIOR_RANGE = 8 };
+
+// Returns true if any face of the local domain is shared with another rank.
+
+static int
+has_shared_face( const grid_t * g ) {
+  static const int f2b[6] = { BOUNDARY(-1, 0, 0),
+                              BOUNDARY( 0,-1, 0),
+                              BOUNDARY( 0, 0,-1),
+                              BOUNDARY( 1, 0, 0),
+                              BOUNDARY( 0, 1, 0),
+                              BOUNDARY( 0, 0, 1) };
+  for( int face=0; face<6; face++ ) {
+    int64_t bc = g->bc[f2b[face]];
+    if( bc>=0 && bc<world_size && bc!=world_rank ) return 1;
+  }
+  return 0;
+}
+
 int vpic_simulation::advance(void) {
   species_t *sp;
   double err;
@@ -20,7 +43,9 @@ int vpic_simulation::advance(void) {
 
   if( num_step>0 && step()>=num_step ) return 0;
 
-  // Sort the particles for performance if desired.
+  // Sort the particles for performance if desired.  With tiled
+  // accumulators, the particle advance partitions the species not sorted
+  // here by pipeline instead (see accumulator_array_t).
 
   LIST_FOR_EACH( sp, species_list )
     if( (sp->sort_interval>0) && ((step() % sp->sort_interval)==0) ) {
@@ -33,8 +58,11 @@ int vpic_simulation::advance(void) {
   // empty and all particles should be inside the local computational domain.
   // Advance the particle lists.
 
-  if( species_list )
+  if( species_list ) {
+    if( accumulator_array->tiled!=(tile_accumulators!=0) )
+      set_accumulator_array_tiling( accumulator_array, tile_accumulators );
     TIC clear_accumulator_array( accumulator_array ); TOC( clear_accumulators, 1 );
+  }
 
   // Note: Particles should not have moved since the last performance sort
   // when calling collision operators.
@@ -46,35 +74,109 @@ int vpic_simulation::advance(void) {
     TIC apply_collision_op_list( collision_op_list ); TOC( collision_model, 1 );
   TIC user_particle_collisions(); TOC( user_particle_collisions, 1 );
 
-  LIST_FOR_EACH( sp, species_list )
-    TIC advance_p( sp, accumulator_array, interpolator_array ); TOC( advance_p, 1 );
+  // When overlap_boundary_p is set and the local domain shares faces with
+  // other ranks, the particle push is split in two.  Particles in the face
+  // voxels, the only ones that can leave the local domain this step, are
+  // pushed first.  The particle exchange is then started and the largest
+  // runs of interior particles are pushed while the messages are in
+  // flight.  The runs come from the voxel partition of species sorted this
+  // step.  The face particles of the other species are moved to the front
+  // of their particle arrays instead (see interior_p_ranges).
+
+  int overlap = species_list && overlap_boundary_p && num_comm_round>0 &&
+                has_shared_face( grid );
+  int * interior = NULL, * n_interior = NULL;
+
+  if( overlap ) {
+    int n_sp = num_species( species_list );
+    MALLOC( interior, 2*MAX_INTERIOR_RANGE*n_sp );
+    MALLOC( n_interior, n_sp );
+    TIC
+      LIST_FOR_EACH( sp, species_list ) {
+        int * r = interior + 2*MAX_INTERIOR_RANGE*sp->id;
+        int n = interior_p_ranges( sp, r, MAX_INTERIOR_RANGE ), n0 = 0;
+        for( int k=0; k<n; k++ ) {
+          if( n0<r[2*k] )
+            advance_p_range( sp, accumulator_array, interpolator_array,
+                             n0, r[2*k] );
+          n0 = r[2*k+1];
+        }
+        if( n0<sp->np )
+          advance_p_range( sp, accumulator_array, interpolator_array,
+                           n0, sp->np );
+        n_interior[sp->id] = n;
+      }
+    TOC( advance_p, 1 );
+  } else {
+    LIST_FOR_EACH( sp, species_list )
+      TIC advance_p( sp, accumulator_array, interpolator_array ); TOC( advance_p, 1 );
+  }
 
   // Because the partial position push when injecting aged particles might
   // place those particles onto the guard list (boundary interaction) and
   // because advance_p requires an empty guard list, particle injection must
   // be done after advance_p and before guard list processing. Note:
   // user_particle_injection should be a stub if species_list is empty.
+  // With overlap_boundary_p, this is before the interior push (see
+  // vpic_simulation::overlap_boundary_p); the exchange started by
+  // boundary_p_begin can not take the movers of injected particles.
 
   if( emitter_list )
     TIC apply_emitter_list( emitter_list ); TOC( emission_model, 1 );
   TIC user_particle_injection(); TOC( user_particle_injection, 1 );
 
-  // This should be after the emission and injection to allow for the
-  // possibility of thread parallelizing these operations
-
-  if( species_list )
-    TIC reduce_accumulator_array( accumulator_array ); TOC( reduce_accumulators, 1 );
+  // boundary_p_begin backfills the holes left by the movers with the
+  // particles at the end of the list, so any interior particles there are
+  // pushed before it.  The rest of the interior particles are not touched
+  // by the first boundary_p phase and cannot leave the local domain.
+
+  if( overlap ) {
+    TIC
+      LIST_FOR_EACH( sp, species_list ) {
+        int * r = interior + 2*MAX_INTERIOR_RANGE*sp->id;
+        int cut = ( sp->np - sp->nm ) & ~( PARTICLE_BLOCK_SIZE - 1 );
+        for( int k=0; k<n_interior[sp->id]; k++ )
+          if( r[2*k+1]>cut ) {
+            int n0 = r[2*k]>cut ? r[2*k] : cut;
+            advance_p_range( sp, accumulator_array, interpolator_array,
+                             n0, r[2*k+1] );
+            r[2*k+1] = n0;
+          }
+      }
+    TOC( advance_p, 0 );
+    TIC
+      boundary_p_begin( particle_bc_list, species_list,
+                        field_array, accumulator_array );
+    TOC( boundary_p, 0 );
+    TIC
+      LIST_FOR_EACH( sp, species_list ) {
+        int * r = interior + 2*MAX_INTERIOR_RANGE*sp->id;
+        for( int k=0; k<n_interior[sp->id]; k++ )
+          if( r[2*k]<r[2*k+1] )
+            advance_p_range( sp, accumulator_array, interpolator_array,
+                             r[2*k], r[2*k+1] );
+      }
+    TOC( advance_p, 0 );
+    FREE( n_interior );
+    FREE( interior );
+  }
 
   // At this point, most particle positions are at r_1 and u_{1/2}. Particles
   // that had boundary interactions are now on the guard list. Process the
   // guard lists. Particles that absorbed are added to rhob (using a corrected
   // local accumulation).
 
-  TIC
-    for( int round=0; round<num_comm_round; round++ )
+  TIC {
+    int round = 0;
+    if( overlap ) {
+      boundary_p_end( particle_bc_list, species_list,
+                      field_array, accumulator_array );
+      round++;
+    }
+    for( ; round<num_comm_round; round++ )
       boundary_p( particle_bc_list, species_list,
                   field_array, accumulator_array );
-  TOC( boundary_p, num_comm_round );
+  } TOC( boundary_p, num_comm_round );
   LIST_FOR_EACH( sp, species_list ) {
     if( sp->nm && verbose )
       WARNING(( "Removing %i particles associated with unprocessed %s movers (increase num_comm_round)",
@@ -86,6 +188,7 @@ int vpic_simulation::advance(void) {
     // in fact go out of bounds of the voxel indexing space. Removal is in
     // reverse order for back filling. Particle charge is accumulated to the
     // mesh before removing the particle.
+    if( sp->nm ) convert_p( sp, particle_layout_aos );
     int nm = sp->nm;
     particle_mover_t * RESTRICT ALIGNED(16)  pm = sp->pm + sp->nm - 1;
     particle_t * RESTRICT ALIGNED(128) p0 = sp->p;
@@ -100,14 +203,26 @@ int vpic_simulation::advance(void) {
     sp->nm = 0;
   }
 
+  // This is after the emission, injection and guard list processing so
+  // the pipelines can accumulate the currents of those particles into
+  // their own accumulators (boundary_p does).
+
+  if( species_list )
+    TIC reduce_accumulator_array( accumulator_array ); TOC( reduce_accumulators, 1 );
+
   // At this point, all particle positions are at r_1 and u_{1/2}, the
   // guard lists are empty and the accumulators on each processor are current.
-  // Convert the accumulators into currents.
+  // Convert the accumulators into currents.  The currents on the faces of
+  // the local domain are unloaded first so that their synchronization can
+  // proceed while the interior currents are unloaded.
 
   TIC FAK->clear_jf( field_array ); TOC( clear_jf, 1 );
   if( species_list )
-    TIC unload_accumulator_array( field_array, accumulator_array ); TOC( unload_accumulator, 1 );
-  TIC FAK->synchronize_jf( field_array ); TOC( synchronize_jf, 1 );
+    TIC unload_accumulator_array_faces( field_array, accumulator_array ); TOC( unload_accumulator, 1 );
+  TIC FAK->begin_synchronize_jf( field_array ); TOC( synchronize_jf, 0 );
+  if( species_list )
+    TIC unload_accumulator_array_interior( field_array, accumulator_array ); TOC( unload_accumulator, 0 );
+  TIC FAK->end_synchronize_jf( field_array ); TOC( synchronize_jf, 1 );
 
   // At this point, the particle currents are known at jf_{1/2}.
   // Let the user add their own current contributions. It is the users
@@ -141,9 +256,14 @@ int vpic_simulation::advance(void) {
   if( (clean_div_e_interval>0) && ((step() % clean_div_e_interval)==0) ) {
     if( rank()==0 ) VMESSAGE(( "Divergence cleaning electric field" ));
 
+    // The charge on the faces of the local domain is synchronized while
+    // the interior charge is reduced (see accumulate_rho_p_list_faces).
+
     TIC FAK->clear_rhof( field_array ); TOC( clear_rhof,1 );
-    if( species_list ) TIC LIST_FOR_EACH( sp, species_list ) accumulate_rho_p( field_array, sp ); TOC( accumulate_rho_p, species_list->id );
-    TIC FAK->synchronize_rho( field_array ); TOC( synchronize_rho, 1 );
+    if( species_list ) TIC accumulate_rho_p_list_faces( field_array, species_list ); TOC( accumulate_rho_p, species_list->id );
+    TIC FAK->begin_synchronize_rho( field_array ); TOC( synchronize_rho, 0 );
+    if( species_list ) TIC accumulate_rho_p_list_interior( field_array ); TOC( accumulate_rho_p, 0 );
+    TIC FAK->end_synchronize_rho( field_array ); TOC( synchronize_rho, 1 );
 
     for( int round=0; round<num_div_e_round; round++ ) {
       TIC FAK->compute_div_e_err( field_array ); TOC( compute_div_e_err, 1 );
@@ -186,6 +306,12 @@ int vpic_simulation::advance(void) {
 
   step()++;
 
+  // Rebalance the domain decomposition if desired.  The particles and
+  // fields are migrated and the interpolator is reloaded.
+
+  if( (balance_interval>0) && ((step() % balance_interval)==0) )
+    TIC rebalance_domain(); TOC( rebalance_domain, 1 );
+
   // Print out status
 
   if( (status_interval>0) && ((step() % status_interval)==0) ) {
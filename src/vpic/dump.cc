@@ -10,10 +10,12 @@
  */
 
 #include <cassert>
+#include <pthread.h>
 
 #include "vpic.h"
 #include "dumpmacros.h"
 #include "../util/io/FileUtils.h"
+#include "../util/pipelines/pipelines_exec.h"
 
 /* -1 means no ranks talk */
 #define VERBOSE_rank -1
@@ -256,6 +258,9 @@ vpic_simulation::dump_hydro( const char *sp_name,
   if( fileIO.close() ) ERROR(( "File close failed on dump hydro!!!" ));
 }
 
+static void
+async_dump_wait_file( const char * fname );
+
 void
 vpic_simulation::dump_particles( const char *sp_name,
                                  const char *fbase,
@@ -279,6 +284,7 @@ vpic_simulation::dump_particles( const char *sp_name,
 
   if( ftag ) sprintf( fname, "%s.%li.%i", fbase, (long)step(), rank() );
   else       sprintf( fname, "%s.%i", fbase, rank() );
+  async_dump_wait_file( fname );
   FileIOStatus status = fileIO.open(fname, io_write);
   if( status==fail ) ERROR(( "Could not open \"%s\"", fname ));
 
@@ -303,6 +309,7 @@ vpic_simulation::dump_particles( const char *sp_name,
   // FIXME: WITH A PIPELINED CENTER_P, PBUF NOMINALLY SHOULD BE QUITE
   // LARGE.
 
+  convert_p( sp, particle_layout_aos );
   particle_t * sp_p = sp->p;      sp->p      = p_buf;
   int sp_np         = sp->np;     sp->np     = 0;
   int sp_max_np     = sp->max_np; sp->max_np = PBUF_SIZE;
@@ -319,6 +326,254 @@ vpic_simulation::dump_particles( const char *sp_name,
   if( fileIO.close() ) ERROR(("File close failed on dump particles!!!"));
 }
 
+/*------------------------------------------------------------------------------
+ * Asynchronous particle dumps
+ *
+ * dump_particles_async writes the same file as dump_particles but the
+ * particle data is written by a dedicated I/O thread so the simulation
+ * can keep advancing.  Hunks of the particle list are copied into one
+ * half of a double buffered staging area by the pipelines (copy_pipelines),
+ * time centered there by the center_p pipelines (each pipeline centers
+ * the particles it copied) and queued for the I/O thread.  While one half
+ * is being written, the other is being filled.  Memory use is bounded by
+ * the staging area; a dump larger than it only blocks until the I/O
+ * thread frees a half.  A dump (asynchronous or not) to a file that still
+ * has hunks queued waits until that file is closed, so it can't be
+ * clobbered.  dump_particles_flush waits until all queued dumps are on
+ * disk.
+ *---------------------------------------------------------------------------*/
+
+typedef struct particle_dump_hunk {
+  char     fname[256]; // Name of the file
+  FileIO * fileIO;     // Open file to append the hunk to
+  int      b;          // Staging buffer holding the hunk
+  int      np;         // Number of particles in the hunk
+  int      last;       // Close the file after writing this hunk
+} particle_dump_hunk_t;
+
+static struct {
+  pthread_t            handle;
+  pthread_mutex_t      mutex;
+  pthread_cond_t       wake;     // Signaled when a hunk is queued or written
+  int                  booted;
+  int                  halt;
+  particle_t         * buf[2];   // Double buffered staging area
+  int                  max_np;   // Capacity of each staging buffer
+  int                  busy[2];  // Staging buffer is queued or being written
+  int                  next;     // Next staging buffer to fill
+  particle_dump_hunk_t queue[2]; // Hunks waiting to be written, oldest first
+  int                  head;
+  int                  n_queued;
+} async_dump;
+
+static int async_dump_max_np = 1048576; // 32MB of particles per buffer
+
+static void *
+async_dump_writer( void * arg ) {
+  particle_dump_hunk_t h;
+
+  (void)arg;
+
+  pthread_mutex_lock( &async_dump.mutex );
+  for(;;) {
+    while( !async_dump.n_queued && !async_dump.halt )
+      pthread_cond_wait( &async_dump.wake, &async_dump.mutex );
+    if( !async_dump.n_queued ) break; // Halted and drained
+
+    // The hunk stays queued while it is written so a flush waits on it.
+
+    h = async_dump.queue[ async_dump.head ];
+    pthread_mutex_unlock( &async_dump.mutex );
+
+    h.fileIO->write( async_dump.buf[h.b], h.np );
+    if( h.last ) {
+      if( h.fileIO->close() ) ERROR(("File close failed on dump particles!!!"));
+      delete h.fileIO;
+    }
+
+    pthread_mutex_lock( &async_dump.mutex );
+    async_dump.busy[h.b] = 0;
+    async_dump.head = ( async_dump.head + 1 ) % 2;
+    async_dump.n_queued--;
+    pthread_cond_broadcast( &async_dump.wake );
+  }
+  pthread_mutex_unlock( &async_dump.mutex );
+
+  return NULL;
+}
+
+static void
+async_dump_boot( void ) {
+  if( async_dump.booted ) return;
+
+  MALLOC_ALIGNED( async_dump.buf[0], async_dump_max_np, 128 );
+  MALLOC_ALIGNED( async_dump.buf[1], async_dump_max_np, 128 );
+  async_dump.max_np   = async_dump_max_np;
+  async_dump.busy[0]  = 0;
+  async_dump.busy[1]  = 0;
+  async_dump.next     = 0;
+  async_dump.head     = 0;
+  async_dump.n_queued = 0;
+  async_dump.halt     = 0;
+
+  if( pthread_mutex_init( &async_dump.mutex, NULL ) )
+    ERROR(( "pthread_mutex_init failed" ));
+  if( pthread_cond_init( &async_dump.wake, NULL ) )
+    ERROR(( "pthread_cond_init failed" ));
+  if( pthread_create( &async_dump.handle, NULL, async_dump_writer, NULL ) )
+    ERROR(( "pthread_create failed" ));
+
+  async_dump.booted = 1;
+}
+
+static void
+async_dump_halt( void ) {
+  if( !async_dump.booted ) return;
+
+  pthread_mutex_lock( &async_dump.mutex );
+  async_dump.halt = 1;
+  pthread_cond_broadcast( &async_dump.wake );
+  pthread_mutex_unlock( &async_dump.mutex );
+
+  pthread_join( async_dump.handle, NULL );
+  pthread_cond_destroy( &async_dump.wake );
+  pthread_mutex_destroy( &async_dump.mutex );
+
+  FREE_ALIGNED( async_dump.buf[1] );
+  FREE_ALIGNED( async_dump.buf[0] );
+  async_dump.booted = 0;
+}
+
+// The last hunk of a file closes it, so a file is open as long as it has
+// hunks queued.
+
+static void
+async_dump_wait_file( const char * fname ) {
+  int i, pending;
+  if( !async_dump.booted ) return;
+  pthread_mutex_lock( &async_dump.mutex );
+  for(;;) {
+    for( pending=0, i=0; i<async_dump.n_queued; i++ )
+      if( !strcmp( async_dump.queue[ ( async_dump.head + i ) % 2 ].fname,
+                   fname ) ) pending = 1;
+    if( !pending ) break;
+    pthread_cond_wait( &async_dump.wake, &async_dump.mutex );
+  }
+  pthread_mutex_unlock( &async_dump.mutex );
+}
+
+void
+vpic_simulation::set_particle_dump_buffer( int n_particle ) {
+  if( n_particle<1 ) ERROR(( "Bad particle dump buffer size (%i)", n_particle ));
+  if( async_dump.booted && async_dump.max_np!=n_particle ) async_dump_halt();
+  async_dump_max_np = n_particle;
+}
+
+void
+vpic_simulation::dump_particles_async( const char *sp_name,
+                                       const char *fbase,
+                                       int ftag ) {
+  species_t *sp;
+  char fname[256];
+  FileIO * fileIO;
+  int dim[1], buf_start, b, np;
+
+  sp = find_species_name( sp_name, species_list );
+  if( !sp ) ERROR(( "Invalid species name \"%s\".", sp_name ));
+
+  if( !fbase ) ERROR(( "Invalid filename" ));
+
+  async_dump_boot();
+
+  if( rank()==0 )
+    VMESSAGE(("Dumping \"%s\" particles to \"%s\" asynchronously",
+              sp->name,fbase));
+
+  if( ftag ) sprintf( fname, "%s.%li.%i", fbase, (long)step(), rank() );
+  else       sprintf( fname, "%s.%i", fbase, rank() );
+  async_dump_wait_file( fname );
+  fileIO = new FileIO;
+  FileIOStatus status = fileIO->open(fname, io_write);
+  if( status==fail ) ERROR(( "Could not open \"%s\"", fname ));
+
+  // The headers are small so they are written here.  The I/O thread
+  // only touches the file once the first hunk is queued.
+
+  nxout = grid->nx;
+  nyout = grid->ny;
+  nzout = grid->nz;
+  dxout = grid->dx;
+  dyout = grid->dy;
+  dzout = grid->dz;
+
+  WRITE_HEADER_V0( dump_type::particle_dump, sp->id, sp->q/sp->m, (*fileIO) );
+
+  dim[0] = sp->np;
+  WRITE_ARRAY_HEADER( sp->p, 1, dim, (*fileIO) );
+
+  if( !sp->np ) {
+    if( fileIO->close() ) ERROR(("File close failed on dump particles!!!"));
+    delete fileIO;
+    return;
+  }
+
+  // Center the particles hunk by hunk into the staging buffers as in
+  // dump_particles, handing each full buffer to the I/O thread.  The copy
+  // is distributed over the pipelines like center_p (blocks of 16) so each
+  // pipeline centers the particles it just copied.
+
+  convert_p( sp, particle_layout_aos );
+  particle_t * sp_p = sp->p;
+  int sp_np         = sp->np;
+  int sp_max_np     = sp->max_np;
+  for( buf_start=0; buf_start<sp_np; buf_start += np ) {
+    np = sp_np-buf_start; if( np > async_dump.max_np ) np = async_dump.max_np;
+
+    pthread_mutex_lock( &async_dump.mutex );
+    b = async_dump.next;
+    while( async_dump.busy[b] )
+      pthread_cond_wait( &async_dump.wake, &async_dump.mutex );
+    pthread_mutex_unlock( &async_dump.mutex );
+
+    sp->p      = async_dump.buf[b];
+    sp->np     = np;
+    sp->max_np = async_dump.max_np;
+    copy_pipelines( sp->p, &sp_p[buf_start], sizeof(particle_t), np, 16 );
+    center_p( sp, interpolator_array );
+
+    pthread_mutex_lock( &async_dump.mutex );
+    particle_dump_hunk_t * h =
+      &async_dump.queue[ ( async_dump.head + async_dump.n_queued ) % 2 ];
+    strcpy( h->fname, fname );
+    h->fileIO = fileIO;
+    h->b      = b;
+    h->np     = np;
+    h->last   = buf_start+np>=sp_np;
+    async_dump.busy[b] = 1;
+    async_dump.next    = 1-b;
+    async_dump.n_queued++;
+    pthread_cond_broadcast( &async_dump.wake );
+    pthread_mutex_unlock( &async_dump.mutex );
+  }
+  sp->p      = sp_p;
+  sp->np     = sp_np;
+  sp->max_np = sp_max_np;
+}
+
+void
+vpic_simulation::dump_particles_flush( void ) {
+  if( !async_dump.booted ) return;
+  pthread_mutex_lock( &async_dump.mutex );
+  while( async_dump.n_queued )
+    pthread_cond_wait( &async_dump.wake, &async_dump.mutex );
+  pthread_mutex_unlock( &async_dump.mutex );
+}
+
+void
+vpic_simulation::dump_particles_halt( void ) {
+  async_dump_halt();
+}
+
 /*------------------------------------------------------------------------------
  * New dump logic
  *---------------------------------------------------------------------------*/
@@ -515,6 +770,151 @@ vpic_simulation::global_header( const char * base,
   if( fileIO.close() ) ERROR(( "File close failed on global header!!!" ));
 }
 
+/*------------------------------------------------------------------------------
+ * Band gathers
+ *
+ * A band is a single voxel variable over the (possibly strided) output
+ * grid, in Fortran order.  The gather_band pipelines transpose a chunk
+ * of rows of a band out of the array-of-structure voxel data into a
+ * contiguous buffer.  write_bands double buffers the chunks so the
+ * pipelines gather the next chunk while the host writes the current one.
+ *---------------------------------------------------------------------------*/
+
+// Floats in a band chunk.  A chunk holds at least one row.
+
+#define BAND_CHUNK (1<<16)
+
+typedef struct gather_band_pipeline_args {
+  MEM_PTR( const float, 128 ) src;  // Voxel data (nb floats per voxel)
+  MEM_PTR( float,       128 ) band; // Output chunk, nr*ni floats
+  MEM_PTR( const int,   128 ) ioff; // Source x index of each output x
+  MEM_PTR( const int,   128 ) joff; // Source y index of each output y
+  MEM_PTR( const int,   128 ) koff; // Source z index of each output z
+  int                         nb;   // Floats per voxel
+  int                         ni;   // Output x extent
+  int                         nj;   // Output y extent
+  int                         nk;   // Output z extent
+  int                         sy;   // Voxel y-stride
+  int                         sz;   // Voxel z-stride
+  int                         r0;   // First output row of the chunk
+  int                         nr;   // Output rows in the chunk
+
+  PAD_STRUCT( 5*SIZEOF_MEM_PTR + 8*sizeof(int) )
+
+} gather_band_pipeline_args_t;
+
+static void
+gather_band_pipeline_scalar( gather_band_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline ) {
+  const float * RESTRICT ALIGNED(4) src  = args->src;
+  const int   * RESTRICT            ioff = args->ioff;
+  const int   * RESTRICT            joff = args->joff;
+  const int   * RESTRICT            koff = args->koff;
+  const int nb = args->nb, ni = args->ni, nj = args->nj;
+  const int sy = args->sy, sz = args->sz;
+  int r, nr, i, v;
+
+  // Each pipeline gathers a contiguous set of the chunk's rows.
+
+  DISTRIBUTE( args->nr, 1, pipeline_rank, n_pipeline, r, nr );
+
+  for( ; nr; nr--, r++ ) {
+    float * RESTRICT b = args->band + (size_t)r*ni;
+    v = sy*joff[(args->r0+r)%nj] + sz*koff[(args->r0+r)/nj];
+    for( i=0; i<ni; i++ ) b[i] = src[ (size_t)nb*( v + ioff[i] ) ];
+  }
+}
+
+// Write the variables in varlist of the nb float voxel array vox as
+// bands.  Unstrided output includes every voxel.  Otherwise, output
+// index i of a dimension with n voxels and stride s maps to voxel 0, n+1
+// or i*s-1 for the first, last and interior indices.  The bands are
+// written in chunks of whole rows, so each of the two buffers holds at
+// most BAND_CHUNK floats (one row if a row is longer) whatever the size
+// of the local domain.  The buffers are freed before returning.
+
+static void
+write_bands( FileIO & fileIO,
+             const float * vox,
+             int nb,
+             const size_t * varlist,
+             size_t numvars,
+             const grid_t * g,
+             int istride, int jstride, int kstride ) {
+  DECLARE_ALIGNED_ARRAY( gather_band_pipeline_args_t, 128, args, 1 );
+
+  float * ALIGNED(128) buf;
+  int   * ALIGNED(128) off;
+
+  const int ni = g->nx/istride + 2, nj = g->ny/jstride + 2,
+            nk = g->nz/kstride + 2;
+  const int strided = istride!=1 || jstride!=1 || kstride!=1;
+  const int n_row = nj*nk;
+  const int n_chunk_row = ni<BAND_CHUNK ? BAND_CHUNK/ni : 1;
+  const int n_chunk = ( n_row + n_chunk_row - 1 ) / n_chunk_row;
+  const size_t sz_chunk = (size_t)n_chunk_row*(size_t)ni;
+  size_t c, n;
+  int i, nr;
+
+  if( !numvars ) return;
+
+  MALLOC_ALIGNED( buf, 2*sz_chunk, 128 );
+  MALLOC_ALIGNED( off, ni+nj+nk,   128 );
+
+# define OFFSET( o, n, nout, s )                                        \
+  for( i=0; i<nout; i++ )                                               \
+    (o)[i] = !strided || i==0 ? i : i==nout-1 ? (n)+1 : i*(s)-1
+
+  OFFSET( off,       g->nx, ni, istride );
+  OFFSET( off+ni,    g->ny, nj, jstride );
+  OFFSET( off+ni+nj, g->nz, nk, kstride );
+
+# undef OFFSET
+
+  args->ioff = off;
+  args->joff = off + ni;
+  args->koff = off + ni + nj;
+  args->nb   = nb;
+  args->ni   = ni;
+  args->nj   = nj;
+  args->nk   = nk;
+  args->sy   = g->sy;
+  args->sz   = g->sz;
+
+  // Chunk c is rows (c%n_chunk)*n_chunk_row onward of variable
+  // c/n_chunk.  The pipelines gather chunk c into half c&1 of buf while
+  // the host writes chunk c-1 from the other half.
+
+# define GATHER( c ) BEGIN_PRIMITIVE {                                  \
+    args->src  = vox + varlist[(c)/n_chunk];                            \
+    args->band = buf + ((c)&1)*sz_chunk;                                \
+    args->r0   = (int)((c)%n_chunk)*n_chunk_row;                        \
+    args->nr   = n_row - args->r0;                                      \
+    if( args->nr>n_chunk_row ) args->nr = n_chunk_row;                  \
+    EXEC_PIPELINES( gather_band, args, 0 );                             \
+  } END_PRIMITIVE
+
+  n = numvars*(size_t)n_chunk;
+
+  GATHER( 0 );
+  WAIT_PIPELINES();
+
+  for( c=1; c<n; c++ ) {
+    nr = args->nr;
+    GATHER( c );
+    fileIO.write( buf + ((c-1)&1)*sz_chunk, (size_t)nr*ni );
+    WAIT_PIPELINES();
+  }
+
+  fileIO.write( buf + ((n-1)&1)*sz_chunk, (size_t)args->nr*ni );
+
+# undef GATHER
+
+  FREE_ALIGNED( off );
+  FREE_ALIGNED( buf );
+}
+
 void
 vpic_simulation::field_dump( DumpParameters & dumpParams ) {
 
@@ -595,37 +995,9 @@ vpic_simulation::field_dump( DumpParameters & dumpParams ) {
     for(size_t i(0), c(0); i<total_field_variables; i++)
       if(dumpParams.output_vars.bitset(i)) varlist[c++] = i;
 
-    if( rank()==VERBOSE_rank ) printf("\nBEGIN_OUTPUT\n");
-
-    // more efficient for standard case
-    if(istride == 1 && jstride == 1 && kstride == 1)
-      for(size_t v(0); v<numvars; v++) {
-      for(size_t k(0); k<nzout+2; k++) {
-      for(size_t j(0); j<nyout+2; j++) {
-      for(size_t i(0); i<nxout+2; i++) {
-              const uint32_t * fref = reinterpret_cast<uint32_t *>(&field_array->f(i,j,k));
-              fileIO.write(&fref[varlist[v]], 1);
-              if(rank()==VERBOSE_rank) printf("%f ", field_array->f(i,j,k).ex);
-              if(rank()==VERBOSE_rank) std::cout << "(" << i << " " << j << " " << k << ")" << std::endl;
-      } if(rank()==VERBOSE_rank) std::cout << std::endl << "ROW_BREAK " << j << " " << k << std::endl;
-      } if(rank()==VERBOSE_rank) std::cout << std::endl << "PLANE_BREAK " << k << std::endl;
-      } if(rank()==VERBOSE_rank) std::cout << std::endl << "BLOCK_BREAK" << std::endl;
-      }
-
-    else
-
-      for(size_t v(0); v<numvars; v++) {
-      for(size_t k(0); k<nzout+2; k++) { const size_t koff = (k == 0) ? 0 : (k == nzout+1) ? grid->nz+1 : k*kstride-1;
-      for(size_t j(0); j<nyout+2; j++) { const size_t joff = (j == 0) ? 0 : (j == nyout+1) ? grid->ny+1 : j*jstride-1;
-      for(size_t i(0); i<nxout+2; i++) { const size_t ioff = (i == 0) ? 0 : (i == nxout+1) ? grid->nx+1 : i*istride-1;
-              const uint32_t * fref = reinterpret_cast<uint32_t *>(&field_array->f(ioff,joff,koff));
-              fileIO.write(&fref[varlist[v]], 1);
-              if(rank()==VERBOSE_rank) printf("%f ", field_array->f(ioff,joff,koff).ex);
-              if(rank()==VERBOSE_rank) std::cout << "(" << ioff << " " << joff << " " << koff << ")" << std::endl;
-      } if(rank()==VERBOSE_rank) std::cout << std::endl << "ROW_BREAK " << joff << " " << koff << std::endl;
-      } if(rank()==VERBOSE_rank) std::cout << std::endl << "PLANE_BREAK " << koff << std::endl;
-      } if(rank()==VERBOSE_rank) std::cout << std::endl << "BLOCK_BREAK" << std::endl;
-      }
+    write_bands( fileIO, (const float *)field_array->f,
+                 sizeof(field_t)/sizeof(float), varlist, numvars, grid,
+                 istride, jstride, kstride );
 
     delete[] varlist;
 
@@ -736,28 +1108,9 @@ vpic_simulation::hydro_dump( const char * speciesname,
     for(size_t i(0), c(0); i<total_hydro_variables; i++)
       if( dumpParams.output_vars.bitset(i) ) varlist[c++] = i;
 
-    // More efficient for standard case
-    if(istride == 1 && jstride == 1 && kstride == 1)
-
-      for(size_t v(0); v<numvars; v++)
-      for(size_t k(0); k<nzout+2; k++)
-      for(size_t j(0); j<nyout+2; j++)
-      for(size_t i(0); i<nxout+2; i++) {
-              const uint32_t * href = reinterpret_cast<uint32_t *>(&hydro(i,j,k));
-              fileIO.write(&href[varlist[v]], 1);
-      }
-
-    else
-
-      for(size_t v(0); v<numvars; v++)
-      for(size_t k(0); k<nzout+2; k++) { const size_t koff = (k == 0) ? 0 : (k == nzout+1) ? grid->nz+1 : k*kstride-1;
-      for(size_t j(0); j<nyout+2; j++) { const size_t joff = (j == 0) ? 0 : (j == nyout+1) ? grid->ny+1 : j*jstride-1;
-      for(size_t i(0); i<nxout+2; i++) { const size_t ioff = (i == 0) ? 0 : (i == nxout+1) ? grid->nx+1 : i*istride-1;
-              const uint32_t * href = reinterpret_cast<uint32_t *>(&hydro(ioff,joff,koff));
-              fileIO.write(&href[varlist[v]], 1);
-      }
-      }
-      }
+    write_bands( fileIO, (const float *)hydro_array->h,
+                 sizeof(hydro_t)/sizeof(float), varlist, numvars, grid,
+                 istride, jstride, kstride );
 
     delete[] varlist;
 
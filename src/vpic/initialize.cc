@@ -30,8 +30,10 @@ vpic_simulation::initialize( int argc,
 
   if( rank()==0 ) VMESSAGE(( "Initializing bound charge density" ));
   TIC FAK->clear_rhof( field_array ); TOC( clear_rhof, 1 );
-  LIST_FOR_EACH( sp, species_list ) TIC accumulate_rho_p( field_array, sp ); TOC( accumulate_rho_p, 1 );
-  TIC FAK->synchronize_rho( field_array ); TOC( synchronize_rho, 1 );
+  if( species_list ) TIC accumulate_rho_p_list_faces( field_array, species_list ); TOC( accumulate_rho_p, 1 );
+  TIC FAK->begin_synchronize_rho( field_array ); TOC( synchronize_rho, 0 );
+  if( species_list ) TIC accumulate_rho_p_list_interior( field_array ); TOC( accumulate_rho_p, 0 );
+  TIC FAK->end_synchronize_rho( field_array ); TOC( synchronize_rho, 1 );
   TIC FAK->compute_rhob( field_array ); TOC( compute_rhob, 1 );
 
   // Internal sanity checks
@@ -59,12 +61,32 @@ vpic_simulation::initialize( int argc,
   // field(i,j,k).jfx, jfy, jfz will not be valid at this point.
   TIC user_diagnostics(); TOC( user_diagnostics, 1 );
 
+  // Move the pages of the loaded particles to the pipelines that advance
+  // them and report where the pages of the large arrays are when the
+  // pipelines are bound to cores (see pipeline_affinity).
+
+  if( pipeline_affinity ) {
+    LIST_FOR_EACH( sp, species_list ) {
+      place_pipelines( sp->p, sizeof(particle_t), sp->np, 16 );
+      log_numa_usage( sp->name, sp->p, (size_t)sp->np*sizeof(particle_t) );
+    }
+    log_numa_usage( "accumulators", accumulator_array->a,
+                    (size_t)accumulator_array->n_array*
+                    (size_t)accumulator_array->stride*sizeof(accumulator_t) );
+    log_numa_usage( "interpolators", interpolator_array->i,
+                    (size_t)grid->nv*sizeof(interpolator_t) );
+    log_numa_usage( "fields", field_array->f,
+                    (size_t)grid->nv*sizeof(field_t) );
+  }
+
   if( rank()==0 ) VMESSAGE(( "Initialization complete" ));
   update_profile( rank()==0 ); // Let the user know how initialization went
 }
 
 void
 vpic_simulation::finalize( void ) {
+  dump_particles_flush();
+  dump_particles_halt();
   barrier();
   update_profile( rank()==0 );
 }
@@ -73,7 +73,11 @@ vpic_simulation::inject_particle( species_t * sp,
   if( iz==nz ) iz = nz-1;             // On far wall ... conditional move
   iz++;                               // Adjust for mesh indexing
 
-  particle_t * p = sp->p + (sp->np++);
+  // AoSoA particles are packed in place (see store_particle_pb)
+
+  particle_t p_aosoa[1];
+  particle_t * p = sp->p_layout==particle_layout_aosoa ? p_aosoa :
+                                                         sp->p + sp->np;
   p->dx = (float)x; // Note: Might be rounded to be on [-1,1]
   p->dy = (float)y; // Note: Might be rounded to be on [-1,1]
   p->dz = (float)z; // Note: Might be rounded to be on [-1,1]
@@ -85,6 +89,8 @@ vpic_simulation::inject_particle( species_t * sp,
 #ifdef ENABLE_PARTICLE_TAG
   p->tag = tag;
 #endif
+  if( p==p_aosoa ) store_particle_pb( (particle_block_t *)sp->p, sp->np, p );
+  sp->np++;
 
   if( update_rhob ) accumulate_rhob( field_array->f, p, grid, -sp->q );
 
@@ -97,7 +103,11 @@ vpic_simulation::inject_particle( species_t * sp,
     pm->dispy = uy*age*grid->rdy;
     pm->dispz = uz*age*grid->rdz;
     pm->i     = sp->np-1;
-    sp->nm += move_p( sp->p, pm, accumulator_array->a, grid, sp->q );
+    if( p==p_aosoa )
+      sp->nm += move_pb( (particle_block_t *)sp->p, pm,
+                         accumulator_array->a, grid, sp->q );
+    else
+      sp->nm += move_p( sp->p, pm, accumulator_array->a, grid, sp->q );
   }
 
 }
@@ -230,6 +240,7 @@ void vpic_simulation::checksum_species(const char * species, CheckSum & cs) {
     ERROR(("Invalid species name \"%s\".", species));
   } // if
   
+  convert_p( sp, particle_layout_aos );
   checkSumBuffer<particle_t>(sp->p, sp->np, cs, "sha1");
 
   if(nproc() > 1) {
@@ -258,6 +269,7 @@ void vpic_simulation::output_checksum_species(const char * species) {
   } // if
   
   CheckSum cs;
+  convert_p( sp, particle_layout_aos );
   checkSumBuffer<particle_t>(sp->p, sp->np, cs, "sha1");
 
   if(nproc() > 1) {
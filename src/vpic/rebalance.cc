@@ -0,0 +1,703 @@
+/*
+ * Dynamic load balancing
+ *
+ * The domain decomposition of a grid built by one of the partition_*_box
+ * functions is rectilinear: each axis of the global voxel mesh is cut into
+ * gp{x,y,z} slabs and rank (px,py,pz) owns the intersection of its three
+ * slabs.  rebalance_domain measures the cost of each rank from the profile
+ * timers, distributes it to the global voxel planes along each axis, moves
+ * the cuts so each slab gets an equal share and then migrates the fields
+ * and particles to their new owners.  remap_domain re-decomposes the domain
+ * of a checkpt written by a different number of ranks the same way.
+ */
+
+#include "vpic.h"
+
+// Tags of the migration messages (the grid ports use tags 0:26)
+
+#define BALANCE_SIZE_TAG 32
+#define BALANCE_DATA_TAG 33
+
+// Blocks of a migration message are padded to 32 bytes
+
+#define BALANCE_ALIGN(n) ( ( (size_t)(n) + 31 ) & ~(size_t)31 )
+
+// Profile times at the last rebalance
+
+static double balance_t_particle = 0, balance_t_field = 0;
+
+// Cut n planes with costs w into np slabs of roughly equal cost.  Each
+// slab gets at least m planes.
+
+static void
+balance_cuts( const double * w,
+              int n,
+              int np,
+              int m,
+              int * cut ) {
+  double total = 0, target, s = 0;
+  int c, p, lo, hi;
+
+  for( c=0; c<n; c++ ) total += w[c];
+
+  cut[0] = 0;
+  for( c=0, p=1; p<np; p++ ) {
+    target = total*(double)p/(double)np;
+    lo = cut[p-1] + m;
+    hi = n - (np-p)*m;
+    while( c<lo ) s += w[c++];
+    while( c<hi && s+0.5*w[c]<target ) s += w[c++];
+    cut[p] = c;
+  }
+  cut[np] = n;
+}
+
+// Box of global voxel indices [lo,hi] that rank src supplies to rank dst
+// when the domain cuts change from scut on the sgp process mesh to dcut
+// on the dgp process mesh.  A rank supplies its non-ghost voxels and, on
+// the global domain faces, the global ghost voxels.  A rank needs its
+// non-ghost and ghost voxels.  Returns the number of voxels in the box.
+
+static size_t
+migration_box( int * const * scut,
+               const int * sgp,
+               int * const * dcut,
+               const int * dgp,
+               const int * gn,
+               int src,
+               int dst,
+               int * lo,
+               int * hi ) {
+  int s[3], d[3], a;
+  size_t n = 1;
+
+  s[0] = src % sgp[0], s[1] = (src/sgp[0]) % sgp[1], s[2] = src/(sgp[0]*sgp[1]);
+  d[0] = dst % dgp[0], d[1] = (dst/dgp[0]) % dgp[1], d[2] = dst/(dgp[0]*dgp[1]);
+
+  for( a=0; a<3; a++ ) {
+    lo[a] = s[a]==0        ? 0       : scut[a][s[a]]+1;
+    hi[a] = s[a]==sgp[a]-1 ? gn[a]+1 : scut[a][s[a]+1];
+    if( lo[a]<dcut[a][d[a]]     ) lo[a] = dcut[a][d[a]];
+    if( hi[a]>dcut[a][d[a]+1]+1 ) hi[a] = dcut[a][d[a]+1]+1;
+    if( hi[a]<lo[a] ) return 0;
+    n *= (size_t)( hi[a]-lo[a]+1 );
+  }
+
+  return n;
+}
+
+// Copy a box of field data between the local field array of a domain of
+// n[0] x n[1] x n[2] voxels and a buffer.  o are the global indices of
+// the local voxel (0,0,0).
+
+static void
+copy_box( field_t * f,
+          const int * n,
+          const int * o,
+          const int * lo,
+          const int * hi,
+          field_t * buf,
+          int unpack ) {
+  int x, y, z;
+  for( z=lo[2]; z<=hi[2]; z++ )
+    for( y=lo[1]; y<=hi[1]; y++ )
+      for( x=lo[0]; x<=hi[0]; x++, buf++ ) {
+        field_t * fv = f + VOXEL( x-o[0], y-o[1], z-o[2], n[0], n[1], n[2] );
+        if( unpack ) *fv = *buf;
+        else         *buf = *fv;
+      }
+}
+
+// Reallocate the voxel indexed arrays after the grid was repartitioned.
+// Their contents are cleared.
+
+void
+vpic_simulation::resize_domain( void ) {
+  species_t * sp;
+
+  FREE_ALIGNED( field_array->f );
+  MALLOC_ALIGNED( field_array->f, grid->nv, 128 );
+  CLEAR( field_array->f, grid->nv );
+
+  FREE_ALIGNED( interpolator_array->i );
+  MALLOC_ALIGNED( interpolator_array->i, grid->nv, 128 );
+  if( pipeline_affinity ) clear_pipelines( interpolator_array->i,
+                                           sizeof(interpolator_t),
+                                           grid->nv, 1 ); // First touch
+  else                    CLEAR( interpolator_array->i, grid->nv );
+
+  reset_accumulator_array( accumulator_array );
+
+  FREE_ALIGNED( hydro_array->h );
+  MALLOC_ALIGNED( hydro_array->h, grid->nv, 128 );
+  clear_hydro_array( hydro_array );
+
+  LIST_FOR_EACH( sp, species_list ) {
+    FREE_ALIGNED( sp->partition );
+    MALLOC_ALIGNED( sp->partition, grid->nv+1, 128 );
+  }
+}
+
+void
+vpic_simulation::rebalance_domain( void ) {
+  const int gp[3] = { grid->gpx, grid->gpy, grid->gpz };
+  const int gn[3] = { grid->gnx, grid->gny, grid->gnz };
+  const int n_cut = gp[0]+gp[1]+gp[2]+3;
+  const int n_sp  = num_species( species_list );
+  int *ocut[3], *ncut[3], *map[3], *old_cut, *cut, *dst, *src, *slot;
+  int *count, me[3], lo[3], hi[3], o[3], ln[3], g3[3], q3[3];
+  int a, i, n, p, q, s, n_dst, n_src, changed;
+  double *wg, *w[3], *cost, t_particle, t_field, wp, wv, c, c_max, c_sum;
+  size_t *off, sz;
+  int64_t np;
+  species_t * sp;
+  mp_t * mp, * mp_sz;
+
+  if( grid->partition==custom_partition ) {
+    static int warned = 0;
+    if( !warned && rank()==0 )
+      WARNING(( "Only grids built with define_*_grid can be rebalanced" ));
+    warned = 1;
+    return;
+  }
+
+  if( emitter_list ) {
+    static int warned = 0;
+    if( !warned && rank()==0 )
+      WARNING(( "Domains with emitters cannot be rebalanced" ));
+    warned = 1;
+    return;
+  }
+
+  //--------------------------------------------------------------------------
+  // Measure the cost of this rank since the last rebalance
+  //--------------------------------------------------------------------------
+
+  t_particle = PROFILE_TIME( advance_p );
+  t_field    = PROFILE_TIME( advance_b ) + PROFILE_TIME( advance_e );
+  if( t_particle<balance_t_particle ) balance_t_particle = 0; // Restored
+  if( t_field   <balance_t_field    ) balance_t_field    = 0;
+  t_particle -= balance_t_particle, balance_t_particle += t_particle;
+  t_field    -= balance_t_field,    balance_t_field    += t_field;
+
+  np = 0;
+  LIST_FOR_EACH( sp, species_list ) np += sp->np;
+
+  MALLOC( cost, 2*world_size );
+  CLEAR( cost, world_size );
+  cost[world_rank] = t_particle + t_field;
+  mp_allsum_d( cost, cost+world_size, world_size );
+  c_max = 0, c_sum = 0;
+  for( n=0; n<world_size; n++ ) {
+    c = cost[world_size+n];
+    if( c>c_max ) c_max = c;
+    c_sum += c;
+  }
+  FREE( cost );
+
+  // Without timings (e.g. before the first step), balance the particle
+  // counts.
+
+  if( c_sum>0 ) {
+    if( c_max<=balance_threshold*c_sum/(double)world_size ) return;
+    wp = np ? t_particle/(double)np : 0;
+    wv = t_field/(double)( grid->nx*grid->ny*grid->nz );
+  } else {
+    wp = 1;
+    wv = 0;
+  }
+
+  //--------------------------------------------------------------------------
+  // Distribute the cost to the global voxel planes along each axis and
+  // cut each axis into slabs of equal cost
+  //--------------------------------------------------------------------------
+
+  // Keep a copy of the old cuts as repartition_box overwrites them
+
+  MALLOC( old_cut, n_cut );
+  COPY( old_cut, grid->cut, n_cut );
+  ocut[0] = old_cut;
+  ocut[1] = ocut[0] + gp[0]+1;
+  ocut[2] = ocut[1] + gp[1]+1;
+
+  me[0] = world_rank % gp[0];
+  me[1] = ( world_rank / gp[0] ) % gp[1];
+  me[2] = world_rank / ( gp[0]*gp[1] );
+
+  for( a=0; a<3; a++ ) o[a] = ocut[a][me[a]];
+
+  n = gn[0]+gn[1]+gn[2];
+  MALLOC( wg, 2*n );
+  CLEAR( wg, n );
+  w[0] = wg;
+  w[1] = w[0] + gn[0];
+  w[2] = w[1] + gn[1];
+
+  for( i=1; i<=grid->nx; i++ ) w[0][o[0]+i-1] += wv*grid->ny*grid->nz;
+  for( i=1; i<=grid->ny; i++ ) w[1][o[1]+i-1] += wv*grid->nz*grid->nx;
+  for( i=1; i<=grid->nz; i++ ) w[2][o[2]+i-1] += wv*grid->nx*grid->ny;
+
+  LIST_FOR_EACH( sp, species_list ) {
+    convert_p( sp, particle_layout_aos );
+    for( p=0; p<sp->np; p++ ) {
+      i = sp->p[p].i;
+      w[0][ o[0] + i % grid->sy - 1                   ] += wp;
+      w[1][ o[1] + ( i / grid->sy ) % (grid->ny+2) - 1 ] += wp;
+      w[2][ o[2] + i / grid->sz - 1                   ] += wp;
+    }
+  }
+
+  mp_allsum_d( wg, wg+n, n );
+
+  // Rank 0 picks the cuts and the others contribute zeros to the sum
+  // so that all ranks agree exactly.
+
+  MALLOC( cut, 2*n_cut );
+  CLEAR( cut, n_cut );
+  if( world_rank==0 )
+    for( p=0, q=0, a=0; a<3; p+=gp[a]+1, q+=gn[a], a++ )
+      balance_cuts( wg+n+q, gn[a], gp[a], gn[a]>=2*gp[a] ? 2 : 1, cut+p );
+  mp_allsum_i( cut, cut+n_cut, n_cut );
+  FREE( wg );
+
+  ncut[0] = cut + n_cut;
+  ncut[1] = ncut[0] + gp[0]+1;
+  ncut[2] = ncut[1] + gp[1]+1;
+
+  changed = 0;
+  for( p=0; p<n_cut; p++ ) if( ncut[0][p]!=ocut[0][p] ) changed = 1;
+  if( !changed ) {
+    FREE( cut );
+    FREE( old_cut );
+    return;
+  }
+
+  if( rank()==0 ) {
+    MESSAGE(( "Rebalancing domain (max/mean cost %.3f)",
+              c_sum>0 ? c_max*(double)world_size/c_sum : 0. ));
+    for( a=0; a<3; a++ ) {
+      char line[256];
+      int len = 0;
+      if( gp[a]==1 ) continue;
+      for( p=0; p<=gp[a] && len<200; p++ )
+        len += sprintf( line+len, " %i", ncut[a][p] );
+      MESSAGE(( "New %c cuts:%s%s", 'x'+a, line, p<=gp[a] ? " ..." : "" ));
+    }
+  }
+
+  //--------------------------------------------------------------------------
+  // Pack the fields and particles for their new owners
+  //--------------------------------------------------------------------------
+
+  // New slab of each global voxel index along each axis
+
+  for( a=0; a<3; a++ ) {
+    MALLOC( map[a], gn[a]+2 );
+    for( q=0; q<gp[a]; q++ )
+      for( i=ncut[a][q]+1; i<=ncut[a][q+1]; i++ ) map[a][i] = q;
+  }
+
+  // Find the ranks this rank sends to and receives from
+
+  MALLOC( dst,  world_size );
+  MALLOC( src,  world_size );
+  MALLOC( slot, world_size );
+  n_dst = n_src = 0;
+  for( q=0; q<world_size; q++ ) {
+    slot[q] = -1;
+    if( migration_box( ocut, gp, ncut, gp, gn, world_rank, q, lo, hi ) )
+      slot[q] = n_dst, dst[n_dst++] = q;
+    if( migration_box( ocut, gp, ncut, gp, gn, q, world_rank, lo, hi ) )
+      src[n_src++] = q;
+  }
+
+  // Count the particles going to each destination
+
+  MALLOC( count, n_dst*n_sp+1 );
+  CLEAR( count, n_dst*n_sp+1 );
+  s = 0;
+  LIST_FOR_EACH( sp, species_list ) {
+    for( p=0; p<sp->np; p++ ) {
+      i = sp->p[p].i;
+      q = map[0][ o[0] + i % grid->sy                   ] + gp[0]*(
+          map[1][ o[1] + ( i / grid->sy ) % (grid->ny+2) ] + gp[1]*
+          map[2][ o[2] + i / grid->sz                   ] );
+      count[ slot[q]*n_sp + s ]++;
+    }
+    s++;
+  }
+
+  // A message holds the particle counts, the field box and then the
+  // particles of each species.  Particle voxel indices are converted to
+  // the new local voxel indices of the receiver.
+
+  mp    = new_mp( world_size );
+  mp_sz = new_mp( world_size );
+
+  ln[0] = grid->nx, ln[1] = grid->ny, ln[2] = grid->nz;
+
+  MALLOC( off, n_dst*n_sp+1 );
+  for( n=0; n<n_dst; n++ ) {
+    char * buf;
+    q  = dst[n];
+    sz = migration_box( ocut, gp, ncut, gp, gn, world_rank, q, lo, hi );
+    sz = BALANCE_ALIGN( n_sp*sizeof(int) ) + BALANCE_ALIGN( sz*sizeof(field_t) );
+    for( s=0; s<n_sp; s++ ) {
+      off[n*n_sp+s] = sz;
+      sz += count[n*n_sp+s]*sizeof(particle_t);
+    }
+    if( sz>INT_MAX ) ERROR(( "Migration message to rank %i too large", q ));
+
+    mp_size_send_buffer( mp, q, (int)sz );
+    buf = (char *)mp_send_buffer( mp, q );
+    COPY( (int *)buf, count+n*n_sp, n_sp );
+    copy_box( field_array->f, ln, o, lo, hi,
+              (field_t *)( buf + BALANCE_ALIGN( n_sp*sizeof(int) ) ), 0 );
+
+    mp_size_send_buffer( mp_sz, q, sizeof(int) );
+    *(int *)mp_send_buffer( mp_sz, q ) = (int)sz;
+  }
+
+  s = 0;
+  LIST_FOR_EACH( sp, species_list ) {
+    for( p=0; p<sp->np; p++ ) {
+      particle_t pn = sp->p[p];
+      i = pn.i;
+      g3[0] = o[0] + i % grid->sy;
+      g3[1] = o[1] + ( i / grid->sy ) % (grid->ny+2);
+      g3[2] = o[2] + i / grid->sz;
+      for( a=0; a<3; a++ ) q3[a] = map[a][g3[a]];
+      q = q3[0] + gp[0]*( q3[1] + gp[1]*q3[2] );
+      pn.i = VOXEL( g3[0]-ncut[0][q3[0]],
+                    g3[1]-ncut[1][q3[1]],
+                    g3[2]-ncut[2][q3[2]],
+                    ncut[0][q3[0]+1]-ncut[0][q3[0]],
+                    ncut[1][q3[1]+1]-ncut[1][q3[1]],
+                    ncut[2][q3[2]+1]-ncut[2][q3[2]] );
+      n = slot[q]*n_sp + s;
+      COPY( (particle_t *)( (char *)mp_send_buffer( mp, q ) + off[n] ),
+            &pn, 1 );
+      off[n] += sizeof(particle_t);
+    }
+    sp->np = 0;
+    s++;
+  }
+  FREE( off );
+
+  //--------------------------------------------------------------------------
+  // Exchange the messages.  The sizes go first so the receivers can size
+  // their buffers.
+  //--------------------------------------------------------------------------
+
+  for( n=0; n<n_src; n++ ) {
+    p = src[n];
+    mp_size_recv_buffer( mp_sz, p, sizeof(int) );
+    mp_begin_recv( mp_sz, p, sizeof(int), p, BALANCE_SIZE_TAG );
+  }
+  for( n=0; n<n_dst; n++ )
+    mp_begin_send( mp_sz, dst[n], sizeof(int), dst[n], BALANCE_SIZE_TAG );
+
+  for( n=0; n<n_src; n++ ) {
+    p = src[n];
+    mp_end_recv( mp_sz, p );
+    sz = *(int *)mp_recv_buffer( mp_sz, p );
+    mp_size_recv_buffer( mp, p, (int)sz );
+    mp_begin_recv( mp, p, (int)sz, p, BALANCE_DATA_TAG );
+  }
+  for( n=0; n<n_dst; n++ ) {
+    q = dst[n];
+    mp_end_send( mp_sz, q );
+    sz = *(int *)mp_send_buffer( mp_sz, q );
+    mp_begin_send( mp, q, (int)sz, q, BALANCE_DATA_TAG );
+  }
+  for( n=0; n<n_src; n++ ) mp_end_recv( mp, src[n] );
+  for( n=0; n<n_dst; n++ ) mp_end_send( mp, dst[n] );
+
+  //--------------------------------------------------------------------------
+  // Repartition the grid and resize the voxel indexed arrays
+  //--------------------------------------------------------------------------
+
+  repartition_box( grid, ncut[0] );
+  resize_domain();
+
+  //--------------------------------------------------------------------------
+  // Unpack the fields and particles
+  //--------------------------------------------------------------------------
+
+  for( a=0; a<3; a++ ) o[a] = ncut[a][me[a]];
+  ln[0] = grid->nx, ln[1] = grid->ny, ln[2] = grid->nz;
+
+  s = 0;
+  LIST_FOR_EACH( sp, species_list ) {
+    int np_recv = 0;
+    for( n=0; n<n_src; n++ )
+      np_recv += ((int *)mp_recv_buffer( mp, src[n] ))[s];
+
+    if( np_recv>sp->max_np ) {
+      particle_t * new_p;
+      n = np_recv + 0.3125*np_recv; // See boundary_p
+      WARNING(( "Resizing local %s particle storage from %i to %i",
+                sp->name, sp->max_np, n ));
+      MALLOC_ALIGNED( new_p, PARTICLE_BLOCK_CEIL(n), 128 );
+      unplace_pipelines( sp->p );
+      FREE_ALIGNED( sp->p );
+      sp->p = new_p, sp->max_np = n;
+    }
+    s++;
+  }
+
+  for( n=0; n<n_src; n++ ) {
+    char * buf = (char *)mp_recv_buffer( mp, src[n] );
+    const int * np_src = (const int *)buf;
+    sz   = migration_box( ocut, gp, ncut, gp, gn, src[n], world_rank,
+                          lo, hi );
+    buf += BALANCE_ALIGN( n_sp*sizeof(int) );
+    copy_box( field_array->f, ln, o, lo, hi, (field_t *)buf, 1 );
+    buf += BALANCE_ALIGN( sz*sizeof(field_t) );
+    s = 0;
+    LIST_FOR_EACH( sp, species_list ) {
+      COPY( sp->p + sp->np, (const particle_t *)buf, np_src[s] );
+      sp->np += np_src[s];
+      buf    += np_src[s]*sizeof(particle_t);
+      s++;
+    }
+  }
+
+  delete_mp( mp_sz );
+  delete_mp( mp );
+  FREE( count );
+  FREE( slot );
+  FREE( src );
+  FREE( dst );
+  for( a=0; a<3; a++ ) FREE( map[a] );
+  FREE( cut );
+  FREE( old_cut );
+
+  // Rebuild the species partitions and the interpolators
+
+  LIST_FOR_EACH( sp, species_list ) sort_p( sp );
+  load_interpolator_array( interpolator_array, field_array );
+}
+
+//----------------------------------------------------------------------------
+// Restarting on a different number of ranks.  Each rank restores the
+// objects of one of the ranks that wrote the checkpt (main does this with
+// restore_remapped_objects), which gives it the simulation with the old
+// domain.  remap_domain then meshes the global domain onto the current
+// ranks and fills each rank's domain with the fields and particles of the
+// old ranks whose domains overlap it, read with restore_object.
+//----------------------------------------------------------------------------
+
+// Process mesh for n ranks with the least surface per domain
+
+static void
+remap_mesh( const int * gn,
+            int n,
+            int * gp ) {
+  double s, best = -1;
+  int p[3];
+
+  for( p[0]=1; p[0]<=n; p[0]++ ) {
+    if( n % p[0] || p[0]>gn[0] ) continue;
+    for( p[1]=1; p[1]<=n/p[0]; p[1]++ ) {
+      if( (n/p[0]) % p[1] || p[1]>gn[1] ) continue;
+      p[2] = n/(p[0]*p[1]);
+      if( p[2]>gn[2] ) continue;
+      s = (double)gn[0]*(double)gn[1]/((double)p[0]*(double)p[1]) +
+          (double)gn[1]*(double)gn[2]/((double)p[1]*(double)p[2]) +
+          (double)gn[2]*(double)gn[0]/((double)p[2]*(double)p[0]);
+      if( best<0 || s<best ) best = s, gp[0] = p[0], gp[1] = p[1], gp[2] = p[2];
+    }
+  }
+
+  if( best<0 )
+    ERROR(( "Unable to decompose a %ix%ix%i domain onto %i ranks",
+            gn[0], gn[1], gn[2], n ));
+}
+
+void
+vpic_simulation::remap_domain( const char * fbase ) {
+  const int face[6] = { BOUNDARY(-1, 0, 0), BOUNDARY( 0,-1, 0),
+                        BOUNDARY( 0, 0,-1), BOUNDARY( 1, 0, 0),
+                        BOUNDARY( 0, 1, 0), BOUNDARY( 0, 0, 1) };
+  const int gn[3] = { grid->gnx, grid->gny, grid->gnz };
+  int ogp[3] = { grid->gpx, grid->gpy, grid->gpz }, ngp[3];
+  int *ocut[3], *ncut[3], *map[3], *old_cut, *cut;
+  int t[3], me[3], s3[3], o[3], so[3], ln[3], sn[3], lo[3], hi[3], g3[3];
+  int fbc[6], a, f, i, n, p, q, n_old, n_cut, on_face;
+  int64_t pbc[6];
+  size_t sz;
+  species_t * sp, * sp_old;
+  field_array_t * fa_old;
+  field_t * buf;
+
+  if( grid->partition==custom_partition )
+    ERROR(( "Only grids built with define_*_grid can be restarted on a "
+            "different number of ranks" ));
+
+  if( emitter_list )
+    ERROR(( "Simulations with emitters cannot be restarted on a different "
+            "number of ranks" ));
+
+  n_old = ogp[0]*ogp[1]*ogp[2];
+  n_cut = ogp[0]+ogp[1]+ogp[2]+3;
+
+  MALLOC( old_cut, n_cut );
+  COPY( old_cut, grid->cut, n_cut );
+  ocut[0] = old_cut;
+  ocut[1] = ocut[0] + ogp[0]+1;
+  ocut[2] = ocut[1] + ogp[1]+1;
+
+  // The old rank this rank was restored from
+
+  p = grid->bc[ BOUNDARY(0,0,0) ];
+  t[0] = p % ogp[0], t[1] = ( p/ogp[0] ) % ogp[1], t[2] = p/( ogp[0]*ogp[1] );
+
+  // Uniformly decompose the domain over the current ranks.  Load
+  // balancing (balance_interval) can refine the cuts later.
+
+  remap_mesh( gn, world_size, ngp );
+
+  MALLOC( cut, ngp[0]+ngp[1]+ngp[2]+3 );
+  ncut[0] = cut;
+  ncut[1] = ncut[0] + ngp[0]+1;
+  ncut[2] = ncut[1] + ngp[1]+1;
+  for( a=0; a<3; a++ )
+    for( p=0; p<=ngp[a]; p++ )
+      ncut[a][p] = (int)( ( (int64_t)p*(int64_t)gn[a] )/(int64_t)ngp[a] );
+
+  me[0] = world_rank % ngp[0];
+  me[1] = ( world_rank/ngp[0] ) % ngp[1];
+  me[2] = world_rank/( ngp[0]*ngp[1] );
+
+  if( rank()==0 )
+    MESSAGE(( "Remapping a %ix%ix%i process mesh onto %ix%ix%i",
+              ogp[0], ogp[1], ogp[2], ngp[0], ngp[1], ngp[2] ));
+
+  //--------------------------------------------------------------------------
+  // Find the boundary conditions of the global domain faces this rank
+  // will be on.  They are on the faces of the old domains on the same
+  // global faces.
+  //--------------------------------------------------------------------------
+
+  for( f=0; f<6; f++ ) {
+    const grid_t * g;
+    grid_t * g_old = NULL;
+    a = f%3;
+    fbc[f] = 0, pbc[f] = 0;
+    on_face = f<3 ? me[a]==0 : me[a]==ngp[a]-1;
+    if( !on_face ) continue;
+
+    s3[0] = t[0], s3[1] = t[1], s3[2] = t[2];
+    s3[a] = f<3 ? 0 : ogp[a]-1;
+    g = grid;
+    if( s3[a]!=t[a] ) {
+      p = s3[0] + ogp[0]*( s3[1] + ogp[1]*s3[2] );
+      g = g_old = (grid_t *)restore_object( fbase, p, grid );
+    }
+
+    fbc[f] = g->bc[ face[f] ];
+    i = f<3 ? VOXEL(1,1,1, g->nx,g->ny,g->nz) :
+              VOXEL(g->nx,g->ny,g->nz, g->nx,g->ny,g->nz);
+    pbc[f] = g->neighbor[ 6*i + f ];
+
+    if( g_old ) {
+      FREE_ALIGNED( g_old->cut );
+      FREE_ALIGNED( g_old->sfc );
+      FREE_ALIGNED( g_old->neighbor );
+      FREE_ALIGNED( g_old->range );
+      FREE( g_old );
+    }
+  }
+
+  //--------------------------------------------------------------------------
+  // Drop the restored domain and remesh the grid
+  //--------------------------------------------------------------------------
+
+  LIST_FOR_EACH( sp, species_list ) sp->np = 0, sp->nm = 0;
+
+  remesh_box( grid, ngp[0], ngp[1], ngp[2], cut, fbc, pbc );
+  resize_domain();
+
+  for( a=0; a<3; a++ ) o[a] = ncut[a][me[a]];
+  ln[0] = grid->nx, ln[1] = grid->ny, ln[2] = grid->nz;
+
+  for( a=0; a<3; a++ ) {
+    MALLOC( map[a], gn[a]+2 );
+    for( q=0; q<ngp[a]; q++ )
+      for( i=ncut[a][q]+1; i<=ncut[a][q+1]; i++ ) map[a][i] = q;
+    map[a][0] = 0, map[a][gn[a]+1] = ngp[a]-1;
+  }
+
+  //--------------------------------------------------------------------------
+  // Load the fields and particles of the old domains overlapping this
+  // rank's domain
+  //--------------------------------------------------------------------------
+
+  for( p=0; p<n_old; p++ ) {
+    sz = migration_box( ocut, ogp, ncut, ngp, gn, p, world_rank, lo, hi );
+    if( !sz ) continue;
+
+    s3[0] = p % ogp[0], s3[1] = ( p/ogp[0] ) % ogp[1];
+    s3[2] = p/( ogp[0]*ogp[1] );
+    for( a=0; a<3; a++ ) {
+      so[a] = ocut[a][s3[a]];
+      sn[a] = ocut[a][s3[a]+1] - ocut[a][s3[a]];
+    }
+
+    // Fields
+
+    fa_old = (field_array_t *)restore_object( fbase, p, field_array );
+    MALLOC_ALIGNED( buf, sz, 128 );
+    copy_box( fa_old->f,      sn, so, lo, hi, buf, 0 );
+    copy_box( field_array->f, ln, o,  lo, hi, buf, 1 );
+    FREE_ALIGNED( buf );
+    REGISTER_OBJECT( fa_old, NULL, NULL, NULL ); // So it can be deleted
+    delete_field_array( fa_old );
+
+    // Particles in this rank's domain.  Voxel indices are converted to
+    // the new local voxel indices.
+
+    LIST_FOR_EACH( sp, species_list ) {
+      sp_old = (species_t *)restore_object( fbase, p, sp );
+      for( n=0; n<sp_old->np; n++ ) {
+        particle_t pn = sp_old->p[n];
+        i = pn.i;
+        g3[0] = so[0] + i % (sn[0]+2);
+        g3[1] = so[1] + ( i/(sn[0]+2) ) % (sn[1]+2);
+        g3[2] = so[2] + i/( (sn[0]+2)*(sn[1]+2) );
+        if( map[0][g3[0]]!=me[0] || map[1][g3[1]]!=me[1] ||
+            map[2][g3[2]]!=me[2] ) continue;
+        if( sp->np==sp->max_np ) {
+          particle_t * new_p;
+          q = sp->max_np + sp->max_np/2 + 16;
+          MALLOC_ALIGNED( new_p, PARTICLE_BLOCK_CEIL(q), 128 );
+          COPY( new_p, sp->p, sp->np );
+          unplace_pipelines( sp->p );
+          FREE_ALIGNED( sp->p );
+          sp->p = new_p, sp->max_np = q;
+        }
+        pn.i = VOXEL( g3[0]-o[0], g3[1]-o[1], g3[2]-o[2],
+                      ln[0], ln[1], ln[2] );
+        sp->p[ sp->np++ ] = pn;
+      }
+      FREE_ALIGNED( sp_old->partition );
+      FREE_ALIGNED( sp_old->pm );
+      FREE_ALIGNED( sp_old->p );
+      FREE( sp_old->name );
+      FREE( sp_old );
+    }
+  }
+
+  for( a=0; a<3; a++ ) FREE( map[a] );
+  FREE( cut );
+  FREE( old_cut );
+
+  // Rebuild the species partitions and the interpolators.  The ranks
+  // restored from the same old rank hold copies of its random number
+  // generators; reseed them from the synchronized generators.
+
+  LIST_FOR_EACH( sp, species_list ) sort_p( sp );
+  load_interpolator_array( interpolator_array, field_array );
+  seed_rng_pool( entropy, (int)( uirand( sync_entropy->rng[0] ) & 0x3ff ), 0 );
+}
@@ -79,6 +79,7 @@ vpic_simulation::vpic_simulation() {
   num_comm_round = 3;
   num_div_e_round = 2;
   num_div_b_round = 2;
+  balance_threshold = 1.1;
 
 #if defined(VPIC_USE_PTHREADS)                         // Pthreads case.
   int                              n_rng = serial.n_pipeline;
@@ -111,6 +112,7 @@ vpic_simulation::vpic_simulation() {
  
 vpic_simulation::~vpic_simulation() {
   UNREGISTER_OBJECT( this );
+  delete_collision_op_list( collision_op_list );
   delete_emitter_list( emitter_list );
   delete_particle_bc_list( particle_bc_list );
   delete_species_list( species_list );
@@ -124,3 +126,9 @@ vpic_simulation::~vpic_simulation() {
   delete_rng_pool( entropy );
 }
  
+
+// Named for checkpt_sym (see REGISTER_SYMBOL)
+
+REGISTER_SYMBOL( checkpt_vpic_simulation )
+REGISTER_SYMBOL( restore_vpic_simulation )
+REGISTER_SYMBOL( reanimate_vpic_simulation )
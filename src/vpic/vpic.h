@@ -126,6 +126,13 @@ public:
   int advance( void );
   void finalize( void );
 
+  // Wait until all asynchronous particle dumps are on disk
+  void dump_particles_flush( void );
+
+  // Load the fields and particles of the checkpt fbase when it was
+  // written by a different number of ranks (see rebalance.cc)
+  void remap_domain( const char * fbase );
+
 private:
 
   // Directly initialized by user
@@ -133,12 +140,31 @@ private:
   int verbose;              // Should system be verbose
   int num_step;             // Number of steps to take
   int num_comm_round;       // Num comm round
+  int overlap_boundary_p;   // Overlap the particle exchange with the
+                            // interior particle push.  Off by default.
+                            // When on, the particles of species not
+                            // sorted that step are reordered before
+                            // the push, and the emitters and
+                            // user_particle_injection run before the
+                            // interior particles are pushed (they are
+                            // still at r_0 and u_{-1/2}) and may only
+                            // append particles, not remove or reorder
+                            // them.
+  int tile_accumulators;    // Have the pipelines accumulate currents to
+                            // tiles instead of full accumulator copies
+                            // (see accumulator_array_t); species not
+                            // sorted in a step are then partitioned by
+                            // pipeline in the particle advance
   int status_interval;      // How often to print status messages
   int clean_div_e_interval; // How often to clean div e
   int num_div_e_round;      // How many clean div e rounds per div e interval
   int clean_div_b_interval; // How often to clean div b
   int num_div_b_round;      // How many clean div b rounds per div b interval
   int sync_shared_interval; // How often to synchronize shared faces
+  int balance_interval;     // How often to rebalance the domain
+                            // decomposition
+  double balance_threshold; // Only rebalance if the max/mean rank cost
+                            // exceeds this
 
   // FIXME: THESE INTERVALS SHOULDN'T BE PART OF vpic_simulation
   // THE BIG LIST FOLLOWING IT SHOULD BE CLEANED UP TOO
@@ -239,6 +265,12 @@ private:
   void dump_particles( const char *sp_name, const char *fbase,
                        int fname_tag = 1 );
 
+  // Asynchronous particle dumps (same file format as dump_particles)
+  void dump_particles_async( const char *sp_name, const char *fbase,
+                             int fname_tag = 1 );
+  void dump_particles_halt( void );
+  void set_particle_dump_buffer( int n_particle );
+
   // convenience functions for simlog output
   void create_field_list(char * strlist, DumpParameters & dumpParams);
   void create_hydro_list(char * strlist, DumpParameters & dumpParams);
@@ -254,6 +286,12 @@ private:
   void field_dump(DumpParameters & dumpParams);
   void hydro_dump(const char * speciesname, DumpParameters & dumpParams);
 
+  //////////////////
+  // Load balancing
+
+  void rebalance_domain( void );
+  void resize_domain( void );
+
   ///////////////////
   // Useful accessors
 
@@ -293,12 +331,12 @@ private:
 
   inline interpolator_t &
   interpolator( const int v ) {
-    return interpolator_array->i[ v ];
+    return interpolator_array->i[ grid->sfc[v] ];
   }
 
   inline interpolator_t &
   interpolator( const int ix, const int iy, const int iz ) {
-    return interpolator_array->i[ voxel(ix,iy,iz) ];
+    return interpolator_array->i[ grid->sfc[voxel(ix,iy,iz)] ];
   }
 
   inline hydro_t &
@@ -398,6 +436,22 @@ private:
     set_pbc( grid, boundary, pbc );
   }
 
+  // Sets the voxel storage order (fortran_order, morton_order or
+  // hilbert_order) of the local domain.  Call after the grid is defined
+  // and before the first step.  If the order changes, the accumulators
+  // (and their cached tile ranges) are cleared, the interpolators are
+  // reloaded in the new order and the species are marked unsorted (their
+  // partitions are indexed in storage order).
+  inline void set_domain_voxel_order( int order ) {
+    species_t * sp;
+    if( order==grid->sfc_order ) return;
+    set_sfc_order( grid, order );
+    if( accumulator_array ) reset_accumulator_array( accumulator_array );
+    if( interpolator_array )
+      load_interpolator_array( interpolator_array, field_array );
+    LIST_FOR_EACH( sp, species_list ) sp->last_sorted = INT64_MIN;
+  }
+
   ///////////////////
   // Material helpers
 
@@ -543,12 +597,16 @@ private:
                        float dx, float dy, float dz, int32_t i,
                        float ux, float uy, float uz, float w,
                        int64_t tag = 0 ) {
-    particle_t * RESTRICT p = sp->p + (sp->np++);
+    particle_t p[1];
     p->dx = dx; p->dy = dy; p->dz = dz; p->i = i;
     p->ux = ux; p->uy = uy; p->uz = uz; p->w = w;
 #ifdef ENABLE_PARTICLE_TAG
     p->tag = tag;
 #endif
+    if( sp->p_layout==particle_layout_aosoa )
+      store_particle_pb( (particle_block_t *)sp->p, sp->np++, p );
+    else
+      sp->p[ sp->np++ ] = p[0];
   }
 
   // This variant does a raw inject and moves the particles
@@ -559,16 +617,23 @@ private:
                        float ux, float uy, float uz, float w,
                        float dispx, float dispy, float dispz,
                        int update_rhob, int64_t tag = 0 ) {
-    particle_t       * RESTRICT p  = sp->p  + (sp->np++);
+    particle_t p[1];
     particle_mover_t * RESTRICT pm = sp->pm + sp->nm;
     p->dx = dx; p->dy = dy; p->dz = dz; p->i = i;
     p->ux = ux; p->uy = uy; p->uz = uz; p->w = w;
 #ifdef ENABLE_PARTICLE_TAG
     p->tag = tag;
 #endif
-    pm->dispx = dispx; pm->dispy = dispy; pm->dispz = dispz; pm->i = sp->np-1;
+    pm->dispx = dispx; pm->dispy = dispy; pm->dispz = dispz; pm->i = sp->np;
     if( update_rhob ) accumulate_rhob( field_array->f, p, grid, -sp->q );
-    sp->nm += move_p( sp->p, pm, accumulator_array->a, grid, sp->q );
+    if( sp->p_layout==particle_layout_aosoa ) {
+      store_particle_pb( (particle_block_t *)sp->p, sp->np++, p );
+      sp->nm += move_pb( (particle_block_t *)sp->p, pm,
+                         accumulator_array->a, grid, sp->q );
+    } else {
+      sp->p[ sp->np++ ] = p[0];
+      sp->nm += move_p( sp->p, pm, accumulator_array->a, grid, sp->q );
+    }
   }
 
   //////////////////////////////////
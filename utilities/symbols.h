@@ -1,25 +0,0 @@
-#ifndef symbols_h
-#define symbols_h
-
-const void * new_field = (void *)(0x0000000010093508);
-const void * delete_field = (void *)(0x00000000100934d8);
-const void * new_material_coefficients = (void *)(0x00000000100934f0);
-const void * delete_material_coefficients = (void *)(0x00000000100934c0);
-const void * advance_b = (void *)(0x00000000100931f0);
-const void * advance_e = (void *)(0x00000000100939a0);
-const void * energy_f = (void *)(0x0000000010093a90);
-const void * clear_jf = (void *)(0x00000000100934a8);
-const void * synchronize_jf = (void *)(0x0000000010093448);
-const void * clear_rhof = (void *)(0x0000000010093490);
-const void * synchronize_rho = (void *)(0x00000000100933e8);
-const void * compute_rhob = (void *)(0x0000000010093a60);
-const void * compute_curl_b = (void *)(0x0000000010093a00);
-const void * synchronize_tang_e_norm_b = (void *)(0x0000000010093460);
-const void * compute_div_e_err = (void *)(0x0000000010093a30);
-const void * compute_rms_div_e_err = (void *)(0x00000000100932b0);
-const void * clean_div_e = (void *)(0x00000000100939d0);
-const void * compute_div_b_err = (void *)(0x0000000010093250);
-const void * compute_rms_div_b_err = (void *)(0x0000000010093280);
-const void * clean_div_b = (void *)(0x0000000010093220);
-
-#endif // symbols_h
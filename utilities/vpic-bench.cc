@@ -0,0 +1,471 @@
+/*
+ * vpic-bench: micro-benchmarks of the pipeline kernels.
+ *
+ * Each kernel is run on a synthetic periodic grid with a uniform thermal
+ * particle distribution for every compiled simd width (only the booted
+ * one without USE_SIMD_DISPATCH), particle layout and thread count
+ * requested.  The state a kernel modifies is restored (untimed) before
+ * each repetition so every repetition does the same work.  The best time
+ * over the repetitions (the max over the ranks) is reported per particle
+ * or per voxel along with the nominal memory bandwidth (the bytes a
+ * kernel must stream per item over the time).
+ *
+ * Usage: vpic-bench [--nx n] [--ny n] [--nz n] [--ppc n] [--uth u]
+ *                   [--reps n] [--threads 1,2,4,...] [--layouts aos,aosoa]
+ *                   [--kernels advance_p,sort_p,...] [--csv file]
+ *                   [--tpp n] [--simd width] ...
+ *
+ * The grid is nx x ny x nz voxels per rank (ranks are stacked along x)
+ * with ppc particles per voxel.  --threads defaults to the powers of two
+ * up to --tpp.  The kernels are advance_p, sort_p, center_p, energy_p,
+ * load_interpolator, unload_accumulator, reduce_accumulator, advance_b
+ * and advance_e.  With --csv, rank 0 also writes the results as comma
+ * separated values for comparing releases.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/util.h"
+#include "grid/grid.h"
+#include "material/material.h"
+#include "field_advance/field_advance.h"
+#include "sf_interface/sf_interface.h"
+#include "species_advance/species_advance.h"
+
+//----------------------------------------------------------------------------//
+// Benchmark state
+//----------------------------------------------------------------------------//
+
+typedef struct bench {
+  grid_t               * g;
+  material_t           * m_list;
+  field_array_t        * fa;
+  interpolator_array_t * ia;
+  accumulator_array_t  * aa;
+  species_t            * sp;
+
+  particle_t * ALIGNED(128) p0; // Particles sorted by voxel
+  particle_t * ALIGNED(128) p1; // Particles one advance after p0
+  field_t    * ALIGNED(128) f0; // Initial fields
+  int np0, np1;                 // Number of particles in p0 and p1
+  int n_block;                  // Particle storage in particles
+} bench_t;
+
+// Drop the particles that left the local domain during the last advance
+// (boundary_p would send them to the neighboring ranks).
+
+static int
+compare_desc( const void * a,
+              const void * b ) {
+  return ((const particle_mover_t *)b)->i - ((const particle_mover_t *)a)->i;
+}
+
+static void
+drop_movers( species_t * sp ) {
+  int m;
+  convert_p( sp, particle_layout_aos );
+  qsort( sp->pm, sp->nm, sizeof(particle_mover_t), compare_desc );
+  for( m=0; m<sp->nm; m++ ) sp->p[ sp->pm[m].i ] = sp->p[ --sp->np ];
+  sp->nm = 0;
+  convert_p( sp, sp->layout );
+}
+
+static void
+new_bench( bench_t * b,
+           int nx, int ny, int nz,
+           int ppc,
+           double uth,
+           int layout ) {
+  rng_t * r;
+  particle_t * p;
+  field_t * f;
+  int np, n, v, x, y, z;
+
+  CLEAR( b, 1 );
+
+  b->g = new_grid();
+  b->g->dt   = 0.5;
+  b->g->cvac = 1;
+  b->g->eps0 = 1;
+  partition_periodic_box( b->g, 0, 0, 0,
+                          nx*world_size, ny, nz,
+                          nx*world_size, ny, nz,
+                          world_size, 1, 1 );
+
+  append_material( material( "vacuum", 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0 ),
+                   &b->m_list );
+
+  b->fa = new_standard_field_array( b->g, b->m_list, 0 );
+  b->ia = new_interpolator_array( b->g );
+  b->aa = new_accumulator_array( b->g );
+
+  np = ppc*nx*ny*nz;
+  b->sp = species( "bench", -1, 1, np, np/25 + 16*(MAX_PIPELINE+1),
+                   0, 0, b->g );
+  b->n_block = PARTICLE_BLOCK_CEIL( np );
+
+  // Random fields of order one and thermal particles uniformly
+  // distributed over the local voxels
+
+  r = new_rng( 1 + world_rank );
+
+  f = b->fa->f;
+  for( v=0; v<b->g->nv; v++ ) {
+    f[v].ex = 0.1*frandn( r ); f[v].ey = 0.1*frandn( r ); f[v].ez = 0.1*frandn( r );
+    f[v].cbx = 0.1*frandn( r ); f[v].cby = 0.1*frandn( r ); f[v].cbz = 0.1*frandn( r );
+  }
+
+  p = b->sp->p;
+  n = 0;
+  for( z=1; z<=nz; z++ )
+    for( y=1; y<=ny; y++ )
+      for( x=1; x<=nx; x++ )
+        for( v=0; v<ppc; v++, n++ ) {
+          p[n].dx = 2*frand_c0( r ) - 1;
+          p[n].dy = 2*frand_c0( r ) - 1;
+          p[n].dz = 2*frand_c0( r ) - 1;
+          p[n].i  = VOXEL( x, y, z, nx, ny, nz );
+          p[n].ux = uth*frandn( r );
+          p[n].uy = uth*frandn( r );
+          p[n].uz = uth*frandn( r );
+          p[n].w  = 1;
+        }
+  b->sp->np = np;
+
+  delete_rng( r );
+
+  // Snapshot the fields and the particles in the requested layout before
+  // and after one advance.
+
+  set_species_layout( b->sp, layout );
+  sort_p( b->sp );
+
+  MALLOC_ALIGNED( b->f0, b->g->nv, 128 );
+  COPY( b->f0, b->fa->f, b->g->nv );
+
+  MALLOC_ALIGNED( b->p0, b->n_block, 128 );
+  COPY( b->p0, b->sp->p, b->n_block );
+  b->np0 = b->sp->np;
+
+  load_interpolator_array( b->ia, b->fa );
+  clear_accumulator_array( b->aa );
+  advance_p( b->sp, b->aa, b->ia );
+  drop_movers( b->sp );
+
+  MALLOC_ALIGNED( b->p1, b->n_block, 128 );
+  COPY( b->p1, b->sp->p, b->n_block );
+  b->np1 = b->sp->np;
+}
+
+static void
+delete_bench( bench_t * b ) {
+  FREE_ALIGNED( b->p1 );
+  FREE_ALIGNED( b->p0 );
+  FREE_ALIGNED( b->f0 );
+  delete_species_list( b->sp );
+  delete_accumulator_array( b->aa );
+  delete_interpolator_array( b->ia );
+  delete_field_array( b->fa );
+  delete_material_list( b->m_list );
+  delete_grid( b->g );
+}
+
+static void
+restore_particles( bench_t * b,
+                   const particle_t * p,
+                   int np ) {
+  COPY( b->sp->p, p, b->n_block );
+  b->sp->np       = np;
+  b->sp->p_layout = b->sp->layout;
+  b->sp->nm       = 0;
+}
+
+//----------------------------------------------------------------------------//
+// Kernels.  prepare restores the state the kernel modifies (untimed);
+// run is timed.  Items are particles or voxels; bytes are the nominal
+// bytes streamed per item.
+//----------------------------------------------------------------------------//
+
+enum { per_particle = 0, per_voxel = 1 };
+
+typedef struct kernel {
+  const char * name;
+  int per;
+  double bytes;
+  void (*prepare)( bench_t * b );
+  void (*run)( bench_t * b );
+} kernel_t;
+
+static void prepare_p0( bench_t * b ) { restore_particles( b, b->p0, b->np0 ); }
+static void prepare_p1( bench_t * b ) { restore_particles( b, b->p1, b->np1 ); }
+
+static void
+prepare_advance_p( bench_t * b ) {
+  restore_particles( b, b->p0, b->np0 );
+  clear_accumulator_array( b->aa );
+}
+
+static void
+prepare_fields( bench_t * b ) {
+  COPY( b->fa->f, b->f0, b->g->nv );
+}
+
+static void
+prepare_none( bench_t * b ) {
+}
+
+static void run_advance_p( bench_t * b ) { advance_p( b->sp, b->aa, b->ia ); }
+static void run_sort_p(    bench_t * b ) { sort_p( b->sp ); }
+static void run_center_p(  bench_t * b ) { center_p( b->sp, b->ia ); }
+static void run_energy_p(  bench_t * b ) { energy_p( b->sp, b->ia ); }
+static void run_load(      bench_t * b ) { load_interpolator_array( b->ia, b->fa ); }
+static void run_unload(    bench_t * b ) { unload_accumulator_array( b->fa, b->aa ); }
+static void run_reduce(    bench_t * b ) { reduce_accumulator_array( b->aa ); }
+static void run_advance_b( bench_t * b ) { b->fa->kernel->advance_b( b->fa, 0.5 ); }
+static void run_advance_e( bench_t * b ) { b->fa->kernel->advance_e( b->fa, 1.0 ); }
+
+static const kernel_t Kernel[] = {
+  { "advance_p",          per_particle, 2*sizeof(particle_t),
+    prepare_advance_p, run_advance_p },
+  { "sort_p",             per_particle, 4*sizeof(particle_t),
+    prepare_p1,        run_sort_p    },
+  { "center_p",           per_particle, 2*sizeof(particle_t),
+    prepare_p0,        run_center_p  },
+  { "energy_p",           per_particle, sizeof(particle_t),
+    prepare_p0,        run_energy_p  },
+  { "load_interpolator",  per_voxel,    sizeof(field_t)+sizeof(interpolator_t),
+    prepare_none,      run_load      },
+  { "unload_accumulator", per_voxel,    sizeof(accumulator_t)+2*sizeof(field_t),
+    prepare_fields,    run_unload    },
+  { "reduce_accumulator", per_voxel,    -1, // Depends on the thread count
+    prepare_none,      run_reduce    },
+  { "advance_b",          per_voxel,    2*sizeof(field_t),
+    prepare_fields,    run_advance_b },
+  { "advance_e",          per_voxel,    2*sizeof(field_t),
+    prepare_fields,    run_advance_e },
+  { NULL, 0, 0, NULL, NULL }
+};
+
+//----------------------------------------------------------------------------//
+// Helpers
+//----------------------------------------------------------------------------//
+
+// Parse a comma separated list of ints into x (at most max); returns
+// the number parsed.
+
+static int
+parse_list( const char * s,
+            int * x,
+            int max ) {
+  char buf[256], * tok;
+  int n = 0;
+  if( strlen( s )>=sizeof(buf) ) ERROR(( "List \"%s\" too long", s ));
+  strcpy( buf, s );
+  for( tok=strtok( buf, "," ); tok && n<max; tok=strtok( NULL, "," ) )
+    x[n++] = atoi( tok );
+  return n;
+}
+
+static int
+in_list( const char * list,
+         const char * name ) {
+  const char * s;
+  size_t len = strlen( name );
+  if( !list ) return 1;
+  for( s=list; (s=strstr( s, name ))!=NULL; s+=len )
+    if( ( s==list || s[-1]==',' ) && ( s[len]==',' || s[len]=='\0' ) )
+      return 1;
+  return 0;
+}
+
+// Restart the pipeline dispatcher with n pipelines
+
+static void
+set_pipelines( int n ) {
+# if defined(VPIC_USE_PTHREADS)
+  char arg0[] = "vpic-bench", arg1[] = "--tpp", arg2[16];
+  char * args[] = { arg0, arg1, arg2, NULL }, ** argv = args;
+  int argc = 3;
+  if( n==thread.n_pipeline ) return;
+  sprintf( arg2, "%i", n );
+  thread.halt();
+  thread.boot( &argc, &argv );
+# elif defined(VPIC_USE_OPENMP)
+  omp_helper.n_pipeline = n;
+  omp_set_num_threads( n );
+# endif
+}
+
+//----------------------------------------------------------------------------//
+// Main
+//----------------------------------------------------------------------------//
+
+static const char Usage[] =
+  "Usage: vpic-bench [--nx n] [--ny n] [--nz n] [--ppc n] [--uth u]\n"
+  "                  [--reps n] [--threads 1,2,4,...] [--layouts aos,aosoa]\n"
+  "                  [--kernels advance_p,sort_p,...] [--csv file]\n"
+  "                  [--tpp n] [--simd width] ...\n"
+  "\n"
+  "  --nx, --ny, --nz  Local grid size per rank (default 32 32 32)\n"
+  "  --ppc             Particles per voxel (default 64)\n"
+  "  --uth             Thermal momentum of the particles (default 0.1)\n"
+  "  --reps            Timed repetitions per kernel (default 10)\n"
+  "  --threads         Thread counts (default powers of two up to --tpp)\n"
+  "  --layouts         Particle layouts (default aos,aosoa)\n"
+  "  --kernels         Kernels (default all): advance_p, sort_p, center_p,\n"
+  "                    energy_p, load_interpolator, unload_accumulator,\n"
+  "                    reduce_accumulator, advance_b, advance_e\n"
+  "  --csv             Also write the results to file as CSV\n"
+  "  --help            Print this and exit\n";
+
+int
+main( int argc,
+      char ** argv ) {
+  static const char * layout_name[] = { "aos", "aosoa" };
+  int threads[ MAX_PIPELINE ], widths[4], layouts[2];
+  int n_thread, n_width, n_layout, max_width, max_pipeline;
+  int nx, ny, nz, ppc, reps, it, iw, il, rep;
+  const char * kernels, * csv_name, * s;
+  const kernel_t * k;
+  FILE * csv = NULL;
+  double uth, t, best, items, bytes;
+  bench_t b[1];
+
+  boot_services( &argc, &argv );
+
+  if( strip_cmdline( &argc, &argv, "--help" ) +
+      strip_cmdline( &argc, &argv, "-h" ) ) {
+    if( world_rank==0 ) log_printf( "%s", Usage );
+    halt_services();
+    return 0;
+  }
+
+  nx       = strip_cmdline_int(    &argc, &argv, "--nx",      32     );
+  ny       = strip_cmdline_int(    &argc, &argv, "--ny",      32     );
+  nz       = strip_cmdline_int(    &argc, &argv, "--nz",      32     );
+  ppc      = strip_cmdline_int(    &argc, &argv, "--ppc",     64     );
+  uth      = strip_cmdline_double( &argc, &argv, "--uth",     0.1    );
+  reps     = strip_cmdline_int(    &argc, &argv, "--reps",    10     );
+  kernels  = strip_cmdline_string( &argc, &argv, "--kernels", NULL   );
+  csv_name = strip_cmdline_string( &argc, &argv, "--csv",     NULL   );
+
+  if( nx<1 || ny<1 || nz<1 || ppc<1 || reps<1 )
+    ERROR(( "Invalid benchmark size" ));
+
+  // Thread counts (default: powers of two up to the booted count)
+
+  max_pipeline = N_PIPELINE;
+  s = strip_cmdline_string( &argc, &argv, "--threads", NULL );
+  if( s ) n_thread = parse_list( s, threads, MAX_PIPELINE );
+  else {
+    n_thread = 0;
+    for( it=1; it<max_pipeline; it*=2 ) threads[ n_thread++ ] = it;
+    threads[ n_thread++ ] = max_pipeline;
+  }
+  for( it=0; it<n_thread; it++ )
+    if( threads[it]<1 || threads[it]>MAX_PIPELINE )
+      ERROR(( "Invalid thread count %i", threads[it] ));
+
+  // Simd widths (all compiled widths up to the booted one with run time
+  // dispatch, else just the booted one)
+
+  max_width = simd_width;
+  n_width = 0;
+# if defined(VPIC_SIMD_DISPATCH)
+  for( iw=0; iw<=16; iw = iw ? 2*iw : 4 )
+    if( iw<=max_width ) widths[ n_width++ ] = iw;
+# else
+  widths[ n_width++ ] = max_width;
+# endif
+
+  // Particle layouts
+
+  s = strip_cmdline_string( &argc, &argv, "--layouts", "aos,aosoa" );
+  n_layout = 0;
+  for( il=0; il<2; il++ ) if( in_list( s, layout_name[il] ) ) layouts[ n_layout++ ] = il;
+# if defined(ENABLE_PARTICLE_TAG)
+  n_layout = 1, layouts[0] = particle_layout_aos;
+# endif
+
+  // Everything left on the command line is unknown
+
+  if( argc>1 ) {
+    if( world_rank==0 ) log_printf( "%s", Usage );
+    ERROR(( "Unknown option \"%s\" (see --help)", argv[1] ));
+  }
+
+  if( world_rank==0 ) {
+    log_printf( "*** vpic-bench: %ix%ix%i voxels and %i particles per voxel "
+                "on each of %i ranks, best of %i\n",
+                nx, ny, nz, ppc, world_size, reps );
+    log_printf( "%-20s %6s %5s %4s %12s %10s\n",
+                "kernel", "layout", "simd", "tpp", "ns/item", "GB/s" );
+    if( csv_name ) {
+      csv = fopen( csv_name, "w" );
+      if( !csv ) ERROR(( "Could not open \"%s\"", csv_name ));
+      fprintf( csv, "kernel,layout,simd,tpp,per,ns_per_item,gb_per_s\n" );
+    }
+  }
+
+  for( it=0; it<n_thread; it++ ) {
+    set_pipelines( threads[it] );
+
+    for( il=0; il<n_layout; il++ ) {
+      new_bench( b, nx, ny, nz, ppc, uth, layouts[il] );
+
+      for( iw=0; iw<n_width; iw++ ) {
+        simd_width = widths[iw];
+
+        for( k=Kernel; k->name; k++ ) {
+          if( !in_list( kernels, k->name ) ) continue;
+
+          // Field kernels do not depend on the particle layout
+
+          if( k->per==per_voxel && il>0 ) continue;
+
+          best = 1e30;
+          for( rep=0; rep<=reps; rep++ ) { // Rep 0 warms up the caches
+            k->prepare( b );
+            mp_barrier();
+            t = wallclock();
+            k->run( b );
+            t = wallclock() - t;
+            if( rep && best>t ) best = t;
+          }
+          mp_allmax_d( &best, &t, 1 );
+
+          items = k->per==per_particle ? (double)b->sp->np :
+                                         (double)( nx*ny*nz );
+          bytes = k->bytes>0 ? k->bytes :
+                  (double)( b->aa->n_pipeline+2 )*sizeof(accumulator_t);
+
+          if( world_rank==0 ) {
+            log_printf( "%-20s %6s %5i %4i %12.3f %10.3f\n",
+                        k->name,
+                        k->per==per_particle ? layout_name[ layouts[il] ] : "-",
+                        widths[iw], threads[it],
+                        1e9*t/items, 1e-9*bytes*items/t );
+            if( csv ) fprintf( csv, "%s,%s,%i,%i,%s,%.6g,%.6g\n",
+                               k->name,
+                               k->per==per_particle ? layout_name[ layouts[il] ] : "-",
+                               widths[iw], threads[it],
+                               k->per==per_particle ? "particle" : "voxel",
+                               1e9*t/items, 1e-9*bytes*items/t );
+          }
+        }
+      }
+
+      simd_width = max_width;
+      delete_bench( b );
+    }
+  }
+
+  if( csv ) fclose( csv );
+
+  set_pipelines( max_pipeline );
+  halt_services();
+
+  return 0;
+}